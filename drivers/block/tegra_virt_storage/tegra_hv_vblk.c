@@ -50,6 +50,14 @@ static uint32_t total_instance_id;
 
 static int vblk_major;
 
+/*
+ * Number of blk-mq hardware queues. All of them feed the same IVC channel,
+ * but separate contexts keep tag allocation and dispatch per CPU group.
+ */
+static unsigned int hw_queues = 4;
+module_param(hw_queues, uint, 0444);
+MODULE_PARM_DESC(hw_queues, "Number of blk-mq hardware queues per device");
+
 static inline uint64_t _arch_counter_get_cntvct(void)
 {
 	uint64_t cval;
@@ -513,7 +521,6 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 		}
 		list_del(&entry->list_entry);
 		bio_req = entry->req;
-		kfree(entry);
 	}
 	spin_unlock(&vblkdev->queue_lock);
 
@@ -683,18 +690,16 @@ bio_exit:
 	return false;
 }
 
-static void vblk_request_work(struct work_struct *ws)
+/*
+ * vblk_process_ivc: Drain responses and submit pending requests until the
+ * IVC channel makes no more progress. Called with ivc_lock held.
+ */
+static void vblk_process_ivc(struct vblk_dev *vblkdev)
 {
-	struct vblk_dev *vblkdev =
-		container_of(ws, struct vblk_dev, work);
 	bool req_submitted, req_completed;
 
-	/* Taking ivc lock before performing IVC read/write */
-	mutex_lock(&vblkdev->ivc_lock);
-	if (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0) {
-		mutex_unlock(&vblkdev->ivc_lock);
+	if (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0)
 		return;
-	}
 
 	req_submitted = true;
 	req_completed = true;
@@ -703,6 +708,16 @@ static void vblk_request_work(struct work_struct *ws)
 
 		req_submitted = submit_bio_req(vblkdev);
 	}
+}
+
+static void vblk_request_work(struct work_struct *ws)
+{
+	struct vblk_dev *vblkdev =
+		container_of(ws, struct vblk_dev, work);
+
+	/* Taking ivc lock before performing IVC read/write */
+	mutex_lock(&vblkdev->ivc_lock);
+	vblk_process_ivc(vblkdev);
 	mutex_unlock(&vblkdev->ivc_lock);
 }
 
@@ -710,19 +725,12 @@ static void vblk_request_work(struct work_struct *ws)
 static blk_status_t vblk_request(struct blk_mq_hw_ctx *hctx,
 			const struct blk_mq_queue_data *bd)
 {
-	struct req_entry *entry;
 	struct request *req = bd->rq;
+	struct req_entry *entry = blk_mq_rq_to_pdu(req);
 	struct vblk_dev *vblkdev = hctx->queue->queuedata;
 
 	blk_mq_start_request(req);
 
-	/* malloc for req list entry */
-	entry = kmalloc(sizeof(struct req_entry), GFP_ATOMIC);
-	if (entry == NULL) {
-		dev_err(vblkdev->device, "Failed to allocate memory\n");
-		return BLK_STS_IOERR;
-	}
-
 	/* Initialise the entry */
 	entry->req = req;
 	INIT_LIST_HEAD(&entry->list_entry);
@@ -732,8 +740,17 @@ static blk_status_t vblk_request(struct blk_mq_hw_ctx *hctx,
 	list_add_tail(&entry->list_entry, &vblkdev->req_list);
 	spin_unlock(&vblkdev->queue_lock);
 
-	/* Now invoke the queue to handle data inserted in queue */
-	queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+	/*
+	 * Submit directly if nobody else is talking to the server, otherwise
+	 * leave it to the worker so that the current ivc_lock holder is not
+	 * relied upon to notice the new entry.
+	 */
+	if (mutex_trylock(&vblkdev->ivc_lock)) {
+		vblk_process_ivc(vblkdev);
+		mutex_unlock(&vblkdev->ivc_lock);
+	} else {
+		queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+	}
 
 	return BLK_STS_OK;
 }
@@ -985,11 +1002,19 @@ static void setup_device(struct vblk_dev *vblkdev)
 
 	memset(&vblkdev->tag_set, 0, sizeof(vblkdev->tag_set));
 	vblkdev->tag_set.ops = &vblk_mq_ops;
-	vblkdev->tag_set.nr_hw_queues = 1;
+	vblkdev->tag_set.nr_hw_queues = clamp_t(unsigned int, hw_queues, 1,
+						num_possible_cpus());
 	vblkdev->tag_set.nr_maps = 1;
-	vblkdev->tag_set.queue_depth = 16;
+	vblkdev->tag_set.queue_depth = MAX_VSC_REQS;
 	vblkdev->tag_set.numa_node = NUMA_NO_NODE;
-	vblkdev->tag_set.flags = BLK_MQ_F_SHOULD_MERGE;
+	vblkdev->tag_set.cmd_size = sizeof(struct req_entry);
+	/*
+	 * queue_rq may take ivc_lock and allocate to submit directly. All
+	 * hw queues share the MAX_VSC_REQS request slots of the one IVC
+	 * channel, so they share one set of tags as well.
+	 */
+	vblkdev->tag_set.flags = BLK_MQ_F_SHOULD_MERGE | BLK_MQ_F_BLOCKING |
+				 BLK_MQ_F_TAG_HCTX_SHARED;
 
 	ret = blk_mq_alloc_tag_set(&vblkdev->tag_set);
 	if (ret)
@@ -35,6 +35,7 @@ struct vblk_ioctl_req {
 	int32_t status;
 };
 
+/* blk-mq PDU of each request, queued on vblk_dev.req_list */
 struct req_entry {
 	struct list_head list_entry;
 	struct request *req;
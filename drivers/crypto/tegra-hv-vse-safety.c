@@ -1629,13 +1629,6 @@ static int tegra_hv_vse_safety_sha_init(struct ahash_request *req)
 		return -EINVAL;
 	}
 
-	req_ctx->sha_buf = dma_alloc_coherent(se_dev->dev, SZ_4M,
-					&req_ctx->sha_buf_addr, GFP_KERNEL);
-	if (!req_ctx->sha_buf) {
-		dev_err(se_dev->dev, "Cannot allocate memory to sha_buf\n");
-		return -ENOMEM;
-	}
-
 	if ((req_ctx->mode == VIRTUAL_SE_OP_MODE_SHAKE128) ||
 			(req_ctx->mode == VIRTUAL_SE_OP_MODE_SHAKE256)) {
 		dst_len = sha_ctx->digest_size;
@@ -1643,22 +1636,53 @@ static int tegra_hv_vse_safety_sha_init(struct ahash_request *req)
 		dst_len = req_ctx->intermediate_digest_size;
 	}
 
-	if (dst_len == 0) {
-		dma_free_coherent(se_dev->dev, SZ_4M,
-				req_ctx->sha_buf, req_ctx->sha_buf_addr);
-		req_ctx->sha_buf = NULL;
+	if (dst_len == 0)
 		return -EINVAL;
-	}
 
-	req_ctx->hash_result = dma_alloc_coherent(
-			se_dev->dev, dst_len,
-			&req_ctx->hash_result_addr, GFP_KERNEL);
-	if (!req_ctx->hash_result) {
-		dma_free_coherent(se_dev->dev, SZ_4M,
-				req_ctx->sha_buf, req_ctx->sha_buf_addr);
-		req_ctx->sha_buf = NULL;
-		dev_err(se_dev->dev, "Cannot allocate memory to hash_result\n");
-		return -ENOMEM;
+	/*
+	 * A 4 MiB coherent allocation per init dominates short hashes, so the
+	 * first request of the tfm keeps its buffers for the next one. Requests
+	 * running concurrently on the same tfm allocate their own.
+	 */
+	req_ctx->bufs_cached = false;
+	if (dst_len <= (TEGRA_HV_VSE_SHA_MAX_BLOCK_SIZE * 2) &&
+			!test_and_set_bit_lock(0, &sha_ctx->cached_bufs_busy)) {
+		if (!sha_ctx->cached_sha_buf)
+			sha_ctx->cached_sha_buf = dma_alloc_coherent(se_dev->dev,
+					SZ_4M, &sha_ctx->cached_sha_buf_addr, GFP_KERNEL);
+		if (sha_ctx->cached_sha_buf && !sha_ctx->cached_hash_result)
+			sha_ctx->cached_hash_result = dma_alloc_coherent(se_dev->dev,
+					(TEGRA_HV_VSE_SHA_MAX_BLOCK_SIZE * 2),
+					&sha_ctx->cached_hash_result_addr, GFP_KERNEL);
+		if (!sha_ctx->cached_hash_result) {
+			clear_bit_unlock(0, &sha_ctx->cached_bufs_busy);
+			dev_err(se_dev->dev, "Cannot allocate memory to sha buffers\n");
+			return -ENOMEM;
+		}
+
+		req_ctx->sha_buf = sha_ctx->cached_sha_buf;
+		req_ctx->sha_buf_addr = sha_ctx->cached_sha_buf_addr;
+		req_ctx->hash_result = sha_ctx->cached_hash_result;
+		req_ctx->hash_result_addr = sha_ctx->cached_hash_result_addr;
+		req_ctx->bufs_cached = true;
+	} else {
+		req_ctx->sha_buf = dma_alloc_coherent(se_dev->dev, SZ_4M,
+						&req_ctx->sha_buf_addr, GFP_KERNEL);
+		if (!req_ctx->sha_buf) {
+			dev_err(se_dev->dev, "Cannot allocate memory to sha_buf\n");
+			return -ENOMEM;
+		}
+
+		req_ctx->hash_result = dma_alloc_coherent(
+				se_dev->dev, dst_len,
+				&req_ctx->hash_result_addr, GFP_KERNEL);
+		if (!req_ctx->hash_result) {
+			dma_free_coherent(se_dev->dev, SZ_4M,
+					req_ctx->sha_buf, req_ctx->sha_buf_addr);
+			req_ctx->sha_buf = NULL;
+			dev_err(se_dev->dev, "Cannot allocate memory to hash_result\n");
+			return -ENOMEM;
+		}
 	}
 	req_ctx->total_count = 0;
 	req_ctx->is_first = true;
@@ -1673,15 +1697,23 @@ static void tegra_hv_vse_safety_sha_req_deinit(struct ahash_request *req)
 {
 	struct tegra_virtual_se_dev *se_dev = g_virtual_se_dev[VIRTUAL_SE_SHA];
 	struct tegra_virtual_se_req_context *req_ctx = ahash_request_ctx(req);
+	struct tegra_virtual_se_sha_context *sha_ctx;
 
-	/* dma_free_coherent does not panic if addr is NULL */
-	dma_free_coherent(se_dev->dev, SZ_4M,
-			req_ctx->sha_buf, req_ctx->sha_buf_addr);
-	req_ctx->sha_buf = NULL;
+	if (req_ctx->bufs_cached) {
+		/* Hand the buffers back to the tfm */
+		sha_ctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+		req_ctx->bufs_cached = false;
+		clear_bit_unlock(0, &sha_ctx->cached_bufs_busy);
+	} else {
+		/* dma_free_coherent does not panic if addr is NULL */
+		dma_free_coherent(se_dev->dev, SZ_4M,
+				req_ctx->sha_buf, req_ctx->sha_buf_addr);
 
-	dma_free_coherent(
-		se_dev->dev, (TEGRA_HV_VSE_SHA_MAX_BLOCK_SIZE * 2),
-		req_ctx->hash_result, req_ctx->hash_result_addr);
+		dma_free_coherent(
+			se_dev->dev, (TEGRA_HV_VSE_SHA_MAX_BLOCK_SIZE * 2),
+			req_ctx->hash_result, req_ctx->hash_result_addr);
+	}
+	req_ctx->sha_buf = NULL;
 	req_ctx->hash_result = NULL;
 	req_ctx->req_context_initialized = false;
 }
@@ -1833,6 +1865,16 @@ static int tegra_hv_vse_safety_sha_cra_init(struct crypto_tfm *tfm)
 
 static void tegra_hv_vse_safety_sha_cra_exit(struct crypto_tfm *tfm)
 {
+	struct tegra_virtual_se_sha_context *sha_ctx = crypto_tfm_ctx(tfm);
+	struct tegra_virtual_se_dev *se_dev = g_virtual_se_dev[VIRTUAL_SE_SHA];
+
+	if (sha_ctx->cached_sha_buf)
+		dma_free_coherent(se_dev->dev, SZ_4M,
+				sha_ctx->cached_sha_buf, sha_ctx->cached_sha_buf_addr);
+	if (sha_ctx->cached_hash_result)
+		dma_free_coherent(se_dev->dev, (TEGRA_HV_VSE_SHA_MAX_BLOCK_SIZE * 2),
+				sha_ctx->cached_hash_result,
+				sha_ctx->cached_hash_result_addr);
 }
 
 static void tegra_hv_vse_safety_prepare_cmd(struct tegra_virtual_se_dev *se_dev,
@@ -2774,9 +2816,11 @@ static int tegra_hv_vse_safety_cmac_init(struct ahash_request *req)
 		return -ENODEV;
 
 	cmac_ctx->digest_size = crypto_ahash_digestsize(tfm);
-	cmac_ctx->hash_result = dma_alloc_coherent(
-			se_dev->dev, TEGRA_VIRTUAL_SE_AES_CMAC_DIGEST_SIZE,
-			&cmac_ctx->hash_result_addr, GFP_KERNEL);
+	/* Kept until the tfm is freed, init runs once per CMAC */
+	if (!cmac_ctx->hash_result)
+		cmac_ctx->hash_result = dma_alloc_coherent(
+				se_dev->dev, TEGRA_VIRTUAL_SE_AES_CMAC_DIGEST_SIZE,
+				&cmac_ctx->hash_result_addr, GFP_KERNEL);
 	if (!cmac_ctx->hash_result) {
 		dev_err(se_dev->dev, "Cannot allocate memory for CMAC result\n");
 		return -ENOMEM;
@@ -2789,7 +2833,6 @@ static int tegra_hv_vse_safety_cmac_init(struct ahash_request *req)
 
 static void tegra_hv_vse_safety_cmac_req_deinit(struct ahash_request *req)
 {
-	struct tegra_virtual_se_dev *se_dev;
 	struct tegra_virtual_se_aes_cmac_context *cmac_ctx;
 
 	cmac_ctx = crypto_ahash_ctx(crypto_ahash_reqtfm(req));
@@ -2798,12 +2841,7 @@ static void tegra_hv_vse_safety_cmac_req_deinit(struct ahash_request *req)
 		return;
 	}
 
-	se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[cmac_ctx->node_id].se_engine];
-
-	dma_free_coherent(
-		se_dev->dev, (TEGRA_HV_VSE_SHA_MAX_BLOCK_SIZE * 2),
-		cmac_ctx->hash_result, cmac_ctx->hash_result_addr);
-	cmac_ctx->hash_result = NULL;
+	/* hash_result stays with the tfm, see cmac_cra_exit */
 	cmac_ctx->req_context_initialized = false;
 }
 
@@ -3135,7 +3173,17 @@ static int tegra_hv_vse_safety_cmac_cra_init(struct crypto_tfm *tfm)
 
 static void tegra_hv_vse_safety_cmac_cra_exit(struct crypto_tfm *tfm)
 {
-	/* nothing to do as user releases the keyslot through tzvault TA */
+	struct tegra_virtual_se_aes_cmac_context *cmac_ctx = crypto_tfm_ctx(tfm);
+	struct tegra_virtual_se_dev *se_dev;
+
+	/* user releases the keyslot through tzvault TA */
+	if (!cmac_ctx->hash_result)
+		return;
+
+	se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[cmac_ctx->node_id].se_engine];
+	dma_free_coherent(se_dev->dev, TEGRA_VIRTUAL_SE_AES_CMAC_DIGEST_SIZE,
+			cmac_ctx->hash_result, cmac_ctx->hash_result_addr);
+	cmac_ctx->hash_result = NULL;
 }
 
 static int tegra_hv_vse_safety_aes_setkey(struct crypto_skcipher *tfm,
@@ -138,6 +138,12 @@ struct tegra_virtual_se_sha_context {
 	u8 mode;
 	/*Crypto dev instance*/
 	uint32_t node_id;
+	/* DMA buffers kept across requests, lent to one request at a time */
+	u8 *cached_sha_buf;
+	dma_addr_t cached_sha_buf_addr;
+	u8 *cached_hash_result;
+	dma_addr_t cached_hash_result_addr;
+	unsigned long cached_bufs_busy;
 };
 
 /* Security Engine request context */
@@ -157,6 +163,7 @@ struct tegra_virtual_se_req_context {
 	bool is_first;			/* Represents first block */
 	bool req_context_initialized;	/* Mark initialization status */
 	bool force_align;		/* Enforce buffer alignment */
+	bool bufs_cached;		/* Buffers borrowed from the tfm */
 	/*Crypto dev instance*/
 	uint32_t node_id;
 };
@@ -19,6 +19,9 @@
 #include <linux/mutex.h>
 #include <linux/version.h>
 #include <linux/string.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 #include <linux/platform/tegra/common.h>
 #include <soc/tegra/fuse.h>
 #include <crypto/rng.h>
@@ -71,6 +74,8 @@
 
 struct nvvse_devnode {
 	struct miscdevice *g_misc_devices;
+	/* Serializes ownership of the single SHA context of the node */
+	struct mutex sha_lock;
 	bool sha_init_done;
 } nvvse_devnode[MAX_NUMBER_MISC_DEVICES];
 
@@ -107,6 +112,36 @@ struct crypto_sha_state {
 	bool				sha_done_success;
 };
 
+/*
+ * Submission ring shared with userspace. Everything the driver relies on
+ * (indices, sizes) is kept in private copies; the shared header is only
+ * published to and never trusted.
+ */
+struct tnvvse_crypto_ring {
+	void				*base;
+	size_t				size;
+	struct tegra_nvvse_ring_hdr	*hdr;
+	struct tegra_nvvse_ring_sqe	*sqes;
+	struct tegra_nvvse_ring_cqe	*cqes;
+	uint8_t				*data;
+	uint32_t			data_size;
+	uint32_t			entries;
+	uint32_t			sq_head;
+	uint32_t			cq_tail;
+	/* Transforms are kept across operations of a batch */
+	struct crypto_ahash		*sha_tfm[TEGRA_NVVSE_SHA_TYPE_MAX];
+	struct ahash_request		*sha_req[TEGRA_NVVSE_SHA_TYPE_MAX];
+	struct crypto_ahash		*cmac_tfm;
+	struct ahash_request		*cmac_req;
+	uint8_t				cmac_key_slot[KEYSLOT_SIZE_BYTES];
+	uint8_t				cmac_key_length;
+	bool				cmac_key_valid;
+	struct tnvvse_crypto_completion	complete;
+	struct scatterlist		*sgl;
+	uint32_t			max_nents;
+	char				*result;
+};
+
 /* Tegra NVVSE crypt context */
 struct tnvvse_crypto_ctx {
 	struct mutex			lock;
@@ -116,6 +151,7 @@ struct tnvvse_crypto_ctx {
 	uint32_t			max_rng_buff;
 	char				*sha_result;
 	uint32_t			node_id;
+	struct tnvvse_crypto_ring	*ring;
 };
 
 enum tnvvse_gmac_request_type {
@@ -347,6 +383,32 @@ fail:
 	return status;
 }
 
+/*
+ * The VSE channel of a node holds one SHA context at a time, shared by all
+ * open files of the node. Claim it for a streaming SHA or a ring operation.
+ */
+static bool tnvvse_crypto_sha_claim(uint32_t node_id)
+{
+	struct nvvse_devnode *node = &nvvse_devnode[node_id];
+	bool claimed;
+
+	mutex_lock(&node->sha_lock);
+	claimed = !node->sha_init_done;
+	node->sha_init_done = true;
+	mutex_unlock(&node->sha_lock);
+
+	return claimed;
+}
+
+static void tnvvse_crypto_sha_release(uint32_t node_id)
+{
+	struct nvvse_devnode *node = &nvvse_devnode[node_id];
+
+	mutex_lock(&node->sha_lock);
+	node->sha_init_done = false;
+	mutex_unlock(&node->sha_lock);
+}
+
 static int tnvvse_crypto_sha_init(struct tnvvse_crypto_ctx *ctx,
 		struct tegra_nvvse_sha_init_ctl *init_ctl)
 {
@@ -358,11 +420,6 @@ static int tnvvse_crypto_sha_init(struct tnvvse_crypto_ctx *ctx,
 	int ret = -ENOMEM;
 	char *result_buff = NULL;
 
-	if (nvvse_devnode[ctx->node_id].sha_init_done) {
-		pr_err("%s: Sha init already done for this node_id %u\n", __func__, ctx->node_id);
-		return -EAGAIN;
-	}
-
 	if (init_ctl->sha_type < TEGRA_NVVSE_SHA_TYPE_SHA256  ||
 			init_ctl->sha_type >= TEGRA_NVVSE_SHA_TYPE_MAX) {
 		pr_err("%s(): SHA Type requested %d is not supported\n",
@@ -370,6 +427,11 @@ static int tnvvse_crypto_sha_init(struct tnvvse_crypto_ctx *ctx,
 		return -EINVAL;
 	}
 
+	if (!tnvvse_crypto_sha_claim(ctx->node_id)) {
+		pr_err("%s: Sha init already done for this node_id %u\n", __func__, ctx->node_id);
+		return -EAGAIN;
+	}
+
 	tfm = crypto_alloc_ahash(sha_alg_names[init_ctl->sha_type], 0, 0);
 	if (IS_ERR(tfm)) {
 		pr_err("%s(): Failed to load transform for %s:%ld\n",
@@ -436,7 +498,6 @@ static int tnvvse_crypto_sha_init(struct tnvvse_crypto_ctx *ctx,
 	sha_state->digest_size = init_ctl->digest_size;
 	sha_state->remaining_bytes = init_ctl->total_msg_size;
 	sha_state->sha_done_success = false;
-	nvvse_devnode[ctx->node_id].sha_init_done = true;
 
 	memset(sha_state->result_buff , 0, 64);
 
@@ -452,6 +513,8 @@ free_req:
 free_tfm:
 	crypto_free_ahash(tfm);
 out:
+	if (ret)
+		tnvvse_crypto_sha_release(ctx->node_id);
 	return ret;
 }
 
@@ -464,6 +527,11 @@ static int tnvvse_crypto_sha_update(struct tnvvse_crypto_ctx *ctx,
 	char *input_buffer = update_ctl->in_buff;
 	int ret;
 
+	if (!sha_state->tfm) {
+		pr_err("%s(): SHA is not initialized\n", __func__);
+		return -EINVAL;
+	}
+
 	if (update_ctl->input_buffer_size > ivc_database.max_buffer_size[ctx->node_id]) {
 		pr_err("%s: Msg size is greater than supported size of %d Bytes\n", __func__,
 						ivc_database.max_buffer_size[ctx->node_id]);
@@ -515,6 +583,7 @@ stop_sha:
 	sha_state->total_bytes = 0;
 	sha_state->digest_size = 0;
 	sha_state->remaining_bytes = 0;
+	tnvvse_crypto_sha_release(ctx->node_id);
 
 done:
 	return ret;
@@ -530,6 +599,12 @@ static int tnvvse_crypto_sha_final(struct tnvvse_crypto_ctx *ctx,
 	char *result_buff;
 	int ret = -ENOMEM;
 
+	/* The node SHA context is only released by the file that owns it */
+	if (!tfm) {
+		pr_err("%s(): SHA is not initialized\n", __func__);
+		return -EINVAL;
+	}
+
 	if (!sha_state->sha_done_success) {
 		result_buff = sha_state->result_buff;
 		req = sha_state->req;
@@ -590,7 +665,7 @@ stop_sha:
 	sha_state->total_bytes = 0;
 	sha_state->digest_size = 0;
 	sha_state->remaining_bytes = 0;
-	nvvse_devnode[ctx->node_id].sha_init_done = false;
+	tnvvse_crypto_sha_release(ctx->node_id);
 
 	return ret;
 }
@@ -1801,6 +1876,428 @@ static int tnvvse_crypto_get_ivc_db(struct tegra_nvvse_get_ivc_db *get_ivc_db)
 	return ret;
 }
 
+static void tnvvse_crypto_ring_free(struct tnvvse_crypto_ring *ring)
+{
+	uint32_t i;
+
+	for (i = 0; i < TEGRA_NVVSE_SHA_TYPE_MAX; i++) {
+		ahash_request_free(ring->sha_req[i]);
+		if (ring->sha_tfm[i])
+			crypto_free_ahash(ring->sha_tfm[i]);
+	}
+
+	ahash_request_free(ring->cmac_req);
+	if (ring->cmac_tfm)
+		crypto_free_ahash(ring->cmac_tfm);
+
+	kfree(ring->result);
+	kvfree(ring->sgl);
+	vfree(ring->base);
+	kfree(ring);
+}
+
+static int tnvvse_crypto_ring_setup(struct tnvvse_crypto_ctx *ctx,
+		struct tegra_nvvse_ring_setup_ctl *setup_ctl)
+{
+	struct tnvvse_crypto_ring *ring;
+	size_t sq_off, cq_off, data_off, size;
+	int ret = -ENOMEM;
+
+	if (ctx->ring) {
+		pr_err("%s(): ring already set up\n", __func__);
+		return -EBUSY;
+	}
+
+	if (setup_ctl->entries == 0 || !is_power_of_2(setup_ctl->entries) ||
+			setup_ctl->entries > TEGRA_NVVSE_RING_MAX_ENTRIES) {
+		pr_err("%s(): invalid ring entries %u\n", __func__, setup_ctl->entries);
+		return -EINVAL;
+	}
+
+	if (setup_ctl->data_size == 0 ||
+			setup_ctl->data_size > TEGRA_NVVSE_RING_MAX_DATA_SIZE) {
+		pr_err("%s(): invalid ring data size %u\n", __func__, setup_ctl->data_size);
+		return -EINVAL;
+	}
+
+	sq_off = ALIGN(sizeof(struct tegra_nvvse_ring_hdr), SMP_CACHE_BYTES);
+	cq_off = sq_off + setup_ctl->entries * sizeof(struct tegra_nvvse_ring_sqe);
+	data_off = PAGE_ALIGN(cq_off + setup_ctl->entries * sizeof(struct tegra_nvvse_ring_cqe));
+	size = data_off + PAGE_ALIGN(setup_ctl->data_size);
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	ring->base = vmalloc_user(size);
+	if (!ring->base)
+		goto free_ring;
+
+	/* An operation's data may straddle one extra page */
+	ring->max_nents = (setup_ctl->data_size >> PAGE_SHIFT) + 2;
+	ring->sgl = kvcalloc(ring->max_nents, sizeof(*ring->sgl), GFP_KERNEL);
+	if (!ring->sgl)
+		goto free_ring;
+
+	ring->result = kzalloc(NVVSE_MAX_ALLOCATED_SHA_RESULT_BUFF_SIZE, GFP_KERNEL);
+	if (!ring->result)
+		goto free_ring;
+
+	ring->size = size;
+	ring->hdr = ring->base;
+	ring->sqes = ring->base + sq_off;
+	ring->cqes = ring->base + cq_off;
+	ring->data = ring->base + data_off;
+	ring->data_size = setup_ctl->data_size;
+	ring->entries = setup_ctl->entries;
+	init_completion(&ring->complete.restart);
+
+	setup_ctl->mmap_size = size;
+	setup_ctl->sq_offset = sq_off;
+	setup_ctl->cq_offset = cq_off;
+	setup_ctl->data_offset = data_off;
+
+	ctx->ring = ring;
+
+	return 0;
+
+free_ring:
+	tnvvse_crypto_ring_free(ring);
+	return ret;
+}
+
+/* Describe a range of the vmalloc'ed data area without copying it */
+static struct scatterlist *tnvvse_crypto_ring_map(struct tnvvse_crypto_ring *ring,
+		uint32_t offset, uint32_t length)
+{
+	struct scatterlist *sg;
+	uint8_t *addr = ring->data + offset;
+	uint32_t nents, len;
+
+	nents = length ? DIV_ROUND_UP(offset_in_page(addr) + length, PAGE_SIZE) : 1;
+	if (WARN_ON(nents > ring->max_nents))
+		return NULL;
+
+	sg_init_table(ring->sgl, nents);
+
+	for (sg = ring->sgl; length; sg = sg_next(sg)) {
+		len = min_t(uint32_t, length, PAGE_SIZE - offset_in_page(addr));
+		sg_set_page(sg, vmalloc_to_page(addr), len, offset_in_page(addr));
+		addr += len;
+		length -= len;
+	}
+
+	return ring->sgl;
+}
+
+static bool tnvvse_crypto_ring_range_ok(struct tnvvse_crypto_ring *ring,
+		uint32_t offset, uint32_t length)
+{
+	return offset <= ring->data_size && length <= ring->data_size - offset;
+}
+
+static int tnvvse_crypto_ring_sha(struct tnvvse_crypto_ctx *ctx,
+		const struct tegra_nvvse_ring_sqe *sqe)
+{
+	struct tnvvse_crypto_ring *ring = ctx->ring;
+	struct tegra_virtual_se_sha_context *sha_ctx;
+	struct crypto_ahash *tfm;
+	struct ahash_request *req;
+	struct scatterlist *sg;
+	uint32_t type = sqe->sha_type, digest_size;
+	int ret;
+
+	if (type < TEGRA_NVVSE_SHA_TYPE_SHA256 || type >= TEGRA_NVVSE_SHA_TYPE_MAX)
+		return -EINVAL;
+	type = array_index_nospec(type, TEGRA_NVVSE_SHA_TYPE_MAX);
+
+	if (sqe->src_length > ivc_database.max_buffer_size[ctx->node_id])
+		return -EINVAL;
+
+	/* The VSE channel holds a single SHA context, do not clobber a streaming one */
+	if (!tnvvse_crypto_sha_claim(ctx->node_id))
+		return -EBUSY;
+
+	if (!ring->sha_tfm[type]) {
+		tfm = crypto_alloc_ahash(sha_alg_names[type], 0, 0);
+		if (IS_ERR(tfm)) {
+			pr_err("%s(): Failed to load transform for %s:%ld\n",
+					__func__, sha_alg_names[type], PTR_ERR(tfm));
+			ret = PTR_ERR(tfm);
+			goto release;
+		}
+
+		req = ahash_request_alloc(tfm, GFP_KERNEL);
+		if (!req) {
+			crypto_free_ahash(tfm);
+			ret = -ENOMEM;
+			goto release;
+		}
+
+		ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   tnvvse_crypto_complete, &ring->complete);
+
+		sha_ctx = crypto_ahash_ctx(tfm);
+		sha_ctx->node_id = ctx->node_id;
+		ring->sha_tfm[type] = tfm;
+		ring->sha_req[type] = req;
+	}
+
+	tfm = ring->sha_tfm[type];
+	req = ring->sha_req[type];
+
+	/* Shake128/Shake256 have variable digest size */
+	if (type == TEGRA_NVVSE_SHA_TYPE_SHAKE128 || type == TEGRA_NVVSE_SHA_TYPE_SHAKE256) {
+		if (sqe->dst_length == 0 ||
+				sqe->dst_length > NVVSE_MAX_ALLOCATED_SHA_RESULT_BUFF_SIZE) {
+			ret = -EINVAL;
+			goto release;
+		}
+		sha_ctx = crypto_ahash_ctx(tfm);
+		sha_ctx->digest_size = sqe->dst_length;
+		digest_size = sqe->dst_length;
+	} else {
+		digest_size = crypto_ahash_digestsize(tfm);
+		if (sqe->dst_length < digest_size) {
+			ret = -EINVAL;
+			goto release;
+		}
+	}
+
+	if (!tnvvse_crypto_ring_range_ok(ring, sqe->dst_offset, digest_size)) {
+		ret = -EINVAL;
+		goto release;
+	}
+
+	sg = tnvvse_crypto_ring_map(ring, sqe->src_offset, sqe->src_length);
+	if (!sg) {
+		ret = -EINVAL;
+		goto release;
+	}
+
+	/* The transform keeps its DMA buffers, init does not allocate here */
+	ret = wait_async_op(&ring->complete, crypto_ahash_init(req));
+	if (ret) {
+		pr_err("%s(): Failed to ahash_init for %s: %d\n",
+				__func__, sha_alg_names[type], ret);
+		goto release;
+	}
+
+	ahash_request_set_crypt(req, sg, ring->result, sqe->src_length);
+	ret = wait_async_op(&ring->complete, crypto_ahash_finup(req));
+	if (ret) {
+		pr_err("%s(): Failed to ahash_finup for %s: %d\n",
+				__func__, sha_alg_names[type], ret);
+		goto release;
+	}
+
+	memcpy(ring->data + sqe->dst_offset, ring->result, digest_size);
+
+release:
+	tnvvse_crypto_sha_release(ctx->node_id);
+	return ret;
+}
+
+static int tnvvse_crypto_ring_cmac(struct tnvvse_crypto_ctx *ctx,
+		const struct tegra_nvvse_ring_sqe *sqe, uint32_t *result)
+{
+	struct tnvvse_crypto_ring *ring = ctx->ring;
+	struct tegra_virtual_se_aes_cmac_context *cmac_ctx;
+	char key_as_keyslot[AES_KEYSLOT_NAME_SIZE] = {0,};
+	struct tnvvse_cmac_req_data priv_data;
+	struct crypto_ahash *tfm;
+	struct ahash_request *req;
+	struct scatterlist *sg;
+	int ret;
+
+	if (sqe->src_length > AES_CMAC_MAX_LEN)
+		return -EINVAL;
+
+	if (sqe->dst_length < TEGRA_NVVSE_AES_CMAC_LEN ||
+			!tnvvse_crypto_ring_range_ok(ring, sqe->dst_offset,
+						     TEGRA_NVVSE_AES_CMAC_LEN))
+		return -EINVAL;
+
+	if (!ring->cmac_tfm) {
+		tfm = crypto_alloc_ahash("cmac-vse(aes)", 0, 0);
+		if (IS_ERR(tfm)) {
+			pr_err("%s(): Failed to allocate ahash for cmac-vse(aes): %ld\n",
+					__func__, PTR_ERR(tfm));
+			return PTR_ERR(tfm);
+		}
+
+		req = ahash_request_alloc(tfm, GFP_KERNEL);
+		if (!req) {
+			crypto_free_ahash(tfm);
+			return -ENOMEM;
+		}
+
+		ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   tnvvse_crypto_complete, &ring->complete);
+
+		cmac_ctx = crypto_ahash_ctx(tfm);
+		cmac_ctx->node_id = ctx->node_id;
+		ring->cmac_tfm = tfm;
+		ring->cmac_req = req;
+	}
+
+	tfm = ring->cmac_tfm;
+	req = ring->cmac_req;
+
+	/* Setting a key may cost an IVC round trip, skip it for repeated keys */
+	if (!ring->cmac_key_valid || ring->cmac_key_length != sqe->key_length ||
+			memcmp(ring->cmac_key_slot, sqe->key_slot, KEYSLOT_SIZE_BYTES)) {
+		ring->cmac_key_valid = false;
+
+		ret = snprintf(key_as_keyslot, AES_KEYSLOT_NAME_SIZE, "NVSEAES ");
+		memcpy(key_as_keyslot + KEYSLOT_OFFSET_BYTES, sqe->key_slot, KEYSLOT_SIZE_BYTES);
+
+		crypto_ahash_clear_flags(tfm, ~0U);
+		ret = crypto_ahash_setkey(tfm, key_as_keyslot, sqe->key_length);
+		if (ret) {
+			pr_err("%s(): Failed to set keys for cmac-vse(aes): %d\n", __func__, ret);
+			return ret;
+		}
+
+		memcpy(ring->cmac_key_slot, sqe->key_slot, KEYSLOT_SIZE_BYTES);
+		ring->cmac_key_length = sqe->key_length;
+		ring->cmac_key_valid = true;
+	}
+
+	if (sqe->op == TEGRA_NVVSE_RING_OP_CMAC_SIGN)
+		priv_data.request_type = CMAC_SIGN;
+	else
+		priv_data.request_type = CMAC_VERIFY;
+	priv_data.result = 0;
+	req->priv = &priv_data;
+
+	sg = tnvvse_crypto_ring_map(ring, sqe->src_offset, sqe->src_length);
+	if (!sg)
+		return -EINVAL;
+
+	ret = wait_async_op(&ring->complete, crypto_ahash_init(req));
+	if (ret) {
+		pr_err("%s(): Failed to initialize ahash: %d\n", __func__, ret);
+		return ret;
+	}
+
+	if (sqe->op == TEGRA_NVVSE_RING_OP_CMAC_VERIFY)
+		memcpy(ring->result, ring->data + sqe->dst_offset, TEGRA_NVVSE_AES_CMAC_LEN);
+
+	ahash_request_set_crypt(req, sg, ring->result, sqe->src_length);
+	ret = wait_async_op(&ring->complete, crypto_ahash_finup(req));
+	if (ret) {
+		pr_err("%s(): Failed to ahash_finup: %d\n", __func__, ret);
+		return ret;
+	}
+
+	if (sqe->op == TEGRA_NVVSE_RING_OP_CMAC_SIGN)
+		memcpy(ring->data + sqe->dst_offset, ring->result, TEGRA_NVVSE_AES_CMAC_LEN);
+	else
+		*result = priv_data.result;
+
+	return 0;
+}
+
+static int tnvvse_crypto_ring_do_op(struct tnvvse_crypto_ctx *ctx,
+		const struct tegra_nvvse_ring_sqe *sqe, uint32_t *result)
+{
+	if (!tnvvse_crypto_ring_range_ok(ctx->ring, sqe->src_offset, sqe->src_length))
+		return -EINVAL;
+
+	switch (sqe->op) {
+	case TEGRA_NVVSE_RING_OP_SHA:
+		return tnvvse_crypto_ring_sha(ctx, sqe);
+	case TEGRA_NVVSE_RING_OP_CMAC_SIGN:
+	case TEGRA_NVVSE_RING_OP_CMAC_VERIFY:
+		return tnvvse_crypto_ring_cmac(ctx, sqe, result);
+	default:
+		return -EINVAL;
+	}
+}
+
+static int tnvvse_crypto_ring_enter(struct tnvvse_crypto_ctx *ctx,
+		struct tegra_nvvse_ring_enter_ctl *enter_ctl)
+{
+	struct tnvvse_crypto_ring *ring = ctx->ring;
+	struct tegra_nvvse_ring_sqe sqe;
+	struct tegra_nvvse_ring_cqe *cqe;
+	uint32_t mask, sq_tail, cq_head, result;
+	int status;
+
+	enter_ctl->submitted = 0;
+
+	if (!ring) {
+		pr_err("%s(): ring not set up\n", __func__);
+		return -ENODEV;
+	}
+
+	mask = ring->entries - 1;
+	sq_tail = smp_load_acquire(&ring->hdr->sq_tail);
+	if (sq_tail - ring->sq_head > ring->entries) {
+		pr_err("%s(): invalid sq_tail %u\n", __func__, sq_tail);
+		return -EINVAL;
+	}
+
+	while (enter_ctl->submitted < enter_ctl->to_submit && ring->sq_head != sq_tail) {
+		cq_head = smp_load_acquire(&ring->hdr->cq_head);
+		if (ring->cq_tail - cq_head >= ring->entries)
+			break;
+
+		if (fatal_signal_pending(current))
+			break;
+
+		/* Snapshot the entry so userspace cannot change it under us */
+		memcpy(&sqe, &ring->sqes[ring->sq_head & mask], sizeof(sqe));
+
+		result = 0;
+		status = tnvvse_crypto_ring_do_op(ctx, &sqe, &result);
+
+		cqe = &ring->cqes[ring->cq_tail & mask];
+		cqe->user_data = sqe.user_data;
+		cqe->status = status;
+		cqe->result = result;
+
+		ring->sq_head++;
+		ring->cq_tail++;
+		smp_store_release(&ring->hdr->sq_head, ring->sq_head);
+		smp_store_release(&ring->hdr->cq_tail, ring->cq_tail);
+
+		enter_ctl->submitted++;
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int tnvvse_crypto_dev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct tnvvse_crypto_ctx *ctx = filp->private_data;
+	int ret;
+
+	if (!ctx)
+		return -EPERM;
+
+	mutex_lock(&ctx->lock);
+
+	if (!ctx->ring) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > ctx->ring->size) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = remap_vmalloc_range(vma, ctx->ring->base, 0);
+
+out:
+	mutex_unlock(&ctx->lock);
+
+	return ret;
+}
+
 static int tnvvse_crypto_dev_open(struct inode *inode, struct file *filp)
 {
 	struct tnvvse_crypto_ctx *ctx;
@@ -1861,6 +2358,8 @@ static int tnvvse_crypto_dev_release(struct inode *inode, struct file *filp)
 	struct tnvvse_crypto_ctx *ctx = filp->private_data;
 	int ret = 0;
 
+	if (ctx->ring)
+		tnvvse_crypto_ring_free(ctx->ring);
 	mutex_destroy(&ctx->lock);
 	kfree(ctx->sha_result);
 	kfree(ctx->rng_buff);
@@ -1888,6 +2387,8 @@ static long tnvvse_crypto_dev_ioctl(struct file *filp,
 	struct tegra_nvvse_aes_gmac_init_ctl *aes_gmac_init_ctl;
 	struct tegra_nvvse_aes_gmac_sign_verify_ctl *aes_gmac_sign_verify_ctl;
 	struct tegra_nvvse_tsec_get_keyload_status *tsec_keyload_status;
+	struct tegra_nvvse_ring_setup_ctl ring_setup_ctl;
+	struct tegra_nvvse_ring_enter_ctl ring_enter_ctl;
 	int ret = 0;
 
 	/*
@@ -2193,6 +2694,40 @@ static long tnvvse_crypto_dev_ioctl(struct file *filp,
 		kfree(tsec_keyload_status);
 		break;
 
+	case NVVSE_IOCTL_CMDID_RING_SETUP:
+		ret = copy_from_user(&ring_setup_ctl, (void __user *)arg, sizeof(ring_setup_ctl));
+		if (ret) {
+			pr_err("%s(): Failed to copy_from_user ring_setup_ctl:%d\n", __func__, ret);
+			goto out;
+		}
+
+		ret = tnvvse_crypto_ring_setup(ctx, &ring_setup_ctl);
+		if (ret)
+			goto out;
+
+		ret = copy_to_user((void __user *)arg, &ring_setup_ctl, sizeof(ring_setup_ctl));
+		if (ret)
+			pr_err("%s(): Failed to copy_to_user ring_setup_ctl:%d\n", __func__, ret);
+
+		break;
+
+	case NVVSE_IOCTL_CMDID_RING_ENTER:
+		ret = copy_from_user(&ring_enter_ctl, (void __user *)arg, sizeof(ring_enter_ctl));
+		if (ret) {
+			pr_err("%s(): Failed to copy_from_user ring_enter_ctl:%d\n", __func__, ret);
+			goto out;
+		}
+
+		ret = tnvvse_crypto_ring_enter(ctx, &ring_enter_ctl);
+		if (ret)
+			goto out;
+
+		ret = copy_to_user((void __user *)arg, &ring_enter_ctl, sizeof(ring_enter_ctl));
+		if (ret)
+			pr_err("%s(): Failed to copy_to_user ring_enter_ctl:%d\n", __func__, ret);
+
+		break;
+
 	default:
 		pr_err("%s(): invalid ioctl code(%d[0x%08x])", __func__, ioctl_num, ioctl_num);
 		ret = -EINVAL;
@@ -2210,6 +2745,7 @@ static const struct file_operations tnvvse_crypto_fops = {
 	.open			= tnvvse_crypto_dev_open,
 	.release		= tnvvse_crypto_dev_release,
 	.unlocked_ioctl		= tnvvse_crypto_dev_ioctl,
+	.mmap			= tnvvse_crypto_dev_mmap,
 };
 
 static int __init tnvvse_crypto_device_init(void)
@@ -2222,6 +2758,7 @@ static int __init tnvvse_crypto_device_init(void)
 	tnvvse_crypto_get_ivc_db(&ivc_database);
 
 	for (cnt = 0; cnt < MAX_NUMBER_MISC_DEVICES; cnt++) {
+		mutex_init(&nvvse_devnode[cnt].sha_lock);
 
 		/* Dynamic initialisation of misc device */
 		misc = kzalloc(sizeof(struct miscdevice), GFP_KERNEL);
@@ -37,11 +37,16 @@ struct tegra_aes_ctx {
 
 struct tegra_aes_reqctx {
 	struct tegra_se_datbuf datbuf;
+	struct tegra_se_slot *slot;
+	dma_addr_t dst_addr;
+	bool datbuf_allocated;
+	bool direct;
 	bool encrypt;
 	u32 config;
 	u32 crypto_config;
 	u32 len;
 	u32 *iv;
+	u8 last_blk[AES_BLOCK_SIZE];
 };
 
 struct tegra_aead_ctx {
@@ -113,8 +118,12 @@ static void tegra_cbc_iv_copyback(struct skcipher_request *req, struct tegra_aes
 
 	offset = req->cryptlen - ctx->ivsize;
 
-	if (rctx->encrypt)
+	if (rctx->encrypt && rctx->direct)
+		scatterwalk_map_and_copy(req->iv, req->dst, offset, ctx->ivsize, 0);
+	else if (rctx->encrypt)
 		memcpy(req->iv, rctx->datbuf.buf + offset, ctx->ivsize);
+	else if (rctx->direct)
+		memcpy(req->iv, rctx->last_blk, ctx->ivsize);
 	else
 		scatterwalk_map_and_copy(req->iv, req->src, offset, ctx->ivsize, 0);
 }
@@ -210,10 +219,10 @@ static int tegra234_aes_cfg(u32 alg, bool encrypt)
 	return -EINVAL;
 }
 
-static unsigned int tegra_aes_prep_cmd(struct tegra_se *se, struct tegra_aes_reqctx *rctx)
+static unsigned int tegra_aes_prep_cmd(struct tegra_se *se, u32 *cpuvaddr,
+				       struct tegra_aes_reqctx *rctx)
 {
 	unsigned int data_count, res_bits, i = 0, j;
-	u32 *cpuvaddr = se->cmdbuf->addr;
 	dma_addr_t addr = rctx->datbuf.addr;
 
 	data_count = rctx->len / AES_BLOCK_SIZE;
@@ -246,8 +255,8 @@ static unsigned int tegra_aes_prep_cmd(struct tegra_se *se, struct tegra_aes_req
 	cpuvaddr[i++] = SE_ADDR_HI_MSB(upper_32_bits(addr)) | SE_ADDR_HI_SZ(rctx->len);
 
 	/* Destination address setting */
-	cpuvaddr[i++] = lower_32_bits(addr);
-	cpuvaddr[i++] = SE_ADDR_HI_MSB(upper_32_bits(addr)) |
+	cpuvaddr[i++] = lower_32_bits(rctx->dst_addr);
+	cpuvaddr[i++] = SE_ADDR_HI_MSB(upper_32_bits(rctx->dst_addr)) |
 			SE_ADDR_HI_SZ(rctx->len);
 
 	cpuvaddr[i++] = se_host1x_opcode_nonincr(se->hw->regs->op, 1);
@@ -263,24 +272,97 @@ static unsigned int tegra_aes_prep_cmd(struct tegra_se *se, struct tegra_aes_req
 	return i;
 }
 
+/*
+ * Let the engine access the request's buffers directly if each of them is a
+ * single, block aligned segment covering the whole request, instead of
+ * bouncing the data.
+ */
+static bool tegra_aes_map_direct(struct tegra_se *se, struct skcipher_request *req,
+				 struct tegra_aes_reqctx *rctx)
+{
+	if (rctx->len != req->cryptlen)
+		return false;
+
+	if (req->src->length < req->cryptlen || req->dst->length < req->cryptlen)
+		return false;
+
+	if (!IS_ALIGNED(req->src->offset | req->dst->offset, AES_BLOCK_SIZE))
+		return false;
+
+	if (req->src == req->dst) {
+		if (!dma_map_sg(se->dev, req->src, 1, DMA_BIDIRECTIONAL))
+			return false;
+	} else {
+		if (!dma_map_sg(se->dev, req->src, 1, DMA_TO_DEVICE))
+			return false;
+
+		if (!dma_map_sg(se->dev, req->dst, 1, DMA_FROM_DEVICE)) {
+			dma_unmap_sg(se->dev, req->src, 1, DMA_TO_DEVICE);
+			return false;
+		}
+	}
+
+	rctx->datbuf.addr = sg_dma_address(req->src);
+	rctx->dst_addr = sg_dma_address(req->dst);
+
+	return true;
+}
+
+static void tegra_aes_unmap_direct(struct tegra_se *se, struct skcipher_request *req)
+{
+	if (req->src == req->dst) {
+		dma_unmap_sg(se->dev, req->src, 1, DMA_BIDIRECTIONAL);
+	} else {
+		dma_unmap_sg(se->dev, req->src, 1, DMA_TO_DEVICE);
+		dma_unmap_sg(se->dev, req->dst, 1, DMA_FROM_DEVICE);
+	}
+}
+
+static void tegra_aes_complete(struct tegra_se_slot *slot, int err)
+{
+	struct skcipher_request *req = slot->data;
+	struct tegra_aes_ctx *ctx = crypto_skcipher_ctx(crypto_skcipher_reqtfm(req));
+	struct tegra_aes_reqctx *rctx = skcipher_request_ctx(req);
+	struct tegra_se *se = ctx->se;
+
+	if (rctx->direct)
+		tegra_aes_unmap_direct(se, req);
+
+	/* Copy the result */
+	tegra_aes_update_iv(req, ctx);
+	if (!rctx->direct)
+		scatterwalk_map_and_copy(rctx->datbuf.buf, req->dst, 0, req->cryptlen, 1);
+
+	/* Free the buffer */
+	if (rctx->datbuf_allocated)
+		dma_free_coherent(se->dev, rctx->datbuf.size,
+				  rctx->datbuf.buf, rctx->datbuf.addr);
+
+	tegra_se_slot_put(slot);
+
+	crypto_finalize_skcipher_request(se->engine, req, err);
+}
+
 static int tegra_aes_do_one_req(struct crypto_engine *engine, void *areq)
 {
 	struct skcipher_request *req = container_of(areq, struct skcipher_request, base);
 	struct tegra_aes_ctx *ctx = crypto_skcipher_ctx(crypto_skcipher_reqtfm(req));
 	struct tegra_aes_reqctx *rctx = skcipher_request_ctx(req);
 	struct tegra_se *se = ctx->se;
+	struct tegra_se_slot *slot;
 	unsigned int cmdlen;
 	int ret;
 
-	/* Set buffer size as a multiple of AES_BLOCK_SIZE*/
-	rctx->datbuf.size = ((req->cryptlen / AES_BLOCK_SIZE) + 1) * AES_BLOCK_SIZE;
-	rctx->datbuf.buf = dma_alloc_coherent(se->dev, rctx->datbuf.size,
-					      &rctx->datbuf.addr, GFP_KERNEL);
-	if (!rctx->datbuf.buf)
-		return -ENOMEM;
+	/*
+	 * Wait for a free slot rather than failing with -ENOSPC, which would
+	 * make the engine spin on requeueing this request.
+	 */
+	wait_event(se->slots_wq, (slot = tegra_se_slot_get(se)) != NULL);
 
+	rctx->slot = slot;
 	rctx->iv = (u32 *)req->iv;
 	rctx->len = req->cryptlen;
+	rctx->datbuf_allocated = false;
 
 	/* Pad input to AES Block size */
 	if (ctx->alg != SE_ALG_XTS) {
@@ -288,21 +370,44 @@ static int tegra_aes_do_one_req(struct crypto_engine *engine, void *areq)
 			rctx->len += AES_BLOCK_SIZE - (rctx->len % AES_BLOCK_SIZE);
 	}
 
-	scatterwalk_map_and_copy(rctx->datbuf.buf, req->src, 0, req->cryptlen, 0);
+	rctx->direct = tegra_aes_map_direct(se, req, rctx);
+	if (rctx->direct) {
+		/* in-place decryption overwrites the next IV */
+		if (ctx->alg == SE_ALG_CBC && !rctx->encrypt)
+			scatterwalk_map_and_copy(rctx->last_blk, req->src,
+						 req->cryptlen - ctx->ivsize,
+						 ctx->ivsize, 0);
+	} else {
+		/* Set buffer size as a multiple of AES_BLOCK_SIZE*/
+		rctx->datbuf.size = ((req->cryptlen / AES_BLOCK_SIZE) + 1) * AES_BLOCK_SIZE;
+		if (rctx->datbuf.size <= slot->datbuf.size) {
+			rctx->datbuf.buf = slot->datbuf.buf;
+			rctx->datbuf.addr = slot->datbuf.addr;
+		} else {
+			rctx->datbuf.buf = dma_alloc_coherent(se->dev, rctx->datbuf.size,
+							      &rctx->datbuf.addr, GFP_KERNEL);
+			if (!rctx->datbuf.buf) {
+				tegra_se_slot_put(slot);
+				return -ENOMEM;
+			}
+
+			rctx->datbuf_allocated = true;
+		}
 
-	/* Prepare the command and submit for execution */
-	cmdlen = tegra_aes_prep_cmd(se, rctx);
-	ret = tegra_se_host1x_submit(se, cmdlen);
+		rctx->dst_addr = rctx->datbuf.addr;
 
-	/* Copy the result */
-	tegra_aes_update_iv(req, ctx);
-	scatterwalk_map_and_copy(rctx->datbuf.buf, req->dst, 0, req->cryptlen, 1);
+		scatterwalk_map_and_copy(rctx->datbuf.buf, req->src, 0, req->cryptlen, 0);
+	}
 
-	/* Free the buffer */
-	dma_free_coherent(ctx->se->dev, rctx->datbuf.size,
-			  rctx->datbuf.buf, rctx->datbuf.addr);
+	/* Prepare the command and submit for execution */
+	cmdlen = tegra_aes_prep_cmd(se, slot->cmdbuf->addr, rctx);
+
+	slot->complete = tegra_aes_complete;
+	slot->data = req;
 
-	crypto_finalize_skcipher_request(se->engine, req, ret);
+	ret = tegra_se_host1x_submit_async(slot, cmdlen);
+	if (ret)
+		tegra_aes_complete(slot, ret);
 
 	return 0;
 }
@@ -1965,6 +2070,10 @@ int tegra_init_aes(struct tegra_se *se)
 
 	se->manifest = tegra_aes_kac_manifest;
 
+	ret = tegra_se_slots_alloc(se, SE_NR_SLOTS, SE_SLOT_BUFLEN);
+	if (ret)
+		return ret;
+
 	for (i = 0; i < ARRAY_SIZE(tegra_aes_algs); i++) {
 		sk_alg = &tegra_aes_algs[i].alg.skcipher;
 		tegra_aes_algs[i].se_dev = se;
@@ -2014,6 +2123,8 @@ err_aes:
 	for (--i; i >= 0; i--)
 		CRYPTO_UNREGISTER(skcipher, &tegra_aes_algs[i].alg.skcipher);
 
+	tegra_se_slots_free(se);
+
 	return ret;
 }
 
@@ -2028,6 +2139,10 @@ int tegra_init_aes(struct tegra_se *se)
 
 	se->manifest = tegra_aes_kac_manifest;
 
+	ret = tegra_se_slots_alloc(se, SE_NR_SLOTS, SE_SLOT_BUFLEN);
+	if (ret)
+		return ret;
+
 	for (i = 0; i < ARRAY_SIZE(tegra_aes_algs); i++) {
 		sk_alg = &tegra_aes_algs[i].alg.skcipher;
 		tegra_aes_algs[i].se_dev = se;
@@ -2077,6 +2192,8 @@ err_aes:
 	for (--i; i >= 0; i--)
 		CRYPTO_UNREGISTER(skcipher, &tegra_aes_algs[i].alg.skcipher);
 
+	tegra_se_slots_free(se);
+
 	return ret;
 }
 #endif
@@ -2094,4 +2211,5 @@ void tegra_deinit_aes(struct tegra_se *se)
 	for (i = 0; i < ARRAY_SIZE(tegra_cmac_algs); i++)
 		CRYPTO_UNREGISTER(ahash, &tegra_cmac_algs[i].alg.ahash);
 
+	tegra_se_slots_free(se);
 }
@@ -5,6 +5,7 @@
  */
 
 #include <linux/clk.h>
+#include <linux/dma-fence.h>
 #include <linux/dma-mapping.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
@@ -14,6 +15,8 @@
 
 #include "tegra-se.h"
 
+#define SE_ENGINE_QLEN		64
+
 static struct host1x_bo *tegra_se_cmdbuf_get(struct host1x_bo *host_bo)
 {
 	struct tegra_se_cmdbuf *cmdbuf = container_of(host_bo, struct tegra_se_cmdbuf, bo);
@@ -129,8 +132,10 @@ static struct tegra_se_cmdbuf *tegra_se_host1x_bo_alloc(struct tegra_se *se, ssi
 
 	cmdbuf->addr = dma_alloc_attrs(dev, size, &cmdbuf->iova,
 				       GFP_KERNEL, 0);
-	if (!cmdbuf->addr)
+	if (!cmdbuf->addr) {
+		kfree(cmdbuf);
 		return NULL;
+	}
 
 	cmdbuf->size = size;
 	cmdbuf->dev  = dev;
@@ -194,6 +199,194 @@ job_put:
 	return ret;
 }
 
+static void tegra_se_slot_work(struct work_struct *work)
+{
+	struct tegra_se_slot *slot = container_of(work, struct tegra_se_slot, work);
+	int err = slot->fence->error;
+
+	dma_fence_put(slot->fence);
+	slot->fence = NULL;
+
+	host1x_job_put(slot->job);
+	slot->job = NULL;
+
+	slot->complete(slot, err);
+}
+
+static void tegra_se_slot_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct tegra_se_slot *slot = container_of(cb, struct tegra_se_slot, cb);
+
+	/* The job can't be released from the fence signalling context */
+	queue_work(system_highpri_wq, &slot->work);
+}
+
+/*
+ * Submit the command buffer of @slot without waiting for it to complete. On
+ * success, @slot->complete is called once the engine is done with the job.
+ * On failure nothing has been queued and the caller still owns the slot.
+ */
+int tegra_se_host1x_submit_async(struct tegra_se_slot *slot, u32 size)
+{
+	struct tegra_se *se = slot->se;
+	struct host1x_job *job;
+	struct dma_fence *fence;
+	int ret;
+
+	job = host1x_job_alloc(se->channel, 1, 0, true);
+	if (!job) {
+		dev_err(se->dev, "failed to allocate host1x job\n");
+		return -ENOMEM;
+	}
+
+	job->syncpt = host1x_syncpt_get(se->syncpt);
+	job->syncpt_incrs = 1;
+	job->client = &se->client;
+	job->class = se->client.class;
+	job->serialize = true;
+	job->engine_fallback_streamid = se->stream_id;
+	job->engine_streamid_offset = SE_STREAM_ID;
+
+	slot->cmdbuf->words = size;
+
+	host1x_job_add_gather(job, &slot->cmdbuf->bo, size, 0);
+
+	ret = host1x_job_pin(job, se->dev);
+	if (ret) {
+		dev_err(se->dev, "failed to pin host1x job\n");
+		goto job_put;
+	}
+
+	ret = host1x_job_submit(job);
+	if (ret) {
+		dev_err(se->dev, "failed to submit host1x job\n");
+		goto job_unpin;
+	}
+
+	fence = host1x_fence_create(job->syncpt, job->syncpt_end, true);
+	if (IS_ERR(fence)) {
+		/* the job is already running, fall back to waiting for it */
+		ret = host1x_syncpt_wait(job->syncpt, job->syncpt_end,
+					 MAX_SCHEDULE_TIMEOUT, NULL);
+		host1x_job_put(job);
+		slot->complete(slot, ret);
+		return 0;
+	}
+
+	slot->job = job;
+	slot->fence = fence;
+
+	ret = dma_fence_add_callback(fence, &slot->cb, tegra_se_slot_fence_cb);
+	if (ret == -ENOENT)
+		queue_work(system_highpri_wq, &slot->work);
+
+	return 0;
+
+job_unpin:
+	host1x_job_unpin(job);
+job_put:
+	host1x_job_put(job);
+
+	return ret;
+}
+
+struct tegra_se_slot *tegra_se_slot_get(struct tegra_se *se)
+{
+	struct tegra_se_slot *slot = NULL;
+	unsigned long bit;
+
+	spin_lock(&se->slots_lock);
+
+	bit = find_first_zero_bit(&se->slots_busy, se->nr_slots);
+	if (bit < se->nr_slots) {
+		set_bit(bit, &se->slots_busy);
+		slot = &se->slots[bit];
+	}
+
+	spin_unlock(&se->slots_lock);
+
+	return slot;
+}
+
+void tegra_se_slot_put(struct tegra_se_slot *slot)
+{
+	struct tegra_se *se = slot->se;
+
+	spin_lock(&se->slots_lock);
+	clear_bit(slot->index, &se->slots_busy);
+	spin_unlock(&se->slots_lock);
+
+	wake_up(&se->slots_wq);
+}
+
+int tegra_se_slots_alloc(struct tegra_se *se, unsigned int nr, ssize_t buflen)
+{
+	struct device *dev = se->dev;
+	unsigned int i;
+
+	if (WARN_ON(nr > BITS_PER_LONG))
+		return -EINVAL;
+
+	spin_lock_init(&se->slots_lock);
+	init_waitqueue_head(&se->slots_wq);
+	se->slots_busy = 0;
+
+	se->slots = kcalloc(nr, sizeof(*se->slots), GFP_KERNEL);
+	if (!se->slots)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i++) {
+		struct tegra_se_slot *slot = &se->slots[i];
+
+		slot->se = se;
+		slot->index = i;
+		INIT_WORK(&slot->work, tegra_se_slot_work);
+
+		slot->cmdbuf = tegra_se_host1x_bo_alloc(se, SZ_4K);
+		if (!slot->cmdbuf)
+			goto free;
+
+		slot->datbuf.size = buflen;
+		slot->datbuf.buf = dma_alloc_coherent(dev, buflen, &slot->datbuf.addr,
+						      GFP_KERNEL);
+		if (!slot->datbuf.buf) {
+			tegra_se_cmdbuf_put(&slot->cmdbuf->bo);
+			goto free;
+		}
+
+		se->nr_slots++;
+	}
+
+	return 0;
+
+free:
+	tegra_se_slots_free(se);
+	return -ENOMEM;
+}
+
+void tegra_se_slots_free(struct tegra_se *se)
+{
+	unsigned int i;
+
+	if (!se->slots)
+		return;
+
+	/* wait for the requests still in flight */
+	wait_event(se->slots_wq, READ_ONCE(se->slots_busy) == 0);
+
+	for (i = 0; i < se->nr_slots; i++) {
+		struct tegra_se_slot *slot = &se->slots[i];
+
+		dma_free_coherent(se->dev, slot->datbuf.size, slot->datbuf.buf,
+				  slot->datbuf.addr);
+		tegra_se_cmdbuf_put(&slot->cmdbuf->bo);
+	}
+
+	kfree(se->slots);
+	se->slots = NULL;
+	se->nr_slots = 0;
+}
+
 static int tegra_se_client_init(struct host1x_client *client)
 {
 	struct tegra_se *se = container_of(client, struct tegra_se, client);
@@ -300,7 +493,12 @@ static int tegra_se_probe(struct platform_device *pdev)
 
 	writel(se->stream_id, se->base + SE_STREAM_ID);
 
-	se->engine = crypto_engine_alloc_init(dev, 0);
+	/*
+	 * Retry support lets the engine hand out the next request while earlier
+	 * ones are still being processed asynchronously.
+	 */
+	se->engine = crypto_engine_alloc_init_and_set(dev, true, NULL, false,
+						      SE_ENGINE_QLEN);
 	if (!se->engine)
 		return dev_err_probe(dev, -ENOMEM, "failed to init crypto engine\n");
 
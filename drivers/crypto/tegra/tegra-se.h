@@ -10,8 +10,12 @@
 #include <nvidia/conftest.h>
 
 #include <linux/bitfield.h>
+#include <linux/dma-fence.h>
 #include <linux/iommu.h>
 #include <linux/host1x-next.h>
+#include <linux/sizes.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 #include <crypto/aead.h>
 #include <crypto/engine.h>
 #include <crypto/hash.h>
@@ -344,6 +348,10 @@
 #define SE_MAX_MEM_ALLOC			SZ_4M
 #define SE_SHA_BUFLEN				0x2000
 
+/* Command and bounce buffer slots for asynchronous submission */
+#define SE_NR_SLOTS				8
+#define SE_SLOT_BUFLEN				SZ_64K
+
 #define SHA_FIRST	BIT(0)
 #define SHA_UPDATE	BIT(1)
 #define SHA_FINAL	BIT(2)
@@ -443,6 +451,11 @@ struct tegra_se {
 	struct host1x_client client;
 	struct host1x_channel *channel;
 	struct tegra_se_cmdbuf *cmdbuf;
+	struct tegra_se_slot *slots;
+	unsigned int nr_slots;
+	unsigned long slots_busy;
+	spinlock_t slots_lock;
+	wait_queue_head_t slots_wq;
 	struct crypto_engine *engine;
 	struct host1x_syncpt *syncpt;
 	struct device *dev;
@@ -470,6 +483,24 @@ struct tegra_se_datbuf {
 	ssize_t size;
 };
 
+/*
+ * A preallocated command buffer and bounce buffer, used to have several
+ * requests in flight on the engine at the same time. @complete is called
+ * from process context once the job's syncpoint fence has signalled.
+ */
+struct tegra_se_slot {
+	struct tegra_se *se;
+	struct tegra_se_cmdbuf *cmdbuf;
+	struct tegra_se_datbuf datbuf;
+	struct host1x_job *job;
+	struct dma_fence *fence;
+	struct dma_fence_cb cb;
+	struct work_struct work;
+	void (*complete)(struct tegra_se_slot *slot, int err);
+	void *data;
+	unsigned int index;
+};
+
 static inline int se_algname_to_algid(const char *name)
 {
 	if (!strcmp(name, "cbc(aes)"))
@@ -526,6 +557,11 @@ int tegra_key_submit(struct tegra_se *se, const u8 *key,
 		     u32 keylen, u32 alg, u32 *keyid);
 void tegra_key_invalidate(struct tegra_se *se, u32 keyid, u32 alg);
 int tegra_se_host1x_submit(struct tegra_se *se, u32 size);
+int tegra_se_slots_alloc(struct tegra_se *se, unsigned int nr, ssize_t buflen);
+void tegra_se_slots_free(struct tegra_se *se);
+struct tegra_se_slot *tegra_se_slot_get(struct tegra_se *se);
+void tegra_se_slot_put(struct tegra_se_slot *slot);
+int tegra_se_host1x_submit_async(struct tegra_se_slot *slot, u32 size);
 
 /* HOST1x OPCODES */
 static inline u32 host1x_opcode_setpayload(unsigned int payload)
@@ -81,6 +81,11 @@ struct tegra_drm_context {
 	/* Only used by new UAPI. */
 	struct xarray mappings;
 	struct host1x_memory_context *memory_context;
+
+	/* Submit state recycled between jobs, see submit.c */
+	struct tegra_drm_gather_pool *gather_pool;
+	void *submit_bufs;
+	void *submit_cmds;
 };
 
 struct tegra_drm_client_ops {
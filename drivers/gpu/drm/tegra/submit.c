@@ -15,6 +15,7 @@
 #include <linux/pm_runtime.h>
 #include <linux/scatterlist.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/sync_file.h>
 
 #include <drm/drm_drv.h>
@@ -34,6 +35,27 @@
 		"%s: job submission failed: " fmt "\n", \
 		current->comm, ##__VA_ARGS__)
 
+/* Largest bufs/cmds array copied in from userspace */
+#define SUBMIT_ARRAY_MAX_SIZE		0x4000
+
+/*
+ * Gather BOs of up to 2^(PAGE_SHIFT + GATHER_POOL_BUCKETS - 1) bytes are
+ * recycled per context, keeping at most GATHER_POOL_MAX_FREE idle BOs in
+ * each power-of-two size bucket. Larger gathers are allocated per submit.
+ */
+#define GATHER_POOL_BUCKETS		5
+#define GATHER_POOL_MAX_FREE		8
+
+struct tegra_drm_gather_pool {
+	struct kref ref;
+	struct device *dev;
+
+	spinlock_t lock;
+	struct list_head free[GATHER_POOL_BUCKETS];
+	unsigned int num_free[GATHER_POOL_BUCKETS];
+	bool closed;
+};
+
 struct gather_bo {
 	struct host1x_bo base;
 
@@ -43,8 +65,114 @@ struct gather_bo {
 	u32 *gather_data;
 	dma_addr_t gather_data_dma;
 	size_t gather_data_words;
+
+	/* allocation backing gather_data, may exceed gather_data_words */
+	size_t size;
+	struct tegra_drm_gather_pool *pool;
+	unsigned int bucket;
+	struct list_head pool_node;
 };
 
+static void gather_pool_release(struct kref *ref)
+{
+	struct tegra_drm_gather_pool *pool =
+		container_of(ref, struct tegra_drm_gather_pool, ref);
+
+	kfree(pool);
+}
+
+static void gather_bo_free(struct gather_bo *bo)
+{
+	dma_free_attrs(bo->dev, bo->size, bo->gather_data, bo->gather_data_dma, 0);
+
+	if (bo->pool)
+		kref_put(&bo->pool->ref, gather_pool_release);
+
+	kfree(bo);
+}
+
+static bool gather_pool_recycle(struct gather_bo *bo)
+{
+	struct tegra_drm_gather_pool *pool = bo->pool;
+	bool recycled = false;
+
+	spin_lock(&pool->lock);
+
+	if (!pool->closed && pool->num_free[bo->bucket] < GATHER_POOL_MAX_FREE) {
+		list_add(&bo->pool_node, &pool->free[bo->bucket]);
+		pool->num_free[bo->bucket]++;
+		recycled = true;
+	}
+
+	spin_unlock(&pool->lock);
+
+	return recycled;
+}
+
+static struct gather_bo *gather_pool_get(struct tegra_drm_gather_pool *pool,
+					 unsigned int bucket)
+{
+	struct gather_bo *bo;
+
+	spin_lock(&pool->lock);
+
+	bo = list_first_entry_or_null(&pool->free[bucket], struct gather_bo, pool_node);
+	if (bo) {
+		list_del(&bo->pool_node);
+		pool->num_free[bucket]--;
+	}
+
+	spin_unlock(&pool->lock);
+
+	return bo;
+}
+
+void tegra_drm_gather_pool_close(struct tegra_drm_gather_pool *pool)
+{
+	struct gather_bo *bo, *tmp;
+	LIST_HEAD(idle);
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	spin_lock(&pool->lock);
+
+	pool->closed = true;
+
+	for (i = 0; i < GATHER_POOL_BUCKETS; i++) {
+		list_splice_init(&pool->free[i], &idle);
+		pool->num_free[i] = 0;
+	}
+
+	spin_unlock(&pool->lock);
+
+	list_for_each_entry_safe(bo, tmp, &idle, pool_node)
+		gather_bo_free(bo);
+
+	/* BOs still owned by jobs hold their own pool reference. */
+	kref_put(&pool->ref, gather_pool_release);
+}
+
+static struct tegra_drm_gather_pool *gather_pool_create(struct device *dev)
+{
+	struct tegra_drm_gather_pool *pool;
+	unsigned int i;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	kref_init(&pool->ref);
+	spin_lock_init(&pool->lock);
+	pool->dev = dev;
+
+	for (i = 0; i < GATHER_POOL_BUCKETS; i++)
+		INIT_LIST_HEAD(&pool->free[i]);
+
+	return pool;
+}
+
 static struct host1x_bo *gather_bo_get(struct host1x_bo *host_bo)
 {
 	struct gather_bo *bo = container_of(host_bo, struct gather_bo, base);
@@ -58,9 +186,10 @@ static void gather_bo_release(struct kref *ref)
 {
 	struct gather_bo *bo = container_of(ref, struct gather_bo, ref);
 
-	dma_free_attrs(bo->dev, bo->gather_data_words * 4, bo->gather_data, bo->gather_data_dma,
-		       0);
-	kfree(bo);
+	if (bo->pool && gather_pool_recycle(bo))
+		return;
+
+	gather_bo_free(bo);
 }
 
 static void gather_bo_put(struct host1x_bo *host_bo)
@@ -164,27 +293,84 @@ tegra_drm_mapping_get(struct tegra_drm_context *context, u32 id)
 	return mapping;
 }
 
-static void *alloc_copy_user_array(void __user *from, size_t count, size_t size)
+/*
+ * Copy a user array into a per-context scratch buffer that is allocated on
+ * first use and kept until the context is closed. Submits are serialized by
+ * the file lock, so the returned data stays valid until the ioctl returns.
+ */
+static void *copy_user_array(void **scratch, void __user *from, size_t count, size_t size)
 {
 	size_t copy_len;
-	void *data;
 
 	if (check_mul_overflow(count, size, &copy_len))
 		return ERR_PTR(-EINVAL);
 
-	if (copy_len > 0x4000)
+	if (copy_len > SUBMIT_ARRAY_MAX_SIZE)
 		return ERR_PTR(-E2BIG);
 
-	data = kvmalloc(copy_len, GFP_KERNEL);
-	if (!data)
-		return ERR_PTR(-ENOMEM);
+	if (!*scratch) {
+		*scratch = kvmalloc(SUBMIT_ARRAY_MAX_SIZE, GFP_KERNEL);
+		if (!*scratch)
+			return ERR_PTR(-ENOMEM);
+	}
 
-	if (copy_from_user(data, from, copy_len)) {
-		kvfree(data);
+	if (copy_from_user(*scratch, from, copy_len))
 		return ERR_PTR(-EFAULT);
+
+	return *scratch;
+}
+
+static struct gather_bo *gather_bo_alloc(struct device *dev, struct tegra_drm_context *context,
+					 size_t copy_len)
+{
+	struct tegra_drm_gather_pool *pool = context->gather_pool;
+	unsigned int order = get_order(copy_len);
+	struct gather_bo *bo;
+	size_t size;
+
+	if (order < GATHER_POOL_BUCKETS) {
+		if (!pool) {
+			pool = gather_pool_create(dev);
+			context->gather_pool = pool;
+		}
+
+		if (pool) {
+			bo = gather_pool_get(pool, order);
+			if (bo) {
+				kref_init(&bo->ref);
+				return bo;
+			}
+		}
+
+		size = PAGE_SIZE << order;
+	} else {
+		pool = NULL;
+		size = copy_len;
+	}
+
+	bo = kzalloc(sizeof(*bo), GFP_KERNEL);
+	if (!bo)
+		return NULL;
+
+	host1x_bo_init(&bo->base, &gather_bo_ops);
+	kref_init(&bo->ref);
+	bo->dev = dev;
+	bo->size = size;
+
+	bo->gather_data = dma_alloc_attrs(dev, size, &bo->gather_data_dma,
+					  GFP_KERNEL | __GFP_NOWARN, 0);
+	if (!bo->gather_data) {
+		kfree(bo);
+		return NULL;
+	}
+
+	if (pool) {
+		kref_get(&pool->ref);
+		bo->pool = pool;
+		bo->bucket = order;
 	}
 
-	return data;
+	return bo;
 }
 
 static int submit_copy_gather_data(struct gather_bo **pbo, struct device *dev,
@@ -204,28 +390,15 @@ static int submit_copy_gather_data(struct gather_bo **pbo, struct device *dev,
 		return -EINVAL;
 	}
 
-	bo = kzalloc(sizeof(*bo), GFP_KERNEL);
+	bo = gather_bo_alloc(dev, context, copy_len);
 	if (!bo) {
-		SUBMIT_ERR(context, "failed to allocate memory for bo info");
-		return -ENOMEM;
-	}
-
-	host1x_bo_init(&bo->base, &gather_bo_ops);
-	kref_init(&bo->ref);
-	bo->dev = dev;
-
-	bo->gather_data = dma_alloc_attrs(dev, copy_len, &bo->gather_data_dma,
-					  GFP_KERNEL | __GFP_NOWARN, 0);
-	if (!bo->gather_data) {
 		SUBMIT_ERR(context, "failed to allocate memory for gather data");
-		kfree(bo);
 		return -ENOMEM;
 	}
 
 	if (copy_from_user(bo->gather_data, u64_to_user_ptr(args->gather_data_ptr), copy_len)) {
 		SUBMIT_ERR(context, "failed to copy gather data from userspace");
-		dma_free_attrs(dev, copy_len, bo->gather_data, bo->gather_data_dma, 0);
-		kfree(bo);
+		gather_bo_put(&bo->base);
 		return -EFAULT;
 	}
 
@@ -274,8 +447,8 @@ static int submit_process_bufs(struct tegra_drm_context *context, struct gather_
 	int err;
 	u32 i;
 
-	bufs = alloc_copy_user_array(u64_to_user_ptr(args->bufs_ptr), args->num_bufs,
-				     sizeof(*bufs));
+	bufs = copy_user_array(&context->submit_bufs, u64_to_user_ptr(args->bufs_ptr),
+			       args->num_bufs, sizeof(*bufs));
 	if (IS_ERR(bufs)) {
 		SUBMIT_ERR(context, "failed to copy bufs array from userspace");
 		return PTR_ERR(bufs);
@@ -330,8 +503,6 @@ drop_refs:
 	job_data->used_mappings = NULL;
 
 done:
-	kvfree(bufs);
-
 	return err;
 }
 
@@ -663,8 +834,8 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 		goto free_job_data;
 
 	/* Copy submit commands from userspace. */
-	cmds = alloc_copy_user_array(u64_to_user_ptr(args->cmds_ptr), args->num_cmds,
-				     sizeof(*cmds));
+	cmds = copy_user_array(&context->submit_cmds, u64_to_user_ptr(args->cmds_ptr),
+			       args->num_cmds, sizeof(*cmds));
 	if (IS_ERR(cmds)) {
 		SUBMIT_ERR(context, "failed to copy cmds array from userspace");
 		err = PTR_ERR(cmds);
@@ -675,7 +846,7 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 	job = submit_create_job(context, bo, args, job_data, &fpriv->syncpoints, cmds);
 	if (IS_ERR(job)) {
 		err = PTR_ERR(job);
-		goto free_cmds;
+		goto free_job_data;
 	}
 
 	/* Map gather data for Host1x. */
@@ -803,8 +974,6 @@ unpin_job:
 	host1x_job_unpin(job);
 put_job:
 	host1x_job_put(job);
-free_cmds:
-	kvfree(cmds);
 free_job_data:
 	if (job_data) {
 		if (job_data->timestamps.virt)
@@ -4,6 +4,8 @@
 #ifndef _TEGRA_DRM_UAPI_SUBMIT_H
 #define _TEGRA_DRM_UAPI_SUBMIT_H
 
+struct tegra_drm_gather_pool;
+
 struct tegra_drm_used_mapping {
 	struct tegra_drm_mapping *mapping;
 	u32 flags;
@@ -25,4 +27,6 @@ int tegra_drm_fw_validate(struct tegra_drm_client *client, u32 *data, u32 start,
 			  u32 words, struct tegra_drm_submit_data *submit,
 			  u32 *job_class);
 
+void tegra_drm_gather_pool_close(struct tegra_drm_gather_pool *pool);
+
 #endif
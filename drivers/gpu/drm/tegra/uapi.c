@@ -10,6 +10,7 @@
 #include <drm/drm_utils.h>
 
 #include "drm.h"
+#include "submit.h"
 #include "uapi.h"
 
 static void tegra_drm_mapping_release(struct kref *ref)
@@ -41,6 +42,10 @@ static void tegra_drm_channel_context_close(struct tegra_drm_context *context)
 
 	xa_destroy(&context->mappings);
 
+	tegra_drm_gather_pool_close(context->gather_pool);
+	kvfree(context->submit_bufs);
+	kvfree(context->submit_cmds);
+
 	host1x_channel_put(context->channel);
 
 	kfree(context);
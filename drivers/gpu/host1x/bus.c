@@ -916,26 +916,76 @@ unlock:
 }
 EXPORT_SYMBOL(host1x_client_resume);
 
-struct host1x_bo_mapping *host1x_bo_pin(struct device *dev, struct host1x_bo *bo,
-					enum dma_data_direction dir,
-					struct host1x_bo_cache *cache)
+static void __host1x_bo_unpin(struct kref *ref)
+{
+	struct host1x_bo_mapping *mapping = to_host1x_bo_mapping(ref);
+
+	/*
+	 * When the last reference of the mapping goes away, make sure to remove the mapping from
+	 * the cache.
+	 */
+	if (mapping->cache) {
+		list_del(&mapping->entry);
+		hash_del(&mapping->node);
+		mapping->cache->count--;
+	}
+
+	spin_lock(&mapping->bo->lock);
+	list_del(&mapping->list);
+	spin_unlock(&mapping->bo->lock);
+
+	mapping->bo->ops->unpin(mapping);
+}
+
+static struct host1x_bo_mapping *
+host1x_bo_cache_lookup(struct host1x_bo_cache *cache, struct host1x_bo *bo,
+		       enum dma_data_direction dir)
 {
 	struct host1x_bo_mapping *mapping;
 
-	if (cache) {
-		mutex_lock(&cache->lock);
+	hash_for_each_possible(cache->hash, mapping, node, (unsigned long)bo) {
+		if (mapping->bo == bo && mapping->direction == dir)
+			return mapping;
+	}
 
-		list_for_each_entry(mapping, &cache->mappings, entry) {
-			if (mapping->bo == bo && mapping->direction == dir) {
-				kref_get(&mapping->ref);
-				goto unlock;
-			}
+	return NULL;
+}
+
+/*
+ * Drop the cache's reference to the least recently used mappings that nobody else holds until
+ * the cache is back within its bounds. Mappings still in use are skipped.
+ */
+static void host1x_bo_cache_reclaim(struct host1x_bo_cache *cache)
+{
+	struct host1x_bo_mapping *mapping, *tmp;
+
+	list_for_each_entry_safe(mapping, tmp, &cache->mappings, entry) {
+		if (cache->count <= cache->max)
+			break;
+
+		if (kref_read(&mapping->ref) == 1)
+			kref_put(&mapping->ref, __host1x_bo_unpin);
+	}
+}
+
+static struct host1x_bo_mapping *__host1x_bo_pin(struct device *dev, struct host1x_bo *bo,
+						 enum dma_data_direction dir,
+						 struct host1x_bo_cache *cache)
+{
+	struct host1x_bo_mapping *mapping;
+
+	if (cache) {
+		mapping = host1x_bo_cache_lookup(cache, bo, dir);
+		if (mapping) {
+			kref_get(&mapping->ref);
+			list_move_tail(&mapping->entry, &cache->mappings);
+			return mapping;
 		}
 	}
 
 	mapping = bo->ops->pin(dev, bo, dir);
 	if (IS_ERR(mapping))
-		goto unlock;
+		return mapping;
 
 	spin_lock(&mapping->bo->lock);
 	list_add_tail(&mapping->list, &bo->mappings);
@@ -946,36 +996,81 @@ struct host1x_bo_mapping *host1x_bo_pin(struct device *dev, struct host1x_bo *bo
 		mapping->cache = cache;
 
 		list_add_tail(&mapping->entry, &cache->mappings);
+		hash_add(cache->hash, &mapping->node, (unsigned long)bo);
+		cache->count++;
 
 		/* bump reference count to track the copy in the cache */
 		kref_get(&mapping->ref);
 	}
 
-unlock:
+	return mapping;
+}
+
+struct host1x_bo_mapping *host1x_bo_pin(struct device *dev, struct host1x_bo *bo,
+					enum dma_data_direction dir,
+					struct host1x_bo_cache *cache)
+{
+	struct host1x_bo_mapping *mapping;
+
 	if (cache)
+		mutex_lock(&cache->lock);
+
+	mapping = __host1x_bo_pin(dev, bo, dir, cache);
+
+	if (cache) {
+		host1x_bo_cache_reclaim(cache);
 		mutex_unlock(&cache->lock);
+	}
 
 	return mapping;
 }
 EXPORT_SYMBOL(host1x_bo_pin);
 
-static void __host1x_bo_unpin(struct kref *ref)
+/**
+ * host1x_bo_pin_many() - pin a set of buffer objects
+ * @dev: device to map the buffer objects for
+ * @reqs: buffer objects and directions to pin, receives the mappings
+ * @count: number of entries in @reqs
+ * @cache: optional cache to look up and store the mappings
+ *
+ * Resolves all requests with a single acquisition of the cache lock. On failure, all mappings
+ * pinned so far are released again and all @reqs[i].map are NULL.
+ */
+int host1x_bo_pin_many(struct device *dev, struct host1x_bo_pin_req *reqs,
+		       unsigned int count, struct host1x_bo_cache *cache)
 {
-	struct host1x_bo_mapping *mapping = to_host1x_bo_mapping(ref);
+	struct host1x_bo_mapping *mapping;
+	unsigned int i;
+	int err = 0;
 
-	/*
-	 * When the last reference of the mapping goes away, make sure to remove the mapping from
-	 * the cache.
-	 */
-	if (mapping->cache)
-		list_del(&mapping->entry);
+	if (cache)
+		mutex_lock(&cache->lock);
 
-	spin_lock(&mapping->bo->lock);
-	list_del(&mapping->list);
-	spin_unlock(&mapping->bo->lock);
+	for (i = 0; i < count; i++) {
+		mapping = __host1x_bo_pin(dev, reqs[i].bo, reqs[i].direction, cache);
+		if (IS_ERR(mapping)) {
+			err = PTR_ERR(mapping);
+			break;
+		}
 
-	mapping->bo->ops->unpin(mapping);
+		reqs[i].map = mapping;
+	}
+
+	if (err) {
+		while (i--) {
+			kref_put(&reqs[i].map->ref, __host1x_bo_unpin);
+			reqs[i].map = NULL;
+		}
+	}
+
+	if (cache) {
+		host1x_bo_cache_reclaim(cache);
+		mutex_unlock(&cache->lock);
+	}
+
+	return err;
 }
+EXPORT_SYMBOL(host1x_bo_pin_many);
 
 void host1x_bo_unpin(struct host1x_bo_mapping *mapping)
 {
@@ -7,6 +7,9 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/dma-fence.h>
+#include <linux/host1x-next.h>
+#include <linux/mm.h>
 #include <linux/pm_runtime.h>
 #include <linux/seq_file.h>
 #include <linux/uaccess.h>
@@ -78,7 +81,7 @@ static int show_channel(struct host1x_channel *ch, void *data, bool show_fifo)
 static void show_syncpts(struct host1x *m, struct output *o, bool show_all)
 {
 	unsigned long irqflags;
-	struct list_head *pos;
+	struct rb_node *node;
 	unsigned int i;
 	int err;
 
@@ -94,7 +97,8 @@ static void show_syncpts(struct host1x *m, struct output *o, bool show_all)
 		unsigned int waiters = 0;
 
 		spin_lock_irqsave(&m->syncpt[i].fences.lock, irqflags);
-		list_for_each(pos, &m->syncpt[i].fences.list)
+		for (node = rb_first_cached(&m->syncpt[i].fences.root); node;
+		     node = rb_next(node))
 			waiters++;
 		spin_unlock_irqrestore(&m->syncpt[i].fences.lock, irqflags);
 
@@ -189,6 +193,83 @@ static const struct file_operations host1x_debug_fops = {
 	.release = single_release,
 };
 
+/*
+ * Interrupt path self-test: queue the given number of fences on a fresh syncpoint, with
+ * thresholds spread over a few increments and inserted out of order, then increment the
+ * syncpoint from the CPU and report the worst-case time spent in the syncpoint interrupt
+ * handler while they expire.
+ */
+#define HOST1X_FENCE_SELFTEST_INCRS	64
+#define HOST1X_FENCE_SELFTEST_MAX	65536
+
+static int host1x_debug_fence_selftest(void *data, u64 val)
+{
+	struct host1x *host = data;
+	struct dma_fence **fences;
+	struct host1x_syncpt *sp;
+	unsigned int i, num = val;
+	int err = 0;
+	u32 base;
+
+	if (!num || num > HOST1X_FENCE_SELFTEST_MAX)
+		return -EINVAL;
+
+	fences = kvcalloc(num, sizeof(*fences), GFP_KERNEL);
+	if (!fences)
+		return -ENOMEM;
+
+	sp = host1x_syncpt_alloc(host, HOST1X_SYNCPT_CLIENT_MANAGED, "fence-selftest");
+	if (!sp) {
+		err = -EBUSY;
+		goto free;
+	}
+
+	base = host1x_syncpt_read(sp);
+
+	for (i = 0; i < num; i++) {
+		u32 offset = (i * 37) % HOST1X_FENCE_SELFTEST_INCRS;
+
+		fences[i] = host1x_fence_create(sp, base + 1 + offset, false);
+		if (IS_ERR(fences[i])) {
+			err = PTR_ERR(fences[i]);
+			fences[i] = NULL;
+			goto put;
+		}
+
+		dma_fence_enable_sw_signaling(fences[i]);
+	}
+
+	WRITE_ONCE(host->intr_max_ns, 0);
+
+	for (i = 0; i < HOST1X_FENCE_SELFTEST_INCRS; i++)
+		host1x_syncpt_incr(sp);
+
+	for (i = 0; i < num; i++) {
+		if (dma_fence_wait_timeout(fences[i], false, HZ) <= 0) {
+			err = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	dev_info(host->dev, "fence selftest: %u fences, worst interrupt handler time %llu ns%s\n",
+		 num, READ_ONCE(host->intr_max_ns), err ? " (timed out)" : "");
+
+put:
+	for (i = 0; i < num && fences[i]; i++) {
+		if (!dma_fence_is_signaled(fences[i]))
+			host1x_fence_cancel(fences[i]);
+		dma_fence_put(fences[i]);
+	}
+
+	host1x_syncpt_put(sp);
+free:
+	kvfree(fences);
+	return err;
+}
+
+DEFINE_DEBUGFS_ATTRIBUTE(host1x_debug_fence_selftest_fops, NULL,
+			 host1x_debug_fence_selftest, "%llu\n");
+
 static void host1x_debugfs_init(struct host1x *host1x)
 {
 	struct dentry *de = debugfs_create_dir("tegra-host1x", NULL);
@@ -213,6 +294,11 @@ static void host1x_debugfs_init(struct host1x *host1x)
 			   &host1x_debug_force_timeout_val);
 	debugfs_create_u32("force_timeout_channel", S_IRUGO|S_IWUSR, de,
 			   &host1x_debug_force_timeout_channel);
+
+	debugfs_create_u64("intr_max_ns", S_IRUGO|S_IWUSR, de,
+			   &host1x->intr_max_ns);
+	debugfs_create_file_unsafe("fence_selftest", S_IWUSR, de, host1x,
+				   &host1x_debug_fence_selftest_fops);
 }
 
 static void host1x_debugfs_exit(struct host1x *host1x)
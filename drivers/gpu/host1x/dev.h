@@ -173,6 +173,8 @@ struct host1x {
 	dma_addr_t iova_end;
 
 	struct mutex intr_mutex;
+	/* longest time spent in host1x_intr_handle_interrupt(), in ns */
+	u64 intr_max_ns;
 
 	const struct host1x_syncpt_ops *syncpt_op;
 	const struct host1x_intr_general_ops *intr_general_op;
@@ -6,6 +6,9 @@
 #ifndef HOST1X_FENCE_H
 #define HOST1X_FENCE_H
 
+#include <linux/rbtree.h>
+#include <linux/workqueue.h>
+
 struct host1x_syncpt_fence {
 	struct dma_fence base;
 
@@ -17,12 +20,20 @@ struct host1x_syncpt_fence {
 
 	struct delayed_work timeout_work;
 
+	/* node in the syncpoint's tree of pending fences */
+	struct rb_node node;
+	/* entry in the list of expired fences waiting to be signalled */
 	struct list_head list;
+	ktime_t ts;
 };
 
 struct host1x_fence_list {
 	spinlock_t lock;
-	struct list_head list;
+	/* pending fences, ordered by threshold */
+	struct rb_root_cached root;
+	/* expired fences, signalled from @work */
+	struct list_head expired;
+	struct work_struct work;
 };
 
 void host1x_fence_signal(struct host1x_syncpt_fence *fence, ktime_t ts);
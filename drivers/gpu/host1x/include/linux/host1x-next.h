@@ -9,6 +9,7 @@
 #include <linux/device.h>
 #include <linux/dma-direction.h>
 #include <linux/dma-fence.h>
+#include <linux/hashtable.h>
 #include <linux/spinlock.h>
 #include <linux/timekeeping.h>
 #include <linux/types.h>
@@ -41,24 +42,36 @@ struct iommu_group;
 
 u64 host1x_get_dma_mask(struct host1x *host1x);
 
+#define HOST1X_BO_CACHE_HASH_BITS	6
+#define HOST1X_BO_CACHE_DEFAULT_MAX	256
+
 /**
  * struct host1x_bo_cache - host1x buffer object cache
- * @mappings: list of mappings
+ * @mappings: list of mappings, in least recently used order
+ * @hash: mappings indexed by buffer object
+ * @count: number of mappings in the cache
+ * @max: number of mappings above which unused mappings are reclaimed
  * @lock: synchronizes accesses to the list of mappings
  *
- * Note that entries are not periodically evicted from this cache and instead need to be
- * explicitly released. This is used primarily for DRM/KMS where the cache's reference is
- * released when the last reference to a buffer object represented by a mapping in this
- * cache is dropped.
+ * Entries are not periodically evicted from this cache. The cache's reference is either
+ * released explicitly, which is used for DRM/KMS when the last reference to a buffer object
+ * represented by a mapping in this cache is dropped, or when the cache grows beyond @max
+ * entries and the mapping is only referenced by the cache.
  */
 struct host1x_bo_cache {
 	struct list_head mappings;
+	DECLARE_HASHTABLE(hash, HOST1X_BO_CACHE_HASH_BITS);
+	unsigned int count;
+	unsigned int max;
 	struct mutex lock;
 };
 
 static inline void host1x_bo_cache_init(struct host1x_bo_cache *cache)
 {
 	INIT_LIST_HEAD(&cache->mappings);
+	hash_init(cache->hash);
+	cache->count = 0;
+	cache->max = HOST1X_BO_CACHE_DEFAULT_MAX;
 	mutex_init(&cache->lock);
 }
 
@@ -154,6 +167,7 @@ struct host1x_bo_mapping {
 
 	struct host1x_bo_cache *cache;
 	struct list_head entry;
+	struct hlist_node node;
 };
 
 static inline struct host1x_bo_mapping *to_host1x_bo_mapping(struct kref *ref)
@@ -200,6 +214,21 @@ struct host1x_bo_mapping *host1x_bo_pin(struct device *dev, struct host1x_bo *bo
 					struct host1x_bo_cache *cache);
 void host1x_bo_unpin(struct host1x_bo_mapping *map);
 
+/**
+ * struct host1x_bo_pin_req - request for host1x_bo_pin_many()
+ * @bo: buffer object to pin
+ * @direction: DMA direction of the mapping
+ * @map: resulting mapping, filled in by host1x_bo_pin_many()
+ */
+struct host1x_bo_pin_req {
+	struct host1x_bo *bo;
+	enum dma_data_direction direction;
+	struct host1x_bo_mapping *map;
+};
+
+int host1x_bo_pin_many(struct device *dev, struct host1x_bo_pin_req *reqs,
+		       unsigned int count, struct host1x_bo_cache *cache);
+
 static inline void *host1x_bo_mmap(struct host1x_bo *bo)
 {
 	return bo->ops->mmap(bo);
@@ -6,34 +6,48 @@
  */
 
 #include <linux/clk.h>
+#include <linux/workqueue.h>
 
 #include "dev.h"
 #include "fence.h"
 #include "intr.h"
 
-static void host1x_intr_add_fence_to_list(struct host1x_fence_list *list,
+static void host1x_intr_add_fence_to_tree(struct host1x_fence_list *list,
 					  struct host1x_syncpt_fence *fence)
 {
-	struct host1x_syncpt_fence *fence_in_list;
-
-	list_for_each_entry_reverse(fence_in_list, &list->list, list) {
-		if ((s32)(fence_in_list->threshold - fence->threshold) <= 0) {
-			/* Fence in list is before us, we can insert here */
-			list_add(&fence->list, &fence_in_list->list);
-			return;
+	struct rb_node **link = &list->root.rb_root.rb_node, *parent = NULL;
+	struct host1x_syncpt_fence *fence_in_tree;
+	bool leftmost = true;
+
+	/*
+	 * Thresholds are compared relative to each other so that wrapping syncpoint values are
+	 * handled, which is fine as long as all pending thresholds are within 2^31 of each other.
+	 * Fences with the same threshold are kept in insertion order.
+	 */
+	while (*link) {
+		parent = *link;
+		fence_in_tree = rb_entry(parent, struct host1x_syncpt_fence, node);
+
+		if ((s32)(fence_in_tree->threshold - fence->threshold) <= 0) {
+			link = &parent->rb_right;
+			leftmost = false;
+		} else {
+			link = &parent->rb_left;
 		}
 	}
 
-	/* Add as first in list */
-	list_add(&fence->list, &list->list);
+	rb_link_node(&fence->node, parent, link);
+	rb_insert_color_cached(&fence->node, &list->root, leftmost);
 }
 
 static void host1x_intr_update_hw_state(struct host1x *host, struct host1x_syncpt *sp)
 {
 	struct host1x_syncpt_fence *fence;
+	struct rb_node *first;
 
-	if (!list_empty(&sp->fences.list)) {
-		fence = list_first_entry(&sp->fences.list, struct host1x_syncpt_fence, list);
+	first = rb_first_cached(&sp->fences.root);
+	if (first) {
+		fence = rb_entry(first, struct host1x_syncpt_fence, node);
 
 		host1x_hw_intr_set_syncpt_threshold(host, sp->id, fence->threshold);
 		host1x_hw_intr_enable_syncpt_intr(host, sp->id);
@@ -48,7 +62,7 @@ void host1x_intr_add_fence_locked(struct host1x *host, struct host1x_syncpt_fenc
 
 	INIT_LIST_HEAD(&fence->list);
 
-	host1x_intr_add_fence_to_list(fence_list, fence);
+	host1x_intr_add_fence_to_tree(fence_list, fence);
 	host1x_intr_update_hw_state(host, fence->sp);
 }
 
@@ -59,43 +73,100 @@ bool host1x_intr_remove_fence(struct host1x *host, struct host1x_syncpt_fence *f
 
 	spin_lock_irqsave(&fence_list->lock, irqflags);
 
-	if (list_empty(&fence->list)) {
+	if (!RB_EMPTY_NODE(&fence->node)) {
+		rb_erase_cached(&fence->node, &fence_list->root);
+		RB_CLEAR_NODE(&fence->node);
+		host1x_intr_update_hw_state(host, fence->sp);
+	} else if (!list_empty(&fence->list)) {
+		/* already expired, but not yet signalled by the worker */
+		list_del_init(&fence->list);
+	} else {
 		spin_unlock_irqrestore(&fence_list->lock, irqflags);
 		return false;
 	}
 
-	list_del_init(&fence->list);
-	host1x_intr_update_hw_state(host, fence->sp);
-
 	spin_unlock_irqrestore(&fence_list->lock, irqflags);
 
 	return true;
 }
 
+/* Number of expired fences signalled per acquisition of the fence list lock */
+#define HOST1X_INTR_SIGNAL_BATCH	8
+
+/*
+ * Signal the fences that the interrupt handler found expired. This runs in process context so
+ * that the dma_fence callbacks of a large batch don't add to the interrupt latency.
+ *
+ * The list lock is also the dma_fence lock, so callbacks still run with it held. It is dropped
+ * every HOST1X_INTR_SIGNAL_BATCH fences to bound the time spent with interrupts disabled.
+ */
+static void host1x_intr_signal_work(struct work_struct *work)
+{
+	struct host1x_fence_list *fence_list =
+		container_of(work, struct host1x_fence_list, work);
+	struct host1x_syncpt_fence *fence;
+	unsigned long irqflags;
+	unsigned int n;
+	bool more;
+
+	do {
+		spin_lock_irqsave(&fence_list->lock, irqflags);
+
+		for (n = 0; n < HOST1X_INTR_SIGNAL_BATCH &&
+			    !list_empty(&fence_list->expired); n++) {
+			fence = list_first_entry(&fence_list->expired,
+						 struct host1x_syncpt_fence, list);
+			list_del_init(&fence->list);
+			host1x_fence_signal(fence, fence->ts);
+		}
+
+		more = !list_empty(&fence_list->expired);
+
+		spin_unlock_irqrestore(&fence_list->lock, irqflags);
+
+		if (more)
+			cond_resched();
+	} while (more);
+}
+
 void host1x_intr_handle_interrupt(struct host1x *host, unsigned int id, ktime_t ts)
 {
 	struct host1x_syncpt *sp = &host->syncpt[id];
-	struct host1x_syncpt_fence *fence, *tmp;
+	struct host1x_syncpt_fence *fence;
+	struct rb_node *node;
 	unsigned int value;
+	u64 elapsed;
 
 	value = host1x_syncpt_load(sp);
 
 	spin_lock(&sp->fences.lock);
 
-	list_for_each_entry_safe(fence, tmp, &sp->fences.list, list) {
+	while ((node = rb_first_cached(&sp->fences.root))) {
+		fence = rb_entry(node, struct host1x_syncpt_fence, node);
+
 		if (((value - fence->threshold) & 0x80000000U) != 0U) {
 			/* Fence is not yet expired, we are done */
 			break;
 		}
 
-		list_del_init(&fence->list);
-		host1x_fence_signal(fence, ts);
+		rb_erase_cached(node, &sp->fences.root);
+		RB_CLEAR_NODE(node);
+
+		fence->ts = ts;
+		list_add_tail(&fence->list, &sp->fences.expired);
 	}
 
 	/* Re-enable interrupt if necessary */
 	host1x_intr_update_hw_state(host, sp);
 
 	spin_unlock(&sp->fences.lock);
+
+	if (!list_empty(&sp->fences.expired))
+		queue_work(system_highpri_wq, &sp->fences.work);
+
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), ts));
+	if (elapsed > READ_ONCE(host->intr_max_ns))
+		WRITE_ONCE(host->intr_max_ns, elapsed);
 }
 
 int host1x_intr_init(struct host1x *host)
@@ -108,7 +179,9 @@ int host1x_intr_init(struct host1x *host)
 		struct host1x_syncpt *syncpt = &host->syncpt[id];
 
 		spin_lock_init(&syncpt->fences.lock);
-		INIT_LIST_HEAD(&syncpt->fences.list);
+		syncpt->fences.root = RB_ROOT_CACHED;
+		INIT_LIST_HEAD(&syncpt->fences.expired);
+		INIT_WORK(&syncpt->fences.work, host1x_intr_signal_work);
 	}
 
 	return 0;
@@ -116,6 +189,10 @@ int host1x_intr_init(struct host1x *host)
 
 void host1x_intr_deinit(struct host1x *host)
 {
+	unsigned int id;
+
+	for (id = 0; id < host1x_syncpt_nb_pts(host); ++id)
+		flush_work(&host->syncpt[id].fences.work);
 }
 
 void host1x_intr_start(struct host1x *host)
@@ -158,6 +158,7 @@ static unsigned int pin_job(struct host1x *host, struct host1x_job *job)
 {
 	unsigned long mask = HOST1X_RELOC_READ | HOST1X_RELOC_WRITE;
 	struct host1x_client *client = job->client;
+	struct host1x_bo_pin_req *reqs = NULL;
 	struct device *dev = client->dev;
 	struct host1x_job_gather *g;
 	unsigned int i;
@@ -165,59 +166,74 @@ static unsigned int pin_job(struct host1x *host, struct host1x_job *job)
 
 	job->num_unpins = 0;
 
+	if (job->num_relocs) {
+		reqs = kmalloc_array(job->num_relocs, sizeof(*reqs), GFP_KERNEL);
+		if (!reqs)
+			return -ENOMEM;
+	}
+
 	for (i = 0; i < job->num_relocs; i++) {
 		struct host1x_reloc *reloc = &job->relocs[i];
-		enum dma_data_direction direction;
-		struct host1x_bo_mapping *map;
-		struct host1x_bo *bo;
 
 		reloc->target.bo = host1x_bo_get(reloc->target.bo);
 		if (!reloc->target.bo) {
 			err = -EINVAL;
-			goto unpin;
+			goto free;
 		}
 
-		bo = reloc->target.bo;
+		reqs[i].bo = reloc->target.bo;
 
 		switch (reloc->flags & mask) {
 		case HOST1X_RELOC_READ:
-			direction = DMA_TO_DEVICE;
+			reqs[i].direction = DMA_TO_DEVICE;
 			break;
 
 		case HOST1X_RELOC_WRITE:
-			direction = DMA_FROM_DEVICE;
+			reqs[i].direction = DMA_FROM_DEVICE;
 			break;
 
 		case HOST1X_RELOC_READ | HOST1X_RELOC_WRITE:
-			direction = DMA_BIDIRECTIONAL;
+			reqs[i].direction = DMA_BIDIRECTIONAL;
 			break;
 
 		default:
+			host1x_bo_put(reqs[i].bo);
 			err = -EINVAL;
-			goto unpin;
+			goto free;
 		}
+	}
 
-		map = host1x_bo_pin(dev, bo, direction, NULL);
-		if (IS_ERR(map)) {
-			err = PTR_ERR(map);
-			goto unpin;
-		}
+	/*
+	 * Pin the relocs in one go but uncached: a cached mapping would keep its BO alive and
+	 * mapped after userspace frees it, skip the per-job cache sync and be torn down by
+	 * host1x_job_unpin() while other jobs still use it.
+	 */
+	err = host1x_bo_pin_many(dev, reqs, job->num_relocs, NULL);
+	if (err < 0)
+		goto free;
 
-		/*
-		 * host1x clients are generally not able to do scatter-gather themselves, so fail
-		 * if the buffer is discontiguous and we fail to map its SG table to a single
-		 * contiguous chunk of I/O virtual memory.
-		 */
-		if (map->chunks > 1) {
-			err = -EINVAL;
-			goto unpin;
-		}
+	for (i = 0; i < job->num_relocs; i++) {
+		struct host1x_bo_mapping *map = reqs[i].map;
 
 		job->addr_phys[job->num_unpins] = map->phys;
 		job->unpins[job->num_unpins].map = map;
 		job->num_unpins++;
 	}
 
+	kfree(reqs);
+
+	/*
+	 * host1x clients are generally not able to do scatter-gather themselves, so fail
+	 * if the buffer is discontiguous and we fail to map its SG table to a single
+	 * contiguous chunk of I/O virtual memory.
+	 */
+	for (i = 0; i < job->num_unpins; i++) {
+		if (job->unpins[i].map->chunks > 1) {
+			err = -EINVAL;
+			goto unpin;
+		}
+	}
+
 	/*
 	 * We will copy gathers BO content later, so there is no need to
 	 * hold and pin them.
@@ -290,6 +306,13 @@ put:
 unpin:
 	host1x_job_unpin(job);
 	return err;
+
+free:
+	/* drop the references taken above, nothing has been pinned yet */
+	while (i--)
+		host1x_bo_put(reqs[i].bo);
+	kfree(reqs);
+	return err;
 }
 
 static int do_relocs(struct host1x_job *job, struct host1x_job_gather *g)
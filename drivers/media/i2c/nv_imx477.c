@@ -55,6 +55,10 @@ struct imx477 {
 	struct camera_common_data *s_data;
 	struct tegracam_device *tc_dev;
 	enum imx477_Config config;
+	/* mode_table entries precompiled into i2c bursts at probe */
+	struct regmap_util_table *tbls[ARRAY_SIZE(mode_table)];
+	/* mode table applied since power on, -1 if none */
+	int cur_mode;
 };
 
 static const struct regmap_config sensor_regmap_config = {
@@ -117,11 +121,32 @@ static inline int imx477_write_reg(struct camera_common_data *s_data,
 	return err;
 }
 
-static int imx477_write_table(struct imx477 *priv, const imx477_reg table[])
+static int imx477_write_table(struct imx477 *priv, unsigned int index)
 {
-	return regmap_util_write_table_8(priv->s_data->regmap, table, NULL, 0,
-					 IMX477_TABLE_WAIT_MS,
-					 IMX477_TABLE_END);
+	return regmap_util_write_compiled(priv->tbls[index]);
+}
+
+static int imx477_compile_tables(struct imx477 *priv)
+{
+	unsigned int i;
+	int err;
+
+	/*
+	 * One register per message to match use_single_write, the tables
+	 * still go out in a few multi-message transfers.
+	 */
+	for (i = 0; i < ARRAY_SIZE(mode_table); i++) {
+		err = regmap_util_compile_table_8(priv->s_data->regmap,
+						  mode_table[i], NULL, 0,
+						  IMX477_TABLE_WAIT_MS,
+						  IMX477_TABLE_END, 1,
+						  &priv->tbls[i]);
+		if (err)
+			return err;
+	}
+	priv->cur_mode = -1;
+
+	return 0;
 }
 
 static int imx477_set_group_hold(struct tegracam_device *tc_dev, bool val)
@@ -331,8 +356,11 @@ static int imx477_power_on(struct camera_common_data *s_data)
 	struct camera_common_power_rail *pw = s_data->power;
 	struct camera_common_pdata *pdata = s_data->pdata;
 	struct device *dev = s_data->dev;
+	struct imx477 *priv = (struct imx477 *)s_data->priv;
 
 	dev_dbg(dev, "%s: power on\n", __func__);
+	if (priv)
+		priv->cur_mode = -1;
 	if (pdata && pdata->power_on) {
 		err = pdata->power_on(pw);
 		if (err)
@@ -408,8 +436,11 @@ static int imx477_power_off(struct camera_common_data *s_data)
 	struct camera_common_power_rail *pw = s_data->power;
 	struct camera_common_pdata *pdata = s_data->pdata;
 	struct device *dev = s_data->dev;
+	struct imx477 *priv = (struct imx477 *)s_data->priv;
 
 	dev_dbg(dev, "%s: power off\n", __func__);
+	if (priv)
+		priv->cur_mode = -1;
 
 	if (pdata && pdata->power_off) {
 		err = pdata->power_off(pw);
@@ -615,18 +646,32 @@ static int imx477_set_mode(struct tegracam_device *tc_dev)
 	else
 		dev_err(tc_dev->dev, "Unsupported config\n");
 
-	err = imx477_write_table(priv, mode_table[IMX477_MODE_COMMON]);
-	if (err)
-		return err;
-
 	mode_index = s_data->mode;
 	if (priv->config == FOUR_LANE_CONFIG)
-		err = imx477_write_table(priv, mode_table[mode_index + offset]);
-	else
-		err = imx477_write_table(priv, mode_table[mode_index]);
+		mode_index += offset;
 
-	if (err)
+	/*
+	 * Registers hold the last mode since power on, only send what the new
+	 * mode changes. Controls are synchronized after set_mode anyway. When
+	 * the delta can't describe the switch, reset through the common table
+	 * and write the whole mode.
+	 */
+	err = -EAGAIN;
+	if (priv->cur_mode >= 0)
+		err = regmap_util_write_delta(priv->tbls[priv->cur_mode],
+					      priv->tbls[mode_index]);
+	if (err == -EAGAIN) {
+		priv->cur_mode = -1;
+		err = imx477_write_table(priv, IMX477_MODE_COMMON);
+		if (!err)
+			err = imx477_write_table(priv, mode_index);
+	}
+
+	if (err) {
+		priv->cur_mode = -1;
 		return err;
+	}
+	priv->cur_mode = mode_index;
 
 	return 0;
 }
@@ -636,7 +681,7 @@ static int imx477_start_streaming(struct tegracam_device *tc_dev)
 	struct imx477 *priv = (struct imx477 *)tegracam_get_privdata(tc_dev);
 
 	dev_dbg(tc_dev->dev, "%s:\n", __func__);
-	return imx477_write_table(priv, mode_table[IMX477_START_STREAM]);
+	return imx477_write_table(priv, IMX477_START_STREAM);
 }
 
 static int imx477_stop_streaming(struct tegracam_device *tc_dev)
@@ -645,7 +690,7 @@ static int imx477_stop_streaming(struct tegracam_device *tc_dev)
 	struct imx477 *priv = (struct imx477 *)tegracam_get_privdata(tc_dev);
 
 	dev_dbg(tc_dev->dev, "%s:\n", __func__);
-	err = imx477_write_table(priv, mode_table[IMX477_STOP_STREAM]);
+	err = imx477_write_table(priv, IMX477_STOP_STREAM);
 
 	return err;
 }
@@ -767,6 +812,13 @@ static int imx477_probe(struct i2c_client *client,
 	priv->subdev = &tc_dev->s_data->subdev;
 	tegracam_set_privdata(tc_dev, (void *)priv);
 
+	err = imx477_compile_tables(priv);
+	if (err) {
+		tegracam_device_unregister(tc_dev);
+		dev_err(dev, "mode table compile failed\n");
+		return err;
+	}
+
 	err = imx477_board_setup(priv);
 	if (err) {
 		dev_err(dev, "board setup failed\n");
@@ -5,10 +5,59 @@
  * Copyright (c) 2013-2022, NVIDIA Corporation. All Rights Reserved.
  */
 
+#include <linux/bsearch.h>
+#include <linux/i2c.h>
+#include <linux/ktime.h>
 #include <linux/regmap.h>
 #include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
 #include <media/camera_common.h>
 
+/* i2c messages per transfer when the adapter does not limit it */
+#define REGMAP_UTIL_MAX_I2C_MSGS	32
+/* 16-bit register address in front of each burst */
+#define REGMAP_UTIL_ADDR_BYTES		2
+
+/* a run of burst messages, followed by an optional wait */
+struct regmap_util_step {
+	unsigned int first_msg;
+	unsigned int num_msgs;
+	unsigned int wait_ms;
+};
+
+struct regmap_util_table {
+	struct regmap *regmap;
+	/* NULL when bursts go through regmap_bulk_write */
+	struct i2c_client *client;
+	unsigned int max_msgs;
+	unsigned int max_burst;
+	u16 wait_ms_addr;
+
+	/* entries in table order with overrides applied, waits included */
+	struct reg_8 *regs;
+	unsigned int num_regs;
+	/* register entries sorted by address, for delta lookups */
+	struct reg_8 *sorted;
+	unsigned int num_sorted;
+	/* a register is written more than once, no delta possible */
+	bool has_dup;
+
+	struct i2c_msg *msgs;
+	unsigned int num_msgs;
+	u8 *wire;
+	struct regmap_util_step *steps;
+	unsigned int num_steps;
+
+	/* duration of the last full write, for latency reports */
+	u64 full_write_ns;
+};
+
+struct regmap_util_override {
+	struct reg_8 reg;
+	unsigned int idx;
+};
+
 int
 regmap_util_write_table_8(struct regmap *regmap,
 			  const struct reg_8 table[],
@@ -165,5 +214,383 @@ regmap_util_write_table_16_as_8(struct regmap *regmap,
 }
 
 EXPORT_SYMBOL_GPL(regmap_util_write_table_16_as_8);
+
+static int regmap_util_cmp_override(const void *a, const void *b)
+{
+	const struct regmap_util_override *l = a, *r = b;
+
+	if (l->reg.addr != r->reg.addr)
+		return l->reg.addr < r->reg.addr ? -1 : 1;
+	/* first match in the list wins, as in regmap_util_write_table_8 */
+	return l->idx < r->idx ? -1 : (l->idx > r->idx);
+}
+
+static int regmap_util_cmp_reg(const void *a, const void *b)
+{
+	const struct reg_8 *l = a, *r = b;
+
+	if (l->addr != r->addr)
+		return l->addr < r->addr ? -1 : 1;
+	return 0;
+}
+
+static int regmap_util_find_override(const void *key, const void *elt)
+{
+	const struct reg_8 *k = key;
+	const struct regmap_util_override *o = elt;
+
+	if (k->addr != o->reg.addr)
+		return k->addr < o->reg.addr ? -1 : 1;
+	return 0;
+}
+
+static const struct reg_8 *
+regmap_util_lookup(const struct regmap_util_table *tbl, u16 addr)
+{
+	struct reg_8 key = { .addr = addr };
+
+	return bsearch(&key, tbl->sorted, tbl->num_sorted,
+		       sizeof(*tbl->sorted), regmap_util_cmp_reg);
+}
+
+/* limits of one i2c_transfer() on the adapter behind the regmap */
+static void regmap_util_setup_bus(struct regmap_util_table *tbl,
+				  unsigned int max_burst)
+{
+	struct device *dev = regmap_get_device(tbl->regmap);
+	struct i2c_client *client = i2c_verify_client(dev);
+	const struct i2c_adapter_quirks *q;
+
+	tbl->max_msgs = 1;
+	tbl->max_burst = max_burst;
+
+	if (!client || !i2c_check_functionality(client->adapter, I2C_FUNC_I2C))
+		return;
+
+	tbl->client = client;
+	tbl->max_msgs = REGMAP_UTIL_MAX_I2C_MSGS;
+	q = client->adapter->quirks;
+	if (!q)
+		return;
+
+	if (q->flags & I2C_AQ_NO_REP_START)
+		tbl->max_msgs = 1;
+	else if (q->max_num_msgs)
+		tbl->max_msgs = min_t(unsigned int, tbl->max_msgs,
+				      q->max_num_msgs);
+	if (q->max_write_len > REGMAP_UTIL_ADDR_BYTES)
+		tbl->max_burst = min_t(unsigned int, tbl->max_burst,
+				       q->max_write_len - REGMAP_UTIL_ADDR_BYTES);
+}
+
+/*
+ * Build burst messages out of the register entries, splitting on
+ * non-contiguous addresses, max_burst and waits. msgs, wire and steps
+ * must be sized for one message per entry.
+ */
+static void regmap_util_build_msgs(const struct regmap_util_table *tbl,
+				   const struct reg_8 *regs,
+				   unsigned int num_regs,
+				   struct i2c_msg *msgs, u8 *wire,
+				   struct regmap_util_step *steps,
+				   unsigned int *num_msgs,
+				   unsigned int *num_steps)
+{
+	struct regmap_util_step *step = &steps[0];
+	struct i2c_msg *msg = NULL;
+	unsigned int nmsgs = 0, nsteps = 1;
+	u16 next_addr = 0;
+	unsigned int i;
+
+	step->first_msg = 0;
+	step->num_msgs = 0;
+	step->wait_ms = 0;
+
+	for (i = 0; i < num_regs; i++) {
+		if (regs[i].addr == tbl->wait_ms_addr) {
+			step->wait_ms = regs[i].val;
+			step = &steps[nsteps++];
+			step->first_msg = nmsgs;
+			step->num_msgs = 0;
+			step->wait_ms = 0;
+			msg = NULL;
+			continue;
+		}
+
+		if (!msg || regs[i].addr != next_addr ||
+		    msg->len - REGMAP_UTIL_ADDR_BYTES >= tbl->max_burst) {
+			msg = &msgs[nmsgs++];
+			msg->addr = tbl->client ? tbl->client->addr : 0;
+			msg->flags = 0;
+			msg->buf = wire;
+			msg->len = REGMAP_UTIL_ADDR_BYTES;
+			wire[0] = regs[i].addr >> 8;
+			wire[1] = regs[i].addr & 0xff;
+			wire += REGMAP_UTIL_ADDR_BYTES;
+			step->num_msgs++;
+		}
+
+		*wire++ = regs[i].val;
+		msg->len++;
+		next_addr = regs[i].addr + 1;
+	}
+
+	*num_msgs = nmsgs;
+	*num_steps = nsteps;
+}
+
+static int regmap_util_xfer(const struct regmap_util_table *tbl,
+			    struct i2c_msg *msgs, unsigned int num_msgs)
+{
+	unsigned int i, n;
+	u16 addr;
+	int err;
+
+	if (!tbl->client) {
+		for (i = 0; i < num_msgs; i++) {
+			addr = (msgs[i].buf[0] << 8) | msgs[i].buf[1];
+			err = regmap_bulk_write(tbl->regmap, addr,
+					&msgs[i].buf[REGMAP_UTIL_ADDR_BYTES],
+					msgs[i].len - REGMAP_UTIL_ADDR_BYTES);
+			if (err)
+				return err;
+		}
+		return 0;
+	}
+
+	for (i = 0; i < num_msgs; i += n) {
+		n = min(num_msgs - i, tbl->max_msgs);
+		err = i2c_transfer(tbl->client->adapter, &msgs[i], n);
+		if (err != (int)n)
+			return err < 0 ? err : -EIO;
+	}
+
+	/* written behind regmap, reads must go to the device again */
+	for (i = 0; i < num_msgs; i++) {
+		addr = (msgs[i].buf[0] << 8) | msgs[i].buf[1];
+		regcache_drop_region(tbl->regmap, addr,
+				     addr + msgs[i].len - REGMAP_UTIL_ADDR_BYTES - 1);
+	}
+
+	return 0;
+}
+
+static int regmap_util_write_steps(const struct regmap_util_table *tbl,
+				   struct i2c_msg *msgs,
+				   const struct regmap_util_step *steps,
+				   unsigned int num_steps)
+{
+	unsigned int i;
+	int err;
+
+	for (i = 0; i < num_steps; i++) {
+		err = regmap_util_xfer(tbl, &msgs[steps[i].first_msg],
+				       steps[i].num_msgs);
+		if (err) {
+			pr_err("%s:regmap_util_write_table:%d", __func__, err);
+			return err;
+		}
+
+		if (steps[i].wait_ms)
+			msleep_range(steps[i].wait_ms);
+	}
+
+	return 0;
+}
+
+/*
+ * Precompile a reg_8 table (16-bit big endian register addresses, 8-bit
+ * values) into burst messages of at most max_burst values. Bursts are sent
+ * as multi-message i2c_transfer() calls when the regmap sits on an I2C
+ * adapter, bypassing the regmap cache, else through regmap_bulk_write().
+ * Memory is device managed against the regmap device.
+ */
+int
+regmap_util_compile_table_8(struct regmap *regmap,
+			    const struct reg_8 table[],
+			    const struct reg_8 override_list[],
+			    int num_override_regs,
+			    u16 wait_ms_addr, u16 end_addr,
+			    unsigned int max_burst,
+			    struct regmap_util_table **out)
+{
+	struct device *dev = regmap_get_device(regmap);
+	struct regmap_util_override *overrides = NULL;
+	const struct regmap_util_override *o;
+	struct regmap_util_table *tbl;
+	unsigned int i, n, wire_len;
+	int err = 0;
+
+	if (!table || !out || !max_burst || regmap_get_val_bytes(regmap) != 1)
+		return -EINVAL;
+
+	tbl = devm_kzalloc(dev, sizeof(*tbl), GFP_KERNEL);
+	if (!tbl)
+		return -ENOMEM;
+
+	tbl->regmap = regmap;
+	tbl->wait_ms_addr = wait_ms_addr;
+	regmap_util_setup_bus(tbl, max_burst);
+
+	for (n = 0; table[n].addr != end_addr; n++)
+		;
+	tbl->num_regs = n;
+
+	if (override_list && num_override_regs > 0) {
+		overrides = kcalloc(num_override_regs, sizeof(*overrides),
+				    GFP_KERNEL);
+		if (!overrides)
+			return -ENOMEM;
+		for (i = 0; i < num_override_regs; i++) {
+			overrides[i].reg = override_list[i];
+			overrides[i].idx = i;
+		}
+		sort(overrides, num_override_regs, sizeof(*overrides),
+		     regmap_util_cmp_override, NULL);
+	}
+
+	tbl->regs = devm_kcalloc(dev, n + 1, sizeof(*tbl->regs), GFP_KERNEL);
+	tbl->sorted = devm_kcalloc(dev, n + 1, sizeof(*tbl->sorted),
+				   GFP_KERNEL);
+	tbl->msgs = devm_kcalloc(dev, n + 1, sizeof(*tbl->msgs), GFP_KERNEL);
+	tbl->steps = devm_kcalloc(dev, n + 1, sizeof(*tbl->steps), GFP_KERNEL);
+	wire_len = n * (REGMAP_UTIL_ADDR_BYTES + 1);
+	tbl->wire = devm_kzalloc(dev, wire_len + 1, GFP_KERNEL);
+	if (!tbl->regs || !tbl->sorted || !tbl->msgs || !tbl->steps ||
+	    !tbl->wire) {
+		err = -ENOMEM;
+		goto done;
+	}
+
+	for (i = 0; i < n; i++) {
+		tbl->regs[i] = table[i];
+		if (table[i].addr == wait_ms_addr)
+			continue;
+
+		if (overrides) {
+			o = bsearch(&table[i], overrides, num_override_regs,
+				    sizeof(*overrides),
+				    regmap_util_find_override);
+			/* step back to the first match in list order */
+			while (o && o > overrides && (o - 1)->reg.addr == o->reg.addr)
+				o--;
+			if (o)
+				tbl->regs[i].val = o->reg.val;
+		}
+		tbl->sorted[tbl->num_sorted++] = tbl->regs[i];
+	}
+
+	sort(tbl->sorted, tbl->num_sorted, sizeof(*tbl->sorted),
+	     regmap_util_cmp_reg, NULL);
+	for (i = 1; i < tbl->num_sorted; i++) {
+		if (tbl->sorted[i].addr == tbl->sorted[i - 1].addr)
+			tbl->has_dup = true;
+	}
+
+	regmap_util_build_msgs(tbl, tbl->regs, tbl->num_regs, tbl->msgs,
+			       tbl->wire, tbl->steps, &tbl->num_msgs,
+			       &tbl->num_steps);
+
+	dev_dbg(dev, "%s: %u regs in %u bursts, %u per transfer\n", __func__,
+		tbl->num_sorted, tbl->num_msgs, tbl->max_msgs);
+	*out = tbl;
+
+done:
+	kfree(overrides);
+	return err;
+}
+EXPORT_SYMBOL_GPL(regmap_util_compile_table_8);
+
+int
+regmap_util_write_compiled(struct regmap_util_table *tbl)
+{
+	ktime_t start = ktime_get();
+	int err;
+
+	if (!tbl)
+		return -EINVAL;
+
+	err = regmap_util_write_steps(tbl, tbl->msgs, tbl->steps,
+				      tbl->num_steps);
+	if (!err)
+		tbl->full_write_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(regmap_util_write_compiled);
+
+/*
+ * Bring the device from the register state left by 'from' to the one of
+ * 'to', writing only the registers of 'to' whose value differs, in table
+ * order and keeping the waits of 'to'. Returns -EAGAIN without writing
+ * anything when 'from' sets registers 'to' does not, or either table writes
+ * a register more than once: the caller then has to restore the device from
+ * its reset state, which 'to' alone does not describe.
+ */
+int
+regmap_util_write_delta(struct regmap_util_table *from,
+			struct regmap_util_table *to)
+{
+	struct device *dev;
+	struct regmap_util_step *steps = NULL;
+	struct reg_8 *regs = NULL;
+	struct i2c_msg *msgs = NULL;
+	const struct reg_8 *old;
+	unsigned int i, n = 0, written = 0, num_msgs, num_steps;
+	ktime_t start;
+	u8 *wire = NULL;
+	int err = 0;
+
+	if (!from || !to || from->regmap != to->regmap)
+		return -EINVAL;
+
+	/* final value of a duplicated register in 'from' is not known here */
+	if (from->has_dup || to->has_dup)
+		return -EAGAIN;
+	for (i = 0; i < from->num_sorted; i++) {
+		if (!regmap_util_lookup(to, from->sorted[i].addr))
+			return -EAGAIN;
+	}
+
+	dev = regmap_get_device(to->regmap);
+	start = ktime_get();
+
+	regs = kcalloc(to->num_regs + 1, sizeof(*regs), GFP_KERNEL);
+	msgs = kcalloc(to->num_regs + 1, sizeof(*msgs), GFP_KERNEL);
+	steps = kcalloc(to->num_regs + 1, sizeof(*steps), GFP_KERNEL);
+	wire = kzalloc(to->num_regs * (REGMAP_UTIL_ADDR_BYTES + 1) + 1,
+		       GFP_KERNEL);
+	if (!regs || !msgs || !steps || !wire) {
+		err = -ENOMEM;
+		goto done;
+	}
+
+	for (i = 0; i < to->num_regs; i++) {
+		if (to->regs[i].addr != to->wait_ms_addr) {
+			old = regmap_util_lookup(from, to->regs[i].addr);
+			if (old && old->val == to->regs[i].val)
+				continue;
+			written++;
+		}
+		regs[n++] = to->regs[i];
+	}
+
+	regmap_util_build_msgs(to, regs, n, msgs, wire, steps, &num_msgs,
+			       &num_steps);
+	err = regmap_util_write_steps(to, msgs, steps, num_steps);
+	if (!err)
+		dev_dbg(dev, "%s: %u of %u regs in %lld us, full write %llu us\n",
+			__func__, written, to->num_sorted,
+			ktime_to_us(ktime_sub(ktime_get(), start)),
+			div_u64(to->full_write_ns, NSEC_PER_USEC));
+
+done:
+	kfree(wire);
+	kfree(steps);
+	kfree(msgs);
+	kfree(regs);
+	return err;
+}
+EXPORT_SYMBOL_GPL(regmap_util_write_delta);
 MODULE_LICENSE("GPL");
 
@@ -6,6 +6,7 @@
 #include <linux/errno.h>
 #include <linux/mutex.h>
 #include <linux/printk.h>
+#include <linux/rbtree.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 
@@ -18,13 +19,19 @@
  *
  * IOVA manager chunks entire IOVA space into these blocks/chunks.
  *
- * The chunk/block is also a node for linking to previous and next
- * nodes of a circular doubly linked list - free or reserved.
+ * A free chunk/block is a node of two red-black trees - one ordered by
+ * address for merging with neighbours on release and one ordered by size
+ * for best-fit reservation. A reserved block is a node of the reserved
+ * list.
  */
 struct block_t {
-	/* for management of this chunk in either avail or reserve lists.*/
+	/* for management of this chunk in reserve list.*/
 	struct list_head node;
 
+	/* for management of this chunk in free trees.*/
+	struct rb_node addr_node;
+	struct rb_node size_node;
+
 	/* block address.*/
 	u64 address;
 
@@ -36,9 +43,8 @@ struct block_t {
  * INTERNAL datastructure for IOVA space manager.
  *
  * IOVA space manager would fragment and manage the IOVA region
- * using two circular doubly linked lists - reserved list and
- * free list. These lists contain blocks/chunks reserved
- * or free for use by clients (callers) from the overall
+ * using free trees and a reserved list. These contain blocks/chunks
+ * reserved or free for use by clients (callers) from the overall
  * IOVA region the IOVA manager was configured with.
  */
 struct mngr_ctx_t {
@@ -50,114 +56,258 @@ struct mngr_ctx_t {
 	char name[NAME_MAX];
 
 	/*
-	 * Circular doubly linked list of blocks indicating
-	 * available/free IOVA space(s). When IOVA manager is
+	 * Blocks indicating available/free IOVA space(s), ordered by
+	 * address and by (size, address). When IOVA manager is
 	 * initialised all of the IOVA space is marked as available
 	 * to begin with.
 	 */
-	struct list_head *free_list;
+	struct rb_root free_addr_tree;
+	struct rb_root free_size_tree;
 
 	/*
 	 * Book-keeping of the user IOVA blocks in a circular double
 	 * linked list.
 	 */
-	struct list_head *reserved_list;
+	struct list_head reserved_list;
 
-	/* Ensuring reserve, free and the list operations are serialized.*/
+	/* Ensuring reserve, free and the tree operations are serialized.*/
 	struct mutex lock;
 
 	/* base address memory manager is configured with. */
 	u64 base_address;
 };
 
+static void
+free_block_insert(struct mngr_ctx_t *ctx, struct block_t *block)
+{
+	struct rb_node **link = &ctx->free_addr_tree.rb_node;
+	struct rb_node *parent = NULL;
+	struct block_t *curr = NULL;
+
+	while (*link) {
+		parent = *link;
+		curr = rb_entry(parent, struct block_t, addr_node);
+		if (block->address < curr->address)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&block->addr_node, parent, link);
+	rb_insert_color(&block->addr_node, &ctx->free_addr_tree);
+
+	link = &ctx->free_size_tree.rb_node;
+	parent = NULL;
+	while (*link) {
+		parent = *link;
+		curr = rb_entry(parent, struct block_t, size_node);
+		if (block->size < curr->size ||
+		    (block->size == curr->size &&
+		     block->address < curr->address))
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&block->size_node, parent, link);
+	rb_insert_color(&block->size_node, &ctx->free_size_tree);
+}
+
+static void
+free_block_erase(struct mngr_ctx_t *ctx, struct block_t *block)
+{
+	rb_erase(&block->addr_node, &ctx->free_addr_tree);
+	rb_erase(&block->size_node, &ctx->free_size_tree);
+}
+
+/*
+ * Near-fit candidates, smaller than size + align - 1, probed for an aligned
+ * fit before falling back to the smallest block that always fits.
+ */
+#define BEST_FIT_MAX_PROBES	(8)
+
+/* leftmost free block of size >= @size.*/
+static struct rb_node *
+free_block_lower_bound(struct mngr_ctx_t *ctx, size_t size)
+{
+	struct rb_node *node = ctx->free_size_tree.rb_node;
+	struct rb_node *first = NULL;
+	struct block_t *curr = NULL;
+
+	while (node) {
+		curr = rb_entry(node, struct block_t, size_node);
+		if (curr->size >= size) {
+			first = node;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+
+	return first;
+}
+
+/*
+ * Smallest free block where @size fits at an @align boundary, lowest
+ * address among equal sizes. Blocks of at least size + align - 1 always
+ * fit, so only smaller blocks need an alignment check. At most
+ * BEST_FIT_MAX_PROBES of them are checked, after that the walk jumps to
+ * the lower bound for size + align - 1 if there is such a block.
+ */
+static struct block_t *
+free_block_best_fit(struct mngr_ctx_t *ctx, size_t size, size_t align,
+		    u64 *start)
+{
+	size_t fit_size = align > 1 ? size + align - 1 : size;
+	struct rb_node *node = NULL, *fit = NULL;
+	struct block_t *curr = NULL;
+	unsigned int probes = 0;
+	u64 addr;
+
+	for (node = free_block_lower_bound(ctx, size); node;
+	     node = rb_next(node)) {
+		curr = rb_entry(node, struct block_t, size_node);
+		if (curr->size >= fit_size)
+			break;
+
+		addr = ALIGN(curr->address, align);
+		if (addr + size <= curr->address + curr->size) {
+			*start = addr;
+			return curr;
+		}
+
+		/* keep walking only when no block always fits.*/
+		if (++probes == BEST_FIT_MAX_PROBES) {
+			fit = free_block_lower_bound(ctx, fit_size);
+			if (fit) {
+				node = fit;
+				break;
+			}
+		}
+	}
+
+	if (!node)
+		return NULL;
+
+	curr = rb_entry(node, struct block_t, size_node);
+	*start = align ? ALIGN(curr->address, align) : curr->address;
+	return curr;
+}
+
 /*
- * Reserves a block from the free IOVA regions. Once reserved, the block
- * is marked reserved and appended in the reserved list (no ordering
- * required and trying to do so shall increase the time)
+ * Reserves a block from the free IOVA regions at @align boundary. Once
+ * reserved, the block is marked reserved and appended in the reserved list
+ * (no ordering required and trying to do so shall increase the time)
  */
 int
-iova_mngr_block_reserve(void *mngr_handle, size_t size,
-			u64 *address, size_t *offset,
-			void **block_handle)
+iova_mngr_block_reserve_aligned(void *mngr_handle, size_t size, size_t align,
+				u64 *address, size_t *offset,
+				void **block_handle)
 {
 	struct mngr_ctx_t *ctx = (struct mngr_ctx_t *)(mngr_handle);
-	struct block_t *reserve = NULL, *curr = NULL, *best = NULL;
+	struct block_t *reserve = NULL, *tail = NULL, *best = NULL;
+	size_t head_size = 0, tail_size = 0;
+	u64 start = 0;
 	int ret = 0;
 
 	if (WARN_ON(!ctx || *block_handle || !size))
 		return -EINVAL;
+	if (WARN_ON(align & (align - 1)))
+		return -EINVAL;
 
 	mutex_lock(&ctx->lock);
 
-	/* if there are no free blocks to reserve. */
-	if (list_empty(ctx->free_list)) {
+	/* find the best of all free bocks to reserve.*/
+	best = free_block_best_fit(ctx, size, align, &start);
+	if (!best) {
 		ret = -ENOMEM;
-		pr_err("(%s): No memory available to reserve block of size:(%lu)\n",
-		       ctx->name, size);
+		/* aligned callers are expected to retry unaligned.*/
+		if (align)
+			pr_debug("(%s): No aligned block sz:(%lu) align:(%lu)\n",
+				 ctx->name, size, align);
+		else
+			pr_err("(%s): No enough mem available to reserve block sz:(%lu)\n",
+			       ctx->name, size);
 		goto err;
 	}
 
-	/* find the best of all free bocks to reserve.*/
-	list_for_each_entry(curr, ctx->free_list, node) {
-		if (curr->size >= size) {
-			if (!best)
-				best = curr;
-			else if (curr->size < best->size)
-				best = curr;
-		}
+	head_size = start - best->address;
+	tail_size = best->size - head_size - size;
+
+	/* perfect fit.*/
+	if (!head_size && !tail_size) {
+		free_block_erase(ctx, best);
+		reserve = best;
+		goto found;
 	}
 
-	/* if there isn't any free block of requested size. */
-	if (!best) {
+	/* chunk out a new block, adjust the free block(s).*/
+	reserve = kzalloc(sizeof(*reserve), GFP_KERNEL);
+	if (WARN_ON(!reserve)) {
 		ret = -ENOMEM;
-		pr_err("(%s): No enough mem available to reserve block sz:(%lu)\n",
-		       ctx->name, size);
 		goto err;
-	} else {
-		struct block_t *found = NULL;
-
-		/* perfect fit.*/
-		if (best->size == size) {
-			list_del(&best->node);
-			list_add_tail(&best->node, ctx->reserved_list);
-			found = best;
-		} else {
-			/* chunk out a new block, adjust the free block.*/
-			reserve = kzalloc(sizeof(*reserve), GFP_KERNEL);
-			if (WARN_ON(!reserve)) {
-				ret = -ENOMEM;
-				goto err;
-			}
-			reserve->address = best->address;
-			reserve->size = size;
-			best->address += size;
-			best->size -= size;
-			list_add_tail(&reserve->node, ctx->reserved_list);
-			found = reserve;
+	}
+	if (head_size && tail_size) {
+		tail = kzalloc(sizeof(*tail), GFP_KERNEL);
+		if (WARN_ON(!tail)) {
+			kfree(reserve);
+			ret = -ENOMEM;
+			goto err;
 		}
-		*block_handle = (void *)(found);
+	}
 
-		if (address)
-			*address = found->address;
-		if (offset)
-			*offset = (found->address - ctx->base_address);
+	free_block_erase(ctx, best);
+	reserve->address = start;
+	reserve->size = size;
+	if (head_size) {
+		best->size = head_size;
+		free_block_insert(ctx, best);
+		if (tail) {
+			tail->address = start + size;
+			tail->size = tail_size;
+			free_block_insert(ctx, tail);
+		}
+	} else {
+		best->address = start + size;
+		best->size = tail_size;
+		free_block_insert(ctx, best);
 	}
+
+found:
+	list_add_tail(&reserve->node, &ctx->reserved_list);
+	*block_handle = (void *)(reserve);
+
+	if (address)
+		*address = reserve->address;
+	if (offset)
+		*offset = (reserve->address - ctx->base_address);
 err:
 	mutex_unlock(&ctx->lock);
 	return ret;
 }
 
+/*
+ * Reserves a block from the free IOVA regions without any alignment
+ * constraint beyond the granularity of earlier reservations.
+ */
+int
+iova_mngr_block_reserve(void *mngr_handle, size_t size,
+			u64 *address, size_t *offset,
+			void **block_handle)
+{
+	return iova_mngr_block_reserve_aligned(mngr_handle, size, 0, address,
+					       offset, block_handle);
+}
+
 /*
  * Release an already reserved IOVA block/chunk by the caller back to
- * free list.
+ * free trees, merging with the immediate free neighbours.
  */
 int
 iova_mngr_block_release(void *mngr_handle, void **block_handle)
 {
 	struct mngr_ctx_t *ctx = (struct mngr_ctx_t *)(mngr_handle);
 	struct block_t *release = (struct block_t *)(*block_handle);
-	struct block_t *curr = NULL, *prev = NULL;
-	bool done = false;
+	struct block_t *curr = NULL, *prev = NULL, *next = NULL;
+	struct rb_node *node = NULL;
 	int ret = 0;
 
 	if (!ctx || !release)
@@ -165,77 +315,37 @@ iova_mngr_block_release(void *mngr_handle, void **block_handle)
 
 	mutex_lock(&ctx->lock);
 
-	list_for_each_entry(curr, ctx->free_list, node) {
+	list_del(&release->node);
+
+	/* immediate free neighbours by address.*/
+	node = ctx->free_addr_tree.rb_node;
+	while (node) {
+		curr = rb_entry(node, struct block_t, addr_node);
 		if (release->address < curr->address) {
-			/* if the immediate next node is available for merge.*/
-			if (curr->address == release->address + release->size) {
-				curr->address = release->address;
-				curr->size += release->size;
-				list_del(&release->node);
-				kfree(release);
-				/*
-				 * if the immediate previous node is also
-				 * available for merge.
-				 */
-				if ((prev) &&
-				    ((prev->address + prev->size)
-				      == curr->address)) {
-					prev->size += curr->size;
-					list_del(&curr->node);
-					kfree(curr);
-				}
-			} else if ((prev) &&
-				   ((prev->address + prev->size)
-				    == release->address)) {
-				/*
-				 * if only the immediate prev node is available
-				 */
-				prev->size += release->size;
-				list_del(&release->node);
-				kfree(release);
-			} else {
-				/*
-				 * cannot be merged with either the immediate
-				 * prev or the immediate next node. Add it in the
-				 * free list before the current node.
-				 */
-				list_del(&release->node);
-				list_add_tail(&release->node, &curr->node);
-			}
-			done = true;
-			break;
+			next = curr;
+			node = node->rb_left;
+		} else {
+			prev = curr;
+			node = node->rb_right;
 		}
-		prev = curr;
 	}
 
-	/*
-	 * Even if after traversing each entry in list, we could not
-	 * add the block to be released back in free list, because:
-	 */
-	if (!done) {
-		if (!list_empty(ctx->free_list)) {
-			/*
-			 * The block to be freed has the highest order
-			 * address of all the existing blocks in free list.
-			 */
-			struct block_t *last =
-			list_last_entry(ctx->free_list, struct block_t, node);
-			if ((last->address + last->size) == release->address) {
-				/* can be merged with last node of list.*/
-				last->size += release->size;
-				list_del(&release->node);
-				kfree(release);
-			} else {
-				/* cannot be merged, add as the last node.*/
-				list_del(&release->node);
-				list_add_tail(&release->node, ctx->free_list);
-			}
-		} else {
-			/* free list was empty.*/
-			list_del(&release->node);
-			list_add_tail(&release->node, ctx->free_list);
-		}
+	/* if the immediate previous node is available for merge.*/
+	if (prev && (prev->address + prev->size) == release->address) {
+		free_block_erase(ctx, prev);
+		prev->size += release->size;
+		kfree(release);
+		release = prev;
 	}
+
+	/* if the immediate next node is available for merge.*/
+	if (next && (release->address + release->size) == next->address) {
+		free_block_erase(ctx, next);
+		release->size += next->size;
+		kfree(next);
+	}
+
+	free_block_insert(ctx, release);
 	*block_handle = NULL;
 
 	mutex_unlock(&ctx->lock);
@@ -255,16 +365,19 @@ iova_mngr_print(void *mngr_handle)
 {
 	struct mngr_ctx_t *ctx = (struct mngr_ctx_t *)(mngr_handle);
 	struct block_t *block = NULL;
+	struct rb_node *node = NULL;
 
 	if (ctx) {
 		mutex_lock(&ctx->lock);
 		pr_debug("(%s): Reserved\n", ctx->name);
-		list_for_each_entry(block, ctx->reserved_list, node) {
+		list_for_each_entry(block, &ctx->reserved_list, node) {
 			pr_debug("\t\t (%s): address = 0x%pa[p], size = 0x%lx\n",
 				 ctx->name, &block->address, block->size);
 		}
 		pr_debug("(%s): Free\n", ctx->name);
-		list_for_each_entry(block, ctx->free_list, node) {
+		for (node = rb_first(&ctx->free_addr_tree); node;
+		     node = rb_next(node)) {
+			block = rb_entry(node, struct block_t, addr_node);
 			pr_debug("\t\t (%s): address = 0x%pa[p], size = 0x%lx\n",
 				 ctx->name, &block->address, block->size);
 		}
@@ -274,8 +387,8 @@ iova_mngr_print(void *mngr_handle)
 
 /*
  * Initialises the IOVA space manager with the base address + size
- * provided. IOVA manager would use two lists for book-keeping reserved
- * memory blocks and free memory blocks.
+ * provided. IOVA manager would use a list for book-keeping reserved
+ * memory blocks and two trees for free memory blocks.
  *
  * When initialised all of the IOVA region: base_address + size is free.
  */
@@ -296,17 +409,10 @@ iova_mngr_init(char *name, u64 base_address, size_t size, void **mngr_handle)
 		goto err;
 	}
 
-	ctx->free_list = kzalloc(sizeof(*ctx->free_list), GFP_KERNEL);
-	if (WARN_ON(!ctx->free_list)) {
-		ret = -ENOMEM;
-		goto err;
-	}
-
-	ctx->reserved_list = kzalloc(sizeof(*ctx->reserved_list), GFP_KERNEL);
-	if (WARN_ON(!ctx->reserved_list)) {
-		ret = -ENOMEM;
-		goto err;
-	}
+	ctx->free_addr_tree = RB_ROOT;
+	ctx->free_size_tree = RB_ROOT;
+	INIT_LIST_HEAD(&ctx->reserved_list);
+	mutex_init(&ctx->lock);
 
 	if (strlen(name) > (NAME_MAX - 1)) {
 		ret = -EINVAL;
@@ -314,9 +420,6 @@ iova_mngr_init(char *name, u64 base_address, size_t size, void **mngr_handle)
 		goto err;
 	}
 	strcpy(ctx->name, name);
-	INIT_LIST_HEAD(ctx->reserved_list);
-	INIT_LIST_HEAD(ctx->free_list);
-	mutex_init(&ctx->lock);
 	ctx->base_address = base_address;
 
 	/* add the base_addrss+size as one whole free block.*/
@@ -327,7 +430,7 @@ iova_mngr_init(char *name, u64 base_address, size_t size, void **mngr_handle)
 	}
 	block->address = base_address;
 	block->size = size;
-	list_add(&block->node, ctx->free_list);
+	free_block_insert(ctx, block);
 
 	*mngr_handle = ctx;
 	return ret;
@@ -345,7 +448,7 @@ err:
 void
 iova_mngr_deinit(void **mngr_handle)
 {
-	struct block_t *block = NULL;
+	struct block_t *block = NULL, *temp = NULL;
 	struct list_head *curr = NULL, *next = NULL;
 	struct mngr_ctx_t *ctx = (struct mngr_ctx_t *)(*mngr_handle);
 
@@ -354,8 +457,8 @@ iova_mngr_deinit(void **mngr_handle)
 		iova_mngr_print(*mngr_handle);
 
 		/* ideally, all blocks should have returned before this.*/
-		if (!list_empty(ctx->reserved_list)) {
-			list_for_each_safe(curr, next, ctx->reserved_list) {
+		if (!list_empty(&ctx->reserved_list)) {
+			list_for_each_safe(curr, next, &ctx->reserved_list) {
 				block = list_entry(curr, struct block_t, node);
 				iova_mngr_block_release(*mngr_handle,
 							(void **)(&block));
@@ -363,15 +466,12 @@ iova_mngr_deinit(void **mngr_handle)
 		}
 
 		/* ideally, just one whole free block should remain as free.*/
-		list_for_each_safe(curr, next, ctx->free_list) {
-			block = list_entry(curr, struct block_t, node);
-			list_del(&block->node);
+		rbtree_postorder_for_each_entry_safe(block, temp,
+						     &ctx->free_addr_tree,
+						     addr_node)
 			kfree(block);
-		}
 
 		mutex_destroy(&ctx->lock);
-		kfree(ctx->reserved_list);
-		kfree(ctx->free_list);
 		kfree(ctx);
 		*mngr_handle = NULL;
 	}
@@ -18,11 +18,23 @@ iova_mngr_block_reserve(void *mngr_handle, size_t size,
 			u64 *address, size_t *offset,
 			void **block_handle);
 
+/*
+ * iova_mngr_block_reserve_aligned
+ *
+ * Same as iova_mngr_block_reserve, but the reserved block address is a
+ * multiple of @align (power of 2, 0 for no alignment). Picks the smallest
+ * free block the aligned reservation fits in.
+ */
+int
+iova_mngr_block_reserve_aligned(void *mngr_handle, size_t size, size_t align,
+				u64 *address, size_t *offset,
+				void **block_handle);
+
 /*
  * iova_mngr_block_release
  *
  * Release an already reserved IOVA block/chunk by the caller back to
- * free list.
+ * free blocks, merging with adjacent free blocks.
  */
 int
 iova_mngr_block_release(void *mngr_handle, void **block_handle);
@@ -41,8 +53,8 @@ void iova_mngr_print(void *handle);
  * iova_mngr_init
  *
  * Initialises the IOVA space manager with the base address + size
- * provided. IOVA manager would use two lists for book-keeping reserved
- * memory blocks and free memory blocks.
+ * provided. IOVA manager would use a list for book-keeping reserved
+ * memory blocks and two trees for free memory blocks.
  *
  * When initialised all of the IOVA region: base_address + size is free.
  */
@@ -387,12 +387,24 @@ pci_client_alloc_iova(void *pci_client_h, size_t size, u64 *iova,
 		      size_t *offset, void **block_h)
 {
 	struct pci_client_t *ctx = (struct pci_client_t *)pci_client_h;
+	int ret = -ENOMEM;
 
 	if (WARN_ON(!ctx))
 		return -EINVAL;
 
-	return iova_mngr_block_reserve(ctx->mem_mngr_h, size,
-				       iova, offset, block_h);
+	/*
+	 * keep large mappings SZ_2M aligned so the IOMMU can use block
+	 * mappings, fall back to any free space if that does not fit.
+	 */
+	if (size >= SZ_2M)
+		ret = iova_mngr_block_reserve_aligned(ctx->mem_mngr_h, size,
+						      SZ_2M, iova, offset,
+						      block_h);
+	if (ret == -ENOMEM)
+		ret = iova_mngr_block_reserve(ctx->mem_mngr_h, size,
+					      iova, offset, block_h);
+
+	return ret;
 }
 
 int
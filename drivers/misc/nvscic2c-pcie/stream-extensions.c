@@ -37,6 +37,15 @@ MODULE_IMPORT_NS(VFS_internal_I_am_really_a_filesystem_and_am_NOT_a_driver);
 struct stream_ext_ctx_t;
 struct stream_ext_obj;
 
+/*
+ * copy requests submitted while eDMA is busy are held back and chained into
+ * one eDMA submission (single doorbell, single completion interrupt) once
+ * a batch in flight completes.
+ */
+#define MAX_INFLIGHT_BATCHES	(2)
+/* descriptors chained in one eDMA submission.*/
+#define MAX_BATCH_EDMA_DESC	(NUM_EDMA_DESC / 8)
+
 /* limits as set for copy requests.*/
 struct copy_req_limits {
 	u64 max_copy_requests;
@@ -127,6 +136,9 @@ struct copy_request {
 	 */
 	u64 *remote_post_fence_values;
 	enum peer_cpu_t peer_cpu;
+
+	/* last copy request of an eDMA submission.*/
+	bool batch_end;
 };
 
 struct stream_ext_obj {
@@ -210,6 +222,14 @@ struct stream_ext_ctx_t {
 	atomic_t transfer_count;
 	wait_queue_head_t transfer_waitq;
 
+	/* copy requests prepared but not yet submitted to eDMA.*/
+	struct list_head pending_list;
+	/* guard pending_list, inflight_batches and xfer_info.*/
+	struct mutex submit_lock;
+	u32 inflight_batches;
+	/* one entry per copy request chained in an eDMA submission.*/
+	struct tegra_pcie_edma_xfer_info *xfer_info;
+
 	/* allocated stream obj list for book-keeping.*/
 	struct list_head obj_list;
 };
@@ -230,12 +250,14 @@ static int
 prepare_edma_desc(enum drv_mode_t drv_mode, struct copy_req_params *params,
 		  struct tegra_pcie_edma_desc *desc, u64 *num_desc);
 
-static edma_xfer_status_t
-schedule_edma_xfer(void *edma_h, void *priv, u64 num_desc,
-		   struct tegra_pcie_edma_desc *desc);
+static int
+schedule_edma_xfer(struct stream_ext_ctx_t *ctx, struct copy_request *own);
 static void
 callback_edma_xfer(void *priv, edma_xfer_status_t status,
 		   struct tegra_pcie_edma_desc *desc);
+
+static void
+complete_copy_request(struct copy_request *cr, edma_xfer_status_t status);
 static int
 validate_handle(struct stream_ext_ctx_t *ctx, s32 handle,
 		enum nvscic2c_pcie_obj_type type);
@@ -556,7 +578,6 @@ ioctl_submit_copy_request(struct stream_ext_ctx_t *ctx,
 {
 	int ret = 0;
 	struct copy_request *cr = NULL;
-	edma_xfer_status_t edma_status = EDMA_XFER_FAIL_INVAL_INPUTS;
 	enum nvscic2c_pcie_link link = NVSCIC2C_PCIE_LINK_DOWN;
 
 	link = pci_client_query_link_status(ctx->pci_client_h);
@@ -608,12 +629,18 @@ ioctl_submit_copy_request(struct stream_ext_ctx_t *ctx,
 		goto reclaim_cr;
 	}
 
-	/* schedule asynchronous eDMA.*/
+	/*
+	 * schedule asynchronous eDMA. Goes out right away unless eDMA is busy
+	 * with earlier batches, then it is chained with other held back
+	 * requests when one of those completes.
+	 */
 	atomic_inc(&ctx->transfer_count);
-	edma_status = schedule_edma_xfer(ctx->edma_h, (void *)cr,
-					 cr->num_edma_desc, cr->edma_desc);
-	if (edma_status != EDMA_XFER_SUCCESS) {
-		ret = -EIO;
+	mutex_lock(&ctx->submit_lock);
+	list_add_tail(&cr->node, &ctx->pending_list);
+	ret = schedule_edma_xfer(ctx, cr);
+	mutex_unlock(&ctx->submit_lock);
+	if (ret) {
+		/* not submitted, fail the caller's request alone.*/
 		atomic_dec(&ctx->transfer_count);
 		release_copy_request_handles(cr);
 		goto reclaim_cr;
@@ -660,6 +687,14 @@ ioctl_set_max_copy_requests(struct stream_ext_ctx_t *ctx,
 		goto clean_up;
 	}
 
+	/* worst-case: all copy requests chained in one eDMA submission.*/
+	ctx->xfer_info = kcalloc(ctx->cr_limits.max_copy_requests,
+				 sizeof(*ctx->xfer_info), GFP_KERNEL);
+	if (WARN_ON(!ctx->xfer_info)) {
+		ret = -ENOMEM;
+		goto clean_up;
+	}
+
 	/* allocate the maximum outstanding copy requests we can have.*/
 	for (i = 0; i < ctx->cr_limits.max_copy_requests; i++) {
 		cr = NULL;
@@ -686,6 +721,8 @@ clean_up:
 	mutex_unlock(&ctx->free_lock);
 
 	free_copy_req_params(&ctx->cr_params);
+	kfree(ctx->xfer_info);
+	ctx->xfer_info = NULL;
 
 	return ret;
 }
@@ -776,6 +813,8 @@ stream_extension_init(struct stream_ext_params *params, void **stream_ext_h)
 	INIT_LIST_HEAD(&ctx->free_list);
 	atomic_set(&ctx->transfer_count, 0);
 	init_waitqueue_head(&ctx->transfer_waitq);
+	mutex_init(&ctx->submit_lock);
+	INIT_LIST_HEAD(&ctx->pending_list);
 
 	/* bookkeeping of stream objs. */
 	INIT_LIST_HEAD(&ctx->obj_list);
@@ -820,6 +859,8 @@ stream_extension_deinit(void **stream_ext_h)
 	mutex_unlock(&ctx->free_lock);
 	free_copy_req_params(&ctx->cr_params);
 	mutex_destroy(&ctx->free_lock);
+	kfree(ctx->xfer_info);
+	mutex_destroy(&ctx->submit_lock);
 
 	/*
 	 * clean-up the non freed stream objs. Descriptor shall be freed when
@@ -935,23 +976,93 @@ allocate_handle(struct stream_ext_ctx_t *ctx, enum nvscic2c_pcie_obj_type type,
 	return handle;
 }
 
-static edma_xfer_status_t
-schedule_edma_xfer(void *edma_h, void *priv, u64 num_desc,
-		   struct tegra_pcie_edma_desc *desc)
+/*
+ * Submit held back copy requests to eDMA, chaining as many as fit in one
+ * submission, while fewer than MAX_INFLIGHT_BATCHES are in flight.
+ *
+ * @own is the request of the submit-copy caller, NULL from the eDMA
+ * callback. If the batch holding it fails to submit, it is taken out and
+ * -EIO returned for the caller to reclaim it, the other requests are
+ * retried without it. Requests already accepted that still fail to submit
+ * are completed with the eDMA error.
+ *
+ * Must be called with submit_lock held.
+ */
+static int
+schedule_edma_xfer(struct stream_ext_ctx_t *ctx, struct copy_request *own)
 {
-	struct tegra_pcie_edma_xfer_info info = {0};
+	int ret = 0;
+	u32 i = 0, num = 0;
+	u64 num_desc = 0;
+	bool own_in_batch = false;
+	struct copy_request *cr = NULL, *next = NULL;
+	struct tegra_pcie_edma_xfer_info *info = NULL;
+	edma_xfer_status_t edma_status = EDMA_XFER_FAIL_INVAL_INPUTS;
 
-	if (WARN_ON(!num_desc || !desc))
-		return -EINVAL;
+	while (ctx->inflight_batches < MAX_INFLIGHT_BATCHES &&
+	       !list_empty(&ctx->pending_list)) {
+		num = 0;
+		num_desc = 0;
+		own_in_batch = false;
+		list_for_each_entry_safe(cr, next, &ctx->pending_list, node) {
+			if (num &&
+			    (num_desc + cr->num_edma_desc) > MAX_BATCH_EDMA_DESC)
+				break;
+
+			info = &ctx->xfer_info[num++];
+			info->type = EDMA_XFER_WRITE;
+			info->channel_num = 0; // no use-case to use all WR channels yet.
+			info->desc = cr->edma_desc;
+			info->nents = cr->num_edma_desc;
+			info->complete = callback_edma_xfer;
+			info->priv = cr;
+			num_desc += cr->num_edma_desc;
+			if (cr == own)
+				own_in_batch = true;
+
+			/* callback can race once submitted, unlink before.*/
+			cr->batch_end = false;
+			list_del(&cr->node);
+		}
+		cr = (struct copy_request *)ctx->xfer_info[num - 1].priv;
+		cr->batch_end = true;
+
+		ctx->inflight_batches++;
+		edma_status = tegra_pcie_edma_submit_xfer_batch(ctx->edma_h,
+								ctx->xfer_info,
+								num);
+		if (edma_status == EDMA_XFER_SUCCESS)
+			continue;
+
+		ctx->inflight_batches--;
+		if (edma_status == EDMA_XFER_FAIL_NOMEM && ctx->inflight_batches) {
+			/* eDMA ring full, retry when the batch in flight completes.*/
+			for (i = num; i > 0; i--) {
+				cr = (struct copy_request *)ctx->xfer_info[i - 1].priv;
+				list_add(&cr->node, &ctx->pending_list);
+			}
+			break;
+		}
 
-	info.type = EDMA_XFER_WRITE;
-	info.channel_num = 0; // no use-case to use all WR channels yet.
-	info.desc = desc;
-	info.nents = num_desc;
-	info.complete = callback_edma_xfer;
-	info.priv = priv;
+		if (own_in_batch) {
+			/* requeue the others in order and retry without it.*/
+			for (i = num; i > 0; i--) {
+				cr = (struct copy_request *)ctx->xfer_info[i - 1].priv;
+				if (cr != own)
+					list_add(&cr->node, &ctx->pending_list);
+			}
+			own = NULL;
+			ret = -EIO;
+			continue;
+		}
 
-	return tegra_pcie_edma_submit_xfer(edma_h, &info);
+		for (i = 0; i < num; i++) {
+			cr = (struct copy_request *)ctx->xfer_info[i].priv;
+			complete_copy_request(cr, edma_status);
+		}
+	}
+
+	return ret;
 }
 
 /* Callback with each async eDMA submit xfer.*/
@@ -960,16 +1071,36 @@ callback_edma_xfer(void *priv, edma_xfer_status_t status,
 		   struct tegra_pcie_edma_desc *desc)
 {
 	struct copy_request *cr = (struct copy_request *)priv;
+	struct stream_ext_ctx_t *ctx = cr->ctx;
+
+	/*
+	 * submit the held back copy requests before completing this one, it
+	 * keeps transfer_count up and ctx alive till then.
+	 */
+	if (cr->batch_end) {
+		mutex_lock(&ctx->submit_lock);
+		ctx->inflight_batches--;
+		(void)schedule_edma_xfer(ctx, NULL);
+		mutex_unlock(&ctx->submit_lock);
+	}
 
-	mutex_lock(&cr->ctx->free_lock);
+	complete_copy_request(cr, status);
+}
+
+static void
+complete_copy_request(struct copy_request *cr, edma_xfer_status_t status)
+{
+	struct stream_ext_ctx_t *ctx = cr->ctx;
+
+	mutex_lock(&ctx->free_lock);
 	/* increment post fences: local and remote.*/
 	if (status == EDMA_XFER_SUCCESS) {
 		signal_remote_post_fences(cr);
 		signal_local_post_fences(cr);
 	} else {
 		/* eDMA xfer failed, Update eDMA error and notify user. */
-		(void)pci_client_set_edma_error(cr->ctx->pci_client_h,
-						cr->ctx->ep_id,
+		(void)pci_client_set_edma_error(ctx->pci_client_h,
+						ctx->ep_id,
 						NVSCIC2C_PCIE_EDMA_XFER_ERROR);
 	}
 
@@ -977,11 +1108,11 @@ callback_edma_xfer(void *priv, edma_xfer_status_t status,
 	release_copy_request_handles(cr);
 
 	/* reclaim the copy_request for reuse.*/
-	list_add_tail(&cr->node, &cr->ctx->free_list);
-	mutex_unlock(&cr->ctx->free_lock);
+	list_add_tail(&cr->node, &ctx->free_list);
+	mutex_unlock(&ctx->free_lock);
 
-	if (atomic_dec_and_test(&cr->ctx->transfer_count))
-		wake_up_all(&cr->ctx->transfer_waitq);
+	if (atomic_dec_and_test(&ctx->transfer_count))
+		wake_up_all(&ctx->transfer_waitq);
 }
 
 static int
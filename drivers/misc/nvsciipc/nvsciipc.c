@@ -24,6 +24,10 @@
 #include <linux/cred.h>
 #include <linux/of.h>
 #include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/sched.h>
 
 #ifdef CONFIG_TEGRA_VIRTUALIZATION
 #include <soc/tegra/virt/syscalls.h>
@@ -51,6 +55,158 @@ static struct nvsciipc *ctx;
 static int32_t s_guestid = -1;
 #endif /* CONFIG_TEGRA_VIRTUALIZATION */
 
+static void nvsciipc_snapshot_release(struct kref *ref)
+{
+	struct nvsciipc_snapshot *snap = container_of(ref,
+			struct nvsciipc_snapshot, ref);
+
+	vfree(snap->hdr);
+	kfree(snap);
+}
+
+static void nvsciipc_snapshot_put(struct nvsciipc_snapshot *snap)
+{
+	kref_put(&snap->ref, nvsciipc_snapshot_release);
+}
+
+static struct nvsciipc_snapshot *nvsciipc_snapshot_get(struct nvsciipc *ctx)
+{
+	struct nvsciipc_snapshot *snap;
+
+	spin_lock(&ctx->snap_lock);
+	snap = ctx->snap;
+	if (snap != NULL)
+		kref_get(&snap->ref);
+	spin_unlock(&ctx->snap_lock);
+
+	return snap;
+}
+
+static void nvsciipc_snapshot_replace(struct nvsciipc *ctx,
+		struct nvsciipc_snapshot *snap)
+{
+	struct nvsciipc_snapshot *old;
+
+	spin_lock(&ctx->snap_lock);
+	old = ctx->snap;
+	ctx->snap = snap;
+	spin_unlock(&ctx->snap_lock);
+
+	if (old != NULL) {
+		WRITE_ONCE(old->hdr->stale, 1U);
+		nvsciipc_snapshot_put(old);
+	}
+}
+
+static int nvsciipc_snapshot_find_name(struct nvsciipc_snapshot *snap,
+		const char *name)
+{
+	uint32_t slot = nvsciipc_db_name_hash(name) & snap->hash_mask;
+	uint32_t idx;
+
+	while ((idx = snap->name_hash[slot]) != NVSCIIPC_DB_HASH_EMPTY) {
+		if (!strncmp(name, snap->entries[idx].ep_name,
+			NVSCIIPC_MAX_EP_NAME))
+			return idx;
+
+		slot = (slot + 1U) & snap->hash_mask;
+	}
+
+	return -ENOENT;
+}
+
+static int nvsciipc_snapshot_find_vuid(struct nvsciipc_snapshot *snap,
+		uint64_t vuid)
+{
+	uint32_t slot = nvsciipc_db_vuid_hash(vuid) & snap->hash_mask;
+	uint32_t idx;
+
+	while ((idx = snap->vuid_hash[slot]) != NVSCIIPC_DB_HASH_EMPTY) {
+		if (snap->entries[idx].vuid == vuid)
+			return idx;
+
+		slot = (slot + 1U) & snap->hash_mask;
+	}
+
+	return -ENOENT;
+}
+
+static void nvsciipc_snapshot_insert(struct nvsciipc_snapshot *snap,
+		uint32_t *table, uint32_t hash, uint32_t idx)
+{
+	uint32_t slot = hash & snap->hash_mask;
+
+	while (table[slot] != NVSCIIPC_DB_HASH_EMPTY)
+		slot = (slot + 1U) & snap->hash_mask;
+
+	table[slot] = idx;
+}
+
+/* copy ctx->db into a mappable table and index it by name and vuid */
+static struct nvsciipc_snapshot *nvsciipc_snapshot_build(struct nvsciipc *ctx)
+{
+	struct nvsciipc_snapshot *snap;
+	struct nvsciipc_db_snapshot_header *hdr;
+	uint64_t entries_size, hash_bytes, size;
+	uint32_t hash_size;
+	int i;
+
+	/* offsets in the header are 32-bit */
+	if (ctx->num_eps > (U32_MAX / 4U) / sizeof(struct nvsciipc_config_entry)) {
+		ERR("endpoint database too large\n");
+		return ERR_PTR(-E2BIG);
+	}
+
+	/* at most half full so probe chains stay short */
+	hash_size = roundup_pow_of_two(max(ctx->num_eps, 8) * 2U);
+	entries_size = (uint64_t)ctx->num_eps *
+			sizeof(struct nvsciipc_config_entry);
+	hash_bytes = (uint64_t)hash_size * sizeof(uint32_t);
+	size = sizeof(*hdr) + entries_size + hash_bytes * 2U;
+
+	snap = kzalloc(sizeof(*snap), GFP_KERNEL);
+	if (snap == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	snap->size = PAGE_ALIGN(size);
+	hdr = vmalloc_user(snap->size);
+	if (hdr == NULL) {
+		kfree(snap);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	kref_init(&snap->ref);
+	snap->hdr = hdr;
+	snap->hash_mask = hash_size - 1U;
+	snap->entries = (void *)(hdr + 1);
+	snap->name_hash = (void *)((uint8_t *)snap->entries + entries_size);
+	snap->vuid_hash = snap->name_hash + hash_size;
+
+	hdr->magic = NVSCIIPC_DB_SNAPSHOT_MAGIC;
+	hdr->version = NVSCIIPC_DB_SNAPSHOT_VERSION;
+	hdr->generation = ++ctx->snap_generation;
+	hdr->total_size = snap->size;
+	hdr->num_eps = ctx->num_eps;
+	hdr->entry_size = sizeof(struct nvsciipc_config_entry);
+	hdr->entries_offset = sizeof(*hdr);
+	hdr->hash_size = hash_size;
+	hdr->name_hash_offset = hdr->entries_offset + entries_size;
+	hdr->vuid_hash_offset = hdr->name_hash_offset + hash_bytes;
+
+	memset(snap->name_hash, 0xFF, hash_bytes * 2U);
+
+	for (i = 0; i < ctx->num_eps; i++) {
+		snap->entries[i] = *ctx->db[i];
+
+		nvsciipc_snapshot_insert(snap, snap->name_hash,
+			nvsciipc_db_name_hash(snap->entries[i].ep_name), i);
+		nvsciipc_snapshot_insert(snap, snap->vuid_hash,
+			nvsciipc_db_vuid_hash(snap->entries[i].vuid), i);
+	}
+
+	return snap;
+}
+
 NvSciError NvSciIpcEndpointGetAuthToken(NvSciIpcEndpoint handle,
 		NvSciIpcEndpointAuthToken *authToken)
 {
@@ -130,6 +286,7 @@ NvSciError NvSciIpcEndpointMapVuid(NvSciIpcEndpointVuid localUserVuid,
 {
 	uint32_t backend = NVSCIIPC_BACKEND_UNKNOWN;
 	struct nvsciipc_config_entry *entry;
+	struct nvsciipc_snapshot *snap;
 	int i;
 	NvSciError ret;
 
@@ -143,19 +300,22 @@ NvSciError NvSciIpcEndpointMapVuid(NvSciIpcEndpointVuid localUserVuid,
 		return NvSciError_NotInitialized;
 	}
 
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (ctx->db[i]->vuid == localUserVuid) {
-			backend = ctx->db[i]->backend;
-			entry = ctx->db[i];
-			break;
-		}
+	snap = nvsciipc_snapshot_get(ctx);
+	if (snap == NULL) {
+		ERR("not initialized\n");
+		return NvSciError_NotInitialized;
 	}
 
-	if (i == ctx->num_eps) {
+	i = nvsciipc_snapshot_find_vuid(snap, localUserVuid);
+	if (i < 0) {
+		nvsciipc_snapshot_put(snap);
 		ERR("wrong localUserVuid passed\n");
 		return NvSciError_BadParameter;
 	}
 
+	entry = &snap->entries[i];
+	backend = entry->backend;
+
 	switch (backend) {
 	case NVSCIIPC_BACKEND_ITC:
 	case NVSCIIPC_BACKEND_IPC:
@@ -184,6 +344,8 @@ NvSciError NvSciIpcEndpointMapVuid(NvSciIpcEndpointVuid localUserVuid,
 		break;
 	}
 
+	nvsciipc_snapshot_put(snap);
+
 	return ret;
 }
 EXPORT_SYMBOL(NvSciIpcEndpointMapVuid);
@@ -209,6 +371,8 @@ static void nvsciipc_free_db(struct nvsciipc *ctx)
 		kfree(ctx->db);
 	}
 
+	nvsciipc_snapshot_replace(ctx, NULL);
+
 	ctx->num_eps = 0;
 }
 
@@ -301,6 +465,7 @@ static int nvsciipc_ioctl_get_db_by_name(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
 	struct nvsciipc_get_db_by_name get_db;
+	struct nvsciipc_snapshot *snap;
 	int i;
 
 	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
@@ -314,17 +479,19 @@ static int nvsciipc_ioctl_get_db_by_name(struct nvsciipc *ctx, unsigned int cmd,
 		return -EFAULT;
 	}
 
+	snap = nvsciipc_snapshot_get(ctx);
+	if (snap == NULL)
+		return -EPERM;
+
 	/* read operation */
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (!strncmp(get_db.ep_name, ctx->db[i]->ep_name,
-			NVSCIIPC_MAX_EP_NAME)) {
-			get_db.entry = *ctx->db[i];
-			get_db.idx = i;
-			break;
-		}
+	i = nvsciipc_snapshot_find_name(snap, get_db.ep_name);
+	if (i >= 0) {
+		get_db.entry = snap->entries[i];
+		get_db.idx = i;
 	}
+	nvsciipc_snapshot_put(snap);
 
-	if (i == ctx->num_eps) {
+	if (i < 0) {
 		INFO("%s: no entry (%s)\n", __func__, get_db.ep_name);
 		return -ENOENT;
 	} else if (copy_to_user((void __user *)arg, &get_db,
@@ -340,6 +507,7 @@ static int nvsciipc_ioctl_get_db_by_vuid(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
 	struct nvsciipc_get_db_by_vuid get_db;
+	struct nvsciipc_snapshot *snap;
 	int i;
 
 	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
@@ -353,16 +521,19 @@ static int nvsciipc_ioctl_get_db_by_vuid(struct nvsciipc *ctx, unsigned int cmd,
 		return -EFAULT;
 	}
 
+	snap = nvsciipc_snapshot_get(ctx);
+	if (snap == NULL)
+		return -EPERM;
+
 	/* read operation */
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (get_db.vuid == ctx->db[i]->vuid) {
-			get_db.entry = *ctx->db[i];
-			get_db.idx = i;
-			break;
-		}
+	i = nvsciipc_snapshot_find_vuid(snap, get_db.vuid);
+	if (i >= 0) {
+		get_db.entry = snap->entries[i];
+		get_db.idx = i;
 	}
+	nvsciipc_snapshot_put(snap);
 
-	if (i == ctx->num_eps) {
+	if (i < 0) {
 		INFO("%s: no entry (0x%llx)\n", __func__, get_db.vuid);
 		return -ENOENT;
 	} else if (copy_to_user((void __user *)arg, &get_db,
@@ -378,6 +549,7 @@ static int nvsciipc_ioctl_get_vuid(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
 	struct nvsciipc_get_vuid get_vuid;
+	struct nvsciipc_snapshot *snap;
 	int i;
 
 	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
@@ -391,16 +563,17 @@ static int nvsciipc_ioctl_get_vuid(struct nvsciipc *ctx, unsigned int cmd,
 		return -EFAULT;
 	}
 
+	snap = nvsciipc_snapshot_get(ctx);
+	if (snap == NULL)
+		return -EPERM;
+
 	/* read operation */
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (!strncmp(get_vuid.ep_name, ctx->db[i]->ep_name,
-			NVSCIIPC_MAX_EP_NAME)) {
-			get_vuid.vuid = ctx->db[i]->vuid;
-			break;
-		}
-	}
+	i = nvsciipc_snapshot_find_name(snap, get_vuid.ep_name);
+	if (i >= 0)
+		get_vuid.vuid = snap->entries[i].vuid;
+	nvsciipc_snapshot_put(snap);
 
-	if (i == ctx->num_eps) {
+	if (i < 0) {
 		INFO("%s: no entry (%s)\n", __func__, get_vuid.ep_name);
 		return -ENOENT;
 	} else if (copy_to_user((void __user *)arg, &get_vuid,
@@ -417,6 +590,7 @@ static int nvsciipc_ioctl_set_db(struct nvsciipc *ctx, unsigned int cmd,
 {
 	struct nvsciipc_db user_db;
 	struct nvsciipc_config_entry **entry_ptr;
+	struct nvsciipc_snapshot *snap;
 	int ret = 0;
 	int i;
 
@@ -523,6 +697,14 @@ static int nvsciipc_ioctl_set_db(struct nvsciipc *ctx, unsigned int cmd,
 	}
 #endif /* CONFIG_TEGRA_VIRTUALIZATION */
 
+	snap = nvsciipc_snapshot_build(ctx);
+	if (IS_ERR(snap)) {
+		ERR("building endpoint snapshot failed\n");
+		ret = PTR_ERR(snap);
+		goto ptr_error;
+	}
+	nvsciipc_snapshot_replace(ctx, snap);
+
 	kfree(entry_ptr);
 
 	ctx->set_db_f = true;
@@ -552,6 +734,83 @@ ptr_error:
 	return ret;
 }
 
+static int nvsciipc_ioctl_resolve(struct nvsciipc *ctx, unsigned int cmd,
+		unsigned long arg)
+{
+	struct nvsciipc_resolve op;
+	struct nvsciipc_resolve_entry res;
+	struct nvsciipc_resolve_entry __user *uentry;
+	struct nvsciipc_snapshot *snap;
+	uint32_t i;
+	int idx;
+	int32_t ret = 0;
+
+	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
+		ERR("%s[%d] need to set endpoint database first\n", __func__,
+			get_current()->pid);
+		return -EPERM;
+	}
+
+	if (copy_from_user(&op, (void __user *)arg, _IOC_SIZE(cmd))) {
+		ERR("%s : copy_from_user failed\n", __func__);
+		return -EFAULT;
+	}
+
+	if ((op.flags & ~NVSCIIPC_RESOLVE_BY_VUID) != 0U) {
+		ERR("%s : invalid flags 0x%x\n", __func__, op.flags);
+		return -EINVAL;
+	}
+
+	snap = nvsciipc_snapshot_get(ctx);
+	if (snap == NULL)
+		return -EPERM;
+
+	uentry = u64_to_user_ptr(op.entries);
+	op.num_found = 0U;
+
+	for (i = 0U; i < op.count; i++) {
+		if (copy_from_user(&res, &uentry[i], sizeof(res))) {
+			ERR("%s : copy_from_user failed\n", __func__);
+			ret = -EFAULT;
+			goto exit;
+		}
+
+		if ((op.flags & NVSCIIPC_RESOLVE_BY_VUID) != 0U)
+			idx = nvsciipc_snapshot_find_vuid(snap, res.vuid);
+		else
+			idx = nvsciipc_snapshot_find_name(snap, res.ep_name);
+
+		if (idx < 0) {
+			memset(&res.entry, 0, sizeof(res.entry));
+			res.idx = 0U;
+			res.status = -ENOENT;
+		} else {
+			res.entry = snap->entries[idx];
+			res.idx = idx;
+			res.status = 0;
+			op.num_found++;
+		}
+
+		if (copy_to_user(&uentry[i], &res, sizeof(res))) {
+			ERR("%s : copy_to_user failed\n", __func__);
+			ret = -EFAULT;
+			goto exit;
+		}
+
+		cond_resched();
+	}
+
+	if (copy_to_user((void __user *)arg, &op, _IOC_SIZE(cmd))) {
+		ERR("%s : copy_to_user failed\n", __func__);
+		ret = -EFAULT;
+	}
+
+exit:
+	nvsciipc_snapshot_put(snap);
+
+	return ret;
+}
+
 static int nvsciipc_ioctl_get_dbsize(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
@@ -613,6 +872,9 @@ static long nvsciipc_dev_ioctl(struct file *filp, unsigned int cmd,
 	case NVSCIIPC_IOCTL_GET_DB_SIZE:
 		ret = nvsciipc_ioctl_get_dbsize(ctx, cmd, arg);
 		break;
+	case NVSCIIPC_IOCTL_RESOLVE:
+		ret = nvsciipc_ioctl_resolve(ctx, cmd, arg);
+		break;
 #if DEBUG_AUTH_API
 	case NVSCIIPC_IOCTL_VALIDATE_AUTH_TOKEN:
 		ret = nvsciipc_ioctl_validate_auth_token(ctx, cmd, arg);
@@ -673,6 +935,68 @@ static ssize_t nvsciipc_dbg_read(struct file *filp, char __user *buf,
 	return 0;
 }
 
+static void nvsciipc_vm_open(struct vm_area_struct *vma)
+{
+	struct nvsciipc_snapshot *snap = vma->vm_private_data;
+
+	kref_get(&snap->ref);
+}
+
+static void nvsciipc_vm_close(struct vm_area_struct *vma)
+{
+	nvsciipc_snapshot_put(vma->vm_private_data);
+}
+
+static const struct vm_operations_struct nvsciipc_vm_ops = {
+	.open = nvsciipc_vm_open,
+	.close = nvsciipc_vm_close,
+};
+
+/* map the current endpoint snapshot read-only */
+static int nvsciipc_dev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct nvsciipc *ctx = filp->private_data;
+	struct nvsciipc_snapshot *snap;
+	int ret;
+
+	if ((vma->vm_flags & VM_WRITE) != 0UL)
+		return -EPERM;
+
+	snap = nvsciipc_snapshot_get(ctx);
+	if (snap == NULL) {
+		ERR("%s[%d] need to set endpoint database first\n", __func__,
+			get_current()->pid);
+		return -EPERM;
+	}
+
+	if ((vma->vm_pgoff != 0UL) ||
+	    (vma->vm_end - vma->vm_start > snap->size)) {
+		ret = -EINVAL;
+		goto fail;
+	}
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	ret = remap_vmalloc_range(vma, snap->hdr, 0);
+	if (ret != 0)
+		goto fail;
+
+	/* the reference is dropped by nvsciipc_vm_close() */
+	vma->vm_private_data = snap;
+	vma->vm_ops = &nvsciipc_vm_ops;
+
+	return 0;
+
+fail:
+	nvsciipc_snapshot_put(snap);
+
+	return ret;
+}
+
 static const struct file_operations nvsciipc_fops = {
 	.owner		= THIS_MODULE,
 	.open		= nvsciipc_dev_open,
@@ -680,6 +1004,7 @@ static const struct file_operations nvsciipc_fops = {
 	.unlocked_ioctl	= nvsciipc_dev_ioctl,
 	.llseek		= no_llseek,
 	.read		= nvsciipc_dbg_read,
+	.mmap		= nvsciipc_dev_mmap,
 };
 
 static int nvsciipc_probe(struct platform_device *pdev)
@@ -699,6 +1024,7 @@ static int nvsciipc_probe(struct platform_device *pdev)
 		goto error;
 	}
 	ctx->set_db_f = false;
+	spin_lock_init(&ctx->snap_lock);
 
 	ctx->dev = &(pdev->dev);
 	platform_set_drvdata(pdev, ctx);
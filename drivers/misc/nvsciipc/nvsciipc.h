@@ -6,6 +6,8 @@
 #ifndef __NVSCIIPC_KERNEL_H__
 #define __NVSCIIPC_KERNEL_H__
 
+#include <linux/kref.h>
+#include <linux/spinlock.h>
 #include <linux/nvscierror.h>
 #include <linux/nvsciipc_interface.h>
 #include <uapi/linux/nvsciipc_ioctl.h>
@@ -24,6 +26,17 @@
 #define NVSCIIPC_BACKEND_C2C_NPM	4U
 #define NVSCIIPC_BACKEND_UNKNOWN	0xFFFFFFFFU
 
+/* refcounted, mmap()ed by clients; see struct nvsciipc_db_snapshot_header */
+struct nvsciipc_snapshot {
+	struct kref ref;
+	size_t size;
+	struct nvsciipc_db_snapshot_header *hdr;
+	struct nvsciipc_config_entry *entries;
+	uint32_t *name_hash;
+	uint32_t *vuid_hash;
+	uint32_t hash_mask;
+};
+
 struct nvsciipc {
 	struct device *dev;
 
@@ -36,6 +49,11 @@ struct nvsciipc {
 	int num_eps;
 	struct nvsciipc_config_entry **db;
 	volatile bool set_db_f;
+
+	/* endpoint snapshot and hash indexes, replaced by every set_db */
+	spinlock_t snap_lock;
+	struct nvsciipc_snapshot *snap;
+	uint32_t snap_generation;
 };
 
 struct vuid_bitfield_64 {
@@ -65,5 +83,7 @@ static int nvsciipc_ioctl_get_vuid(struct nvsciipc *ctx, unsigned int cmd,
 			unsigned long arg);
 static int nvsciipc_ioctl_set_db(struct nvsciipc *ctx, unsigned int cmd,
 			unsigned long arg);
+static int nvsciipc_ioctl_resolve(struct nvsciipc *ctx, unsigned int cmd,
+			unsigned long arg);
 
 #endif /* __NVSCIIPC_KERNEL_H__ */
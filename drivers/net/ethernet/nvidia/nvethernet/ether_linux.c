@@ -1782,6 +1782,12 @@ static void ether_free_rx_skbs(struct osi_rx_swcx *rx_swcx,
 
 		if (prx_swcx->buf_virt_addr != NULL) {
 			if (resv_buf_virt_addr != prx_swcx->buf_virt_addr) {
+#ifdef ETHER_XDP
+				if (chan != ETHER_INVALID_CHAN_NUM &&
+				    pdata->xsk_pool[chan])
+					xsk_buff_free(prx_swcx->buf_virt_addr);
+				else
+#endif
 #ifdef ETHER_PAGE_POOL
 				if (chan != ETHER_INVALID_CHAN_NUM)
 					page_pool_put_full_page(pdata->page_pool[chan],
@@ -1836,6 +1842,11 @@ static void free_rx_dma_resources(struct osi_dma_priv_data *osi_dma,
 			kfree(rx_ring);
 			osi_dma->rx_ring[i] = NULL;
 		}
+#ifdef ETHER_XDP
+		if (chan != ETHER_INVALID_CHAN_NUM &&
+		    xdp_rxq_info_is_reg(&pdata->xdp_rxq[chan]))
+			xdp_rxq_info_unreg(&pdata->xdp_rxq[chan]);
+#endif
 #ifdef ETHER_PAGE_POOL
 		if (chan != ETHER_INVALID_CHAN_NUM && pdata->page_pool[chan]) {
 			page_pool_destroy(pdata->page_pool[chan]);
@@ -1938,6 +1949,27 @@ static int ether_allocate_rx_buffers(struct ether_priv_data *pdata,
 
 		rx_swcx = rx_ring->rx_swcx + i;
 
+#ifdef ETHER_XDP
+		if (chan != ETHER_INVALID_CHAN_NUM && pdata->xsk_pool[chan]) {
+			struct xdp_buff *xdp;
+
+			/* Fill ring may not be populated by user space yet,
+			 * park the descriptor on the reserved buffer and let
+			 * Rx refill pick up UMEM frames once available.
+			 */
+			xdp = xsk_buff_alloc(pdata->xsk_pool[chan]);
+			if (!xdp) {
+				rx_swcx->buf_virt_addr = pdata->resv_buf_virt_addr;
+				rx_swcx->buf_phy_addr = pdata->resv_buf_phy_addr;
+				pdata->xsk_rx_starved[chan] = true;
+				continue;
+			}
+
+			rx_swcx->buf_virt_addr = xdp;
+			rx_swcx->buf_phy_addr = xsk_buff_xdp_get_dma(xdp);
+			continue;
+		}
+#endif
 #ifdef ETHER_PAGE_POOL
 		if (chan != ETHER_INVALID_CHAN_NUM) {
 			page = page_pool_dev_alloc_pages(pdata->page_pool[chan]);
@@ -1947,7 +1979,8 @@ static int ether_allocate_rx_buffers(struct ether_priv_data *pdata,
 				return -ENOMEM;
 			}
 
-			dma_addr = page_pool_get_dma_addr(page);
+			dma_addr = page_pool_get_dma_addr(page) +
+				   ETHER_RX_BUF_OFFSET;
 			rx_swcx->buf_virt_addr = page;
 		}
 #else
@@ -1974,6 +2007,47 @@ static int ether_allocate_rx_buffers(struct ether_priv_data *pdata,
 	return 0;
 }
 
+#ifdef ETHER_XDP
+/**
+ * @brief Register XDP Rx queue info for a channel
+ *
+ * Algorithm: Register Rx queue info with the memory model of the Rx
+ * buffers, AF_XDP buffer pool if bound to the channel else page pool.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] chan: Rx DMA channel number.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xdp_rxq_reg(struct ether_priv_data *pdata, unsigned int chan)
+{
+	struct xsk_buff_pool *pool = pdata->xsk_pool[chan];
+	struct xdp_rxq_info *rxq = &pdata->xdp_rxq[chan];
+	int ret;
+
+	ret = xdp_rxq_info_reg(rxq, pdata->ndev, chan,
+			       pdata->rx_napi[chan]->napi.napi_id);
+	if (ret < 0)
+		return ret;
+
+	if (pool) {
+		ret = xdp_rxq_info_reg_mem_model(rxq, MEM_TYPE_XSK_BUFF_POOL,
+						 NULL);
+		if (ret == 0)
+			xsk_pool_set_rxq_info(pool, rxq);
+	} else {
+		ret = xdp_rxq_info_reg_mem_model(rxq, MEM_TYPE_PAGE_POOL,
+						 pdata->page_pool[chan]);
+	}
+
+	if (ret < 0)
+		xdp_rxq_info_unreg(rxq);
+
+	return ret;
+}
+#endif /* ETHER_XDP */
+
 #ifdef ETHER_PAGE_POOL
 /**
  * @brief Create Rx buffer page pool per channel
@@ -1994,13 +2068,29 @@ static int ether_page_pool_create_per_chan(struct ether_priv_data *pdata,
 	unsigned int num_pages, pool_size = 1024;
 	int ret = 0;
 
+#ifdef ETHER_XDP
+	/* Rx buffers come from AF_XDP UMEM */
+	if (pdata->xsk_pool[chan])
+		return ether_xdp_rxq_reg(pdata, chan);
+#endif
+
 	pp_params.flags = PP_FLAG_DMA_MAP;
 	pp_params.pool_size = pool_size;
-	num_pages = DIV_ROUND_UP(osi_dma->rx_buf_len, PAGE_SIZE);
+	num_pages = DIV_ROUND_UP(ETHER_RX_BUF_OFFSET + osi_dma->rx_buf_len +
+				 ETHER_RX_BUF_TAILROOM, PAGE_SIZE);
 	pp_params.order = ilog2(roundup_pow_of_two(num_pages));
 	pp_params.nid = dev_to_node(pdata->dev);
 	pp_params.dev = pdata->dev;
 	pp_params.dma_dir = DMA_FROM_DEVICE;
+#ifdef ETHER_XDP
+	/* Buffers are written by the CPU once handed to the stack or XDP
+	 * and may be transmitted back by XDP_TX.
+	 */
+	pp_params.flags |= PP_FLAG_DMA_SYNC_DEV;
+	pp_params.dma_dir = DMA_BIDIRECTIONAL;
+	pp_params.offset = ETHER_RX_BUF_OFFSET;
+	pp_params.max_len = osi_dma->rx_buf_len;
+#endif
 
 	pdata->page_pool[chan] = page_pool_create(&pp_params);
 	if (IS_ERR(pdata->page_pool[chan])) {
@@ -2009,6 +2099,16 @@ static int ether_page_pool_create_per_chan(struct ether_priv_data *pdata,
 		return ret;
 	}
 
+#ifdef ETHER_XDP
+	pdata->rx_buf_truesize = PAGE_SIZE << pp_params.order;
+
+	ret = ether_xdp_rxq_reg(pdata, chan);
+	if (ret < 0) {
+		page_pool_destroy(pdata->page_pool[chan]);
+		pdata->page_pool[chan] = NULL;
+	}
+#endif
+
 	return ret;
 }
 #endif
@@ -2068,6 +2168,53 @@ exit:
 	return ret;
 }
 
+#ifdef ETHER_XDP
+/**
+ * @brief Free XDP frames still pending in Tx ring
+ *
+ * Algorithm: Return XDP frames to their memory model and report pending
+ * AF_XDP zero-copy transmissions as completed.
+ *
+ * @param[in] osi_dma: OSI private data structure.
+ * @param[in] dev: device instance associated with driver.
+ * @param[in] tx_ring: Tx ring instance.
+ */
+static void ether_free_xdp_tx_frames(struct osi_dma_priv_data *osi_dma,
+				     struct device *dev,
+				     struct osi_tx_ring *tx_ring)
+{
+	struct ether_priv_data *pdata = osi_dma->osd;
+	struct osi_tx_swcx *tx_swcx;
+	unsigned long addr;
+	unsigned int i;
+
+	/* Walk from the oldest descriptor so AF_XDP completions stay in order */
+	for (i = 0; i < osi_dma->tx_ring_sz; i++) {
+		tx_swcx = tx_ring->tx_swcx +
+			  ((tx_ring->clean_idx + i) & (osi_dma->tx_ring_sz - 1U));
+		addr = (unsigned long)tx_swcx->buf_virt_addr;
+
+		if ((addr & ETHER_XSK_TX_TAG) != 0UL) {
+			ether_xsk_tx_complete(pdata, (struct xsk_buff_pool *)
+					      (addr & ~ETHER_XSK_TX_TAG));
+			tx_swcx->buf_virt_addr = NULL;
+			continue;
+		}
+
+		if ((addr & ETHER_XDP_TX_TAG) == 0UL)
+			continue;
+
+		if ((tx_swcx->flags & OSI_PKT_CX_PAGED_BUF) !=
+		    OSI_PKT_CX_PAGED_BUF)
+			dma_unmap_single(dev, tx_swcx->buf_phy_addr,
+					 tx_swcx->len, DMA_TO_DEVICE);
+
+		xdp_return_frame((struct xdp_frame *)(addr & ~ETHER_XDP_TX_TAG));
+		tx_swcx->buf_virt_addr = NULL;
+	}
+}
+#endif /* ETHER_XDP */
+
 /**
  * @brief Frees allocated DMA resources.
  *
@@ -2089,6 +2236,9 @@ static void free_tx_dma_resources(struct osi_dma_priv_data *osi_dma,
 
 		if (tx_ring != NULL) {
 			if (tx_ring->tx_swcx != NULL) {
+#ifdef ETHER_XDP
+				ether_free_xdp_tx_frames(osi_dma, dev, tx_ring);
+#endif
 				kfree(tx_ring->tx_swcx);
 			}
 
@@ -2306,6 +2456,9 @@ static int ether_allocate_dma_resources(struct ether_priv_data *pdata)
 		goto error_alloc;
 	}
 
+	/* Rx buffer allocation may fall back to the reserved buffer */
+	pdata->resv_buf_virt_addr = (void *)skb;
+
 	ret = ether_allocate_tx_dma_resources(osi_dma, pdata->dev);
 	if (ret != 0) {
 		goto error_alloc;
@@ -2317,8 +2470,6 @@ static int ether_allocate_dma_resources(struct ether_priv_data *pdata)
 		goto error_alloc;
 	}
 
-	pdata->resv_buf_virt_addr = (void *)skb;
-
 	return ret;
 
 error_alloc:
@@ -3385,6 +3536,28 @@ static unsigned short ether_select_queue(struct net_device *dev,
 	return txqueue_select;
 }
 
+/**
+ * @brief Arm Tx coalesce timer if enabled and not armed already.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] chan: DMA Tx channel number.
+ */
+static inline void ether_tx_usecs_timer_arm(struct ether_priv_data *pdata,
+					    unsigned int chan)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+
+	if (osi_dma->use_tx_usecs == OSI_ENABLE &&
+	    atomic_read(&pdata->tx_napi[chan]->tx_usecs_timer_armed) ==
+			OSI_DISABLE) {
+		atomic_set(&pdata->tx_napi[chan]->tx_usecs_timer_armed,
+			   OSI_ENABLE);
+		hrtimer_start(&pdata->tx_napi[chan]->tx_usecs_timer,
+			      osi_dma->tx_usecs * NSEC_PER_USEC,
+			      HRTIMER_MODE_REL);
+	}
+}
+
 /**
  * @brief Network layer hook for data transmission.
  *
@@ -3440,18 +3613,517 @@ static int ether_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		netdev_dbg(ndev, "Tx ring[%d] insufficient desc.\n", chan);
 	}
 
-	if (osi_dma->use_tx_usecs == OSI_ENABLE &&
-	    atomic_read(&pdata->tx_napi[chan]->tx_usecs_timer_armed) ==
-			OSI_DISABLE) {
-		atomic_set(&pdata->tx_napi[chan]->tx_usecs_timer_armed,
-			   OSI_ENABLE);
-		hrtimer_start(&pdata->tx_napi[chan]->tx_usecs_timer,
-			      osi_dma->tx_usecs * NSEC_PER_USEC,
-			      HRTIMER_MODE_REL);
-	}
+	ether_tx_usecs_timer_arm(pdata, chan);
+
 	return NETDEV_TX_OK;
 }
 
+void ether_tx_wake_queue(struct ether_priv_data *pdata, unsigned int qinx)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	unsigned int chan = osi_dma->dma_chans[qinx];
+	struct netdev_queue *txq = netdev_get_tx_queue(pdata->ndev, qinx);
+
+	if (netif_tx_queue_stopped(txq) &&
+	    (ether_avail_txdesc_cnt(osi_dma, osi_dma->tx_ring[chan]) >
+	    ETHER_TX_DESC_THRESHOLD)) {
+		netif_tx_wake_queue(txq);
+		netdev_dbg(pdata->ndev, "Tx ring[%d] - waking Txq\n", chan);
+	}
+}
+
+#ifdef ETHER_XDP
+/**
+ * @brief Select Tx queue for XDP transmission.
+ *
+ * Algorithm: Spread XDP transmission over the Tx queues by CPU, each
+ * queue lock serializes against ether_start_xmit().
+ *
+ * @param[in] pdata: OSD private data.
+ *
+ * @retval "transmit queue index"
+ */
+static inline unsigned int ether_xdp_txq(struct ether_priv_data *pdata)
+{
+	return smp_processor_id() % pdata->osi_dma->num_dma_chans;
+}
+
+/**
+ * @brief Check whether Tx ring can take one more XDP buffer.
+ *
+ * @param[in] osi_dma: OSI DMA private data.
+ * @param[in] tx_ring: Tx ring instance.
+ *
+ * @retval true if a descriptor is available
+ * @retval false if the ring is full
+ */
+static inline bool ether_xdp_tx_avail(struct osi_dma_priv_data *osi_dma,
+				      struct osi_tx_ring *tx_ring)
+{
+	struct osi_tx_swcx *tx_swcx = tx_ring->tx_swcx + tx_ring->cur_tx_idx;
+
+	/* Leave room for a maximum sized skb from the stack */
+	return ether_avail_txdesc_cnt(osi_dma, tx_ring) >
+	       ETHER_TX_DESC_THRESHOLD && tx_swcx->len == 0U;
+}
+
+/**
+ * @brief Queue one DMA mapped XDP buffer for transmission.
+ *
+ * Algorithm: Fill single descriptor software context and invoke OSI for
+ * transmission. XDP buffers are tagged in buf_virt_addr so that Tx
+ * completion does not treat them as skbs.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] chan: DMA Tx channel number.
+ * @param[in] dma_addr: DMA address of the buffer.
+ * @param[in] len: Buffer length.
+ * @param[in] cookie: Tagged buffer owner for Tx completion.
+ * @param[in] paged: Buffer mapping is owned by a pool, not to be unmapped
+ * on completion.
+ *
+ * @note Tx queue lock must be held and ether_xdp_tx_avail() checked.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xdp_xmit_buf(struct ether_priv_data *pdata,
+			      unsigned int chan, dma_addr_t dma_addr,
+			      unsigned int len, void *cookie, bool paged)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	struct osi_tx_ring *tx_ring = osi_dma->tx_ring[chan];
+	struct osi_tx_pkt_cx *tx_pkt_cx = &tx_ring->tx_pkt_cx;
+	struct osi_tx_swcx *tx_swcx = tx_ring->tx_swcx + tx_ring->cur_tx_idx;
+	int ret;
+
+	if (paged)
+		tx_swcx->flags |= OSI_PKT_CX_PAGED_BUF;
+	else
+		tx_swcx->flags &= ~OSI_PKT_CX_PAGED_BUF;
+
+	memset(tx_pkt_cx, 0, sizeof(*tx_pkt_cx));
+	tx_pkt_cx->flags |= OSI_PKT_CX_LEN;
+	tx_pkt_cx->payload_len = len;
+	tx_pkt_cx->desc_cnt = 1;
+
+	tx_swcx->buf_phy_addr = dma_addr;
+	tx_swcx->len = len;
+	tx_swcx->buf_virt_addr = cookie;
+
+	ret = osi_hw_transmit(osi_dma, chan);
+	if (unlikely(ret < 0)) {
+		tx_swcx->buf_virt_addr = NULL;
+		tx_swcx->buf_phy_addr = 0;
+		tx_swcx->len = 0;
+		tx_swcx->flags = 0;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Queue one XDP frame for transmission.
+ *
+ * Algorithm: Use the page pool mapping for frames built on our own Rx
+ * buffers, map other frames for DMA.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] qinx: Tx queue index.
+ * @param[in] xdpf: XDP frame to transmit.
+ * @param[in] page: Page pool page holding the frame, NULL for frames
+ * from other devices.
+ *
+ * @note Tx queue lock must be held.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xdp_xmit_frame(struct ether_priv_data *pdata,
+				unsigned int qinx, struct xdp_frame *xdpf,
+				struct page *page)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	unsigned int chan = osi_dma->dma_chans[qinx];
+	void *cookie = (void *)((unsigned long)xdpf | ETHER_XDP_TX_TAG);
+	dma_addr_t dma_addr;
+	int ret;
+
+	if (unlikely(xdpf->len > ETHER_TX_MAX_BUFF_SIZE))
+		return -EINVAL;
+
+	if (!ether_xdp_tx_avail(osi_dma, osi_dma->tx_ring[chan]))
+		return -EBUSY;
+
+	if (page) {
+		dma_addr = page_pool_get_dma_addr(page) + sizeof(*xdpf) +
+			   xdpf->headroom;
+		dma_sync_single_for_device(pdata->dev, dma_addr, xdpf->len,
+					   DMA_BIDIRECTIONAL);
+	} else {
+		dma_addr = dma_map_single(pdata->dev, xdpf->data, xdpf->len,
+					  DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(pdata->dev, dma_addr)))
+			return -ENOMEM;
+	}
+
+	ret = ether_xdp_xmit_buf(pdata, chan, dma_addr, xdpf->len, cookie,
+				 page != NULL);
+	if (unlikely(ret < 0) && !page)
+		dma_unmap_single(pdata->dev, dma_addr, xdpf->len,
+				 DMA_TO_DEVICE);
+
+	return ret;
+}
+
+int ether_xdp_xmit_back(struct ether_priv_data *pdata, struct xdp_frame *xdpf,
+			struct page *page)
+{
+	unsigned int qinx = ether_xdp_txq(pdata);
+	struct netdev_queue *txq = netdev_get_tx_queue(pdata->ndev, qinx);
+	int ret;
+
+	__netif_tx_lock(txq, smp_processor_id());
+	ret = ether_xdp_xmit_frame(pdata, qinx, xdpf, page);
+	__netif_tx_unlock(txq);
+
+	if (ret == 0)
+		ether_tx_usecs_timer_arm(pdata, pdata->osi_dma->dma_chans[qinx]);
+
+	return ret;
+}
+
+/**
+ * @brief Network layer hook for XDP_REDIRECT transmission.
+ *
+ * @param[in] ndev: Net device structure.
+ * @param[in] n: Number of frames.
+ * @param[in] frames: XDP frames to transmit.
+ * @param[in] flags: XDP_XMIT_* flags.
+ *
+ * @retval "number of frames queued" on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xdp_xmit(struct net_device *ndev, int n,
+			  struct xdp_frame **frames, u32 flags)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+	struct netdev_queue *txq;
+	unsigned int qinx;
+	int i;
+
+	if (unlikely(!netif_running(ndev) || !netif_carrier_ok(ndev)))
+		return -ENETDOWN;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	qinx = ether_xdp_txq(pdata);
+	txq = netdev_get_tx_queue(ndev, qinx);
+
+	__netif_tx_lock(txq, smp_processor_id());
+	for (i = 0; i < n; i++) {
+		if (ether_xdp_xmit_frame(pdata, qinx, frames[i], NULL) < 0)
+			break;
+	}
+	__netif_tx_unlock(txq);
+
+	if (i > 0)
+		ether_tx_usecs_timer_arm(pdata, pdata->osi_dma->dma_chans[qinx]);
+
+	return i;
+}
+
+/**
+ * @brief Get Tx queue index of a DMA channel.
+ *
+ * @param[in] osi_dma: OSI DMA private data.
+ * @param[in] chan: DMA channel number.
+ *
+ * @retval "transmit queue index"
+ */
+static inline unsigned int ether_chan_to_qinx(struct osi_dma_priv_data *osi_dma,
+					      unsigned int chan)
+{
+	unsigned int qinx;
+
+	for (qinx = 0; qinx < osi_dma->num_dma_chans; qinx++) {
+		if (osi_dma->dma_chans[qinx] == chan)
+			break;
+	}
+
+	return qinx;
+}
+
+void ether_xsk_tx_complete(struct ether_priv_data *pdata,
+			   struct xsk_buff_pool *pool)
+{
+	unsigned int chan;
+
+	xsk_tx_completed(pool, 1);
+
+	for (chan = 0; chan < OSI_MGBE_MAX_NUM_CHANS; chan++) {
+		if (pdata->xsk_pool[chan] == pool)
+			break;
+	}
+	if (chan == OSI_MGBE_MAX_NUM_CHANS)
+		return;
+
+	if (pdata->xsk_tx_inflight[chan] > 0U)
+		pdata->xsk_tx_inflight[chan]--;
+
+	/* Dropped frames were consumed after every in-flight one */
+	if (pdata->xsk_tx_inflight[chan] == 0U &&
+	    pdata->xsk_tx_dropped[chan] > 0U) {
+		xsk_tx_completed(pool, pdata->xsk_tx_dropped[chan]);
+		pdata->xsk_tx_dropped[chan] = 0;
+	}
+}
+
+/**
+ * @brief Transmit frames posted on AF_XDP socket Tx ring.
+ *
+ * Algorithm:
+ * 1) Pull descriptors from the socket Tx ring while the DMA ring has
+ * room. UMEM is already mapped by the buffer pool, so frames go out
+ * without copy or mapping.
+ * 2) Tx completion reports frames back to the socket completion ring.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] chan: DMA Tx channel number.
+ * @param[in] budget: Maximum frames to transmit.
+ *
+ * @note Tx queue lock must be held.
+ *
+ * @retval true if socket Tx ring is drained
+ * @retval false if budget is exhausted
+ */
+static bool ether_xsk_xmit(struct ether_priv_data *pdata, unsigned int chan,
+			   unsigned int budget)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	struct xsk_buff_pool *pool = pdata->xsk_pool[chan];
+	struct osi_tx_ring *tx_ring = osi_dma->tx_ring[chan];
+	void *cookie = (void *)((unsigned long)pool | ETHER_XSK_TX_TAG);
+	unsigned int sent = 0;
+	struct xdp_desc desc;
+	dma_addr_t dma_addr;
+
+	/*
+	 * A dropped frame is only reported once the frames queued before it
+	 * complete. Queueing more now would complete them ahead of it.
+	 */
+	if (pdata->xsk_tx_dropped[chan] > 0U)
+		return true;
+
+	while (sent < budget && ether_xdp_tx_avail(osi_dma, tx_ring)) {
+		if (!xsk_tx_peek_desc(pool, &desc))
+			break;
+
+		dma_addr = xsk_buff_raw_get_dma(pool, desc.addr);
+		xsk_buff_raw_dma_sync_for_device(pool, dma_addr, desc.len);
+
+		/* Length is bounded by the chunk size checked at pool setup */
+		if (unlikely(ether_xdp_xmit_buf(pdata, chan, dma_addr,
+						desc.len, cookie, true) < 0)) {
+			/*
+			 * Descriptor is consumed, drop the frame. The socket
+			 * completion ring is FIFO, so it can only be reported
+			 * after the frames still in flight.
+			 */
+			pdata->ndev->stats.tx_dropped++;
+			if (pdata->xsk_tx_inflight[chan] == 0U) {
+				xsk_tx_completed(pool, 1);
+				continue;
+			}
+			pdata->xsk_tx_dropped[chan]++;
+			break;
+		}
+
+		pdata->xsk_tx_inflight[chan]++;
+		sent++;
+	}
+
+	if (sent > 0U) {
+		xsk_tx_release(pool);
+		ether_tx_usecs_timer_arm(pdata, chan);
+	}
+
+	if (xsk_uses_need_wakeup(pool))
+		xsk_set_tx_need_wakeup(pool);
+
+	return sent < budget;
+}
+
+/**
+ * @brief Bind or unbind AF_XDP buffer pool to a DMA channel.
+ *
+ * Algorithm:
+ * 1) Validate queue and UMEM frame size against Rx buffer length.
+ * 2) Map UMEM for DMA on bind and unmap it on unbind.
+ * 3) Restart the interface so the channel Rx ring is refilled from the
+ * new buffer source.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] pool: Buffer pool, NULL to unbind.
+ * @param[in] qid: Queue index.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xsk_pool_setup(struct ether_priv_data *pdata,
+				struct xsk_buff_pool *pool, u16 qid)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	struct net_device *ndev = pdata->ndev;
+	bool running = netif_running(ndev);
+	bool enable = (pool != NULL);
+	unsigned int chan;
+	int ret;
+
+	if (qid >= osi_dma->num_dma_chans)
+		return -EINVAL;
+
+	chan = osi_dma->dma_chans[qid];
+
+	if (enable) {
+		if (pdata->xsk_pool[chan])
+			return -EBUSY;
+
+		if (xsk_pool_get_rx_frame_size(pool) < osi_dma->rx_buf_len) {
+			netdev_err(ndev, "UMEM frame size %u less than Rx buffer length %u\n",
+				   xsk_pool_get_rx_frame_size(pool),
+				   osi_dma->rx_buf_len);
+			return -EINVAL;
+		}
+
+		/* Tx frames must fit a single descriptor */
+		if (xsk_pool_get_chunk_size(pool) > ETHER_TX_MAX_BUFF_SIZE) {
+			netdev_err(ndev, "UMEM chunk size %u exceeds Tx buffer limit %u\n",
+				   xsk_pool_get_chunk_size(pool),
+				   ETHER_TX_MAX_BUFF_SIZE);
+			return -EINVAL;
+		}
+
+		ret = xsk_pool_dma_map(pool, pdata->dev, 0);
+		if (ret < 0)
+			return ret;
+	} else {
+		pool = pdata->xsk_pool[chan];
+		if (!pool)
+			return -EINVAL;
+	}
+
+	if (running)
+		ether_close(ndev);
+
+	pdata->xsk_pool[chan] = enable ? pool : NULL;
+	pdata->xsk_rx_starved[chan] = false;
+	pdata->xsk_tx_inflight[chan] = 0;
+	pdata->xsk_tx_dropped[chan] = 0;
+
+	if (!enable)
+		xsk_pool_dma_unmap(pool, 0);
+
+	if (running) {
+		ret = ether_open(ndev);
+		if (ret < 0) {
+			netdev_err(ndev, "failed to restart with AF_XDP pool on queue %u\n",
+				   qid);
+			goto err_open;
+		}
+	}
+
+	return 0;
+
+err_open:
+	/*
+	 * A failed bind leaves the channel without the pool, so try to bring
+	 * the interface back up on page pool buffers. A failed unbind has
+	 * already released the pool.
+	 */
+	if (enable) {
+		pdata->xsk_pool[chan] = NULL;
+		xsk_pool_dma_unmap(pool, 0);
+		if (ether_open(ndev) < 0)
+			netdev_err(ndev, "failed to restart without AF_XDP pool on queue %u\n",
+				   qid);
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Network layer hook for AF_XDP wakeup.
+ *
+ * Algorithm: Schedule Rx and Tx NAPI of the channel so that socket Tx
+ * ring is drained and Rx refill picks up new fill ring entries.
+ *
+ * @param[in] ndev: Net device structure.
+ * @param[in] qid: Queue index.
+ * @param[in] flags: XDP_WAKEUP_* flags.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xsk_wakeup(struct net_device *ndev, u32 qid, u32 flags)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	unsigned int chan;
+
+	if (unlikely(!netif_running(ndev) || !netif_carrier_ok(ndev)))
+		return -ENETDOWN;
+
+	if (qid >= osi_dma->num_dma_chans)
+		return -EINVAL;
+
+	chan = osi_dma->dma_chans[qid];
+	if (!pdata->xsk_pool[chan])
+		return -EINVAL;
+
+	if ((flags & XDP_WAKEUP_RX) != 0U)
+		napi_schedule(&pdata->rx_napi[chan]->napi);
+
+	if ((flags & XDP_WAKEUP_TX) != 0U)
+		napi_schedule(&pdata->tx_napi[chan]->napi);
+
+	return 0;
+}
+
+/**
+ * @brief Network layer hook for BPF program setup.
+ *
+ * Algorithm: Swap attached XDP program. Rx buffers always carry XDP
+ * headroom so no ring reconfiguration is required. Binding an AF_XDP
+ * buffer pool restarts the interface.
+ *
+ * @param[in] ndev: Net device structure.
+ * @param[in] bpf: BPF command.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+	struct bpf_prog *old_prog;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		old_prog = xchg(&pdata->xdp_prog, bpf->prog);
+		if (old_prog)
+			bpf_prog_put(old_prog);
+		return 0;
+	case XDP_SETUP_XSK_POOL:
+		return ether_xsk_pool_setup(pdata, bpf->xsk.pool,
+					    bpf->xsk.queue_id);
+	default:
+		return -EINVAL;
+	}
+}
+#endif /* ETHER_XDP */
+
 /**
  * @brief Function to configure the multicast address in device.
  *
@@ -4043,6 +4715,9 @@ static int ether_change_mtu(struct net_device *ndev, int new_mtu)
 	struct osi_core_priv_data *osi_core = pdata->osi_core;
 	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
 	struct osi_ioctl ioctl_data = {};
+#ifdef ETHER_XDP
+	unsigned int i;
+#endif
 	int ret = 0;
 
 	if (netif_running(ndev)) {
@@ -4050,6 +4725,16 @@ static int ether_change_mtu(struct net_device *ndev, int new_mtu)
 		return -EBUSY;
 	}
 
+#ifdef ETHER_XDP
+	for (i = 0; i < osi_dma->num_dma_chans; i++) {
+		if (pdata->xsk_pool[osi_dma->dma_chans[i]]) {
+			netdev_err(pdata->ndev,
+				   "MTU can't change with AF_XDP socket bound\n");
+			return -EBUSY;
+		}
+	}
+#endif
+
 	if ((new_mtu > OSI_MTU_SIZE_9000) &&
 	    (osi_dma->num_dma_chans != 1U)) {
 		netdev_err(pdata->ndev,
@@ -4289,6 +4974,11 @@ static const struct net_device_ops ether_netdev_ops = {
 	.ndo_vlan_rx_kill_vid = ether_vlan_rx_kill_vid,
 #endif /* ETHER_VLAN_VID_SUPPORT */
 	.ndo_setup_tc = ether_setup_tc,
+#ifdef ETHER_XDP
+	.ndo_bpf = ether_bpf,
+	.ndo_xdp_xmit = ether_xdp_xmit,
+	.ndo_xsk_wakeup = ether_xsk_wakeup,
+#endif
 };
 
 /**
@@ -4314,9 +5004,27 @@ static int ether_napi_poll_rx(struct napi_struct *napi, int budget)
 	unsigned int more_data_avail;
 	unsigned long flags;
 	int received = 0;
+#ifdef ETHER_XDP
+	struct xsk_buff_pool *pool = pdata->xsk_pool[chan];
+
+	pdata->xsk_rx_starved[chan] = false;
+#endif
 
 	received = osi_process_rx_completions(osi_dma, chan, budget,
 					      &more_data_avail);
+#ifdef ETHER_XDP
+	if (pdata->xdp_redirect[chan]) {
+		pdata->xdp_redirect[chan] = false;
+		xdp_do_flush();
+	}
+
+	if (pool && xsk_uses_need_wakeup(pool)) {
+		if (pdata->xsk_rx_starved[chan])
+			xsk_set_rx_need_wakeup(pool);
+		else
+			xsk_clear_rx_need_wakeup(pool);
+	}
+#endif
 	if (received < budget) {
 		napi_complete(napi);
 		raw_spin_lock_irqsave(&pdata->rlock, flags);
@@ -4351,9 +5059,34 @@ static int ether_napi_poll_tx(struct napi_struct *napi, int budget)
 	unsigned int chan = tx_napi->chan;
 	unsigned long flags;
 	int processed;
+#ifdef ETHER_XDP
+	struct netdev_queue *txq;
+	bool xsk_done;
+#endif
 
 	processed = osi_process_tx_completions(osi_dma, chan, budget);
 
+#ifdef ETHER_XDP
+	/*
+	 * XDP_TX and AF_XDP completions free descriptors of the ring shared
+	 * with the stack queue without going through the skb wake check.
+	 */
+	if (processed > 0)
+		ether_tx_wake_queue(pdata, ether_chan_to_qinx(osi_dma, chan));
+
+	if (pdata->xsk_pool[chan]) {
+		txq = netdev_get_tx_queue(pdata->ndev,
+					  ether_chan_to_qinx(osi_dma, chan));
+		__netif_tx_lock(txq, smp_processor_id());
+		xsk_done = ether_xsk_xmit(pdata, chan, budget);
+		__netif_tx_unlock(txq);
+
+		/* Keep polling until socket Tx ring is drained */
+		if (!xsk_done)
+			processed = budget;
+	}
+#endif
+
 	/* re-arm the timer if tx ring is not empty */
 	if (!osi_txring_empty(osi_dma, chan) &&
 	    osi_dma->use_tx_usecs == OSI_ENABLE &&
@@ -6635,6 +7368,14 @@ static int ether_probe(struct platform_device *pdev)
 
 	ndev->netdev_ops = &ether_netdev_ops;
 	ether_set_ethtool_ops(ndev);
+#ifdef ETHER_XDP
+	pdata->rx_copybreak = ETHER_RX_COPYBREAK;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+	ndev->xdp_features = NETDEV_XDP_ACT_BASIC | NETDEV_XDP_ACT_REDIRECT |
+			     NETDEV_XDP_ACT_NDO_XMIT |
+			     NETDEV_XDP_ACT_XSK_ZEROCOPY;
+#endif
+#endif
 
 	ret = ether_alloc_napi(pdata);
 	if (ret < 0) {
@@ -47,6 +47,15 @@
 #endif
 #define ETHER_PAGE_POOL
 #endif
+#if defined(ETHER_PAGE_POOL) && (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0))
+/* Build skbs around page pool Rx buffers and run XDP programs on them */
+#define ETHER_XDP
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+#include <net/xdp_sock_drv.h>
+#endif
 #include <osi_core.h>
 #include <osi_dma.h>
 #include <mmc.h>
@@ -244,6 +253,36 @@
 /** @} */
 
 #define ETHER_INVALID_CHAN_NUM		0xFFU
+
+#ifdef ETHER_PAGE_POOL
+#ifdef ETHER_XDP
+/**
+ * @brief Rx page pool buffer layout: headroom for XDP and skb headers in
+ * front of the DMA area, skb_shared_info behind it so that skbs can be
+ * built around the buffer.
+ */
+#define ETHER_RX_BUF_OFFSET		XDP_PACKET_HEADROOM
+#define ETHER_RX_BUF_TAILROOM		SKB_DATA_ALIGN(sizeof(struct skb_shared_info))
+/**
+ * @brief Default Rx copybreak: packets up to this length are copied into a
+ * small skb and the page goes straight back to the pool.
+ */
+#define ETHER_RX_COPYBREAK		256U
+/**
+ * @brief Tag for XDP frames in Tx software context buf_virt_addr, which
+ * otherwise holds an skb.
+ */
+#define ETHER_XDP_TX_TAG		0x1UL
+/**
+ * @brief Tag for AF_XDP zero-copy Tx in Tx software context buf_virt_addr,
+ * which then holds the XSK buffer pool.
+ */
+#define ETHER_XSK_TX_TAG		0x2UL
+#else
+#define ETHER_RX_BUF_OFFSET		0U
+#define ETHER_RX_BUF_TAILROOM		0U
+#endif /* ETHER_XDP */
+#endif /* ETHER_PAGE_POOL */
 /**
  * @brief Check if Tx data buffer length is within bounds.
  *
@@ -578,6 +617,27 @@ struct ether_priv_data {
 	/** Pointer to page pool */
 	struct page_pool *page_pool[OSI_MGBE_MAX_NUM_CHANS];
 #endif
+#ifdef ETHER_XDP
+	/** Attached XDP program */
+	struct bpf_prog *xdp_prog;
+	/** XDP Rx queue info per DMA channel */
+	struct xdp_rxq_info xdp_rxq[OSI_MGBE_MAX_NUM_CHANS];
+	/** XDP_REDIRECT issued in current NAPI poll per DMA channel */
+	bool xdp_redirect[OSI_MGBE_MAX_NUM_CHANS];
+	/** Size of one Rx page pool buffer */
+	unsigned int rx_buf_truesize;
+	/** Rx copybreak length */
+	unsigned int rx_copybreak;
+	/** AF_XDP zero-copy buffer pool per DMA channel */
+	struct xsk_buff_pool *xsk_pool[OSI_MGBE_MAX_NUM_CHANS];
+	/** Rx refill ran out of AF_XDP fill ring entries per DMA channel */
+	bool xsk_rx_starved[OSI_MGBE_MAX_NUM_CHANS];
+	/** AF_XDP frames queued to the Tx ring per DMA channel */
+	unsigned int xsk_tx_inflight[OSI_MGBE_MAX_NUM_CHANS];
+	/** AF_XDP frames dropped after in-flight ones per DMA channel, to be
+	 * completed once those are done */
+	unsigned int xsk_tx_dropped[OSI_MGBE_MAX_NUM_CHANS];
+#endif
 #ifdef CONFIG_DEBUG_FS
 	/** Debug fs directory pointer */
 	struct dentry *dbgfs_dir;
@@ -855,6 +915,46 @@ int ether_tc_setup_cbs(struct ether_priv_data *pdata,
  */
 int ether_get_tx_ts(struct ether_priv_data *pdata);
 void ether_restart_lane_bringup_task(struct tasklet_struct *t);
+
+/**
+ * @brief Wake a stopped Tx queue once its ring has room again
+ *
+ * @param[in] pdata: Pointer to private data structure.
+ * @param[in] qinx: Tx queue index.
+ *
+ * @note Called from Tx completion context.
+ */
+void ether_tx_wake_queue(struct ether_priv_data *pdata, unsigned int qinx);
+#ifdef ETHER_XDP
+/**
+ * @brief Report one transmitted AF_XDP frame to its socket
+ *
+ * Also completes frames that were dropped after it, so that the socket
+ * completion ring stays in submission order.
+ *
+ * @param[in] pdata: Pointer to private data structure.
+ * @param[in] pool: AF_XDP buffer pool the frame belongs to.
+ *
+ * @note Called from Tx NAPI context.
+ */
+void ether_xsk_tx_complete(struct ether_priv_data *pdata,
+			   struct xsk_buff_pool *pool);
+
+/**
+ * @brief Transmit an XDP_TX frame back on the interface it was received on
+ *
+ * @param[in] pdata: Pointer to private data structure.
+ * @param[in] xdpf: XDP frame built on a page pool buffer of this device.
+ * @param[in] page: Page pool page holding the frame.
+ *
+ * @note Called from Rx NAPI context.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on Failure
+ */
+int ether_xdp_xmit_back(struct ether_priv_data *pdata, struct xdp_frame *xdpf,
+			struct page *page);
+#endif /* ETHER_XDP */
 #ifdef ETHER_NVGRO
 void ether_nvgro_purge_timer(struct timer_list *t);
 #endif /* ETHER_NVGRO */
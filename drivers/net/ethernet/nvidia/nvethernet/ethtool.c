@@ -1669,6 +1669,57 @@ static void ether_set_msglevel(struct net_device *ndev, u32 level)
 }
 #endif /* OSI_STRIPPED_LIB */
 
+#ifdef ETHER_XDP
+/**
+ * @brief Get driver tunables
+ *
+ * @param[in] ndev: network device instance
+ * @param[in] tuna: tunable id
+ * @param[out] data: tunable value
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_get_tunable(struct net_device *ndev,
+			     const struct ethtool_tunable *tuna, void *data)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+
+	switch (tuna->id) {
+	case ETHTOOL_RX_COPYBREAK:
+		*(u32 *)data = pdata->rx_copybreak;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/**
+ * @brief Set driver tunables
+ *
+ * @param[in] ndev: network device instance
+ * @param[in] tuna: tunable id
+ * @param[in] data: tunable value
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_set_tunable(struct net_device *ndev,
+			     const struct ethtool_tunable *tuna,
+			     const void *data)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+
+	switch (tuna->id) {
+	case ETHTOOL_RX_COPYBREAK:
+		WRITE_ONCE(pdata->rx_copybreak, *(const u32 *)data);
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+#endif /* ETHER_XDP */
+
 /**
  * @brief Set of ethtool operations
  */
@@ -1684,6 +1735,10 @@ static const struct ethtool_ops ether_ethtool_ops = {
 	.supported_coalesce_params = (ETHTOOL_COALESCE_USECS |
 		ETHTOOL_COALESCE_MAX_FRAMES),
 	.set_coalesce = ether_set_coalesce,
+#ifdef ETHER_XDP
+	.get_tunable = ether_get_tunable,
+	.set_tunable = ether_set_tunable,
+#endif
 #ifndef OSI_STRIPPED_LIB
 	.get_wol = ether_get_wol,
 	.set_wol = ether_set_wol,
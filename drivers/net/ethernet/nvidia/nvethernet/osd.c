@@ -217,6 +217,27 @@ static inline int ether_alloc_skb(struct ether_priv_data *pdata,
 		return 0;
 	}
 
+#ifdef ETHER_XDP
+	if (pdata->xsk_pool[chan]) {
+		struct xdp_buff *xdp = xsk_buff_alloc(pdata->xsk_pool[chan]);
+
+		if (unlikely(!xdp)) {
+			/* Fill ring is empty, user space gets woken up to
+			 * post more frames from the Rx NAPI poll.
+			 */
+			pdata->xsk_rx_starved[chan] = true;
+			rx_swcx->buf_virt_addr = pdata->resv_buf_virt_addr;
+			rx_swcx->buf_phy_addr = pdata->resv_buf_phy_addr;
+		} else {
+			rx_swcx->buf_virt_addr = xdp;
+			rx_swcx->buf_phy_addr = xsk_buff_xdp_get_dma(xdp);
+		}
+
+		rx_swcx->flags |= OSI_RX_SWCX_BUF_VALID;
+		return 0;
+	}
+#endif
+
 #ifndef ETHER_PAGE_POOL
 	skb = netdev_alloc_skb_ip_align(pdata->ndev, dma_rx_buf_len);
 
@@ -253,7 +274,8 @@ static inline int ether_alloc_skb(struct ether_priv_data *pdata,
 		return 0;
 	}
 
-	rx_swcx->buf_phy_addr = page_pool_get_dma_addr(rx_swcx->buf_virt_addr);
+	rx_swcx->buf_phy_addr = page_pool_get_dma_addr(rx_swcx->buf_virt_addr) +
+				ETHER_RX_BUF_OFFSET;
 #endif
 #ifndef ETHER_PAGE_POOL
 	rx_swcx->buf_virt_addr = skb;
@@ -590,6 +612,225 @@ exit:
 }
 #endif
 
+#ifdef ETHER_XDP
+/**
+ * @brief Run attached XDP program on a received buffer.
+ *
+ * Algorithm:
+ * 1) Run the program on the page pool buffer.
+ * 2) XDP_TX frames are queued back on this interface, XDP_REDIRECT
+ * frames are handed to the redirect target and flushed at the end of
+ * the NAPI poll.
+ * 3) Buffer goes back to page pool on drop or on failure.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] prog: XDP program.
+ * @param[in] chan: DMA Rx channel number.
+ * @param[in] page: Page pool page holding the packet.
+ * @param[in] xdp: XDP buffer describing the packet.
+ *
+ * @retval true if buffer is consumed by XDP
+ * @retval false if packet need to be passed to network stack
+ */
+static bool ether_run_xdp(struct ether_priv_data *pdata,
+			  struct bpf_prog *prog, unsigned int chan,
+			  struct page *page, struct xdp_buff *xdp)
+{
+	struct xdp_frame *xdpf;
+	u32 act;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return false;
+	case XDP_TX:
+		xdpf = xdp_convert_buff_to_frame(xdp);
+		if (unlikely(!xdpf) ||
+		    ether_xdp_xmit_back(pdata, xdpf, page) < 0)
+			goto err;
+		return true;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(pdata->ndev, xdp, prog) < 0)
+			goto err;
+		pdata->xdp_redirect[chan] = true;
+		return true;
+	default:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
+		bpf_warn_invalid_xdp_action(pdata->ndev, prog, act);
+#else
+		bpf_warn_invalid_xdp_action(act);
+#endif
+		fallthrough;
+	case XDP_ABORTED:
+err:
+		trace_xdp_exception(pdata->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		pdata->ndev->stats.rx_dropped++;
+		page_pool_recycle_direct(pdata->page_pool[chan], page);
+		return true;
+	}
+}
+
+/**
+ * @brief Build skb around a received page pool buffer.
+ *
+ * Algorithm:
+ * 1) Run attached XDP program, if any, before skb allocation.
+ * 2) Copy packets up to rx_copybreak length into a small skb and recycle
+ * the page right away.
+ * 3) Otherwise build the skb around the buffer without copying. Page
+ * goes back to the pool once the skb is freed.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] rx_napi: Rx NAPI instance.
+ * @param[in] chan: DMA Rx channel number.
+ * @param[in] page: Page pool page holding the packet.
+ * @param[in] len: Received packet length.
+ *
+ * @retval skb to be passed to network stack
+ * @retval NULL if buffer is consumed by XDP or dropped
+ */
+static struct sk_buff *ether_rx_build_skb(struct ether_priv_data *pdata,
+					  struct ether_rx_napi *rx_napi,
+					  unsigned int chan,
+					  struct page *page,
+					  unsigned int len)
+{
+	unsigned int headroom = ETHER_RX_BUF_OFFSET;
+	void *va = page_address(page);
+	struct bpf_prog *prog;
+	struct sk_buff *skb;
+	struct xdp_buff xdp;
+
+	prog = READ_ONCE(pdata->xdp_prog);
+	if (prog) {
+		xdp_init_buff(&xdp, pdata->rx_buf_truesize,
+			      &pdata->xdp_rxq[chan]);
+		xdp_prepare_buff(&xdp, va, headroom, len, false);
+		if (ether_run_xdp(pdata, prog, chan, page, &xdp))
+			return NULL;
+
+		/* Program may have moved packet boundaries */
+		headroom = xdp.data - xdp.data_hard_start;
+		len = xdp.data_end - xdp.data;
+	}
+
+	if (len <= pdata->rx_copybreak) {
+		skb = napi_alloc_skb(&rx_napi->napi, len);
+		if (unlikely(!skb))
+			goto drop;
+
+		skb_put_data(skb, va + headroom, len);
+		page_pool_recycle_direct(pdata->page_pool[chan], page);
+		return skb;
+	}
+
+	skb = napi_build_skb(va, pdata->rx_buf_truesize);
+	if (unlikely(!skb))
+		goto drop;
+
+	skb_reserve(skb, headroom);
+	skb_put(skb, len);
+	skb_mark_for_recycle(skb);
+
+	return skb;
+
+drop:
+	pdata->ndev->stats.rx_dropped++;
+	page_pool_recycle_direct(pdata->page_pool[chan], page);
+	return NULL;
+}
+
+/**
+ * @brief Handle a packet received into AF_XDP UMEM buffer.
+ *
+ * Algorithm:
+ * 1) Run attached XDP program on the zero-copy buffer.
+ * 2) XDP_REDIRECT hands the buffer to the bound AF_XDP socket without
+ * any copy. XDP_TX copies the buffer into a frame and queues it back.
+ * 3) XDP_PASS copies the packet into an skb, UMEM buffer is released
+ * back to the fill queue in all other cases.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] rx_napi: Rx NAPI instance.
+ * @param[in] chan: DMA Rx channel number.
+ * @param[in] xdp: UMEM buffer holding the packet.
+ * @param[in] len: Received packet length.
+ *
+ * @retval skb to be passed to network stack
+ * @retval NULL if buffer is consumed by XDP or dropped
+ */
+static struct sk_buff *ether_xsk_rx(struct ether_priv_data *pdata,
+				    struct ether_rx_napi *rx_napi,
+				    unsigned int chan,
+				    struct xdp_buff *xdp,
+				    unsigned int len)
+{
+	struct xdp_frame *xdpf;
+	struct bpf_prog *prog;
+	struct sk_buff *skb;
+	u32 act = XDP_PASS;
+
+	xdp->data_end = xdp->data + len;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+	xsk_buff_dma_sync_for_cpu(xdp);
+#else
+	xsk_buff_dma_sync_for_cpu(xdp, pdata->xsk_pool[chan]);
+#endif
+
+	prog = READ_ONCE(pdata->xdp_prog);
+	if (prog)
+		act = bpf_prog_run_xdp(prog, xdp);
+
+	switch (act) {
+	case XDP_PASS:
+		break;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(pdata->ndev, xdp, prog) < 0)
+			goto err;
+		pdata->xdp_redirect[chan] = true;
+		return NULL;
+	case XDP_TX:
+		/* Converting releases the UMEM buffer on success */
+		xdpf = xdp_convert_buff_to_frame(xdp);
+		if (unlikely(!xdpf))
+			goto err;
+		if (ether_xdp_xmit_back(pdata, xdpf, NULL) < 0) {
+			pdata->ndev->stats.rx_dropped++;
+			xdp_return_frame(xdpf);
+		}
+		return NULL;
+	default:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
+		bpf_warn_invalid_xdp_action(pdata->ndev, prog, act);
+#else
+		bpf_warn_invalid_xdp_action(act);
+#endif
+		fallthrough;
+	case XDP_ABORTED:
+err:
+		trace_xdp_exception(pdata->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		pdata->ndev->stats.rx_dropped++;
+		xsk_buff_free(xdp);
+		return NULL;
+	}
+
+	len = xdp->data_end - xdp->data;
+	skb = napi_alloc_skb(&rx_napi->napi, len);
+	if (likely(skb))
+		skb_put_data(skb, xdp->data, len);
+	else
+		pdata->ndev->stats.rx_dropped++;
+
+	xsk_buff_free(xdp);
+
+	return skb;
+}
+#endif /* ETHER_XDP */
+
 /**
  * @brief Handover received packet to network stack.
  *
@@ -646,7 +887,25 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 	/* Process only the Valid packets */
 	if (likely((rx_pkt_cx->flags & OSI_PKT_CX_VALID) ==
 		   OSI_PKT_CX_VALID)) {
-#ifdef ETHER_PAGE_POOL
+#ifdef ETHER_XDP
+		if (pdata->xsk_pool[chan]) {
+			skb = ether_xsk_rx(pdata, rx_napi, chan,
+					   rx_swcx->buf_virt_addr,
+					   rx_pkt_cx->pkt_len);
+		} else {
+			dma_sync_single_for_cpu(pdata->dev, dma_addr,
+						rx_pkt_cx->pkt_len,
+						DMA_FROM_DEVICE);
+			skb = ether_rx_build_skb(pdata, rx_napi, chan, page,
+						 rx_pkt_cx->pkt_len);
+		}
+		/*
+		 * Consumed by XDP or dropped, which is accounted in
+		 * rx_dropped, so not counted as a received packet.
+		 */
+		if (!skb)
+			goto consumed;
+#elif defined(ETHER_PAGE_POOL)
 		skb = netdev_alloc_skb_ip_align(pdata->ndev,
 						rx_pkt_cx->pkt_len);
 		if (unlikely(!skb)) {
@@ -716,6 +975,11 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 #endif /* !OSI_STRIPPED_LIB */
 		ndev->stats.rx_fifo_errors = osi_core->mmc.mmc_rx_fifo_overflow;
 		ndev->stats.rx_errors++;
+#ifdef ETHER_XDP
+		if (pdata->xsk_pool[chan])
+			xsk_buff_free(rx_swcx->buf_virt_addr);
+		else
+#endif
 #ifdef ETHER_PAGE_POOL
 		page_pool_recycle_direct(pdata->page_pool[chan], page);
 #endif
@@ -726,6 +990,9 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 done:
 #endif
 	ndev->stats.rx_packets++;
+#ifdef ETHER_XDP
+consumed:
+#endif
 	rx_swcx->buf_virt_addr = NULL;
 	rx_swcx->buf_phy_addr = 0;
 	/* mark packet is processed */
@@ -756,18 +1023,42 @@ static void osd_transmit_complete(void *priv, const struct osi_tx_swcx *swcx,
 				  *txdone_pkt_cx)
 {
 	struct ether_priv_data *pdata = (struct ether_priv_data *)priv;
-	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
 	struct sk_buff *skb = (struct sk_buff *)swcx->buf_virt_addr;
 	unsigned long dmaaddr = swcx->buf_phy_addr;
 	struct skb_shared_hwtstamps shhwtstamp;
 	struct net_device *ndev = pdata->ndev;
-	struct osi_tx_ring *tx_ring;
-	struct netdev_queue *txq;
-	unsigned int chan, qinx;
+	unsigned int qinx;
 	unsigned int len = swcx->len;
 
 	ndev->stats.tx_bytes += len;
 
+#ifdef ETHER_XDP
+	if ((unsigned long)swcx->buf_virt_addr & ETHER_XSK_TX_TAG) {
+		struct xsk_buff_pool *pool = (struct xsk_buff_pool *)
+			((unsigned long)swcx->buf_virt_addr & ~ETHER_XSK_TX_TAG);
+
+		/* UMEM stays mapped by the pool, only report completion */
+		ether_xsk_tx_complete(pdata, pool);
+		ndev->stats.tx_packets++;
+		return;
+	}
+
+	if ((unsigned long)swcx->buf_virt_addr & ETHER_XDP_TX_TAG) {
+		struct xdp_frame *xdpf = (struct xdp_frame *)
+			((unsigned long)swcx->buf_virt_addr & ~ETHER_XDP_TX_TAG);
+
+		/* XDP_TX frames reuse the page pool mapping of Rx buffer */
+		if ((txdone_pkt_cx->flags & OSI_TXDONE_CX_PAGED_BUF) !=
+		    OSI_TXDONE_CX_PAGED_BUF)
+			dma_unmap_single(pdata->dev, dmaaddr, len,
+					 DMA_TO_DEVICE);
+
+		xdp_return_frame(xdpf);
+		ndev->stats.tx_packets++;
+		return;
+	}
+#endif /* ETHER_XDP */
+
 	if ((txdone_pkt_cx->flags & OSI_TXDONE_CX_TS) == OSI_TXDONE_CX_TS) {
 		memset(&shhwtstamp, 0, sizeof(struct skb_shared_hwtstamps));
 		shhwtstamp.hwtstamp = ns_to_ktime(txdone_pkt_cx->ns);
@@ -791,16 +1082,7 @@ static void osd_transmit_complete(void *priv, const struct osi_tx_swcx *swcx,
 		 * network queue.
 		 */
 		qinx = skb_get_queue_mapping(skb);
-		chan = osi_dma->dma_chans[qinx];
-		tx_ring = osi_dma->tx_ring[chan];
-		txq = netdev_get_tx_queue(ndev, qinx);
-
-		if (netif_tx_queue_stopped(txq) &&
-		    (ether_avail_txdesc_cnt(osi_dma, tx_ring) >
-		    ETHER_TX_DESC_THRESHOLD)) {
-			netif_tx_wake_queue(txq);
-			netdev_dbg(ndev, "Tx ring[%d] - waking Txq\n", chan);
-		}
+		ether_tx_wake_queue(pdata, qinx);
 
 		ndev->stats.tx_packets++;
 		if ((txdone_pkt_cx->flags & OSI_TXDONE_CX_TS_DELAYED) ==
@@ -15,6 +15,8 @@ struct ether_packet_ctxt {
 #else
 	unsigned char *dst;
 #endif
+	/** Extra payload length following test header */
+	unsigned int size;
 };
 
 /**
@@ -78,7 +80,7 @@ static struct sk_buff *ether_test_get_udp_skb(struct ether_priv_data *pdata,
 	struct iphdr *iph;
 	int    iplen;
 
-	skb = netdev_alloc_skb(pdata->ndev, ETHER_TEST_PKT_SIZE);
+	skb = netdev_alloc_skb(pdata->ndev, ETHER_TEST_PKT_SIZE + ctxt->size);
 	if (!skb) {
 		netdev_err(pdata->ndev, "Failed to allocate loopback skb\n");
 		return NULL;
@@ -104,7 +106,8 @@ static struct sk_buff *ether_test_get_udp_skb(struct ether_priv_data *pdata,
 	/* Fill UDP header */
 	udph->source = htons(ETHER_UDP_TEST_PORT);
 	udph->dest = htons(ETHER_UDP_TEST_PORT); /* Discard Protocol */
-	udph->len = htons(sizeof(struct ether_testhdr) + sizeof(struct udphdr));
+	udph->len = htons(sizeof(struct ether_testhdr) + sizeof(struct udphdr) +
+			  ctxt->size);
 	udph->check = OSI_NONE;
 
 	/* Fill IP header */
@@ -113,7 +116,7 @@ static struct sk_buff *ether_test_get_udp_skb(struct ether_priv_data *pdata,
 	iph->version = IPVERSION;
 	iph->protocol = IPPROTO_UDP;
 	iplen = sizeof(struct iphdr) + sizeof(struct udphdr) +
-		sizeof(struct ether_testhdr);
+		sizeof(struct ether_testhdr) + ctxt->size;
 	iph->tot_len = htons(iplen);
 	iph->frag_off = OSI_NONE;
 	iph->saddr = OSI_NONE;
@@ -125,6 +128,8 @@ static struct sk_buff *ether_test_get_udp_skb(struct ether_priv_data *pdata,
 	/* Fill test header and data */
 	testhdr = skb_put(skb, sizeof(*testhdr));
 	testhdr->magic = cpu_to_be64(ETHER_TEST_PKT_MAGIC);
+	if (ctxt->size > 0U)
+		memset(skb_put(skb, ctxt->size), 0, ctxt->size);
 
 	skb->csum = OSI_NONE;
 	skb->ip_summed = CHECKSUM_PARTIAL;
@@ -299,6 +304,34 @@ static int ether_test_phy_loopback(struct ether_priv_data *pdata)
 	return ether_test_loopback(pdata, &ctxt);
 }
 
+/**
+ * @brief ether_test_page_pool_loopback - Ethernet selftest for page pool Rx
+ *
+ * Algorithm:
+ * 1) Use a payload above Rx copybreak so that the packet is passed up in
+ * the page pool buffer it was received in, without copy.
+ *
+ * @param[in] pdata: Ethernet OSD private data
+ *
+ * @retval zero on success
+ * @retval negative value on failure.
+ */
+static int ether_test_page_pool_loopback(struct ether_priv_data *pdata)
+{
+	struct ether_packet_ctxt ctxt = { };
+
+#ifdef ETHER_XDP
+	ctxt.size = pdata->rx_copybreak + 1U;
+	if (ETHER_TEST_PKT_SIZE + ctxt.size > pdata->ndev->mtu + ETH_HLEN)
+		return -EINVAL;
+#else
+	return -EOPNOTSUPP;
+#endif
+
+	ctxt.dst = pdata->ndev->dev_addr;
+	return ether_test_loopback(pdata, &ctxt);
+}
+
 /**
  * @brief ether_test_mmc_counters - Ethernet selftest for MMC Counters
  *
@@ -368,6 +401,10 @@ static const struct ether_test {
 		.name = "MMC Counters		",
 		.lb = ETHER_LOOPBACK_MAC,
 		.fn = ether_test_mmc_counters,
+	}, {
+		.name = "Page Pool Loopback	",
+		.lb = ETHER_LOOPBACK_MAC,
+		.fn = ether_test_page_pool_loopback,
 	},
 };
 
@@ -23,10 +23,41 @@
 #include <linux/netdevice.h>
 #include <linux/pci.h>
 #include <linux/tegra_vnet.h>
+#if defined(NV_NET_GSO_H_PRESENT)
+#include <net/gso.h>
+#endif
+
+struct tvnet_priv;
+
+/* Data queue pair: H2EP and EP2H data rings with own NAPI and MSI vector */
+struct tvnet_queue {
+	struct tvnet_priv *tvnet;
+	int qid;
+	struct napi_struct napi;
+	struct list_head ep2h_empty_list;
+	/* To protect ep2h empty list */
+	spinlock_t ep2h_empty_lock;
+
+	/* Endpoint written message buffers */
+	struct data_msg *ep2h_full_msgs;
+	struct data_msg *h2ep_empty_msgs;
+	/* Host written message buffers */
+	struct data_msg *ep2h_empty_msgs;
+	struct data_msg *h2ep_full_msgs;
+
+	struct tvnet_counter h2ep_empty;
+	struct tvnet_counter h2ep_full;
+	struct tvnet_counter ep2h_empty;
+	struct tvnet_counter ep2h_full;
+
+	/* Tx packets waiting for DMA doorbell, protected by Tx queue lock */
+	struct tvnet_tx_pkt *tx_pkts;
+	u32 tx_pending;
+	u32 tx_pending_descs;
+};
 
 struct tvnet_priv {
 	struct net_device *ndev;
-	struct napi_struct napi;
 	struct pci_dev *pdev;
 	void __iomem *mmio_base;
 	void __iomem *msix_tbl;
@@ -34,13 +65,14 @@ struct tvnet_priv {
 	struct bar_md *bar_md;
 	struct ep_ring_buf ep_mem;
 	struct host_ring_buf host_mem;
-	struct list_head ep2h_empty_list;
-	/* To protect ep2h empty list */
-	spinlock_t ep2h_empty_lock;
 	struct tvnet_dma_desc *dma_desc;
 #if ENABLE_DMA
 	struct dma_desc_cnt desc_cnt;
+	/* EP DMA read channel is shared by all Tx queues */
+	spinlock_t dma_lock;
 #endif
+	struct tvnet_queue queues[TVNET_MAX_QUEUES];
+	int num_queues;
 	enum dir_link_state tx_link_state;
 	enum dir_link_state rx_link_state;
 	enum os_link_state os_link_state;
@@ -54,10 +86,6 @@ struct tvnet_priv {
 
 	struct tvnet_counter h2ep_ctrl;
 	struct tvnet_counter ep2h_ctrl;
-	struct tvnet_counter h2ep_empty;
-	struct tvnet_counter h2ep_full;
-	struct tvnet_counter ep2h_empty;
-	struct tvnet_counter ep2h_full;
 };
 
 #if ENABLE_DMA
@@ -96,9 +124,10 @@ static void tvnet_host_raise_ep_ctrl_irq(struct tvnet_priv *tvnet)
 	}
 }
 
-static void tvnet_host_raise_ep_data_irq(struct tvnet_priv *tvnet)
+static void tvnet_host_raise_ep_data_irq(struct tvnet_priv *tvnet,
+					 struct tvnet_queue *q)
 {
-	struct irq_md *irq = &tvnet->bar_md->irq_data;
+	struct irq_md *irq = &tvnet->bar_md->irq_data_mq[q->qid];
 
 	if (irq->irq_type == IRQ_SIMPLE) {
 		/* Can write any value to generate sync point irq */
@@ -156,16 +185,17 @@ static int tvnet_host_write_ctrl_msg(struct tvnet_priv *tvnet,
 	return 0;
 }
 
-static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
+static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet,
+					   struct tvnet_queue *q)
 {
 	struct net_device *ndev = tvnet->ndev;
-	struct host_ring_buf *host_mem = &tvnet->host_mem;
-	struct data_msg *ep2h_empty_msg = host_mem->ep2h_empty_msgs;
+	struct data_msg *ep2h_empty_msg = q->ep2h_empty_msgs;
 	struct ep2h_empty_list *ep2h_empty_ptr;
 	struct device *d = &tvnet->pdev->dev;
 	unsigned long flags;
+	bool posted = false;
 
-	while (!tvnet_ivc_full(&tvnet->ep2h_empty)) {
+	while (!tvnet_ivc_full(&q->ep2h_empty)) {
 		struct sk_buff *skb;
 		dma_addr_t iova;
 		int len = ndev->mtu + ETH_HLEN;
@@ -197,11 +227,11 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 		ep2h_empty_ptr->skb = skb;
 		ep2h_empty_ptr->iova = iova;
 		ep2h_empty_ptr->len = len;
-		spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-		list_add_tail(&ep2h_empty_ptr->list, &tvnet->ep2h_empty_list);
-		spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
+		spin_lock_irqsave(&q->ep2h_empty_lock, flags);
+		list_add_tail(&ep2h_empty_ptr->list, &q->ep2h_empty_list);
+		spin_unlock_irqrestore(&q->ep2h_empty_lock, flags);
 
-		idx = tvnet_ivc_get_wr_cnt(&tvnet->ep2h_empty) %
+		idx = tvnet_ivc_get_wr_cnt(&q->ep2h_empty) %
 					RING_COUNT;
 		ep2h_empty_msg[idx].u.empty_buffer.pcie_address = iova;
 		ep2h_empty_msg[idx].u.empty_buffer.buffer_len = len;
@@ -209,35 +239,51 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 		 * buffers are updated before updating counters.
 		 */
 		mb();
-		tvnet_ivc_advance_wr(&tvnet->ep2h_empty);
+		tvnet_ivc_advance_wr(&q->ep2h_empty);
+		posted = true;
+	}
 
+	/* One interrupt for the whole refill */
+	if (posted)
 		tvnet_host_raise_ep_ctrl_irq(tvnet);
-	}
+}
+
+static void tvnet_host_alloc_all_empty_buffers(struct tvnet_priv *tvnet)
+{
+	int i;
+
+	for (i = 0; i < tvnet->num_queues; i++)
+		tvnet_host_alloc_empty_buffers(tvnet, &tvnet->queues[i]);
 }
 
 static void tvnet_host_free_empty_buffers(struct tvnet_priv *tvnet)
 {
 	struct ep2h_empty_list *ep2h_empty_ptr, *temp;
 	struct device *d = &tvnet->pdev->dev;
+	struct tvnet_queue *q;
 	unsigned long flags;
-
-	spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-	list_for_each_entry_safe(ep2h_empty_ptr, temp, &tvnet->ep2h_empty_list,
-				 list) {
-		list_del(&ep2h_empty_ptr->list);
-		dma_unmap_single(d, ep2h_empty_ptr->iova, ep2h_empty_ptr->len,
-				 DMA_FROM_DEVICE);
-		dev_kfree_skb_any(ep2h_empty_ptr->skb);
-		kfree(ep2h_empty_ptr);
+	int i;
+
+	for (i = 0; i < tvnet->num_queues; i++) {
+		q = &tvnet->queues[i];
+		spin_lock_irqsave(&q->ep2h_empty_lock, flags);
+		list_for_each_entry_safe(ep2h_empty_ptr, temp,
+					 &q->ep2h_empty_list, list) {
+			list_del(&ep2h_empty_ptr->list);
+			dma_unmap_single(d, ep2h_empty_ptr->iova,
+					 ep2h_empty_ptr->len, DMA_FROM_DEVICE);
+			dev_kfree_skb_any(ep2h_empty_ptr->skb);
+			kfree(ep2h_empty_ptr);
+		}
+		spin_unlock_irqrestore(&q->ep2h_empty_lock, flags);
 	}
-	spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
 }
 
 static void tvnet_host_stop_tx_queue(struct tvnet_priv *tvnet)
 {
 	struct net_device *ndev = tvnet->ndev;
 
-	netif_stop_queue(ndev);
+	netif_tx_stop_all_queues(ndev);
 	/* Get tx lock to make sure that there is no ongoing xmit */
 	netif_tx_lock(ndev);
 	netif_tx_unlock(ndev);
@@ -245,8 +291,11 @@ static void tvnet_host_stop_tx_queue(struct tvnet_priv *tvnet)
 
 static void tvnet_host_stop_rx_work(struct tvnet_priv *tvnet)
 {
+	int i;
+
 	/* wait for interrupt handle to return to ensure rx is stopped */
-	synchronize_irq(pci_irq_vector(tvnet->pdev, 1));
+	for (i = 0; i < tvnet->num_queues; i++)
+		synchronize_irq(pci_irq_vector(tvnet->pdev, 1 + i));
 }
 
 static void tvnet_host_clear_data_msg_counters(struct tvnet_priv *tvnet)
@@ -255,22 +304,25 @@ static void tvnet_host_clear_data_msg_counters(struct tvnet_priv *tvnet)
 	struct host_own_cnt *host_cnt = host_mem->host_cnt;
 	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
 	struct ep_own_cnt *ep_cnt = ep_mem->ep_cnt;
+	int i;
 
-	host_cnt->ep2h_empty_wr_cnt = 0;
-	ep_cnt->ep2h_empty_rd_cnt = 0;
-	host_cnt->h2ep_full_wr_cnt = 0;
-	ep_cnt->h2ep_full_rd_cnt = 0;
+	for (i = 0; i < tvnet->num_queues; i++) {
+		host_cnt->data[i].ep2h_empty_wr_cnt = 0;
+		ep_cnt->data[i].ep2h_empty_rd_cnt = 0;
+		host_cnt->data[i].h2ep_full_wr_cnt = 0;
+		ep_cnt->data[i].h2ep_full_rd_cnt = 0;
+	}
 }
 
 static void tvnet_host_update_link_state(struct net_device *ndev,
 					 enum os_link_state state)
 {
 	if (state == OS_LINK_STATE_UP) {
-		netif_start_queue(ndev);
+		netif_tx_start_all_queues(ndev);
 		netif_carrier_on(ndev);
 	} else if (state == OS_LINK_STATE_DOWN) {
 		netif_carrier_off(ndev);
-		netif_stop_queue(ndev);
+		netif_tx_stop_all_queues(ndev);
 	} else {
 		pr_err("%s: invalid sate: %d\n", __func__, state);
 	}
@@ -298,7 +350,9 @@ static void tvnet_host_user_link_up_req(struct tvnet_priv *tvnet)
 	struct ctrl_msg msg = {};
 
 	tvnet_host_clear_data_msg_counters(tvnet);
-	tvnet_host_alloc_empty_buffers(tvnet);
+	tvnet_host_alloc_all_empty_buffers(tvnet);
+	/* Let EP know how many queue pairs are serviced */
+	tvnet->bar_md->host_num_queues = tvnet->num_queues;
 	msg.msg_id = CTRL_MSG_LINK_UP;
 	tvnet_host_write_ctrl_msg(tvnet, &msg);
 	tvnet->rx_link_state = DIR_LINK_STATE_UP;
@@ -346,11 +400,13 @@ static void tvnet_host_rcv_link_down_ack(struct tvnet_priv *tvnet)
 static int tvnet_host_open(struct net_device *ndev)
 {
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	int i;
 
 	mutex_lock(&tvnet->link_state_lock);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_DOWN)
 		tvnet_host_user_link_up_req(tvnet);
-	napi_enable(&tvnet->napi);
+	for (i = 0; i < tvnet->num_queues; i++)
+		napi_enable(&tvnet->queues[i].napi);
 	mutex_unlock(&tvnet->link_state_lock);
 
 	return 0;
@@ -360,9 +416,11 @@ static int tvnet_host_close(struct net_device *ndev)
 {
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
 	int ret = 0;
+	int i;
 
 	mutex_lock(&tvnet->link_state_lock);
-	napi_disable(&tvnet->napi);
+	for (i = 0; i < tvnet->num_queues; i++)
+		napi_disable(&tvnet->queues[i].napi);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_UP)
 		tvnet_host_user_link_down_req(tvnet);
 
@@ -406,94 +464,65 @@ static int tvnet_host_change_mtu(struct net_device *ndev, int new_mtu)
 	return 0;
 }
 
-static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
-					 struct net_device *ndev)
+static void tvnet_host_tx_unmap(struct tvnet_priv *tvnet,
+				struct tvnet_tx_pkt *pkt)
 {
-	struct tvnet_priv *tvnet = netdev_priv(ndev);
-	struct host_ring_buf *host_mem = &tvnet->host_mem;
-	struct data_msg *h2ep_full_msg = host_mem->h2ep_full_msgs;
-	struct skb_shared_info *info = skb_shinfo(skb);
-	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
-	struct data_msg *h2ep_empty_msg = ep_mem->h2ep_empty_msgs;
 	struct device *d = &tvnet->pdev->dev;
+	u32 i;
+
+	for (i = 0; i < pkt->nr_maps; i++) {
+		if (pkt->map[i].page)
+			dma_unmap_page(d, pkt->map[i].iova, pkt->map[i].len,
+				       DMA_TO_DEVICE);
+		else
+			dma_unmap_single(d, pkt->map[i].iova, pkt->map[i].len,
+					 DMA_TO_DEVICE);
+	}
+	pkt->nr_maps = 0;
+}
+
 #if ENABLE_DMA
+/*
+ * Chain DMA descriptors of all pending packets, each skb fragment is copied
+ * to its offset in the EP buffer. Doorbell is rung once and only the last
+ * descriptor raises the done interrupt.
+ */
+static int tvnet_host_tx_dma(struct tvnet_priv *tvnet, struct tvnet_queue *q)
+{
 	struct tvnet_dma_desc *dma_desc = tvnet->dma_desc;
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
-	u32 desc_widx, desc_ridx, val;
-	u32 ctrl_d;
+	u32 desc_widx = 0, desc_start, val, ctrl_d, i, j, n = 0;
 	unsigned long timeout;
-#endif
-	dma_addr_t src_iova;
-	dma_addr_t dst_iova;
-	u32 rd_idx;
-	u32 wr_idx;
-	void *dst_virt;
-	int len;
-
-	/* TODO Not expecting skb frags, remove this after testing */
-	WARN_ON(info->nr_frags);
-
-	/* Check if H2EP_EMPTY_BUF available to read */
-	if (!tvnet_ivc_rd_available(&tvnet->h2ep_empty)) {
-		tvnet_host_raise_ep_ctrl_irq(tvnet);
-		pr_debug("%s: No H2EP empty msg, stop tx\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-
-	/* Check if H2EP_FULL_BUF available to write */
-	if (tvnet_ivc_full(&tvnet->h2ep_full)) {
-		tvnet_host_raise_ep_ctrl_irq(tvnet);
-		pr_debug("%s: No H2EP full buf, stop tx\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-
-#if ENABLE_DMA
-	/* Check if dma desc available */
-	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) >= DMA_DESC_COUNT) {
-		pr_debug("%s: dma descriptors are not available\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
-#endif
-
-	len = skb_headlen(skb);
+	int ret = 0;
 
-	src_iova = dma_map_single(d, skb->data, len, DMA_TO_DEVICE);
-	if (dma_mapping_error(d, src_iova)) {
-		pr_err("%s: dma_map_single failed\n", __func__);
-		dev_kfree_skb_any(skb);
-		return NETDEV_TX_OK;
+	spin_lock(&tvnet->dma_lock);
+
+	desc_start = desc_cnt->wr_cnt;
+	for (i = 0; i < q->tx_pending; i++) {
+		struct tvnet_tx_pkt *pkt = &q->tx_pkts[i];
+		u64 dst_iova = pkt->dst_iova;
+
+		for (j = 0; j < pkt->nr_maps; j++) {
+			desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
+			dma_desc[desc_widx].size = pkt->map[j].len;
+			dma_desc[desc_widx].sar_low =
+					lower_32_bits(pkt->map[j].iova);
+			dma_desc[desc_widx].sar_high =
+					upper_32_bits(pkt->map[j].iova);
+			dma_desc[desc_widx].dar_low = lower_32_bits(dst_iova);
+			dma_desc[desc_widx].dar_high = upper_32_bits(dst_iova);
+			dst_iova += pkt->map[j].len;
+			/* CB bit should be set at the end */
+			mb();
+			ctrl_d = DMA_CH_CONTROL1_OFF_RDCH_CB;
+			if (++n == q->tx_pending_descs) {
+				ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_RIE;
+				ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_LIE;
+			}
+			dma_desc[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+			desc_cnt->wr_cnt++;
+		}
 	}
-
-	/* Get H2EP empty msg */
-	rd_idx = tvnet_ivc_get_rd_cnt(&tvnet->h2ep_empty) %
-				RING_COUNT;
-	dst_iova = h2ep_empty_msg[rd_idx].u.empty_buffer.pcie_address;
-	dst_virt = (__force void *)tvnet->mmio_base + (dst_iova - tvnet->bar_md->bar0_base_phy);
-	/* Advance read count after all failure cases complated, to avoid
-	 * dangling buffer at endpoint.
-	 */
-	tvnet_ivc_advance_rd(&tvnet->h2ep_empty);
-	/* Raise an interrupt to let EP populate H2EP_EMPTY_BUF ring */
-	tvnet_host_raise_ep_ctrl_irq(tvnet);
-
-#if ENABLE_DMA
-	/* Trigger DMA write from src_iova to dst_iova */
-	desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
-	dma_desc[desc_widx].size = len;
-	dma_desc[desc_widx].sar_low = lower_32_bits(src_iova);
-	dma_desc[desc_widx].sar_high = upper_32_bits(src_iova);
-	dma_desc[desc_widx].dar_low = lower_32_bits(dst_iova);
-	dma_desc[desc_widx].dar_high = upper_32_bits(dst_iova);
-	/* CB bit should be set at the end */
-	mb();
-	/* RIE is not required for polling mode */
-	ctrl_d = DMA_CH_CONTROL1_OFF_RDCH_RIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_LIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_CB;
-	dma_desc[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
 	/*
 	 * Read after write to avoid EP DMA reading LLE before CB is written to
 	 * EP's system memory.
@@ -506,12 +535,10 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	timeout = jiffies + msecs_to_jiffies(1000);
 	dma_common_wr(tvnet->dma_base, DMA_RD_DATA_CH, DMA_READ_DOORBELL_OFF);
 
-	desc_cnt->wr_cnt++;
-
 	while (true) {
 		val = dma_common_rd(tvnet->dma_base, DMA_READ_INT_STATUS_OFF);
-		if (val == BIT(DMA_RD_DATA_CH)) {
-			dma_common_wr(tvnet->dma_base, val,
+		if (val & BIT(DMA_RD_DATA_CH)) {
+			dma_common_wr(tvnet->dma_base, BIT(DMA_RD_DATA_CH),
 				      DMA_READ_INT_CLEAR_OFF);
 			break;
 		}
@@ -524,45 +551,256 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 			dma_common_wr(tvnet->dma_base,
 				      DMA_READ_ENGINE_EN_OFF_ENABLE,
 				      DMA_READ_ENGINE_EN_OFF);
-			desc_cnt->wr_cnt--;
-			dma_unmap_single(d, src_iova, len, DMA_TO_DEVICE);
-			return NETDEV_TX_BUSY;
+			ret = -ETIMEDOUT;
+			break;
 		}
 	}
 
-	desc_ridx = tvnet->desc_cnt.rd_cnt % DMA_DESC_COUNT;
-	/* Clear DMA cycle bit and increment rd_cnt */
-	dma_desc[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+	/* Clear DMA cycle bit of the whole chain */
+	for (i = desc_start; i != desc_cnt->wr_cnt; i++)
+		dma_desc[i % DMA_DESC_COUNT].ctrl_reg.ctrl_e.cb = 0;
 	mb();
 
-	tvnet->desc_cnt.rd_cnt++;
+	if (ret < 0)
+		desc_cnt->wr_cnt = desc_start;
+	desc_cnt->rd_cnt = desc_cnt->wr_cnt;
+
+	spin_unlock(&tvnet->dma_lock);
+
+	return ret;
+}
+#endif
+
+/* Copy pending packets to EP and hand them over with one interrupt */
+static void tvnet_host_tx_flush(struct tvnet_priv *tvnet,
+				struct tvnet_queue *q)
+{
+	struct data_msg *h2ep_full_msg = q->h2ep_full_msgs;
+	struct net_device *ndev = tvnet->ndev;
+	struct tvnet_tx_pkt *pkt;
+	u32 wr_idx, i;
+	int ret = 0;
+
+	if (!q->tx_pending)
+		return;
+
+	/* Let EP populate H2EP_EMPTY_BUF ring */
+	tvnet_host_raise_ep_ctrl_irq(tvnet);
+
+#if ENABLE_DMA
+	ret = tvnet_host_tx_dma(tvnet, q);
 #else
-	/* Copy skb->data to endpoint dst address, use CPU virt addr */
-	memcpy(dst_virt, skb->data, len);
+	for (i = 0; i < q->tx_pending; i++) {
+		void *dst_virt;
+
+		pkt = &q->tx_pkts[i];
+		/* Copy skb to endpoint dst address, use CPU virt addr */
+		dst_virt = (__force void *)tvnet->mmio_base +
+			   (pkt->dst_iova - tvnet->bar_md->bar0_base_phy);
+		skb_copy_bits(pkt->skb, 0, dst_virt, pkt->skb->len);
+	}
 	/* BAR0 mmio address is wc mem, add mb to make sure that complete
 	 * skb->data is written before updating counters.
 	 */
 	mb();
 #endif
 
-	/* Push dst to H2EP full ring */
-	wr_idx = tvnet_ivc_get_wr_cnt(&tvnet->h2ep_full) %
-				RING_COUNT;
-	h2ep_full_msg[wr_idx].u.full_buffer.packet_size = len;
-	h2ep_full_msg[wr_idx].u.full_buffer.pcie_address = dst_iova;
-	h2ep_full_msg[wr_idx].msg_id = DATA_MSG_FULL_BUF;
-	/* BAR0 mmio address is wc mem, add mb to make sure that full
-	 * buffer is written before updating counters.
+	for (i = 0; i < q->tx_pending; i++) {
+		pkt = &q->tx_pkts[i];
+		tvnet_host_tx_unmap(tvnet, pkt);
+
+		if (ret < 0) {
+			ndev->stats.tx_errors++;
+		} else {
+			/* Push dst to H2EP full ring */
+			wr_idx = tvnet_ivc_get_wr_cnt(&q->h2ep_full) %
+						RING_COUNT;
+			h2ep_full_msg[wr_idx].u.full_buffer.packet_size =
+						pkt->skb->len;
+			h2ep_full_msg[wr_idx].u.full_buffer.pcie_address =
+						pkt->dst_iova;
+			tvnet_skb_to_full_msg(pkt->skb,
+					      &h2ep_full_msg[wr_idx]);
+			h2ep_full_msg[wr_idx].msg_id = DATA_MSG_FULL_BUF;
+			/* BAR0 mmio address is wc mem, add mb to make sure
+			 * that full buffer is written before updating
+			 * counters.
+			 */
+			mb();
+			tvnet_ivc_advance_wr(&q->h2ep_full);
+			ndev->stats.tx_packets++;
+			ndev->stats.tx_bytes += pkt->skb->len;
+		}
+
+		netdev_tx_completed_queue(pkt->txq, 1, pkt->skb->len);
+		dev_consume_skb_any(pkt->skb);
+		pkt->skb = NULL;
+	}
+
+	if (ret == 0)
+		tvnet_host_raise_ep_data_irq(tvnet, q);
+
+	q->tx_pending = 0;
+	q->tx_pending_descs = 0;
+}
+
+static bool tvnet_host_tx_avail(struct tvnet_queue *q, u32 count)
+{
+	/* Full messages of pending packets are not pushed yet */
+	return tvnet_ivc_rd_available(&q->h2ep_empty) >= count &&
+	       tvnet_ivc_wr_available(&q->h2ep_full) >= q->tx_pending + count;
+}
+
+/* Map skb and reserve an EP empty buffer for it, doorbell comes at flush */
+static void tvnet_host_tx_queue_skb(struct tvnet_priv *tvnet,
+				    struct tvnet_queue *q,
+				    struct netdev_queue *txq,
+				    struct sk_buff *skb)
+{
+	struct skb_shared_info *info = skb_shinfo(skb);
+	struct data_msg *h2ep_empty_msg = q->h2ep_empty_msgs;
+	struct device *d = &tvnet->pdev->dev;
+	struct tvnet_tx_pkt *pkt;
+	u32 nr_descs = info->nr_frags + 1;
+	u32 rd_idx, len, i;
+	dma_addr_t iova;
+
+	if (q->tx_pending == TVNET_TX_BATCH ||
+	    q->tx_pending_descs + nr_descs > DMA_DESC_COUNT)
+		tvnet_host_tx_flush(tvnet, q);
+
+	pkt = &q->tx_pkts[q->tx_pending];
+	pkt->nr_maps = 0;
+
+	len = skb_headlen(skb);
+	if (len) {
+		iova = dma_map_single(d, skb->data, len, DMA_TO_DEVICE);
+		if (dma_mapping_error(d, iova)) {
+			pr_err("%s: dma_map_single failed\n", __func__);
+			goto drop;
+		}
+		pkt->map[pkt->nr_maps].iova = iova;
+		pkt->map[pkt->nr_maps].len = len;
+		pkt->map[pkt->nr_maps].page = false;
+		pkt->nr_maps++;
+	}
+
+	for (i = 0; i < info->nr_frags; i++) {
+		skb_frag_t *frag = &info->frags[i];
+
+		len = skb_frag_size(frag);
+		iova = skb_frag_dma_map(d, frag, 0, len, DMA_TO_DEVICE);
+		if (dma_mapping_error(d, iova)) {
+			pr_err("%s: skb_frag_dma_map failed\n", __func__);
+			goto drop;
+		}
+		pkt->map[pkt->nr_maps].iova = iova;
+		pkt->map[pkt->nr_maps].len = len;
+		pkt->map[pkt->nr_maps].page = true;
+		pkt->nr_maps++;
+	}
+
+	/* Get H2EP empty msg */
+	rd_idx = tvnet_ivc_get_rd_cnt(&q->h2ep_empty) % RING_COUNT;
+	pkt->dst_iova = h2ep_empty_msg[rd_idx].u.empty_buffer.pcie_address;
+	/* Advance read count after all failure cases complated, to avoid
+	 * dangling buffer at endpoint.
 	 */
-	mb();
-	tvnet_ivc_advance_wr(&tvnet->h2ep_full);
-	tvnet_host_raise_ep_data_irq(tvnet);
+	tvnet_ivc_advance_rd(&q->h2ep_empty);
+
+	pkt->skb = skb;
+	pkt->txq = txq;
+	netdev_tx_sent_queue(txq, skb->len);
+	q->tx_pending++;
+	q->tx_pending_descs += pkt->nr_maps;
 
-	/* Free skb */
-	dma_unmap_single(d, src_iova, len, DMA_TO_DEVICE);
+	return;
+
+drop:
+	tvnet_host_tx_unmap(tvnet, pkt);
+	tvnet->ndev->stats.tx_dropped++;
 	dev_kfree_skb_any(skb);
+}
+
+/* TSO frame larger than EP buffer, segment it in software */
+static void tvnet_host_tx_gso(struct tvnet_priv *tvnet, struct tvnet_queue *q,
+			      struct netdev_queue *txq, struct sk_buff *skb)
+{
+	struct net_device *ndev = tvnet->ndev;
+	struct sk_buff *segs, *next;
+
+	segs = skb_gso_segment(skb, ndev->features & ~NETIF_F_GSO_MASK);
+	if (IS_ERR_OR_NULL(segs)) {
+		ndev->stats.tx_dropped++;
+		dev_kfree_skb_any(skb);
+		return;
+	}
+	dev_consume_skb_any(skb);
+
+	for (; segs; segs = next) {
+		next = segs->next;
+		segs->next = NULL;
+
+		/* Space for gso_segs segments is checked by the caller */
+		if (unlikely(!tvnet_host_tx_avail(q, 1))) {
+			ndev->stats.tx_dropped++;
+			dev_kfree_skb_any(segs);
+			continue;
+		}
+
+		tvnet_host_tx_queue_skb(tvnet, q, txq, segs);
+	}
+}
+
+static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
+					 struct net_device *ndev)
+{
+	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	u16 qid = skb_get_queue_mapping(skb);
+	struct tvnet_queue *q = &tvnet->queues[qid];
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, qid);
+	struct data_msg *h2ep_empty_msg = q->h2ep_empty_msgs;
+	bool more = tvnet_xmit_more(skb);
+	u32 rd_idx, dst_len, nr_segs;
+
+	/* Check if H2EP_EMPTY_BUF available to read and H2EP_FULL_BUF
+	 * available to write.
+	 */
+	if (!tvnet_host_tx_avail(q, 1))
+		goto busy;
+
+	rd_idx = tvnet_ivc_get_rd_cnt(&q->h2ep_empty) % RING_COUNT;
+	dst_len = h2ep_empty_msg[rd_idx].u.empty_buffer.buffer_len;
+
+	if (likely(skb->len <= dst_len)) {
+		tvnet_host_tx_queue_skb(tvnet, q, txq, skb);
+	} else if (skb_is_gso(skb) &&
+		   skb_shinfo(skb)->gso_segs <= RING_COUNT) {
+		/* All segments must fit, or the skb is requeued as a whole */
+		nr_segs = skb_shinfo(skb)->gso_segs;
+		if (!tvnet_host_tx_avail(q, nr_segs)) {
+			tvnet_host_tx_flush(tvnet, q);
+			if (!tvnet_host_tx_avail(q, nr_segs))
+				goto busy;
+		}
+		tvnet_host_tx_gso(tvnet, q, txq, skb);
+	} else {
+		ndev->stats.tx_dropped++;
+		dev_kfree_skb_any(skb);
+	}
+
+	if (!more || q->tx_pending == TVNET_TX_BATCH ||
+	    netif_xmit_stopped(txq))
+		tvnet_host_tx_flush(tvnet, q);
 
 	return NETDEV_TX_OK;
+
+busy:
+	tvnet_host_tx_flush(tvnet, q);
+	tvnet_host_raise_ep_ctrl_irq(tvnet);
+	pr_debug("%s: No H2EP empty/full msg, stop tx\n", __func__);
+	netif_tx_stop_queue(txq);
+	return NETDEV_TX_BUSY;
 }
 
 static const struct net_device_ops tvnet_host_netdev_ops = {
@@ -604,14 +842,35 @@ static void tvnet_host_setup_bar0_md(struct tvnet_priv *tvnet)
 	tvnet->h2ep_ctrl.wr = &host_mem->host_cnt->h2ep_ctrl_wr_cnt;
 	tvnet->ep2h_ctrl.rd = &host_mem->host_cnt->ep2h_ctrl_rd_cnt;
 	tvnet->ep2h_ctrl.wr = &ep_mem->ep_cnt->ep2h_ctrl_wr_cnt;
-	tvnet->h2ep_empty.rd = &host_mem->host_cnt->h2ep_empty_rd_cnt;
-	tvnet->h2ep_empty.wr = &ep_mem->ep_cnt->h2ep_empty_wr_cnt;
-	tvnet->h2ep_full.rd = &ep_mem->ep_cnt->h2ep_full_rd_cnt;
-	tvnet->h2ep_full.wr = &host_mem->host_cnt->h2ep_full_wr_cnt;
-	tvnet->ep2h_empty.rd = &ep_mem->ep_cnt->ep2h_empty_rd_cnt;
-	tvnet->ep2h_empty.wr = &host_mem->host_cnt->ep2h_empty_wr_cnt;
-	tvnet->ep2h_full.rd = &host_mem->host_cnt->ep2h_full_rd_cnt;
-	tvnet->ep2h_full.wr = &ep_mem->ep_cnt->ep2h_full_wr_cnt;
+}
+
+/* Data rings of queue N follow the RING_COUNT messages of queue N - 1 */
+static void tvnet_host_setup_queue(struct tvnet_priv *tvnet, int qid)
+{
+	struct tvnet_queue *q = &tvnet->queues[qid];
+	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
+	struct host_ring_buf *host_mem = &tvnet->host_mem;
+	struct ep_own_data_cnt *ep_cnt = &ep_mem->ep_cnt->data[qid];
+	struct host_own_data_cnt *host_cnt = &host_mem->host_cnt->data[qid];
+
+	q->tvnet = tvnet;
+	q->qid = qid;
+	INIT_LIST_HEAD(&q->ep2h_empty_list);
+	spin_lock_init(&q->ep2h_empty_lock);
+
+	q->ep2h_full_msgs = ep_mem->ep2h_full_msgs + qid * RING_COUNT;
+	q->h2ep_empty_msgs = ep_mem->h2ep_empty_msgs + qid * RING_COUNT;
+	q->ep2h_empty_msgs = host_mem->ep2h_empty_msgs + qid * RING_COUNT;
+	q->h2ep_full_msgs = host_mem->h2ep_full_msgs + qid * RING_COUNT;
+
+	q->h2ep_empty.rd = &host_cnt->h2ep_empty_rd_cnt;
+	q->h2ep_empty.wr = &ep_cnt->h2ep_empty_wr_cnt;
+	q->h2ep_full.rd = &ep_cnt->h2ep_full_rd_cnt;
+	q->h2ep_full.wr = &host_cnt->h2ep_full_wr_cnt;
+	q->ep2h_empty.rd = &ep_cnt->ep2h_empty_rd_cnt;
+	q->ep2h_empty.wr = &host_cnt->ep2h_empty_wr_cnt;
+	q->ep2h_full.rd = &host_cnt->ep2h_full_rd_cnt;
+	q->ep2h_full.wr = &ep_cnt->ep2h_full_wr_cnt;
 }
 
 static void tvnet_host_process_ctrl_msg(struct tvnet_priv *tvnet)
@@ -629,31 +888,33 @@ static void tvnet_host_process_ctrl_msg(struct tvnet_priv *tvnet)
 	}
 }
 
-static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
+static int tvnet_host_process_ep2h_msg(struct tvnet_queue *q)
 {
-	struct ep_ring_buf *ep_mem = &tvnet->ep_mem;
-	struct data_msg *data_msg = ep_mem->ep2h_full_msgs;
+	struct tvnet_priv *tvnet = q->tvnet;
+	struct data_msg *data_msg = q->ep2h_full_msgs;
 	struct device *d = &tvnet->pdev->dev;
 	struct ep2h_empty_list *ep2h_empty_ptr;
 	struct net_device *ndev = tvnet->ndev;
 	int count = 0;
 
 	while ((count < TVNET_NAPI_WEIGHT) &&
-	       tvnet_ivc_rd_available(&tvnet->ep2h_full)) {
+	       tvnet_ivc_rd_available(&q->ep2h_full)) {
 		struct sk_buff *skb;
+		struct data_msg msg;
 		u64 pcie_address;
 		u32 len;
 		int idx, found = 0;
 		unsigned long flags;
 
-		/* Read EP2H full msg */
-		idx = tvnet_ivc_get_rd_cnt(&tvnet->ep2h_full) %
+		/* Read EP2H full msg, slot is reused once rd is advanced */
+		idx = tvnet_ivc_get_rd_cnt(&q->ep2h_full) %
 					RING_COUNT;
-		len = data_msg[idx].u.full_buffer.packet_size;
-		pcie_address = data_msg[idx].u.full_buffer.pcie_address;
+		msg = data_msg[idx];
+		len = msg.u.full_buffer.packet_size;
+		pcie_address = msg.u.full_buffer.pcie_address;
 
-		spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-		list_for_each_entry(ep2h_empty_ptr, &tvnet->ep2h_empty_list,
+		spin_lock_irqsave(&q->ep2h_empty_lock, flags);
+		list_for_each_entry(ep2h_empty_ptr, &q->ep2h_empty_list,
 				    list) {
 			if (ep2h_empty_ptr->iova == pcie_address) {
 				list_del(&ep2h_empty_ptr->list);
@@ -661,10 +922,10 @@ static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
 				break;
 			}
 		}
-		spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
+		spin_unlock_irqrestore(&q->ep2h_empty_lock, flags);
 
 		/* Advance H2EP full buffer after search in local list */
-		tvnet_ivc_advance_rd(&tvnet->ep2h_full);
+		tvnet_ivc_advance_rd(&q->ep2h_full);
 		if (WARN_ON(!found))
 			continue;
 
@@ -676,8 +937,15 @@ static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
 		dma_unmap_single(d, pcie_address, ndev->mtu + ETH_HLEN, DMA_FROM_DEVICE);
 		skb = ep2h_empty_ptr->skb;
 		skb_put(skb, len);
+		if (tvnet_full_msg_to_skb(skb, &msg) < 0) {
+			ndev->stats.rx_errors++;
+			dev_kfree_skb_any(skb);
+			kfree(ep2h_empty_ptr);
+			continue;
+		}
 		skb->protocol = eth_type_trans(skb, ndev);
-		napi_gro_receive(&tvnet->napi, skb);
+		skb_record_rx_queue(skb, q->qid);
+		napi_gro_receive(&q->napi, skb);
 
 		/* Free EP2H empty list element */
 		kfree(ep2h_empty_ptr);
@@ -691,34 +959,38 @@ static irqreturn_t tvnet_irq_ctrl(int irq, void *data)
 {
 	struct net_device *ndev = data;
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
-
-	if (netif_queue_stopped(ndev)) {
-		if ((tvnet->os_link_state == OS_LINK_STATE_UP) &&
-		    tvnet_ivc_rd_available(&tvnet->h2ep_empty) &&
-		    !tvnet_ivc_full(&tvnet->h2ep_full)) {
-			pr_debug("%s: wake net tx queue\n", __func__);
-			netif_wake_queue(ndev);
+	struct netdev_queue *txq;
+	struct tvnet_queue *q;
+	int i;
+
+	for (i = 0; i < tvnet->num_queues; i++) {
+		q = &tvnet->queues[i];
+		txq = netdev_get_tx_queue(ndev, i);
+		if (netif_tx_queue_stopped(txq) &&
+		    (tvnet->os_link_state == OS_LINK_STATE_UP) &&
+		    tvnet_ivc_rd_available(&q->h2ep_empty) &&
+		    !tvnet_ivc_full(&q->h2ep_full)) {
+			pr_debug("%s: wake net tx queue %d\n", __func__, i);
+			netif_tx_wake_queue(txq);
 		}
 	}
 
 	if (tvnet_ivc_rd_available(&tvnet->ep2h_ctrl))
 		tvnet_host_process_ctrl_msg(tvnet);
 
-	if (!tvnet_ivc_full(&tvnet->ep2h_empty) &&
-	    (tvnet->os_link_state == OS_LINK_STATE_UP))
-		tvnet_host_alloc_empty_buffers(tvnet);
+	if (tvnet->os_link_state == OS_LINK_STATE_UP)
+		tvnet_host_alloc_all_empty_buffers(tvnet);
 
 	return IRQ_HANDLED;
 }
 
 static irqreturn_t tvnet_irq_data(int irq, void *data)
 {
-	struct net_device *ndev = data;
-	struct tvnet_priv *tvnet = netdev_priv(ndev);
+	struct tvnet_queue *q = data;
 
-	if (tvnet_ivc_rd_available(&tvnet->ep2h_full)) {
-		disable_irq_nosync(pci_irq_vector(tvnet->pdev, 1));
-		napi_schedule(&tvnet->napi);
+	if (tvnet_ivc_rd_available(&q->ep2h_full)) {
+		disable_irq_nosync(irq);
+		napi_schedule(&q->napi);
 	}
 
 	return IRQ_HANDLED;
@@ -726,31 +998,87 @@ static irqreturn_t tvnet_irq_data(int irq, void *data)
 
 static int tvnet_host_poll(struct napi_struct *napi, int budget)
 {
-	struct tvnet_priv *tvnet = container_of(napi, struct tvnet_priv, napi);
+	struct tvnet_queue *q = container_of(napi, struct tvnet_queue, napi);
 	int work_done;
 
-	work_done = tvnet_host_process_ep2h_msg(tvnet);
+	work_done = tvnet_host_process_ep2h_msg(q);
 	if (work_done < budget) {
 		napi_complete(napi);
-		enable_irq(pci_irq_vector(tvnet->pdev, 1));
+		enable_irq(pci_irq_vector(q->tvnet->pdev, 1 + q->qid));
 	}
 
 	return work_done;
 }
 
+static void tvnet_host_free_queues(struct tvnet_priv *tvnet)
+{
+	int i;
+
+	for (i = 0; i < tvnet->num_queues; i++) {
+		netif_napi_del(&tvnet->queues[i].napi);
+		kfree(tvnet->queues[i].tx_pkts);
+		tvnet->queues[i].tx_pkts = NULL;
+	}
+}
+
+static int tvnet_host_alloc_queues(struct tvnet_priv *tvnet)
+{
+	struct net_device *ndev = tvnet->ndev;
+	struct tvnet_queue *q;
+	int i, ret;
+
+	for (i = 0; i < tvnet->num_queues; i++) {
+		q = &tvnet->queues[i];
+		tvnet_host_setup_queue(tvnet, i);
+		q->tx_pkts = kcalloc(TVNET_TX_BATCH, sizeof(*q->tx_pkts),
+				     GFP_KERNEL);
+		if (!q->tx_pkts) {
+			tvnet->num_queues = i;
+			tvnet_host_free_queues(tvnet);
+			return -ENOMEM;
+		}
+#if defined(NV_NETIF_NAPI_ADD_WEIGHT_PRESENT) /* Linux v6.1 */
+		netif_napi_add_weight(ndev, &q->napi, tvnet_host_poll,
+				      TVNET_NAPI_WEIGHT);
+#else
+		netif_napi_add(ndev, &q->napi, tvnet_host_poll,
+			       TVNET_NAPI_WEIGHT);
+#endif
+	}
+
+	ret = netif_set_real_num_tx_queues(ndev, tvnet->num_queues);
+	if (!ret)
+		ret = netif_set_real_num_rx_queues(ndev, tvnet->num_queues);
+	if (ret)
+		tvnet_host_free_queues(tvnet);
+
+	return ret;
+}
+
+static void tvnet_host_free_data_irqs(struct tvnet_priv *tvnet, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		free_irq(pci_irq_vector(tvnet->pdev, 1 + i),
+			 &tvnet->queues[i]);
+}
+
 static int tvnet_host_probe(struct pci_dev *pdev,
 			    const struct pci_device_id *pci_id)
 {
 	struct tvnet_priv *tvnet;
 	struct net_device *ndev;
-	int ret;
+	u32 nr_queues;
+	int ret, i;
 
 	dev_dbg(&pdev->dev, "%s: PCIe VID: 0x%x DID: 0x%x\n", __func__,
 		pci_id->vendor, pci_id->device);
-	ndev = alloc_etherdev(sizeof(struct tvnet_priv));
+	ndev = alloc_etherdev_mqs(sizeof(struct tvnet_priv), TVNET_MAX_QUEUES,
+				  TVNET_MAX_QUEUES);
 	if (!ndev) {
 		ret = -ENOMEM;
-		dev_err(&pdev->dev, "alloc_etherdev() failed");
+		dev_err(&pdev->dev, "alloc_etherdev_mqs() failed");
 		goto fail;
 	}
 
@@ -814,21 +1142,32 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 
 	/* Setup BAR0 meta data */
 	tvnet_host_setup_bar0_md(tvnet);
-
-#if defined(NV_NETIF_NAPI_ADD_WEIGHT_PRESENT) /* Linux v6.1 */
-	netif_napi_add_weight(ndev, &tvnet->napi, tvnet_host_poll, TVNET_NAPI_WEIGHT);
-#else
-	netif_napi_add(ndev, &tvnet->napi, tvnet_host_poll, TVNET_NAPI_WEIGHT);
+#if ENABLE_DMA
+	spin_lock_init(&tvnet->dma_lock);
 #endif
 
-	ndev->mtu = TVNET_DEFAULT_MTU;
+	/* Vector 0 is for ctrl msgs, one data vector per queue pair */
+	nr_queues = clamp_t(u32, tvnet->bar_md->num_queues, 1,
+			    TVNET_MAX_QUEUES);
+	ret = pci_alloc_irq_vectors(pdev, 2, 1 + nr_queues, PCI_IRQ_MSIX |
+				    PCI_IRQ_AFFINITY);
+	if (ret <= 0) {
+		dev_err(&pdev->dev, "pci_alloc_irq_vectors() fail: %d\n", ret);
+		ret = -EIO;
+		goto pci_disable;
+	}
+	tvnet->num_queues = ret - 1;
 
-	ret = register_netdev(ndev);
+	ret = tvnet_host_alloc_queues(tvnet);
 	if (ret) {
-		dev_err(&pdev->dev, "register_netdev() fail: %d\n", ret);
-		goto pci_disable;
+		dev_err(&pdev->dev, "queue setup fail: %d\n", ret);
+		goto disable_msi;
 	}
-	netif_carrier_off(ndev);
+
+	ndev->mtu = TVNET_DEFAULT_MTU;
+	ndev->hw_features = NETIF_F_SG | NETIF_F_HW_CSUM | NETIF_F_TSO |
+			    NETIF_F_TSO6;
+	ndev->features = ndev->hw_features | NETIF_F_HIGHDMA;
 
 	tvnet->rx_link_state = DIR_LINK_STATE_DOWN;
 	tvnet->tx_link_state = DIR_LINK_STATE_DOWN;
@@ -836,45 +1175,45 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 	mutex_init(&tvnet->link_state_lock);
 	init_waitqueue_head(&tvnet->link_state_wq);
 
-	ret = pci_alloc_irq_vectors(pdev, 2, 2, PCI_IRQ_MSIX |
-				    PCI_IRQ_AFFINITY);
-	if (ret <= 0) {
-		dev_err(&pdev->dev, "pci_alloc_irq_vectors() fail: %d\n", ret);
-		ret = -EIO;
-		goto unreg_netdev;
+	ret = register_netdev(ndev);
+	if (ret) {
+		dev_err(&pdev->dev, "register_netdev() fail: %d\n", ret);
+		goto free_queues;
 	}
+	netif_carrier_off(ndev);
 
 	ret = request_irq(pci_irq_vector(pdev, 0), tvnet_irq_ctrl, 0,
 			  ndev->name, ndev);
 	if (ret < 0) {
 		dev_err(&pdev->dev, "request_irq() fail: %d\n", ret);
-		goto disable_msi;
+		goto unreg_netdev;
 	}
 
-	ret = request_irq(pci_irq_vector(pdev, 1), tvnet_irq_data, 0,
-			  ndev->name, ndev);
-	if (ret < 0) {
-		dev_err(&pdev->dev, "request_irq() fail: %d\n", ret);
-		goto fail_request_irq_ctrl;
+	for (i = 0; i < tvnet->num_queues; i++) {
+		ret = request_irq(pci_irq_vector(pdev, 1 + i), tvnet_irq_data,
+				  0, ndev->name, &tvnet->queues[i]);
+		if (ret < 0) {
+			dev_err(&pdev->dev, "request_irq() fail: %d\n", ret);
+			tvnet_host_free_data_irqs(tvnet, i);
+			goto fail_request_irq_ctrl;
+		}
 	}
 
 #if ENABLE_DMA
 	tvnet_host_write_dma_msix_settings(tvnet);
 #endif
 
-	INIT_LIST_HEAD(&tvnet->ep2h_empty_list);
-	spin_lock_init(&tvnet->ep2h_empty_lock);
-
 	return 0;
 
 fail_request_irq_ctrl:
 	free_irq(pci_irq_vector(pdev, 0), ndev);
-disable_msi:
-	pci_free_irq_vectors(pdev);
 unreg_netdev:
 	unregister_netdev(ndev);
+free_queues:
+	tvnet_host_free_queues(tvnet);
+disable_msi:
+	pci_free_irq_vectors(pdev);
 pci_disable:
-	netif_napi_del(&tvnet->napi);
 	pci_disable_device(pdev);
 free_netdev:
 	free_netdev(ndev);
@@ -902,10 +1241,10 @@ static void tvnet_host_remove(struct pci_dev *pdev)
 	}
 
 	free_irq(pci_irq_vector(pdev, 0), tvnet->ndev);
-	free_irq(pci_irq_vector(pdev, 1), tvnet->ndev);
-	pci_free_irq_vectors(pdev);
+	tvnet_host_free_data_irqs(tvnet, tvnet->num_queues);
 	unregister_netdev(tvnet->ndev);
-	netif_napi_del(&tvnet->napi);
+	tvnet_host_free_queues(tvnet);
+	pci_free_irq_vectors(pdev);
 	pci_disable_device(pdev);
 	free_netdev(tvnet->ndev);
 }
@@ -913,8 +1252,10 @@ static void tvnet_host_remove(struct pci_dev *pdev)
 static int tvnet_host_suspend(struct pci_dev *pdev, pm_message_t state)
 {
 	struct tvnet_priv *tvnet = pci_get_drvdata(pdev);
+	int i;
 
-	disable_irq(pci_irq_vector(tvnet->pdev, 1));
+	for (i = 0; i < tvnet->num_queues; i++)
+		disable_irq(pci_irq_vector(tvnet->pdev, 1 + i));
 
 	if (tvnet->rx_link_state == DIR_LINK_STATE_UP) {
 		tvnet_host_close(tvnet->ndev);
@@ -927,6 +1268,7 @@ static int tvnet_host_suspend(struct pci_dev *pdev, pm_message_t state)
 static int tvnet_host_resume(struct pci_dev *pdev)
 {
 	struct tvnet_priv *tvnet = pci_get_drvdata(pdev);
+	int i;
 #if ENABLE_DMA
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
 
@@ -939,7 +1281,8 @@ static int tvnet_host_resume(struct pci_dev *pdev)
 		tvnet->pm_closed = false;
 	}
 
-	enable_irq(pci_irq_vector(tvnet->pdev, 1));
+	for (i = 0; i < tvnet->num_queues; i++)
+		enable_irq(pci_irq_vector(tvnet->pdev, 1 + i));
 
 	return 0;
 }
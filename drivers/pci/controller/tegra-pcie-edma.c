@@ -6,6 +6,7 @@
  */
 
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/dma-mapping.h>
 #include <linux/io.h>
@@ -14,6 +15,8 @@
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
 #include <linux/tegra-pcie-edma.h>
 #include <linux/limits.h>
 #include "tegra-pcie-dma-osi.h"
@@ -33,10 +36,34 @@
 
 #define INCR_DESC(idx, i) ((idx) = ((idx) + (i)) % (ch->desc_sz))
 
+/** Completion slot, one per descriptor, used at the last descriptor of an xfer */
+struct edma_ring {
+	edma_complete_t *complete;
+	void *priv;
+	ktime_t submit_ts;
+};
+
+/** Per channel counters exposed in debugfs */
+struct edma_chan_stats {
+	/** xfer requests submitted */
+	u64 xfers;
+	/** doorbells rung for those xfers */
+	u64 doorbells;
+	/** completion interrupts processed */
+	u64 irqs;
+	/** xfer requests completed */
+	u64 completed;
+	/** submit to completion latency of completed xfers */
+	u64 lat_sum_ns;
+	u64 lat_max_ns;
+	/** max descriptors outstanding after a submit */
+	u32 depth_max;
+};
+
 struct edma_chan {
 	void *desc;
 	void __iomem *remap_desc;
-	struct tegra_pcie_edma_xfer_info *ring;
+	struct edma_ring *ring;
 	dma_addr_t dma_iova;
 	uint32_t desc_sz;
 	/* descriptor size that is allocated for a channel */
@@ -55,6 +82,7 @@ struct edma_chan {
 	bool db_pos;
 	/** This field is updated to abort or de-init to stop further xfer submits */
 	edma_xfer_status_t st;
+	struct edma_chan_stats stats;
 };
 
 struct edma_prv {
@@ -72,6 +100,7 @@ struct edma_prv {
 	struct edma_chan rx[DMA_RD_CHNL_NUM];
 	/* BIT(0) - Write initialized, BIT(1) - Read initialized */
 	uint32_t ch_init;
+	struct dentry *debugfs;
 };
 
 /** TODO: Define osi_ll_init strcuture and make this as OSI */
@@ -268,7 +297,9 @@ static inline void process_r_idx(struct edma_chan *ch, edma_xfer_status_t st, u3
 	u32 count = 0;
 	struct edma_hw_desc *dma_ll_virt;
 	struct edma_dblock *db;
-	struct tegra_pcie_edma_xfer_info *ring;
+	struct edma_ring *ring;
+	ktime_t now = ktime_get();
+	u64 lat;
 
 	while ((ch->r_idx != idx) && (count < ch->desc_sz)) {
 		count++;
@@ -281,6 +312,11 @@ static inline void process_r_idx(struct edma_chan *ch, edma_xfer_status_t st, u3
 		dma_ll_virt->ctrl_reg.ctrl_e.lie = 0;
 		dma_ll_virt->ctrl_reg.ctrl_e.rie = 0;
 		if (ch->type == EDMA_CHAN_XFER_ASYNC && ring->complete) {
+			lat = ktime_to_ns(ktime_sub(now, ring->submit_ts));
+			ch->stats.completed++;
+			ch->stats.lat_sum_ns += lat;
+			if (lat > ch->stats.lat_max_ns)
+				ch->stats.lat_max_ns = lat;
 			ring->complete(ring->priv, st, NULL);
 			/* Clear ring callback and priv variables */
 			ring->complete = NULL;
@@ -294,6 +330,7 @@ static inline void process_ch_irq(struct edma_prv *prv, u32 chan, struct edma_ch
 {
 	u32 idx;
 
+	ch->stats.irqs++;
 	idx = get_dma_idx_from_llp(prv, (u8)(chan & 0xFF), ch, type);
 
 	if (ch->type == EDMA_CHAN_XFER_SYNC) {
@@ -418,6 +455,38 @@ static irqreturn_t edma_irq_handler(int irq, void *cookie)
 	return IRQ_HANDLED;
 }
 
+static int edma_stats_show(struct seq_file *s, void *data)
+{
+	struct edma_prv *prv = (struct edma_prv *)s->private;
+	struct edma_chan *chan[2] = {&prv->tx[0], &prv->rx[0]};
+	u32 mode_cnt[2] = {DMA_WR_CHNL_NUM, DMA_RD_CHNL_NUM};
+	const char *dir[2] = {"wr", "rd"};
+	struct edma_chan_stats *st;
+	struct edma_chan *ch;
+	u64 avg;
+	int i, j;
+
+	seq_puts(s, "chan\txfers\tdoorbells\tirqs\tcompleted\tdepth\tdepth_max\tlat_avg_ns\tlat_max_ns\n");
+	for (j = 0; j < 2; j++) {
+		for (i = 0; i < mode_cnt[j]; i++) {
+			ch = chan[j] + i;
+			if (!ch->desc_sz)
+				continue;
+
+			st = &ch->stats;
+			avg = st->completed ? div64_u64(st->lat_sum_ns, st->completed) : 0;
+			seq_printf(s, "%s%d\t%llu\t%llu\t%llu\t%llu\t%u\t%u\t%llu\t%llu\n",
+				   dir[j], i, st->xfers, st->doorbells, st->irqs,
+				   st->completed,
+				   (ch->w_idx - ch->r_idx) & (ch->desc_sz - 1U),
+				   st->depth_max, avg, st->lat_max_ns);
+		}
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(edma_stats);
+
 void *tegra_pcie_edma_initialize(struct tegra_pcie_edma_init_info *info)
 {
 	struct edma_prv *prv;
@@ -567,6 +636,10 @@ void *tegra_pcie_edma_initialize(struct tegra_pcie_edma_init_info *info)
 
 	edma_hw_init(prv, false);
 	edma_hw_init(prv, true);
+
+	prv->debugfs = debugfs_create_dir(prv->irq_name, NULL);
+	debugfs_create_file("stats", 0444, prv->debugfs, prv, &edma_stats_fops);
+
 	dev_info(prv->dev, "%s: success", __func__);
 
 	return prv;
@@ -602,25 +675,29 @@ free_priv:
 }
 EXPORT_SYMBOL_GPL(tegra_pcie_edma_initialize);
 
-edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
-						struct tegra_pcie_edma_xfer_info *tx_info)
+edma_xfer_status_t tegra_pcie_edma_submit_xfer_batch(void *cookie,
+						      struct tegra_pcie_edma_xfer_info *tx_info,
+						      u32 num_xfer)
 {
 	struct edma_prv *prv = (struct edma_prv *)cookie;
 	struct edma_chan *ch;
 	struct edma_hw_desc *dma_ll_virt = NULL;
 	struct edma_dblock *db;
+	struct tegra_pcie_edma_xfer_info *xfer;
 	int i;
-	u64 total_sz = 0;
+	u32 n;
+	u64 total_sz = 0, nents = 0;
 	edma_xfer_status_t st = EDMA_XFER_SUCCESS;
-	u32 avail, to_ms;
-	struct tegra_pcie_edma_xfer_info *ring;
+	u32 avail, to_ms, depth;
+	struct edma_ring *ring;
 	u32 int_status_off[2] = {DMA_WRITE_INT_STATUS_OFF, DMA_READ_INT_STATUS_OFF};
 	u32 doorbell_off[2] = {DMA_WRITE_DOORBELL_OFF, DMA_READ_DOORBELL_OFF};
 	u32 mode_cnt[2] = {DMA_WR_CHNL_NUM, DMA_RD_CHNL_NUM};
-	bool pcs, final_pcs = false;
+	bool pcs, last, final_pcs = false;
+	ktime_t now;
 	long ret, to_jif;
 
-	if (!prv || !tx_info || tx_info->nents == 0 || !tx_info->desc ||
+	if (!prv || !tx_info || num_xfer == 0 ||
 	    (tx_info->type < EDMA_XFER_WRITE || tx_info->type > EDMA_XFER_READ) ||
 	    tx_info->channel_num >= mode_cnt[tx_info->type])
 		return EDMA_XFER_FAIL_INVAL_INPUTS;
@@ -631,8 +708,18 @@ edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
 	if (!ch->desc_sz)
 		return EDMA_XFER_FAIL_INVAL_INPUTS;
 
-	if ((tx_info->complete == NULL) && (ch->type == EDMA_CHAN_XFER_ASYNC))
-		return EDMA_XFER_FAIL_INVAL_INPUTS;
+	/* All xfers of a batch go on the same channel, one after the other */
+	for (n = 0; n < num_xfer; n++) {
+		xfer = &tx_info[n];
+		if (xfer->nents == 0 || !xfer->desc || xfer->type != tx_info->type ||
+		    xfer->channel_num != tx_info->channel_num)
+			return EDMA_XFER_FAIL_INVAL_INPUTS;
+
+		if ((xfer->complete == NULL) && (ch->type == EDMA_CHAN_XFER_ASYNC))
+			return EDMA_XFER_FAIL_INVAL_INPUTS;
+
+		nents += xfer->nents;
+	}
 
 	/* Get hold of the hardware - locking */
 	mutex_lock(&ch->lock);
@@ -646,55 +733,68 @@ edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
 	}
 
 	avail = (ch->r_idx - ch->w_idx - 1U) & (ch->desc_sz - 1U);
-	if (tx_info->nents > avail) {
-		dev_dbg(prv->dev, "Descriptors full. w_idx %d. r_idx %d, avail %d, req %d\n",
-			ch->w_idx, ch->r_idx, avail, tx_info->nents);
+	if (nents > avail) {
+		dev_dbg(prv->dev, "Descriptors full. w_idx %d. r_idx %d, avail %d, req %llu\n",
+			ch->w_idx, ch->r_idx, avail, nents);
 		st = EDMA_XFER_FAIL_NOMEM;
 		goto unlock;
 	}
 
-	dev_dbg(prv->dev, "xmit for %d nents at %d widx and %d ridx\n",
-		tx_info->nents, ch->w_idx, ch->r_idx);
+	dev_dbg(prv->dev, "xmit for %llu nents in %u xfers at %d widx and %d ridx\n",
+		nents, num_xfer, ch->w_idx, ch->r_idx);
+	now = ktime_get();
 	db = (struct edma_dblock *)ch->desc + (ch->w_idx/2);
-	for (i = 0; i < tx_info->nents; i++) {
-		dma_ll_virt = &db->desc[ch->db_pos];
-		dma_ll_virt->size = tx_info->desc[i].sz;
-		/* calculate number of packets and add those many headers */
-		total_sz +=  (u64)(((tx_info->desc[i].sz / ch->desc_sz) + 1) * 30ULL);
-		total_sz += tx_info->desc[i].sz;
-		dma_ll_virt->sar_low = lower_32_bits(tx_info->desc[i].src);
-		dma_ll_virt->sar_high = upper_32_bits(tx_info->desc[i].src);
-		dma_ll_virt->dar_low = lower_32_bits(tx_info->desc[i].dst);
-		dma_ll_virt->dar_high = upper_32_bits(tx_info->desc[i].dst);
-		/* Set LIE or RIE in last element */
-		if (i == tx_info->nents - 1) {
-			dma_ll_virt->ctrl_reg.ctrl_e.lie = 1;
-			dma_ll_virt->ctrl_reg.ctrl_e.rie = !!prv->is_remote_dma;
-			final_pcs = ch->pcs;
-		} else {
-			/* CB should be updated last in the descriptor */
-			dma_ll_virt->ctrl_reg.ctrl_e.cb = ch->pcs;
-		}
-		ch->db_pos = !ch->db_pos;
-		avail = ch->w_idx;
-		ch->w_idx++;
-		if (!ch->db_pos) {
-			ch->wcount = 0;
-			db->llp.ctrl_reg.ctrl_e.cb = ch->pcs;
-			if (ch->w_idx == ch->desc_sz) {
-				ch->pcs = !ch->pcs;
+	for (n = 0; n < num_xfer; n++) {
+		xfer = &tx_info[n];
+
+		/*
+		 * Completion slot is at the last descriptor of this xfer. Fill it
+		 * before the descriptors are handed to HW, an interrupt for an
+		 * earlier xfer may already walk past them.
+		 */
+		ring = &ch->ring[(ch->w_idx + xfer->nents - 1U) & (ch->desc_sz - 1U)];
+		ring->priv = xfer->priv;
+		ring->complete = xfer->complete;
+		ring->submit_ts = now;
+		if (n != num_xfer - 1)
+			wmb();
+
+		for (i = 0; i < xfer->nents; i++) {
+			last = (n == num_xfer - 1) && (i == xfer->nents - 1);
+			dma_ll_virt = &db->desc[ch->db_pos];
+			dma_ll_virt->size = xfer->desc[i].sz;
+			/* calculate number of packets and add those many headers */
+			total_sz +=  (u64)(((xfer->desc[i].sz / ch->desc_sz) + 1) * 30ULL);
+			total_sz += xfer->desc[i].sz;
+			dma_ll_virt->sar_low = lower_32_bits(xfer->desc[i].src);
+			dma_ll_virt->sar_high = upper_32_bits(xfer->desc[i].src);
+			dma_ll_virt->dar_low = lower_32_bits(xfer->desc[i].dst);
+			dma_ll_virt->dar_high = upper_32_bits(xfer->desc[i].dst);
+			/* Set LIE or RIE only in last element of the batch */
+			if (last) {
+				dma_ll_virt->ctrl_reg.ctrl_e.lie = 1;
+				dma_ll_virt->ctrl_reg.ctrl_e.rie = !!prv->is_remote_dma;
+				final_pcs = ch->pcs;
+			} else {
+				/* CB should be updated last in the descriptor */
+				dma_ll_virt->ctrl_reg.ctrl_e.cb = ch->pcs;
+			}
+			ch->db_pos = !ch->db_pos;
+			ch->w_idx++;
+			if (!ch->db_pos) {
+				ch->wcount = 0;
 				db->llp.ctrl_reg.ctrl_e.cb = ch->pcs;
-				dev_dbg(prv->dev, "Toggled pcs at w_idx %d\n", ch->w_idx);
-				ch->w_idx = 0;
+				if (ch->w_idx == ch->desc_sz) {
+					ch->pcs = !ch->pcs;
+					db->llp.ctrl_reg.ctrl_e.cb = ch->pcs;
+					dev_dbg(prv->dev, "Toggled pcs at w_idx %d\n", ch->w_idx);
+					ch->w_idx = 0;
+				}
+				db = (struct edma_dblock *)ch->desc + (ch->w_idx/2);
 			}
-			db = (struct edma_dblock *)ch->desc + (ch->w_idx/2);
 		}
 	}
 
-	ring = &ch->ring[avail];
-	ring->priv = tx_info->priv;
-	ring->complete = tx_info->complete;
-
 	/* Update CB post SW ring update to order callback and transfer updates */
 	dma_ll_virt->ctrl_reg.ctrl_e.cb = final_pcs;
 
@@ -717,6 +817,12 @@ edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
 
 	dma_common_wr(prv->edma_base, tx_info->channel_num, doorbell_off[tx_info->type]);
 
+	ch->stats.xfers += num_xfer;
+	ch->stats.doorbells++;
+	depth = (ch->w_idx - ch->r_idx) & (ch->desc_sz - 1U);
+	if (depth > ch->stats.depth_max)
+		ch->stats.depth_max = depth;
+
 	if (ch->type == EDMA_CHAN_XFER_SYNC) {
 		total_sz = GET_SYNC_TIMEOUT(total_sz);
 		to_ms = (total_sz > UINT_MAX) ? UINT_MAX : (u32)(total_sz & UINT_MAX);
@@ -736,8 +842,8 @@ edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
 		} else {
 			st = ch->st;
 		}
-		dev_dbg(prv->dev, "xmit done for %d nents at %d widx and %d ridx\n",
-			tx_info->nents, ch->w_idx, ch->r_idx);
+		dev_dbg(prv->dev, "xmit done for %llu nents at %d widx and %d ridx\n",
+			nents, ch->w_idx, ch->r_idx);
 	}
 unlock:
 	/* release hardware - unlocking */
@@ -745,6 +851,13 @@ unlock:
 
 	return st;
 }
+EXPORT_SYMBOL_GPL(tegra_pcie_edma_submit_xfer_batch);
+
+edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
+						struct tegra_pcie_edma_xfer_info *tx_info)
+{
+	return tegra_pcie_edma_submit_xfer_batch(cookie, tx_info, 1);
+}
 EXPORT_SYMBOL_GPL(tegra_pcie_edma_submit_xfer);
 
 static void edma_stop(struct edma_prv *prv, edma_xfer_status_t st)
@@ -810,6 +923,7 @@ void tegra_pcie_edma_deinit(void *cookie)
 
 	edma_stop(prv, EDMA_XFER_DEINIT);
 
+	debugfs_remove_recursive(prv->debugfs);
 	free_irq(prv->irq, prv);
 	kfree(prv->irq_name);
 
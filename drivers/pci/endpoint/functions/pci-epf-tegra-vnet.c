@@ -14,6 +14,9 @@
 #include <linux/workqueue.h>
 #include <linux/vmalloc.h>
 #include <linux/tegra_vnet.h>
+#if defined(NV_NET_GSO_H_PRESENT)
+#include <net/gso.h>
+#endif
 
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
 #include <linux/dma-fence.h>
@@ -30,6 +33,9 @@
 #endif
 
 #define BAR0_SIZE SZ_4M
+/* DMA write link list of one queue: descriptors plus link element */
+#define TVNET_EP_DMA_RING_SIZE \
+	((DMA_DESC_COUNT + 1) * sizeof(struct tvnet_dma_desc))
 #define APPL_INTR_EN_L1_8_0                     0x44
 #define APPL_INTR_EN_L1_8_EDMA_INT_EN           BIT(6)
 
@@ -96,6 +102,44 @@ struct irqsp_data {
 	struct work_struct reprime_work;
 #endif
 	struct device *dev;
+	int qid;
+};
+
+struct pci_epf_tvnet;
+
+/* Data queue pair: H2EP and EP2H data rings with own NAPI and syncpoint */
+struct tvnet_ep_queue {
+	struct pci_epf_tvnet *tvnet;
+	int qid;
+	struct napi_struct napi;
+	struct irqsp_data *data_irqsp;
+	struct list_head h2ep_empty_list;
+	/* To protect h2ep empty list */
+	spinlock_t h2ep_empty_lock;
+
+	/* Endpoint written message buffers */
+	struct data_msg *ep2h_full_msgs;
+	struct data_msg *h2ep_empty_msgs;
+	/* Host written message buffers */
+	struct data_msg *ep2h_empty_msgs;
+	struct data_msg *h2ep_full_msgs;
+
+	struct tvnet_counter h2ep_empty;
+	struct tvnet_counter h2ep_full;
+	struct tvnet_counter ep2h_empty;
+	struct tvnet_counter ep2h_full;
+
+#if ENABLE_DMA
+	/* DMA write channel and its slice of link list elements */
+	struct dma_desc_cnt desc_cnt;
+	struct tvnet_dma_desc *ep_dma_virt;
+	dma_addr_t ep_dma_iova;
+#endif
+	/* Net Tx queues are folded on active rings, to protect Tx ring */
+	spinlock_t tx_lock;
+	struct tvnet_tx_pkt *tx_pkts;
+	u32 tx_pending;
+	u32 tx_pending_descs;
 };
 
 struct pci_epf_tvnet {
@@ -107,7 +151,6 @@ struct pci_epf_tvnet {
 	struct bar_md *bar_md;
 	dma_addr_t bar0_iova;
 	struct net_device *ndev;
-	struct napi_struct napi;
 	bool pcie_link_status;
 	struct ep_ring_buf ep_ring_buf;
 	struct host_ring_buf host_ring_buf;
@@ -117,12 +160,10 @@ struct pci_epf_tvnet {
 	/* To synchronize network link state machine*/
 	struct mutex link_state_lock;
 	wait_queue_head_t link_state_wq;
-	struct list_head h2ep_empty_list;
-#if ENABLE_DMA
-	struct dma_desc_cnt desc_cnt;
-#endif
-	/* To protect h2ep empty list */
-	spinlock_t h2ep_empty_lock;
+	struct tvnet_ep_queue queues[TVNET_MAX_QUEUES];
+	int num_queues;
+	/* Queue pairs serviced by host, set on host LINK_UP */
+	int active_queues;
 	dma_addr_t rx_buf_iova;
 	unsigned long *rx_buf_bitmap;
 	int rx_num_pages;
@@ -131,15 +172,12 @@ struct pci_epf_tvnet {
 	void *ep_dma_virt;
 	dma_addr_t ep_dma_iova;
 	struct irqsp_data *ctrl_irqsp;
-	struct irqsp_data *data_irqsp;
 	struct work_struct raise_irq_work;
+	/* Queues with EP2H full msgs not yet notified to host */
+	unsigned long raise_irq_pending;
 
 	struct tvnet_counter h2ep_ctrl;
 	struct tvnet_counter ep2h_ctrl;
-	struct tvnet_counter h2ep_empty;
-	struct tvnet_counter h2ep_full;
-	struct tvnet_counter ep2h_empty;
-	struct tvnet_counter ep2h_full;
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
 	/* DRV_MODE specific.*/
 	struct pci_epc *epc;
@@ -162,20 +200,44 @@ static void tvnet_ep_raise_irq_work_function(struct work_struct *work)
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
 	struct pci_epf *epf = tvnet->epf;
 #endif
+	int i;
 
+	/* Vector 0 is ctrl irq, vector 1 + N is data irq of queue N */
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
 #if defined(PCI_EPC_IRQ_TYPE_ENUM_PRESENT) /* Dropped from Linux 6.8 */
 	lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 0);
-	lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 1);
 #else
 	lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 0);
-	lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 1);
 #endif
 #else
 	pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
-	pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1);
 #endif
 
+	/*
+	 * Host grants one data vector per queue it services and publishes
+	 * that count, never raise a vector beyond it.
+	 */
+	for (i = 0; i < tvnet->num_queues; i++) {
+		if (!test_and_clear_bit(i, &tvnet->raise_irq_pending) ||
+		    i >= tvnet->active_queues)
+			continue;
+#if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
+#if defined(PCI_EPC_IRQ_TYPE_ENUM_PRESENT) /* Dropped from Linux 6.8 */
+		lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 1 + i);
+#else
+		lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 1 + i);
+#endif
+#else
+		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1 + i);
+#endif
+	}
+}
+
+static void tvnet_ep_raise_data_irq(struct pci_epf_tvnet *tvnet,
+				    struct tvnet_ep_queue *q)
+{
+	set_bit(q->qid, &tvnet->raise_irq_pending);
+	schedule_work(&tvnet->raise_irq_work);
 }
 
 static void tvnet_ep_read_ctrl_msg(struct pci_epf_tvnet *tvnet,
@@ -265,16 +327,17 @@ static void tvnet_ep_iova_dealloc(struct pci_epf_tvnet *tvnet, dma_addr_t iova)
 }
 #endif
 
-static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet)
+static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet,
+					 struct tvnet_ep_queue *q)
 {
-	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
 	struct pci_epc *epc = tvnet->epf->epc;
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
 	struct pci_epf *epf = tvnet->epf;
 #endif
 	struct device *cdev = epc->dev.parent;
-	struct data_msg *h2ep_empty_msg = ep_ring_buf->h2ep_empty_msgs;
+	struct data_msg *h2ep_empty_msg = q->h2ep_empty_msgs;
 	struct h2ep_empty_list *h2ep_empty_ptr;
+	bool posted = false;
 #if ENABLE_DMA
 	struct net_device *ndev = tvnet->ndev;
 #else
@@ -282,7 +345,7 @@ static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet)
 	int ret = 0;
 #endif
 
-	while (!tvnet_ivc_full(&tvnet->h2ep_empty)) {
+	while (!tvnet_ivc_full(&q->h2ep_empty)) {
 		dma_addr_t iova;
 #if ENABLE_DMA
 		struct sk_buff *skb;
@@ -375,25 +438,39 @@ static void tvnet_ep_alloc_empty_buffers(struct pci_epf_tvnet *tvnet)
 		h2ep_empty_ptr->size = PAGE_SIZE;
 #endif
 		h2ep_empty_ptr->iova = iova;
-		spin_lock_irqsave(&tvnet->h2ep_empty_lock, flags);
-		list_add_tail(&h2ep_empty_ptr->list, &tvnet->h2ep_empty_list);
-		spin_unlock_irqrestore(&tvnet->h2ep_empty_lock, flags);
+		spin_lock_irqsave(&q->h2ep_empty_lock, flags);
+		list_add_tail(&h2ep_empty_ptr->list, &q->h2ep_empty_list);
+		spin_unlock_irqrestore(&q->h2ep_empty_lock, flags);
 
-		idx = tvnet_ivc_get_wr_cnt(&tvnet->h2ep_empty) % RING_COUNT;
+		idx = tvnet_ivc_get_wr_cnt(&q->h2ep_empty) % RING_COUNT;
 		h2ep_empty_msg[idx].u.empty_buffer.pcie_address = iova;
-		h2ep_empty_msg[idx].u.empty_buffer.buffer_len = PAGE_SIZE;
-		tvnet_ivc_advance_wr(&tvnet->h2ep_empty);
+		/* Host uses buffer_len to decide whether to segment GSO skb */
+		h2ep_empty_msg[idx].u.empty_buffer.buffer_len =
+						h2ep_empty_ptr->size;
+		tvnet_ivc_advance_wr(&q->h2ep_empty);
+		posted = true;
+	}
 
+	/* One interrupt for the whole refill */
+	if (!posted)
+		return;
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
 #if defined(PCI_EPC_IRQ_TYPE_ENUM_PRESENT) /* Dropped from Linux 6.8 */
-		lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 0);
+	lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 0);
 #else
-		lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 0);
+	lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 0);
 #endif
 #else
-		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
+	pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
 #endif
-	}
+}
+
+static void tvnet_ep_alloc_all_empty_buffers(struct pci_epf_tvnet *tvnet)
+{
+	int i;
+
+	for (i = 0; i < tvnet->active_queues; i++)
+		tvnet_ep_alloc_empty_buffers(tvnet, &tvnet->queues[i]);
 }
 
 static void tvnet_ep_free_empty_buffers(struct pci_epf_tvnet *tvnet)
@@ -405,32 +482,38 @@ static void tvnet_ep_free_empty_buffers(struct pci_epf_tvnet *tvnet)
 	struct iommu_domain *domain = iommu_get_domain_for_dev(cdev);
 #endif
 	struct h2ep_empty_list *h2ep_empty_ptr, *temp;
+	struct tvnet_ep_queue *q;
 	unsigned long flags;
-
-	spin_lock_irqsave(&tvnet->h2ep_empty_lock, flags);
-	list_for_each_entry_safe(h2ep_empty_ptr, temp, &tvnet->h2ep_empty_list,
-				 list) {
-		list_del(&h2ep_empty_ptr->list);
+	int i;
+
+	for (i = 0; i < tvnet->num_queues; i++) {
+		q = &tvnet->queues[i];
+		spin_lock_irqsave(&q->h2ep_empty_lock, flags);
+		list_for_each_entry_safe(h2ep_empty_ptr, temp,
+					 &q->h2ep_empty_list, list) {
+			list_del(&h2ep_empty_ptr->list);
 #if ENABLE_DMA
-		dma_unmap_single(cdev, h2ep_empty_ptr->iova,
-				 h2ep_empty_ptr->size, DMA_FROM_DEVICE);
-		dev_kfree_skb_any(h2ep_empty_ptr->skb);
+			dma_unmap_single(cdev, h2ep_empty_ptr->iova,
+					 h2ep_empty_ptr->size,
+					 DMA_FROM_DEVICE);
+			dev_kfree_skb_any(h2ep_empty_ptr->skb);
 #else
-		vunmap(h2ep_empty_ptr->virt);
-		iommu_unmap(domain, h2ep_empty_ptr->iova, PAGE_SIZE);
-		__free_pages(h2ep_empty_ptr->page, 1);
-		tvnet_ep_iova_dealloc(tvnet, h2ep_empty_ptr->iova);
+			vunmap(h2ep_empty_ptr->virt);
+			iommu_unmap(domain, h2ep_empty_ptr->iova, PAGE_SIZE);
+			__free_pages(h2ep_empty_ptr->page, 1);
+			tvnet_ep_iova_dealloc(tvnet, h2ep_empty_ptr->iova);
 #endif
-		kfree(h2ep_empty_ptr);
+			kfree(h2ep_empty_ptr);
+		}
+		spin_unlock_irqrestore(&q->h2ep_empty_lock, flags);
 	}
-	spin_unlock_irqrestore(&tvnet->h2ep_empty_lock, flags);
 }
 
 static void tvnet_ep_stop_tx_queue(struct pci_epf_tvnet *tvnet)
 {
 	struct net_device *ndev = tvnet->ndev;
 
-	netif_stop_queue(ndev);
+	netif_tx_stop_all_queues(ndev);
 	/* Get tx lock to make sure that there is no ongoing xmit */
 	netif_tx_lock(ndev);
 	netif_tx_unlock(ndev);
@@ -447,22 +530,25 @@ static void tvnet_ep_clear_data_msg_counters(struct pci_epf_tvnet *tvnet)
 	struct host_own_cnt *host_cnt = host_ring_buf->host_cnt;
 	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
 	struct ep_own_cnt *ep_cnt = ep_ring_buf->ep_cnt;
+	int i;
 
-	host_cnt->h2ep_empty_rd_cnt = 0;
-	ep_cnt->h2ep_empty_wr_cnt = 0;
-	ep_cnt->ep2h_full_wr_cnt = 0;
-	host_cnt->ep2h_full_rd_cnt = 0;
+	for (i = 0; i < tvnet->num_queues; i++) {
+		host_cnt->data[i].h2ep_empty_rd_cnt = 0;
+		ep_cnt->data[i].h2ep_empty_wr_cnt = 0;
+		ep_cnt->data[i].ep2h_full_wr_cnt = 0;
+		host_cnt->data[i].ep2h_full_rd_cnt = 0;
+	}
 }
 
 static void tvnet_ep_update_link_state(struct net_device *ndev,
 				    enum os_link_state state)
 {
 	if (state == OS_LINK_STATE_UP) {
-		netif_start_queue(ndev);
+		netif_tx_start_all_queues(ndev);
 		netif_carrier_on(ndev);
 	} else if (state == OS_LINK_STATE_DOWN) {
 		netif_carrier_off(ndev);
-		netif_stop_queue(ndev);
+		netif_tx_stop_all_queues(ndev);
 	} else {
 		pr_err("%s: invalid sate: %d\n", __func__, state);
 	}
@@ -490,7 +576,7 @@ static void tvnet_ep_user_link_up_req(struct pci_epf_tvnet *tvnet)
 	struct ctrl_msg msg;
 
 	tvnet_ep_clear_data_msg_counters(tvnet);
-	tvnet_ep_alloc_empty_buffers(tvnet);
+	tvnet_ep_alloc_all_empty_buffers(tvnet);
 	msg.msg_id = CTRL_MSG_LINK_UP;
 	tvnet_ep_write_ctrl_msg(tvnet, &msg);
 	tvnet->rx_link_state = DIR_LINK_STATE_UP;
@@ -509,6 +595,11 @@ static void tvnet_ep_user_link_down_req(struct pci_epf_tvnet *tvnet)
 
 static void tvnet_ep_rcv_link_up_msg(struct pci_epf_tvnet *tvnet)
 {
+	/* Host publishes serviced queue pairs before sending LINK_UP */
+	tvnet->active_queues = clamp_t(u32, tvnet->bar_md->host_num_queues, 1,
+				       tvnet->num_queues);
+	if (tvnet->rx_link_state == DIR_LINK_STATE_UP)
+		tvnet_ep_alloc_all_empty_buffers(tvnet);
 	tvnet->tx_link_state = DIR_LINK_STATE_UP;
 	tvnet_ep_update_link_sm(tvnet);
 }
@@ -539,6 +630,7 @@ static int tvnet_ep_open(struct net_device *ndev)
 {
 	struct device *fdev = ndev->dev.parent;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
+	int i;
 
 	if (!tvnet->pcie_link_status) {
 		dev_err(fdev, "%s: PCIe link is not up\n", __func__);
@@ -548,7 +640,8 @@ static int tvnet_ep_open(struct net_device *ndev)
 	mutex_lock(&tvnet->link_state_lock);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_DOWN)
 		tvnet_ep_user_link_up_req(tvnet);
-	napi_enable(&tvnet->napi);
+	for (i = 0; i < tvnet->num_queues; i++)
+		napi_enable(&tvnet->queues[i].napi);
 	mutex_unlock(&tvnet->link_state_lock);
 
 	return 0;
@@ -559,9 +652,11 @@ static int tvnet_ep_close(struct net_device *ndev)
 	struct device *fdev = ndev->dev.parent;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
 	int ret = 0;
+	int i;
 
 	mutex_lock(&tvnet->link_state_lock);
-	napi_disable(&tvnet->napi);
+	for (i = 0; i < tvnet->num_queues; i++)
+		napi_disable(&tvnet->queues[i].napi);
 	if (tvnet->rx_link_state == DIR_LINK_STATE_UP)
 		tvnet_ep_user_link_down_req(tvnet);
 
@@ -605,202 +700,377 @@ static int tvnet_ep_change_mtu(struct net_device *ndev, int new_mtu)
 	return 0;
 }
 
-static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
-				    struct net_device *ndev)
+static void tvnet_ep_tx_unmap(struct pci_epf_tvnet *tvnet,
+			      struct tvnet_tx_pkt *pkt)
 {
-	struct device *fdev = ndev->dev.parent;
-	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
-	struct host_ring_buf *host_ring_buf = &tvnet->host_ring_buf;
-	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
-	struct data_msg *ep2h_full_msg = ep_ring_buf->ep2h_full_msgs;
-	struct skb_shared_info *info = skb_shinfo(skb);
-	struct data_msg *ep2h_empty_msg = host_ring_buf->ep2h_empty_msgs;
-	struct pci_epf *epf = tvnet->epf;
-	struct pci_epc *epc = epf->epc;
-	struct device *cdev = epc->dev.parent;
+	struct device *cdev = tvnet->epf->epc->dev.parent;
+	u32 i;
+
+	for (i = 0; i < pkt->nr_maps; i++) {
+		if (pkt->map[i].page)
+			dma_unmap_page(cdev, pkt->map[i].iova, pkt->map[i].len,
+				       DMA_TO_DEVICE);
+		else
+			dma_unmap_single(cdev, pkt->map[i].iova,
+					 pkt->map[i].len, DMA_TO_DEVICE);
+	}
+	pkt->nr_maps = 0;
+}
+
 #if ENABLE_DMA
-	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
-	struct tvnet_dma_desc *ep_dma_virt =
-				(struct tvnet_dma_desc *)tvnet->ep_dma_virt;
-	u32 desc_widx, desc_ridx, val, ctrl_d;
+/*
+ * Chain DMA descriptors of all pending packets on the queue's write channel,
+ * each skb fragment is copied to its offset in the host buffer. Doorbell is
+ * rung once and only the last descriptor raises the done interrupt.
+ */
+static int tvnet_ep_tx_dma(struct pci_epf_tvnet *tvnet,
+			   struct tvnet_ep_queue *q)
+{
+	struct dma_desc_cnt *desc_cnt = &q->desc_cnt;
+	struct tvnet_dma_desc *ep_dma_virt = q->ep_dma_virt;
+	u32 ch = DMA_WR_DATA_CH + q->qid;
+	u32 desc_widx, desc_start, val, ctrl_d, i, j, n = 0;
 	unsigned long timeout;
+	int ret = 0;
+
+	desc_start = desc_cnt->wr_cnt;
+	for (i = 0; i < q->tx_pending; i++) {
+		struct tvnet_tx_pkt *pkt = &q->tx_pkts[i];
+		u64 dst_iova = pkt->dst_iova;
+
+		for (j = 0; j < pkt->nr_maps; j++) {
+			desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
+			ep_dma_virt[desc_widx].size = pkt->map[j].len;
+			ep_dma_virt[desc_widx].sar_low =
+					lower_32_bits(pkt->map[j].iova);
+			ep_dma_virt[desc_widx].sar_high =
+					upper_32_bits(pkt->map[j].iova);
+			ep_dma_virt[desc_widx].dar_low =
+					lower_32_bits(dst_iova);
+			ep_dma_virt[desc_widx].dar_high =
+					upper_32_bits(dst_iova);
+			dst_iova += pkt->map[j].len;
+			/* CB bit should be set at the end */
+			mb();
+			ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_CB;
+			if (++n == q->tx_pending_descs)
+				ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_LIE;
+			ep_dma_virt[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+			desc_cnt->wr_cnt++;
+		}
+	}
+
+	/* DMA write should not go out of order wrt CB bit set */
+	mb();
+
+	timeout = jiffies + msecs_to_jiffies(1000);
+	dma_common_wr8(tvnet->dma_base, ch, DMA_WRITE_DOORBELL_OFF);
+
+	while (true) {
+		val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_STATUS_OFF);
+		if (val & BIT(ch)) {
+			dma_common_wr(tvnet->dma_base, BIT(ch),
+				      DMA_WRITE_INT_CLEAR_OFF);
+			break;
+		}
+		if (time_after(jiffies, timeout)) {
+			dev_err(tvnet->fdev, "dma took more time, reset dma engine\n");
+			dma_common_wr(tvnet->dma_base,
+				      DMA_WRITE_ENGINE_EN_OFF_DISABLE,
+				      DMA_WRITE_ENGINE_EN_OFF);
+			mdelay(1);
+			dma_common_wr(tvnet->dma_base,
+				      DMA_WRITE_ENGINE_EN_OFF_ENABLE,
+				      DMA_WRITE_ENGINE_EN_OFF);
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	/* Clear DMA cycle bit of the whole chain */
+	for (i = desc_start; i != desc_cnt->wr_cnt; i++)
+		ep_dma_virt[i % DMA_DESC_COUNT].ctrl_reg.ctrl_e.cb = 0;
+	mb();
+
+	if (ret < 0)
+		desc_cnt->wr_cnt = desc_start;
+	desc_cnt->rd_cnt = desc_cnt->wr_cnt;
+
+	return ret;
+}
 #else
+static int tvnet_ep_tx_copy(struct pci_epf_tvnet *tvnet,
+			    struct tvnet_ep_queue *q)
+{
+	struct pci_epf *epf = tvnet->epf;
+	struct pci_epc *epc = epf->epc;
+	u64 dst_masked, dst_off;
+	struct tvnet_tx_pkt *pkt;
 	int ret;
-#endif
-	dma_addr_t src_iova;
-	u32 rd_idx, wr_idx;
-	u64 dst_masked, dst_off, dst_iova;
-	int dst_len, len;
-
-	/*TODO Not expecting skb frags, remove this after testing */
-	WARN_ON(info->nr_frags);
+	u32 i;
 
-	/* Check if EP2H_EMPTY_BUF available to read */
-	if (!tvnet_ivc_rd_available(&tvnet->ep2h_empty)) {
+	for (i = 0; i < q->tx_pending; i++) {
+		pkt = &q->tx_pkts[i];
+		/*
+		 * Map host dst mem to local PCIe address range.
+		 * PCIe address range is SZ_64K aligned.
+		 */
+		dst_masked = (pkt->dst_iova & ~(SZ_64K - 1));
+		dst_off = (pkt->dst_iova & (SZ_64K - 1));
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
-#if defined(PCI_EPC_IRQ_TYPE_ENUM_PRESENT) /* Dropped from Linux 6.8 */
-		lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 0);
-#else
-		lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 0);
-#endif
+		ret = lpci_epc_map_addr(epc, epf->func_no,
+					tvnet->tx_dst_pci_addr, dst_masked,
+					pkt->skb->len);
 #else
-		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 0);
+		ret = pci_epc_map_addr(epc, tvnet->tx_dst_pci_addr, dst_masked,
+				       pkt->skb->len);
 #endif
-		dev_dbg(fdev, "%s: No EP2H empty msg, stop tx\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
+		if (ret < 0) {
+			dev_err(tvnet->fdev,
+				"failed to map dst addr to PCIe addr range\n");
+			return ret;
+		}
 
-	/* Check if EP2H_FULL_BUF available to write */
-	if (tvnet_ivc_full(&tvnet->ep2h_full)) {
+		/* Copy skb to host dst address, use CPU virt addr */
+		skb_copy_bits(pkt->skb, 0,
+			      (__force void *)(tvnet->tx_dst_va + dst_off),
+			      pkt->skb->len);
+		/*
+		 * tx_dst_va is ioremap_wc() mem, add mb to make sure complete
+		 * skb data written to dst before adding it to full buffer
+		 */
+		mb();
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
-#if defined(PCI_EPC_IRQ_TYPE_ENUM_PRESENT) /* Dropped from Linux 6.8 */
-		lpci_epc_raise_irq(epc, epf->func_no, PCI_EPC_IRQ_MSIX, 1);
-#else
-		lpci_epc_raise_irq(epc, epf->func_no, PCI_IRQ_MSIX, 1);
-#endif
+		lpci_epc_unmap_addr(epc, epf->func_no, tvnet->tx_dst_pci_addr);
 #else
-		pci_epc_raise_irq(epc, PCI_EPC_IRQ_MSIX, 1);
+		pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
 #endif
-		dev_dbg(fdev, "%s: No EP2H full buf, stop tx\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
 	}
 
+	return 0;
+}
+#endif
+
+/* Copy pending packets to host and hand them over with one interrupt */
+static void tvnet_ep_tx_flush(struct pci_epf_tvnet *tvnet,
+			      struct tvnet_ep_queue *q)
+{
+	struct data_msg *ep2h_full_msg = q->ep2h_full_msgs;
+	struct net_device *ndev = tvnet->ndev;
+	struct tvnet_tx_pkt *pkt;
+	u32 wr_idx, i;
+	int ret;
+
+	if (!q->tx_pending)
+		return;
+
 #if ENABLE_DMA
-	/* Check if dma desc available */
-	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) >= DMA_DESC_COUNT) {
-		dev_dbg(fdev, "%s: dma descs are not available\n", __func__);
-		netif_stop_queue(ndev);
-		return NETDEV_TX_BUSY;
-	}
+	ret = tvnet_ep_tx_dma(tvnet, q);
+#else
+	ret = tvnet_ep_tx_copy(tvnet, q);
 #endif
 
-	len = skb_headlen(skb);
+	for (i = 0; i < q->tx_pending; i++) {
+		pkt = &q->tx_pkts[i];
+		tvnet_ep_tx_unmap(tvnet, pkt);
 
-	src_iova = dma_map_single(cdev, skb->data, len, DMA_TO_DEVICE);
-	if (dma_mapping_error(cdev, src_iova)) {
-		dev_err(fdev, "%s: dma_map_single failed\n", __func__);
-		dev_kfree_skb_any(skb);
-		return NETDEV_TX_OK;
+		if (ret < 0) {
+			ndev->stats.tx_errors++;
+		} else {
+			/* Push dst to EP2H full ring */
+			wr_idx = tvnet_ivc_get_wr_cnt(&q->ep2h_full) %
+						RING_COUNT;
+			ep2h_full_msg[wr_idx].u.full_buffer.packet_size =
+						pkt->skb->len;
+			ep2h_full_msg[wr_idx].u.full_buffer.pcie_address =
+						pkt->dst_iova;
+			tvnet_skb_to_full_msg(pkt->skb,
+					      &ep2h_full_msg[wr_idx]);
+			tvnet_ivc_advance_wr(&q->ep2h_full);
+			ndev->stats.tx_packets++;
+			ndev->stats.tx_bytes += pkt->skb->len;
+		}
+
+		netdev_tx_completed_queue(pkt->txq, 1, pkt->skb->len);
+		dev_consume_skb_any(pkt->skb);
+		pkt->skb = NULL;
 	}
 
-	/* Get EP2H empty msg */
-	rd_idx = tvnet_ivc_get_rd_cnt(&tvnet->ep2h_empty) % RING_COUNT;
-	dst_iova = ep2h_empty_msg[rd_idx].u.empty_buffer.pcie_address;
-	dst_len = ep2h_empty_msg[rd_idx].u.empty_buffer.buffer_len;
+	if (ret == 0)
+		tvnet_ep_raise_data_irq(tvnet, q);
 
-	/*
-	 * Map host dst mem to local PCIe address range.
-	 * PCIe address range is SZ_64K aligned.
-	 */
-	dst_masked = (dst_iova & ~(SZ_64K - 1));
-	dst_off = (dst_iova & (SZ_64K - 1));
+	q->tx_pending = 0;
+	q->tx_pending_descs = 0;
+}
 
-#if !ENABLE_DMA
-#if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
-	ret = lpci_epc_map_addr(epc, epf->func_no, tvnet->tx_dst_pci_addr,
-			       dst_masked, dst_len);
-#else
-	ret = pci_epc_map_addr(epc, tvnet->tx_dst_pci_addr, dst_masked,
-			       dst_len);
-#endif
-	if (ret < 0) {
-		dev_err(fdev, "failed to map dst addr to PCIe addr range\n");
-		dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
-		dev_kfree_skb_any(skb);
-		return NETDEV_TX_OK;
+static bool tvnet_ep_tx_avail(struct tvnet_ep_queue *q, u32 count)
+{
+	/* Full messages of pending packets are not pushed yet */
+	return tvnet_ivc_rd_available(&q->ep2h_empty) >= count &&
+	       tvnet_ivc_wr_available(&q->ep2h_full) >= q->tx_pending + count;
+}
+
+/* Map skb and reserve a host empty buffer for it, doorbell comes at flush */
+static void tvnet_ep_tx_queue_skb(struct pci_epf_tvnet *tvnet,
+				  struct tvnet_ep_queue *q,
+				  struct netdev_queue *txq,
+				  struct sk_buff *skb)
+{
+	struct skb_shared_info *info = skb_shinfo(skb);
+	struct data_msg *ep2h_empty_msg = q->ep2h_empty_msgs;
+	struct device *cdev = tvnet->epf->epc->dev.parent;
+	struct tvnet_tx_pkt *pkt;
+	u32 nr_descs = info->nr_frags + 1;
+	u32 rd_idx, len, i;
+	dma_addr_t iova;
+
+	if (q->tx_pending == TVNET_TX_BATCH ||
+	    q->tx_pending_descs + nr_descs > DMA_DESC_COUNT)
+		tvnet_ep_tx_flush(tvnet, q);
+
+	pkt = &q->tx_pkts[q->tx_pending];
+	pkt->nr_maps = 0;
+
+	len = skb_headlen(skb);
+	if (len) {
+		iova = dma_map_single(cdev, skb->data, len, DMA_TO_DEVICE);
+		if (dma_mapping_error(cdev, iova)) {
+			dev_err(tvnet->fdev, "%s: dma_map_single failed\n",
+				__func__);
+			goto drop;
+		}
+		pkt->map[pkt->nr_maps].iova = iova;
+		pkt->map[pkt->nr_maps].len = len;
+		pkt->map[pkt->nr_maps].page = false;
+		pkt->nr_maps++;
 	}
-#endif
+
+	for (i = 0; i < info->nr_frags; i++) {
+		skb_frag_t *frag = &info->frags[i];
+
+		len = skb_frag_size(frag);
+		iova = skb_frag_dma_map(cdev, frag, 0, len, DMA_TO_DEVICE);
+		if (dma_mapping_error(cdev, iova)) {
+			dev_err(tvnet->fdev, "%s: skb_frag_dma_map failed\n",
+				__func__);
+			goto drop;
+		}
+		pkt->map[pkt->nr_maps].iova = iova;
+		pkt->map[pkt->nr_maps].len = len;
+		pkt->map[pkt->nr_maps].page = true;
+		pkt->nr_maps++;
+	}
+
+	/* Get EP2H empty msg */
+	rd_idx = tvnet_ivc_get_rd_cnt(&q->ep2h_empty) % RING_COUNT;
+	pkt->dst_iova = ep2h_empty_msg[rd_idx].u.empty_buffer.pcie_address;
 	/*
 	 * Advance read count after all failure cases completed, to avoid
 	 * dangling buffer at host.
 	 */
-	tvnet_ivc_advance_rd(&tvnet->ep2h_empty);
+	tvnet_ivc_advance_rd(&q->ep2h_empty);
 
-#if ENABLE_DMA
-	/* Trigger DMA write from src_iova to dst_iova */
-	desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
-	ep_dma_virt[desc_widx].size = len;
-	ep_dma_virt[desc_widx].sar_low = lower_32_bits(src_iova);
-	ep_dma_virt[desc_widx].sar_high = upper_32_bits(src_iova);
-	ep_dma_virt[desc_widx].dar_low = lower_32_bits(dst_iova);
-	ep_dma_virt[desc_widx].dar_high = upper_32_bits(dst_iova);
-	/* CB bit should be set at the end */
-	mb();
-	ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_LIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_CB;
-	ep_dma_virt[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+	pkt->skb = skb;
+	pkt->txq = txq;
+	netdev_tx_sent_queue(txq, skb->len);
+	q->tx_pending++;
+	q->tx_pending_descs += pkt->nr_maps;
 
-	/* DMA write should not go out of order wrt CB bit set */
-	mb();
+	return;
 
-	timeout = jiffies + msecs_to_jiffies(1000);
-	dma_common_wr8(tvnet->dma_base, DMA_WR_DATA_CH, DMA_WRITE_DOORBELL_OFF);
-	desc_cnt->wr_cnt++;
+drop:
+	tvnet_ep_tx_unmap(tvnet, pkt);
+	tvnet->ndev->stats.tx_dropped++;
+	dev_kfree_skb_any(skb);
+}
 
-	while (true) {
-		val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_STATUS_OFF);
-		if (val == BIT(DMA_WR_DATA_CH)) {
-			dma_common_wr(tvnet->dma_base, val,
-				      DMA_WRITE_INT_CLEAR_OFF);
-			break;
-		}
-		if (time_after(jiffies, timeout)) {
-			dev_err(fdev, "dma took more time, reset dma engine\n");
-			dma_common_wr(tvnet->dma_base,
-				      DMA_WRITE_ENGINE_EN_OFF_DISABLE,
-				      DMA_WRITE_ENGINE_EN_OFF);
-			mdelay(1);
-			dma_common_wr(tvnet->dma_base,
-				      DMA_WRITE_ENGINE_EN_OFF_ENABLE,
-				      DMA_WRITE_ENGINE_EN_OFF);
-			desc_cnt->wr_cnt--;
-#if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
-			lpci_epc_unmap_addr(epc, epf->func_no, tvnet->tx_dst_pci_addr);
-#else
-			pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
-#endif
-			dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
-			return NETDEV_TX_BUSY;
+/* TSO frame larger than host buffer, segment it in software */
+static void tvnet_ep_tx_gso(struct pci_epf_tvnet *tvnet,
+			    struct tvnet_ep_queue *q,
+			    struct netdev_queue *txq, struct sk_buff *skb)
+{
+	struct net_device *ndev = tvnet->ndev;
+	struct sk_buff *segs, *next;
+
+	segs = skb_gso_segment(skb, ndev->features & ~NETIF_F_GSO_MASK);
+	if (IS_ERR_OR_NULL(segs)) {
+		ndev->stats.tx_dropped++;
+		dev_kfree_skb_any(skb);
+		return;
+	}
+	dev_consume_skb_any(skb);
+
+	for (; segs; segs = next) {
+		next = segs->next;
+		segs->next = NULL;
+
+		/* Space for gso_segs segments is checked by the caller */
+		if (unlikely(!tvnet_ep_tx_avail(q, 1))) {
+			ndev->stats.tx_dropped++;
+			dev_kfree_skb_any(segs);
+			continue;
 		}
+
+		tvnet_ep_tx_queue_skb(tvnet, q, txq, segs);
 	}
+}
 
-	desc_ridx = tvnet->desc_cnt.rd_cnt % DMA_DESC_COUNT;
-	/* Clear DMA cycle bit and increment rd_cnt */
-	ep_dma_virt[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
-	mb();
+static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
+				    struct net_device *ndev)
+{
+	struct device *fdev = ndev->dev.parent;
+	struct pci_epf_tvnet *tvnet = dev_get_drvdata(fdev);
+	u16 qid = skb_get_queue_mapping(skb);
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, qid);
+	struct tvnet_ep_queue *q = &tvnet->queues[qid % tvnet->active_queues];
+	struct data_msg *ep2h_empty_msg = q->ep2h_empty_msgs;
+	bool more = tvnet_xmit_more(skb);
+	u32 rd_idx, dst_len, nr_segs;
 
-	tvnet->desc_cnt.rd_cnt++;
-#else
-	/* Copy skb->data to host dst address, use CPU virt addr */
-	memcpy((void *)(tvnet->tx_dst_va + dst_off), skb->data, len);
-	/*
-	 * tx_dst_va is ioremap_wc() mem, add mb to make sure complete skb->data
-	 * written to dst before adding it to full buffer
+	spin_lock(&q->tx_lock);
+
+	/* Check if EP2H_EMPTY_BUF available to read and EP2H_FULL_BUF
+	 * available to write.
 	 */
-	mb();
-#endif
+	if (!tvnet_ep_tx_avail(q, 1))
+		goto busy;
 
-	/* Push dst to EP2H full ring */
-	wr_idx = tvnet_ivc_get_wr_cnt(&tvnet->ep2h_full) % RING_COUNT;
-	ep2h_full_msg[wr_idx].u.full_buffer.packet_size = len;
-	ep2h_full_msg[wr_idx].u.full_buffer.pcie_address = dst_iova;
-	tvnet_ivc_advance_wr(&tvnet->ep2h_full);
+	rd_idx = tvnet_ivc_get_rd_cnt(&q->ep2h_empty) % RING_COUNT;
+	dst_len = ep2h_empty_msg[rd_idx].u.empty_buffer.buffer_len;
 
-	/* Free temp src and skb */
-#if !ENABLE_DMA
-#if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
-	lpci_epc_unmap_addr(epc, epf->func_no, tvnet->tx_dst_pci_addr);
-#else
-	pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
-#endif
-#endif
-	dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
-	dev_kfree_skb_any(skb);
-	schedule_work(&tvnet->raise_irq_work);
+	if (likely(skb->len <= dst_len)) {
+		tvnet_ep_tx_queue_skb(tvnet, q, txq, skb);
+	} else if (skb_is_gso(skb) &&
+		   skb_shinfo(skb)->gso_segs <= RING_COUNT) {
+		/* All segments must fit, or the skb is requeued as a whole */
+		nr_segs = skb_shinfo(skb)->gso_segs;
+		if (!tvnet_ep_tx_avail(q, nr_segs)) {
+			tvnet_ep_tx_flush(tvnet, q);
+			if (!tvnet_ep_tx_avail(q, nr_segs))
+				goto busy;
+		}
+		tvnet_ep_tx_gso(tvnet, q, txq, skb);
+	} else {
+		ndev->stats.tx_dropped++;
+		dev_kfree_skb_any(skb);
+	}
+
+	if (!more || q->tx_pending == TVNET_TX_BATCH ||
+	    netif_xmit_stopped(txq))
+		tvnet_ep_tx_flush(tvnet, q);
+
+	spin_unlock(&q->tx_lock);
 
 	return NETDEV_TX_OK;
+
+busy:
+	tvnet_ep_tx_flush(tvnet, q);
+	spin_unlock(&q->tx_lock);
+	/* Raise ctrl and data irq to let host process rings */
+	tvnet_ep_raise_data_irq(tvnet, q);
+	dev_dbg(fdev, "%s: No EP2H empty/full msg, stop tx\n", __func__);
+	netif_tx_stop_queue(txq);
+	return NETDEV_TX_BUSY;
 }
 
 static const struct net_device_ops tvnet_netdev_ops = {
@@ -825,10 +1095,10 @@ static void tvnet_ep_process_ctrl_msg(struct pci_epf_tvnet *tvnet)
 	}
 }
 
-static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
+static int tvnet_ep_process_h2ep_msg(struct tvnet_ep_queue *q)
 {
-	struct host_ring_buf *host_ring_buf = &tvnet->host_ring_buf;
-	struct data_msg *data_msg = host_ring_buf->h2ep_full_msgs;
+	struct pci_epf_tvnet *tvnet = q->tvnet;
+	struct data_msg *data_msg = q->h2ep_full_msgs;
 	struct pci_epf *epf = tvnet->epf;
 	struct pci_epc *epc = epf->epc;
 	struct device *cdev = epc->dev.parent;
@@ -840,21 +1110,23 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 	int count = 0;
 
 	while ((count < TVNET_NAPI_WEIGHT) &&
-	       tvnet_ivc_rd_available(&tvnet->h2ep_full)) {
+	       tvnet_ivc_rd_available(&q->h2ep_full)) {
 		struct sk_buff *skb;
+		struct data_msg msg;
 		int idx, found = 0;
 		u32 len;
 		u64 pcie_address;
 		unsigned long flags;
 
-		/* Read H2EP full msg */
-		idx = tvnet_ivc_get_rd_cnt(&tvnet->h2ep_full) % RING_COUNT;
-		len = data_msg[idx].u.full_buffer.packet_size;
-		pcie_address = data_msg[idx].u.full_buffer.pcie_address;
+		/* Read H2EP full msg, slot is reused once rd is advanced */
+		idx = tvnet_ivc_get_rd_cnt(&q->h2ep_full) % RING_COUNT;
+		msg = data_msg[idx];
+		len = msg.u.full_buffer.packet_size;
+		pcie_address = msg.u.full_buffer.pcie_address;
 
 		/* Get H2EP msg pointer from saved list */
-		spin_lock_irqsave(&tvnet->h2ep_empty_lock, flags);
-		list_for_each_entry(h2ep_empty_ptr, &tvnet->h2ep_empty_list,
+		spin_lock_irqsave(&q->h2ep_empty_lock, flags);
+		list_for_each_entry(h2ep_empty_ptr, &q->h2ep_empty_list,
 				    list) {
 			if (h2ep_empty_ptr->iova == pcie_address) {
 				list_del(&h2ep_empty_ptr->list);
@@ -862,26 +1134,38 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 				break;
 			}
 		}
-		spin_unlock_irqrestore(&tvnet->h2ep_empty_lock, flags);
+		spin_unlock_irqrestore(&q->h2ep_empty_lock, flags);
 
 		/* Advance H2EP full buffer after search in local list */
-		tvnet_ivc_advance_rd(&tvnet->h2ep_full);
+		tvnet_ivc_advance_rd(&q->h2ep_full);
 		if (WARN_ON(!found))
 			continue;
 #if ENABLE_DMA
-		dma_unmap_single(cdev, pcie_address, ndev->mtu + ETH_HLEN,
+		dma_unmap_single(cdev, pcie_address, h2ep_empty_ptr->size,
 				 DMA_FROM_DEVICE);
 		skb = h2ep_empty_ptr->skb;
 		skb_put(skb, len);
-		skb->protocol = eth_type_trans(skb, ndev);
-		napi_gro_receive(&tvnet->napi, skb);
+		if (tvnet_full_msg_to_skb(skb, &msg) < 0) {
+			ndev->stats.rx_errors++;
+			dev_kfree_skb_any(skb);
+		} else {
+			skb->protocol = eth_type_trans(skb, ndev);
+			skb_record_rx_queue(skb, q->qid);
+			napi_gro_receive(&q->napi, skb);
+		}
 #else
 		/* Alloc new skb and copy data from full buffer */
 		skb = netdev_alloc_skb(ndev, len);
 		memcpy(skb->data, h2ep_empty_ptr->virt, len);
 		skb_put(skb, len);
-		skb->protocol = eth_type_trans(skb, ndev);
-		napi_gro_receive(&tvnet->napi, skb);
+		if (tvnet_full_msg_to_skb(skb, &msg) < 0) {
+			ndev->stats.rx_errors++;
+			dev_kfree_skb_any(skb);
+		} else {
+			skb->protocol = eth_type_trans(skb, ndev);
+			skb_record_rx_queue(skb, q->qid);
+			napi_gro_receive(&q->napi, skb);
+		}
 
 		/* Free H2EP dst msg */
 		vunmap(h2ep_empty_ptr->virt);
@@ -901,36 +1185,44 @@ static int tvnet_ep_process_h2ep_msg(struct pci_epf_tvnet *tvnet)
 static void tvnet_ep_setup_dma(struct pci_epf_tvnet *tvnet)
 {
 	dma_addr_t iova = tvnet->bar0_amap[HOST_DMA].iova;
-	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
-	u32 val;
-
-	desc_cnt->rd_cnt = desc_cnt->wr_cnt = 0;
-
-	/* Enable linked list mode and set CCS for write channel-0 */
-	val = dma_channel_rd(tvnet->dma_base, DMA_WR_DATA_CH,
-			     DMA_CH_CONTROL1_OFF_WRCH);
-	val |= DMA_CH_CONTROL1_OFF_WRCH_LLE;
-	val |= DMA_CH_CONTROL1_OFF_WRCH_CCS;
-	dma_channel_wr(tvnet->dma_base, DMA_WR_DATA_CH, val,
-		       DMA_CH_CONTROL1_OFF_WRCH);
-
-	/* Unmask write channel-0 done irq to enable LIE */
-	val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_MASK_OFF);
-	val &= ~0x1;
-	dma_common_wr(tvnet->dma_base, val, DMA_WRITE_INT_MASK_OFF);
-
-	/* Enable write channel-0 local abort irq */
-	val = dma_common_rd(tvnet->dma_base, DMA_WRITE_LINKED_LIST_ERR_EN_OFF);
-	val |= (0x1 << 16);
-	dma_common_wr(tvnet->dma_base, val, DMA_WRITE_LINKED_LIST_ERR_EN_OFF);
-
-	/* Program DMA write linked list base address to DMA LLP register */
-	dma_channel_wr(tvnet->dma_base, DMA_WR_DATA_CH,
-		       lower_32_bits(tvnet->ep_dma_iova),
-		       DMA_LLP_LOW_OFF_WRCH);
-	dma_channel_wr(tvnet->dma_base, DMA_WR_DATA_CH,
-		       upper_32_bits(tvnet->ep_dma_iova),
-		       DMA_LLP_HIGH_OFF_WRCH);
+	struct tvnet_ep_queue *q;
+	u32 val, ch;
+	int i;
+
+	/* Each queue transmits on its own write channel */
+	for (i = 0; i < tvnet->num_queues; i++) {
+		q = &tvnet->queues[i];
+		ch = DMA_WR_DATA_CH + i;
+		q->desc_cnt.rd_cnt = q->desc_cnt.wr_cnt = 0;
+
+		/* Enable linked list mode and set CCS for write channel */
+		val = dma_channel_rd(tvnet->dma_base, ch,
+				     DMA_CH_CONTROL1_OFF_WRCH);
+		val |= DMA_CH_CONTROL1_OFF_WRCH_LLE;
+		val |= DMA_CH_CONTROL1_OFF_WRCH_CCS;
+		dma_channel_wr(tvnet->dma_base, ch, val,
+			       DMA_CH_CONTROL1_OFF_WRCH);
+
+		/* Unmask write channel done irq to enable LIE */
+		val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_MASK_OFF);
+		val &= ~BIT(ch);
+		dma_common_wr(tvnet->dma_base, val, DMA_WRITE_INT_MASK_OFF);
+
+		/* Enable write channel local abort irq */
+		val = dma_common_rd(tvnet->dma_base,
+				    DMA_WRITE_LINKED_LIST_ERR_EN_OFF);
+		val |= BIT(16 + ch);
+		dma_common_wr(tvnet->dma_base, val,
+			      DMA_WRITE_LINKED_LIST_ERR_EN_OFF);
+
+		/* Program DMA write linked list base address to LLP register */
+		dma_channel_wr(tvnet->dma_base, ch,
+			       lower_32_bits(q->ep_dma_iova),
+			       DMA_LLP_LOW_OFF_WRCH);
+		dma_channel_wr(tvnet->dma_base, ch,
+			       upper_32_bits(q->ep_dma_iova),
+			       DMA_LLP_HIGH_OFF_WRCH);
+	}
 
 	/* Enable DMA write engine */
 	dma_common_wr(tvnet->dma_base, DMA_WRITE_ENGINE_EN_OFF_ENABLE,
@@ -1065,21 +1357,25 @@ static void tvnet_ep_ctrl_irqsp_callback(void *private_data)
 	struct irqsp_data *data_irqsp = private_data;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(data_irqsp->dev);
 	struct net_device *ndev = tvnet->ndev;
+	struct netdev_queue *txq;
+	struct tvnet_ep_queue *q;
+	int i;
 
-	if (netif_queue_stopped(ndev)) {
-		if ((tvnet->os_link_state == OS_LINK_STATE_UP) &&
-		    tvnet_ivc_rd_available(&tvnet->ep2h_empty) &&
-		    !tvnet_ivc_full(&tvnet->ep2h_full)) {
-			netif_wake_queue(ndev);
-		}
+	for (i = 0; i < ndev->real_num_tx_queues; i++) {
+		q = &tvnet->queues[i % tvnet->active_queues];
+		txq = netdev_get_tx_queue(ndev, i);
+		if (netif_tx_queue_stopped(txq) &&
+		    (tvnet->os_link_state == OS_LINK_STATE_UP) &&
+		    tvnet_ivc_rd_available(&q->ep2h_empty) &&
+		    !tvnet_ivc_full(&q->ep2h_full))
+			netif_tx_wake_queue(txq);
 	}
 
 	if (tvnet_ivc_rd_available(&tvnet->h2ep_ctrl))
 		tvnet_ep_process_ctrl_msg(tvnet);
 
-	if (!tvnet_ivc_full(&tvnet->h2ep_empty) &&
-	    (tvnet->os_link_state == OS_LINK_STATE_UP))
-		tvnet_ep_alloc_empty_buffers(tvnet);
+	if (tvnet->os_link_state == OS_LINK_STATE_UP)
+		tvnet_ep_alloc_all_empty_buffers(tvnet);
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 14, 0))
 	schedule_work(&data_irqsp->reprime_work);
 #endif
@@ -1104,9 +1400,10 @@ static void tvnet_ep_data_irqsp_callback(void *private_data)
 {
 	struct irqsp_data *data_irqsp = private_data;
 	struct pci_epf_tvnet *tvnet = dev_get_drvdata(data_irqsp->dev);
+	struct tvnet_ep_queue *q = &tvnet->queues[data_irqsp->qid];
 
-	if (tvnet_ivc_rd_available(&tvnet->h2ep_full))
-		napi_schedule(&tvnet->napi);
+	if (tvnet_ivc_rd_available(&q->h2ep_full))
+		napi_schedule(&q->napi);
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 14, 0))
 	else
 		schedule_work(&data_irqsp->reprime_work);
@@ -1115,14 +1412,14 @@ static void tvnet_ep_data_irqsp_callback(void *private_data)
 
 static int tvnet_ep_poll(struct napi_struct *napi, int budget)
 {
-	struct pci_epf_tvnet *tvnet = container_of(napi, struct pci_epf_tvnet,
-						   napi);
+	struct tvnet_ep_queue *q = container_of(napi, struct tvnet_ep_queue,
+						napi);
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 14, 0))
-	struct irqsp_data *data_irqsp = tvnet->data_irqsp;
+	struct irqsp_data *data_irqsp = q->data_irqsp;
 #endif
 	int work_done;
 
-	work_done = tvnet_ep_process_h2ep_msg(tvnet);
+	work_done = tvnet_ep_process_h2ep_msg(q);
 	if (work_done < budget) {
 		napi_complete(napi);
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 14, 0))
@@ -1133,10 +1430,12 @@ static int tvnet_ep_poll(struct napi_struct *napi, int budget)
 	return work_done;
 }
 
-static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
+/* Data syncpoint of queue N is exposed at page N + 1 of SIMPLE_IRQ region */
+static int tvnet_ep_pci_epf_setup_data_irqsp(struct pci_epf_tvnet *tvnet,
+					     int qid)
 {
 	struct bar0_amap *amap = &tvnet->bar0_amap[SIMPLE_IRQ];
-	struct irqsp_data *ctrl_irqsp, *data_irqsp;
+	struct irqsp_data *data_irqsp;
 	struct pci_epf *epf = tvnet->epf;
 	struct device *fdev = tvnet->fdev;
 	struct pci_epc *epc = epf->epc;
@@ -1155,83 +1454,154 @@ static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
 		return -EINVAL;
 	}
 #endif
-	ctrl_irqsp = devm_kzalloc(fdev, sizeof(*ctrl_irqsp), GFP_KERNEL);
-	if (!ctrl_irqsp) {
-		ret = -ENOMEM;
-		goto fail;
-	}
+	data_irqsp = devm_kzalloc(fdev, sizeof(*data_irqsp), GFP_KERNEL);
+	if (!data_irqsp)
+		return -ENOMEM;
 
+	data_irqsp->dev = fdev;
+	data_irqsp->qid = qid;
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
-	syncpt = &ctrl_irqsp->syncpt;
+	syncpt = &data_irqsp->syncpt;
 	syncpt->sp = host1x_syncpt_alloc(host1x, HOST1X_SYNCPT_CLIENT_MANAGED,
-					 "pcie-ep-vnet-ctrl");
+					 "pcie-ep-vnet-data");
 	if (IS_ERR_OR_NULL(syncpt->sp)) {
-		ret = -ENOMEM;
 		pr_err("Failed to reserve comm notify syncpt\n");
-		goto free_ctrl_sp;
+		return -ENOMEM;
 	}
 
 	syncpt->id = host1x_syncpt_id(syncpt->sp);
-	ctrl_irqsp->dev = fdev;
-	INIT_WORK(&syncpt->work, tvnet_ep_ctrl_irqsp_work);
-	tvnet->ctrl_irqsp = ctrl_irqsp;
+	INIT_WORK(&syncpt->work, tvnet_ep_data_irqsp_work);
+	tvnet->queues[qid].data_irqsp = data_irqsp;
 
 	syncpt->threshold = host1x_syncpt_read(syncpt->sp);
 
 	/* enable syncpt notifications handling from peer.*/
 	mutex_init(&syncpt->lock);
-	syncpt->notifier = tvnet_ep_ctrl_irqsp_callback;
-	syncpt->notifier_data = (void *)ctrl_irqsp;
+	syncpt->notifier = tvnet_ep_data_irqsp_callback;
+	syncpt->notifier_data = (void *)data_irqsp;
 	syncpt->host1x_cb_set = true;
 	syncpt->fence_release = false;
 
 	ret = allocate_fence(syncpt);
 	if (ret != 0) {
 		pr_err("allocate_fence failed with: %d\n", ret);
-		goto free_ctrl_sp;
+		goto free_data_sp;
 	}
+
+	syncpt_addr = get_syncpt_shim_offset(syncpt->id);
+	syncpt->phy_addr = syncpt_addr;
+	syncpt->size = PAGE_SIZE;
 #else
-	ctrl_irqsp->is =
+	data_irqsp->is =
 		nvhost_interrupt_syncpt_get(cdev->of_node,
-					    tvnet_ep_ctrl_irqsp_callback,
-					    ctrl_irqsp);
-	if (IS_ERR(ctrl_irqsp->is)) {
-		ret = PTR_ERR(ctrl_irqsp->is);
-		dev_err(fdev, "failed to get ctrl syncpt irq: %d\n", ret);
-		goto fail;
+					    tvnet_ep_data_irqsp_callback,
+					    data_irqsp);
+	if (IS_ERR(data_irqsp->is)) {
+		ret = PTR_ERR(data_irqsp->is);
+		dev_err(fdev, "failed to get data syncpt irq: %d\n", ret);
+		return ret;
 	}
 
-	ctrl_irqsp->dev = fdev;
-	INIT_WORK(&ctrl_irqsp->reprime_work, tvnet_ep_ctrl_irqsp_reprime_work);
-	tvnet->ctrl_irqsp = ctrl_irqsp;
+	INIT_WORK(&data_irqsp->reprime_work, tvnet_ep_data_irqsp_reprime_work);
+	tvnet->queues[qid].data_irqsp = data_irqsp;
+
+	syncpt_addr = nvhost_interrupt_syncpt_get_syncpt_addr(data_irqsp->is);
 #endif
-	data_irqsp = devm_kzalloc(fdev, sizeof(*data_irqsp), GFP_KERNEL);
-	if (!data_irqsp) {
+	ret = iommu_map(domain, amap->iova + (1 + qid) * PAGE_SIZE,
+			syncpt_addr, PAGE_SIZE,
+#if defined(NV_IOMMU_MAP_HAS_GFP_ARG)
+			IOMMU_CACHE | IOMMU_READ | IOMMU_WRITE, GFP_KERNEL);
+#else
+			IOMMU_CACHE | IOMMU_READ | IOMMU_WRITE);
+#endif
+	if (ret < 0) {
+		dev_err(fdev, "%s: iommu_map of datasp %d mem failed: %d\n",
+			__func__, qid, ret);
+		goto free_data_sp;
+	}
+
+	irq = &tvnet->bar_md->irq_data_mq[qid];
+	irq->irq_addr = (2 + qid) * PAGE_SIZE;
+	irq->irq_type = IRQ_SIMPLE;
+
+	return 0;
+
+free_data_sp:
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
+	host1x_syncpt_put(data_irqsp->syncpt.sp);
+#else
+	nvhost_interrupt_syncpt_free(data_irqsp->is);
+#endif
+	return ret;
+}
+
+static void tvnet_ep_pci_epf_destroy_data_irqsp(struct pci_epf_tvnet *tvnet,
+						int qid)
+{
+	struct irqsp_data *data_irqsp = tvnet->queues[qid].data_irqsp;
+	struct pci_epf *epf = tvnet->epf;
+	struct pci_epc *epc = epf->epc;
+	struct device *cdev = epc->dev.parent;
+	struct iommu_domain *domain = iommu_get_domain_for_dev(cdev);
+
+	iommu_unmap(domain, tvnet->bar0_amap[SIMPLE_IRQ].iova +
+		    (1 + qid) * PAGE_SIZE, PAGE_SIZE);
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
+	host1x_syncpt_put(data_irqsp->syncpt.sp);
+#else
+	nvhost_interrupt_syncpt_free(data_irqsp->is);
+#endif
+}
+
+static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
+{
+	struct bar0_amap *amap = &tvnet->bar0_amap[SIMPLE_IRQ];
+	struct irqsp_data *ctrl_irqsp;
+	struct pci_epf *epf = tvnet->epf;
+	struct device *fdev = tvnet->fdev;
+	struct pci_epc *epc = epf->epc;
+	struct device *cdev = epc->dev.parent;
+	struct iommu_domain *domain = iommu_get_domain_for_dev(cdev);
+	struct irq_md *irq;
+	phys_addr_t syncpt_addr;
+	int ret, i;
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
+	struct host1x *host1x = NULL;
+	struct syncpt_t *syncpt = NULL;
+
+	host1x = platform_get_drvdata(tvnet->host1x_pdev);
+	if (!host1x) {
+		pr_err("Host1x handle is null.");
+		return -EINVAL;
+	}
+#endif
+	ctrl_irqsp = devm_kzalloc(fdev, sizeof(*ctrl_irqsp), GFP_KERNEL);
+	if (!ctrl_irqsp) {
 		ret = -ENOMEM;
-		goto free_ctrl_sp;
+		goto fail;
 	}
 
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
-	syncpt = &data_irqsp->syncpt;
+	syncpt = &ctrl_irqsp->syncpt;
 	syncpt->sp = host1x_syncpt_alloc(host1x, HOST1X_SYNCPT_CLIENT_MANAGED,
-					 "pcie-ep-vnet-data");
+					 "pcie-ep-vnet-ctrl");
 	if (IS_ERR_OR_NULL(syncpt->sp)) {
 		ret = -ENOMEM;
 		pr_err("Failed to reserve comm notify syncpt\n");
-		goto free_ctrl_sp;
+		goto fail;
 	}
 
 	syncpt->id = host1x_syncpt_id(syncpt->sp);
-	data_irqsp->dev = fdev;
-	INIT_WORK(&syncpt->work, tvnet_ep_data_irqsp_work);
-	tvnet->data_irqsp = data_irqsp;
+	ctrl_irqsp->dev = fdev;
+	INIT_WORK(&syncpt->work, tvnet_ep_ctrl_irqsp_work);
+	tvnet->ctrl_irqsp = ctrl_irqsp;
 
 	syncpt->threshold = host1x_syncpt_read(syncpt->sp);
 
 	/* enable syncpt notifications handling from peer.*/
 	mutex_init(&syncpt->lock);
-	syncpt->notifier = tvnet_ep_data_irqsp_callback;
-	syncpt->notifier_data = (void *)data_irqsp;
+	syncpt->notifier = tvnet_ep_ctrl_irqsp_callback;
+	syncpt->notifier_data = (void *)ctrl_irqsp;
 	syncpt->host1x_cb_set = true;
 	syncpt->fence_release = false;
 
@@ -1245,19 +1615,19 @@ static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
 	ctrl_irqsp->syncpt.phy_addr = syncpt_addr;
 	ctrl_irqsp->syncpt.size = PAGE_SIZE;
 #else
-	data_irqsp->is =
+	ctrl_irqsp->is =
 		nvhost_interrupt_syncpt_get(cdev->of_node,
-					    tvnet_ep_data_irqsp_callback,
-					    data_irqsp);
-	if (IS_ERR(data_irqsp->is)) {
-		ret = PTR_ERR(data_irqsp->is);
-		dev_err(fdev, "failed to get data syncpt irq: %d\n", ret);
-		goto free_ctrl_sp;
+					    tvnet_ep_ctrl_irqsp_callback,
+					    ctrl_irqsp);
+	if (IS_ERR(ctrl_irqsp->is)) {
+		ret = PTR_ERR(ctrl_irqsp->is);
+		dev_err(fdev, "failed to get ctrl syncpt irq: %d\n", ret);
+		goto fail;
 	}
 
-	data_irqsp->dev = fdev;
-	INIT_WORK(&data_irqsp->reprime_work, tvnet_ep_data_irqsp_reprime_work);
-	tvnet->data_irqsp = data_irqsp;
+	ctrl_irqsp->dev = fdev;
+	INIT_WORK(&ctrl_irqsp->reprime_work, tvnet_ep_ctrl_irqsp_reprime_work);
+	tvnet->ctrl_irqsp = ctrl_irqsp;
 
 	syncpt_addr = nvhost_interrupt_syncpt_get_syncpt_addr(ctrl_irqsp->is);
 #endif
@@ -1270,48 +1640,32 @@ static int tvnet_ep_pci_epf_setup_irqsp(struct pci_epf_tvnet *tvnet)
 	if (ret < 0) {
 		dev_err(fdev, "%s: iommu_map of ctrlsp mem failed: %d\n",
 			__func__, ret);
-		goto free_data_sp;
+		goto free_ctrl_sp;
 	}
 
 	irq = &tvnet->bar_md->irq_ctrl;
 	irq->irq_addr = PAGE_SIZE;
 	irq->irq_type = IRQ_SIMPLE;
 
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
-	syncpt_addr = get_syncpt_shim_offset(data_irqsp->syncpt.id);
-	data_irqsp->syncpt.phy_addr = syncpt_addr;
-	data_irqsp->syncpt.size = PAGE_SIZE;
-#else
-	syncpt_addr = nvhost_interrupt_syncpt_get_syncpt_addr(data_irqsp->is);
-#endif
-	ret = iommu_map(domain, amap->iova + PAGE_SIZE, syncpt_addr, PAGE_SIZE,
-#if defined(NV_IOMMU_MAP_HAS_GFP_ARG)
-			IOMMU_CACHE | IOMMU_READ | IOMMU_WRITE, GFP_KERNEL);
-#else
-			IOMMU_CACHE | IOMMU_READ | IOMMU_WRITE);
-#endif
-	if (ret < 0) {
-		dev_err(fdev, "%s: iommu_map of datasp mem failed: %d\n",
-			__func__, ret);
-		goto free_ctrl_ivoa;
+	for (i = 0; i < tvnet->num_queues; i++) {
+		ret = tvnet_ep_pci_epf_setup_data_irqsp(tvnet, i);
+		if (ret < 0)
+			goto free_data_sp;
 	}
 
-	irq = &tvnet->bar_md->irq_data;
-	irq->irq_addr = 2 * PAGE_SIZE;
-	irq->irq_type = IRQ_SIMPLE;
+	/* Queue 0 data irq stays at the location known to old hosts */
+	tvnet->bar_md->irq_data = tvnet->bar_md->irq_data_mq[0];
 
 	return 0;
 
-free_ctrl_ivoa:
-	iommu_unmap(domain, amap->iova, PAGE_SIZE);
 free_data_sp:
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
-	host1x_syncpt_put(data_irqsp->syncpt.sp);
+	while (i--)
+		tvnet_ep_pci_epf_destroy_data_irqsp(tvnet, i);
+	iommu_unmap(domain, amap->iova, PAGE_SIZE);
 free_ctrl_sp:
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
 	host1x_syncpt_put(ctrl_irqsp->syncpt.sp);
 #else
-	nvhost_interrupt_syncpt_free(data_irqsp->is);
-free_ctrl_sp:
 	nvhost_interrupt_syncpt_free(ctrl_irqsp->is);
 #endif
 fail:
@@ -1324,15 +1678,14 @@ static void tvnet_ep_pci_epf_destroy_irqsp(struct pci_epf_tvnet *tvnet)
 	struct pci_epc *epc = epf->epc;
 	struct device *cdev = epc->dev.parent;
 	struct iommu_domain *domain = iommu_get_domain_for_dev(cdev);
+	int i;
 
-	iommu_unmap(domain, tvnet->bar0_amap[SIMPLE_IRQ].iova + PAGE_SIZE,
-		    PAGE_SIZE);
+	for (i = 0; i < tvnet->num_queues; i++)
+		tvnet_ep_pci_epf_destroy_data_irqsp(tvnet, i);
 	iommu_unmap(domain, tvnet->bar0_amap[SIMPLE_IRQ].iova, PAGE_SIZE);
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
-	host1x_syncpt_put(tvnet->data_irqsp->syncpt.sp);
 	host1x_syncpt_put(tvnet->ctrl_irqsp->syncpt.sp);
 #else
-	nvhost_interrupt_syncpt_free(tvnet->data_irqsp->is);
 	nvhost_interrupt_syncpt_free(tvnet->ctrl_irqsp->is);
 #endif
 }
@@ -1559,6 +1912,18 @@ static int tvnet_ep_pci_epf_core_init(struct pci_epf *epf)
 }
 #endif
 
+static void tvnet_ep_reset_ep2h_full(struct pci_epf_tvnet *tvnet)
+{
+	struct tvnet_ep_queue *q;
+	int i;
+
+	for (i = 0; i < tvnet->num_queues; i++) {
+		q = &tvnet->queues[i];
+		tvnet_ivc_set_wr(&q->ep2h_full,
+				 tvnet_ivc_get_rd_cnt(&q->ep2h_full));
+	}
+}
+
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0) && \
 	LINUX_VERSION_CODE < KERNEL_VERSION(5, 14, 0))
 static int tvnet_ep_pci_epf_notifier(struct notifier_block *nb,
@@ -1585,8 +1950,7 @@ static int tvnet_ep_pci_epf_notifier(struct notifier_block *nb,
 		 * empty buffer. Clear any pending EP2H full buffer by setting
 		 * "wr_cnt = rd_cnt".
 		 */
-		tvnet_ivc_set_wr(&tvnet->ep2h_full,
-				 tvnet_ivc_get_rd_cnt(&tvnet->ep2h_full));
+		tvnet_ep_reset_ep2h_full(tvnet);
 
 		tvnet->pcie_link_status = true;
 		break;
@@ -1615,8 +1979,7 @@ static void tvnet_ep_pci_epf_linkup(struct pci_epf *epf)
 	 * If host goes through a suspend resume, it recycles EP2H empty buffer.
 	 * Clear any pending EP2H full buffer by setting "wr_cnt = rd_cnt".
 	 */
-	tvnet_ivc_set_wr(&tvnet->ep2h_full,
-			 tvnet_ivc_get_rd_cnt(&tvnet->ep2h_full));
+	tvnet_ep_reset_ep2h_full(tvnet);
 
 	tvnet->pcie_link_status = true;
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
@@ -1677,6 +2040,37 @@ struct iommu_dma_cookie {
 };
 #endif
 
+/* Data rings of queue N follow the RING_COUNT messages of queue N - 1 */
+static void tvnet_ep_setup_queue(struct pci_epf_tvnet *tvnet, int qid)
+{
+	struct tvnet_ep_queue *q = &tvnet->queues[qid];
+	struct ep_ring_buf *ep_ring_buf = &tvnet->ep_ring_buf;
+	struct host_ring_buf *host_ring_buf = &tvnet->host_ring_buf;
+	struct ep_own_data_cnt *ep_cnt = &ep_ring_buf->ep_cnt->data[qid];
+	struct host_own_data_cnt *host_cnt =
+					&host_ring_buf->host_cnt->data[qid];
+
+	q->tvnet = tvnet;
+	q->qid = qid;
+	INIT_LIST_HEAD(&q->h2ep_empty_list);
+	spin_lock_init(&q->h2ep_empty_lock);
+	spin_lock_init(&q->tx_lock);
+
+	q->ep2h_full_msgs = ep_ring_buf->ep2h_full_msgs + qid * RING_COUNT;
+	q->h2ep_empty_msgs = ep_ring_buf->h2ep_empty_msgs + qid * RING_COUNT;
+	q->ep2h_empty_msgs = host_ring_buf->ep2h_empty_msgs + qid * RING_COUNT;
+	q->h2ep_full_msgs = host_ring_buf->h2ep_full_msgs + qid * RING_COUNT;
+
+	q->h2ep_empty.rd = &host_cnt->h2ep_empty_rd_cnt;
+	q->h2ep_empty.wr = &ep_cnt->h2ep_empty_wr_cnt;
+	q->h2ep_full.rd = &ep_cnt->h2ep_full_rd_cnt;
+	q->h2ep_full.wr = &host_cnt->h2ep_full_wr_cnt;
+	q->ep2h_empty.rd = &ep_cnt->ep2h_empty_rd_cnt;
+	q->ep2h_empty.wr = &host_cnt->ep2h_empty_wr_cnt;
+	q->ep2h_full.rd = &host_cnt->ep2h_full_rd_cnt;
+	q->ep2h_full.wr = &ep_cnt->ep2h_full_wr_cnt;
+}
+
 static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 {
 	struct pci_epf_tvnet *tvnet = epf_get_drvdata(epf);
@@ -1695,7 +2089,7 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	struct resource *res;
 	struct bar0_amap *amap;
 	struct tvnet_dma_desc *dma_desc;
-	int ret, size, bitmap_size;
+	int ret, size, bitmap_size, i;
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
 	unsigned long shift;
 #endif
@@ -1777,11 +2171,21 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	tvnet->bar_md = (struct bar_md *)tvnet->bar0_amap[META_DATA].virt;
 	bar_md = tvnet->bar_md;
 
-	/* BAR0 SIMPLE_IRQ setup: two interrupts required two pages */
+	/* Data queue pairs, EP Tx needs a DMA write channel per queue */
+#if ENABLE_DMA
+	tvnet->num_queues = TVNET_MAX_QUEUES;
+#else
+	tvnet->num_queues = 1;
+#endif
+	tvnet->active_queues = 1;
+	memset(bar_md, 0, sizeof(*bar_md));
+	bar_md->num_queues = tvnet->num_queues;
+
+	/* BAR0 SIMPLE_IRQ setup: one page per ctrl and per data interrupt */
 	amap = &tvnet->bar0_amap[SIMPLE_IRQ];
 	amap->iova = tvnet->bar0_amap[META_DATA].iova +
 		tvnet->bar0_amap[META_DATA].size;
-	amap->size = 2 * PAGE_SIZE;
+	amap->size = (1 + tvnet->num_queues) * PAGE_SIZE;
 
 	ret = tvnet_ep_pci_epf_setup_irqsp(tvnet);
 	if (ret < 0) {
@@ -1794,7 +2198,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	amap->iova = tvnet->bar0_amap[SIMPLE_IRQ].iova +
 		tvnet->bar0_amap[SIMPLE_IRQ].size;
 	size = sizeof(struct ep_own_cnt) + (RING_COUNT *
-		(sizeof(struct ctrl_msg) + 2 * sizeof(struct data_msg)));
+		(sizeof(struct ctrl_msg) +
+		 2 * tvnet->num_queues * sizeof(struct data_msg)));
 	amap->size = PAGE_ALIGN(size);
 	ret = tvnet_ep_alloc_multi_page_bar0_mem(epf, EP_MEM);
 	if (ret < 0) {
@@ -1808,7 +2213,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	ep_ring_buf->ep2h_full_msgs = (struct data_msg *)
 				(ep_ring_buf->ep2h_ctrl_msgs + RING_COUNT);
 	ep_ring_buf->h2ep_empty_msgs = (struct data_msg *)
-				(ep_ring_buf->ep2h_full_msgs + RING_COUNT);
+				(ep_ring_buf->ep2h_full_msgs +
+				 tvnet->num_queues * RING_COUNT);
 	/* Clear EP counters */
 	memset(ep_ring_buf->ep_cnt, 0, sizeof(struct ep_own_cnt));
 
@@ -1817,7 +2223,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	amap->iova = tvnet->bar0_amap[EP_MEM].iova +
 					tvnet->bar0_amap[EP_MEM].size;
 	size = (sizeof(struct host_own_cnt)) + (RING_COUNT *
-		(sizeof(struct ctrl_msg) + 2 * sizeof(struct data_msg)));
+		(sizeof(struct ctrl_msg) +
+		 2 * tvnet->num_queues * sizeof(struct data_msg)));
 	amap->size = PAGE_ALIGN(size);
 	ret = tvnet_ep_alloc_multi_page_bar0_mem(epf, HOST_MEM);
 	if (ret < 0) {
@@ -1831,7 +2238,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	host_ring_buf->ep2h_empty_msgs = (struct data_msg *)
 				(host_ring_buf->h2ep_ctrl_msgs + RING_COUNT);
 	host_ring_buf->h2ep_full_msgs = (struct data_msg *)
-				(host_ring_buf->ep2h_empty_msgs + RING_COUNT);
+				(host_ring_buf->ep2h_empty_msgs +
+				 tvnet->num_queues * RING_COUNT);
 	/* Clear host counters */
 	memset(host_ring_buf->host_cnt, 0, sizeof(struct host_own_cnt));
 
@@ -1868,7 +2276,8 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 					(RING_COUNT * sizeof(struct ctrl_msg));
 	bar_md->ep2h_md.ep2h_size = RING_COUNT;
 	bar_md->h2ep_md.ep2h_offset = bar_md->ep2h_md.ep2h_offset +
-					(RING_COUNT * sizeof(struct data_msg));
+					(tvnet->num_queues * RING_COUNT *
+					 sizeof(struct data_msg));
 	bar_md->h2ep_md.ep2h_size = RING_COUNT;
 
 	/* Host owned memory */
@@ -1881,21 +2290,16 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 					(RING_COUNT * sizeof(struct ctrl_msg));
 	bar_md->ep2h_md.h2ep_size = RING_COUNT;
 	bar_md->h2ep_md.h2ep_offset = bar_md->ep2h_md.h2ep_offset +
-					(RING_COUNT * sizeof(struct data_msg));
+					(tvnet->num_queues * RING_COUNT *
+					 sizeof(struct data_msg));
 	bar_md->h2ep_md.h2ep_size = RING_COUNT;
 
 	tvnet->h2ep_ctrl.rd = &ep_ring_buf->ep_cnt->h2ep_ctrl_rd_cnt;
 	tvnet->h2ep_ctrl.wr = &host_ring_buf->host_cnt->h2ep_ctrl_wr_cnt;
 	tvnet->ep2h_ctrl.rd = &host_ring_buf->host_cnt->ep2h_ctrl_rd_cnt;
 	tvnet->ep2h_ctrl.wr = &ep_ring_buf->ep_cnt->ep2h_ctrl_wr_cnt;
-	tvnet->h2ep_empty.rd = &host_ring_buf->host_cnt->h2ep_empty_rd_cnt;
-	tvnet->h2ep_empty.wr = &ep_ring_buf->ep_cnt->h2ep_empty_wr_cnt;
-	tvnet->h2ep_full.rd = &ep_ring_buf->ep_cnt->h2ep_full_rd_cnt;
-	tvnet->h2ep_full.wr = &host_ring_buf->host_cnt->h2ep_full_wr_cnt;
-	tvnet->ep2h_empty.rd = &ep_ring_buf->ep_cnt->ep2h_empty_rd_cnt;
-	tvnet->ep2h_empty.wr = &host_ring_buf->host_cnt->ep2h_empty_wr_cnt;
-	tvnet->ep2h_full.rd = &host_ring_buf->host_cnt->ep2h_full_rd_cnt;
-	tvnet->ep2h_full.wr = &ep_ring_buf->ep_cnt->ep2h_full_wr_cnt;
+	for (i = 0; i < tvnet->num_queues; i++)
+		tvnet_ep_setup_queue(tvnet, i);
 
 	/* RAM region for use by host when programming EP DMA controller */
 	bar_md->host_dma_offset = bar_md->host_own_cnt_offset +
@@ -1935,10 +2339,21 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 		goto free_host_dma;
 	}
 
+	for (i = 0; i < tvnet->num_queues; i++) {
+		tvnet->queues[i].tx_pkts =
+			devm_kcalloc(fdev, TVNET_TX_BATCH,
+				     sizeof(*tvnet->queues[i].tx_pkts),
+				     GFP_KERNEL);
+		if (!tvnet->queues[i].tx_pkts) {
+			ret = -ENOMEM;
+			goto free_pci_mem;
+		}
+	}
+
 	/* Register network device */
-	ndev = alloc_etherdev(0);
+	ndev = alloc_etherdev_mqs(0, tvnet->num_queues, tvnet->num_queues);
 	if (!ndev) {
-		dev_err(fdev, "alloc_etherdev() failed\n");
+		dev_err(fdev, "alloc_etherdev_mqs() failed\n");
 		ret = -ENOMEM;
 		goto free_pci_mem;
 	}
@@ -1947,12 +2362,19 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	tvnet->ndev = ndev;
 	SET_NETDEV_DEV(ndev, fdev);
 	ndev->netdev_ops = &tvnet_netdev_ops;
+	for (i = 0; i < tvnet->num_queues; i++) {
 #if defined(NV_NETIF_NAPI_ADD_WEIGHT_PRESENT) /* Linux v6.1 */
-	netif_napi_add_weight(ndev, &tvnet->napi, tvnet_ep_poll, TVNET_NAPI_WEIGHT);
+		netif_napi_add_weight(ndev, &tvnet->queues[i].napi,
+				      tvnet_ep_poll, TVNET_NAPI_WEIGHT);
 #else
-	netif_napi_add(ndev, &tvnet->napi, tvnet_ep_poll, TVNET_NAPI_WEIGHT);
+		netif_napi_add(ndev, &tvnet->queues[i].napi, tvnet_ep_poll,
+			       TVNET_NAPI_WEIGHT);
 #endif
+	}
 	ndev->mtu = TVNET_DEFAULT_MTU;
+	ndev->hw_features = NETIF_F_SG | NETIF_F_HW_CSUM | NETIF_F_TSO |
+			    NETIF_F_TSO6;
+	ndev->features = ndev->hw_features | NETIF_F_HIGHDMA;
 
 	ret = register_netdev(ndev);
 	if (ret < 0) {
@@ -1967,9 +2389,6 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	mutex_init(&tvnet->link_state_lock);
 	init_waitqueue_head(&tvnet->link_state_wq);
 
-	INIT_LIST_HEAD(&tvnet->h2ep_empty_list);
-	spin_lock_init(&tvnet->h2ep_empty_lock);
-
 	INIT_WORK(&tvnet->raise_irq_work, tvnet_ep_raise_irq_work_function);
 
 #if (LINUX_VERSION_CODE <= KERNEL_VERSION(4, 15, 0))
@@ -1991,8 +2410,11 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	}
 #endif
 
-	/* Allocate local memory for DMA write link list elements */
-	size = ((DMA_DESC_COUNT + 1) * sizeof(struct tvnet_dma_desc));
+	/*
+	 * Allocate local memory for DMA write link list elements, one desc
+	 * ring per write channel.
+	 */
+	size = tvnet->num_queues * TVNET_EP_DMA_RING_SIZE;
 	tvnet->ep_dma_virt = dma_alloc_coherent(cdev, size,
 						&tvnet->ep_dma_iova,
 						GFP_KERNEL);
@@ -2004,15 +2426,26 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 
 	/* Set link list pointer to create a dma desc ring */
 	memset(tvnet->ep_dma_virt, 0, size);
-	dma_desc = (struct tvnet_dma_desc *)tvnet->ep_dma_virt;
-	dma_desc[DMA_DESC_COUNT].sar_low = (tvnet->ep_dma_iova & 0xffffffff);
-	dma_desc[DMA_DESC_COUNT].sar_high = ((tvnet->ep_dma_iova >> 32) &
-					     0xffffffff);
-	dma_desc[DMA_DESC_COUNT].ctrl_reg.ctrl_e.llp = 1;
+	for (i = 0; i < tvnet->num_queues; i++) {
+		dma_addr_t ring_iova = tvnet->ep_dma_iova +
+				       i * TVNET_EP_DMA_RING_SIZE;
+
+		dma_desc = (struct tvnet_dma_desc *)(tvnet->ep_dma_virt +
+						     i * TVNET_EP_DMA_RING_SIZE);
+		dma_desc[DMA_DESC_COUNT].sar_low = (ring_iova & 0xffffffff);
+		dma_desc[DMA_DESC_COUNT].sar_high = ((ring_iova >> 32) &
+						     0xffffffff);
+		dma_desc[DMA_DESC_COUNT].ctrl_reg.ctrl_e.llp = 1;
+#if ENABLE_DMA
+		tvnet->queues[i].ep_dma_virt = dma_desc;
+		tvnet->queues[i].ep_dma_iova = ring_iova;
+#endif
+	}
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 14, 0))
 	nvhost_interrupt_syncpt_prime(tvnet->ctrl_irqsp->is);
-	nvhost_interrupt_syncpt_prime(tvnet->data_irqsp->is);
+	for (i = 0; i < tvnet->num_queues; i++)
+		nvhost_interrupt_syncpt_prime(tvnet->queues[i].data_irqsp->is);
 
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
 	epf->nb.notifier_call = tvnet_ep_pci_epf_notifier;
@@ -2029,7 +2462,8 @@ fail_unreg_netdev:
 #endif
 	unregister_netdev(ndev);
 fail_free_netdev:
-	netif_napi_del(&tvnet->napi);
+	for (i = 0; i < tvnet->num_queues; i++)
+		netif_napi_del(&tvnet->queues[i].napi);
 	free_netdev(ndev);
 free_pci_mem:
 	pci_epc_mem_free_addr(epc, tvnet->tx_dst_pci_addr, tvnet->tx_dst_va,
@@ -2087,6 +2521,7 @@ static void tvnet_ep_pci_epf_unbind(struct pci_epf *epf)
 #endif
 	struct pci_epc *epc = epf->epc;
 	struct device *cdev = epc->dev.parent;
+	int i;
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 14, 0))
 	struct syncpt_t *syncpt = NULL;
 
@@ -2094,9 +2529,11 @@ static void tvnet_ep_pci_epf_unbind(struct pci_epf *epf)
 	free_fence_resource(syncpt);
 	cancel_work_sync(&syncpt->work);
 
-	syncpt = &tvnet->data_irqsp->syncpt;
-	free_fence_resource(syncpt);
-	cancel_work_sync(&syncpt->work);
+	for (i = 0; i < tvnet->num_queues; i++) {
+		syncpt = &tvnet->queues[i].data_irqsp->syncpt;
+		free_fence_resource(syncpt);
+		cancel_work_sync(&syncpt->work);
+	}
 #endif
 	pci_epc_stop(epc);
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
@@ -2104,11 +2541,11 @@ static void tvnet_ep_pci_epf_unbind(struct pci_epf *epf)
 #else
 	pci_epc_clear_bar(epc, BAR_0);
 #endif
-	dma_free_coherent(cdev,
-			  ((RING_COUNT + 1) * sizeof(struct tvnet_dma_desc)),
+	dma_free_coherent(cdev, tvnet->num_queues * TVNET_EP_DMA_RING_SIZE,
 			  tvnet->ep_dma_virt, tvnet->ep_dma_iova);
 	unregister_netdev(tvnet->ndev);
-	netif_napi_del(&tvnet->napi);
+	for (i = 0; i < tvnet->num_queues; i++)
+		netif_napi_del(&tvnet->queues[i].napi);
 	free_netdev(tvnet->ndev);
 	pci_epc_mem_free_addr(epc, tvnet->tx_dst_pci_addr, tvnet->tx_dst_va,
 			      SZ_64K);
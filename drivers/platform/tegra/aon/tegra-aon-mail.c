@@ -5,6 +5,7 @@
 
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
+#include <linux/err.h>
 #include <linux/mailbox_controller.h>
 #include <linux/of_address.h>
 #include <linux/slab.h>
@@ -131,6 +132,7 @@ static void tegra_aon_rx_handler(u32 ivc_chans)
 	struct ivc *ivc;
 	struct tegra_aon_ivc_chan *ivc_chan;
 	struct tegra_aon_mbox_msg msg;
+	uint32_t n;
 	int i;
 
 	ivc_chans &= BIT(aon_ivc.mbox.num_chans) - 1;
@@ -143,12 +145,20 @@ static void tegra_aon_rx_handler(u32 ivc_chans)
 		if (ivc_chan->chan_id == -1)
 			continue;
 		ivc = &ivc_chan->ivc;
-		while (tegra_ivc_can_read(ivc)) {
-			msg.data = tegra_ivc_read_get_next_frame(ivc);
-			msg.length = ivc->frame_size;
-			mbox_chan_received_data(mbox_chan, &msg);
-			tegra_ivc_read_advance(ivc);
-		}
+		/*
+		 * Hand every pending frame to the client and release them
+		 * together, so that the remote is notified once per batch.
+		 */
+		do {
+			for (n = 0; ; n++) {
+				msg.data = tegra_ivc_read_get_frame(ivc, n);
+				if (IS_ERR(msg.data))
+					break;
+				msg.length = ivc->frame_size;
+				mbox_chan_received_data(mbox_chan, &msg);
+			}
+			tegra_ivc_read_advance_n(ivc, n);
+		} while (n);
 	}
 }
 
@@ -10,6 +10,10 @@
 #include <linux/ioport.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/kref.h>
+#include <linux/log2.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/nospec.h>
 #include <linux/of.h>
@@ -23,7 +27,11 @@
 #include <linux/workqueue.h>
 #include <linux/platform_device.h>
 #include <linux/nvhost.h>
+#include <linux/poll.h>
+#include <linux/vmalloc.h>
+#include <linux/wait.h>
 #include <asm/cacheflush.h>
+#include <uapi/linux/tegra-rtcpu-trace-raw.h>
 
 #include "device-group.h"
 
@@ -42,12 +50,15 @@ EXPORT_TRACEPOINT_SYMBOL_GPL(capture_ivc_recv);
 
 #define WORK_INTERVAL_DEFAULT		100
 #define EXCEPTION_STR_LENGTH		2048
+#define RAW_RING_ENTRIES_DEFAULT	4096
 
 /*
  * Private driver data structure
  */
 
 struct tegra_rtcpu_trace {
+	/* held by the creator and by an open raw consumer */
+	struct kref ref;
 	struct device *dev;
 	struct device_node *of_node;
 	struct mutex lock;
@@ -98,6 +109,20 @@ struct tegra_rtcpu_trace {
 	bool enable_printk;
 	u32 printk_used;
 	char printk[EXCEPTION_STR_LENGTH];
+
+	/* raw consumer ring, non-NULL while /dev/camrtc-trace is open */
+	struct miscdevice raw_misc;
+	bool raw_misc_registered;
+	struct camrtc_trace_raw_header *raw;
+	void *raw_data;
+	size_t raw_size;
+	u32 raw_entries;
+	/* producer state, the copies in the user mapping are only published */
+	u32 raw_write_idx;
+	u64 raw_dropped;
+	wait_queue_head_t raw_wq;
+	u64 n_raw_batches;
+	u64 n_notify;
 };
 
 /*
@@ -1179,6 +1204,63 @@ static void rtcpu_trace_event(struct tegra_rtcpu_trace *tracer,
 	}
 }
 
+/*
+ * Copy events [old_next, new_next) to the raw consumer ring in at most
+ * four contiguous chunks and publish them with a single index update.
+ */
+static void rtcpu_trace_raw_events(struct tegra_rtcpu_trace *tracer,
+	u32 old_next, u32 new_next)
+{
+	struct camrtc_trace_raw_header *raw = tracer->raw;
+	void *data = tracer->raw_data;
+	u32 mask = tracer->raw_entries - 1;
+	u32 wr = tracer->raw_write_idx;
+	u32 rd = READ_ONCE(raw->read_idx);
+	u32 space = tracer->raw_entries - (wr - rd);
+	u32 count, chunk;
+
+	if (new_next >= old_next)
+		count = new_next - old_next;
+	else
+		count = tracer->event_entries - old_next + new_next;
+
+	tracer->n_events += count;
+
+	/* consumer moved read_idx outside the ring, resynchronize */
+	if (space > tracer->raw_entries) {
+		space = tracer->raw_entries;
+		rd = wr;
+		WRITE_ONCE(raw->read_idx, rd);
+	}
+
+	if (count > space) {
+		tracer->raw_dropped += count - space;
+		WRITE_ONCE(raw->dropped, tracer->raw_dropped);
+		count = space;
+	}
+
+	while (count > 0) {
+		chunk = min3(count, tracer->event_entries - old_next,
+			tracer->raw_entries - (wr & mask));
+		memcpy(data + (size_t)(wr & mask) * CAMRTC_TRACE_EVENT_SIZE,
+			&tracer->events[old_next],
+			(size_t)chunk * CAMRTC_TRACE_EVENT_SIZE);
+		wr += chunk;
+		count -= chunk;
+		old_next += chunk;
+		if (old_next == tracer->event_entries)
+			old_next = 0;
+	}
+
+	if (wr != tracer->raw_write_idx) {
+		tracer->raw_write_idx = wr;
+		/* entries must be visible before the index */
+		smp_store_release(&raw->write_idx, wr);
+		tracer->n_raw_batches++;
+		wake_up_interruptible(&tracer->raw_wq);
+	}
+}
+
 static inline void rtcpu_trace_events(struct tegra_rtcpu_trace *tracer)
 {
 	const struct camrtc_trace_memory_header *header = tracer->trace_memory;
@@ -1205,6 +1287,15 @@ static inline void rtcpu_trace_events(struct tegra_rtcpu_trace *tracer)
 				CAMRTC_TRACE_EVENT_SIZE,
 				tracer->event_entries);
 
+	if (tracer->raw != NULL) {
+		rtcpu_trace_raw_events(tracer, old_next, new_next);
+		last_event = &tracer->events[new_next == 0 ?
+				tracer->event_entries - 1 : new_next - 1];
+		tracer->event_last_idx = new_next;
+		tracer->copy_last_event = *last_event;
+		return;
+	}
+
 	/* pull events */
 	while (old_next != new_next) {
 		old_next = array_index_nospec(old_next, tracer->event_entries);
@@ -1252,6 +1343,163 @@ static void rtcpu_trace_worker(struct work_struct *work)
 	schedule_delayed_work(&tracer->work, tracer->work_interval_jiffies);
 }
 
+void tegra_rtcpu_trace_notify(struct tegra_rtcpu_trace *tracer)
+{
+	if (tracer == NULL)
+		return;
+
+	/*
+	 * Pull the trace now instead of waiting for the next interval. Work
+	 * already pending is not queued again, so bursts of notifications
+	 * are drained in a single pass.
+	 */
+	tracer->n_notify++;
+	mod_delayed_work(system_wq, &tracer->work, 0);
+}
+EXPORT_SYMBOL(tegra_rtcpu_trace_notify);
+
+/*
+ * Raw consumer device
+ */
+
+static void rtcpu_trace_free(struct kref *ref)
+{
+	struct tegra_rtcpu_trace *tracer = container_of(ref,
+				struct tegra_rtcpu_trace, ref);
+
+	kfree(tracer);
+}
+
+static int rtcpu_trace_raw_open(struct inode *inode, struct file *file)
+{
+	struct tegra_rtcpu_trace *tracer = container_of(file->private_data,
+				struct tegra_rtcpu_trace, raw_misc);
+	struct camrtc_trace_raw_header *raw;
+	size_t data_offset = ALIGN(sizeof(*raw), CAMRTC_TRACE_EVENT_SIZE);
+	size_t size;
+	int ret = 0;
+
+	size = PAGE_ALIGN(data_offset +
+		(size_t)tracer->raw_entries * CAMRTC_TRACE_EVENT_SIZE);
+
+	raw = vmalloc_user(size);
+	if (raw == NULL)
+		return -ENOMEM;
+
+	raw->magic = CAMRTC_TRACE_RAW_MAGIC;
+	raw->version = CAMRTC_TRACE_RAW_VERSION;
+	raw->entry_size = CAMRTC_TRACE_EVENT_SIZE;
+	raw->entries = tracer->raw_entries;
+	raw->data_offset = data_offset;
+
+	mutex_lock(&tracer->lock);
+	if (tracer->raw != NULL) {
+		ret = -EBUSY;
+	} else {
+		tracer->raw = raw;
+		tracer->raw_data = (void *)raw + data_offset;
+		tracer->raw_size = size;
+		tracer->raw_write_idx = 0;
+		tracer->raw_dropped = 0;
+	}
+	mutex_unlock(&tracer->lock);
+
+	if (ret) {
+		vfree(raw);
+		return ret;
+	}
+
+	/*
+	 * misc_open() calls us under misc_mtx, so the tracer can't be
+	 * destroyed before this reference is taken.
+	 */
+	kref_get(&tracer->ref);
+	file->private_data = tracer;
+
+	return nonseekable_open(inode, file);
+}
+
+static int rtcpu_trace_raw_release(struct inode *inode, struct file *file)
+{
+	struct tegra_rtcpu_trace *tracer = file->private_data;
+	struct camrtc_trace_raw_header *raw;
+
+	mutex_lock(&tracer->lock);
+	raw = tracer->raw;
+	tracer->raw = NULL;
+	mutex_unlock(&tracer->lock);
+
+	vfree(raw);
+	kref_put(&tracer->ref, rtcpu_trace_free);
+
+	return 0;
+}
+
+static int rtcpu_trace_raw_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct tegra_rtcpu_trace *tracer = file->private_data;
+
+	if (vma->vm_end - vma->vm_start > tracer->raw_size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, tracer->raw, vma->vm_pgoff);
+}
+
+static __poll_t rtcpu_trace_raw_poll(struct file *file, poll_table *wait)
+{
+	struct tegra_rtcpu_trace *tracer = file->private_data;
+	struct camrtc_trace_raw_header *raw = tracer->raw;
+
+	poll_wait(file, &tracer->raw_wq, wait);
+
+	if (READ_ONCE(tracer->raw_write_idx) != READ_ONCE(raw->read_idx))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations rtcpu_trace_raw_fops = {
+	.owner = THIS_MODULE,
+	.open = rtcpu_trace_raw_open,
+	.release = rtcpu_trace_raw_release,
+	.mmap = rtcpu_trace_raw_mmap,
+	.poll = rtcpu_trace_raw_poll,
+	.llseek = no_llseek,
+};
+
+static void rtcpu_trace_raw_init(struct tegra_rtcpu_trace *tracer)
+{
+	u32 entries = RAW_RING_ENTRIES_DEFAULT;
+	int ret;
+
+	init_waitqueue_head(&tracer->raw_wq);
+
+	of_property_read_u32(tracer->of_node, NV(raw-ring-entries), &entries);
+	if (entries < tracer->event_entries)
+		entries = tracer->event_entries;
+	tracer->raw_entries = roundup_pow_of_two(entries);
+
+	tracer->raw_misc.minor = MISC_DYNAMIC_MINOR;
+	tracer->raw_misc.name = "camrtc-trace";
+	tracer->raw_misc.fops = &rtcpu_trace_raw_fops;
+	tracer->raw_misc.parent = tracer->dev;
+
+	ret = misc_register(&tracer->raw_misc);
+	if (ret) {
+		dev_warn(tracer->dev, "raw trace device not available: %d\n",
+			ret);
+		return;
+	}
+
+	tracer->raw_misc_registered = true;
+}
+
+static void rtcpu_trace_raw_deinit(struct tegra_rtcpu_trace *tracer)
+{
+	if (tracer->raw_misc_registered)
+		misc_deregister(&tracer->raw_misc);
+}
+
 /*
  * Debugfs
  */
@@ -1274,6 +1522,13 @@ static int rtcpu_trace_debugfs_stats_read(
 
 	seq_printf(file, "Exceptions: %u\nEvents: %llu\n",
 			tracer->n_exceptions, tracer->n_events);
+	seq_printf(file, "Notifications: %llu\nRaw batches: %llu\n",
+			tracer->n_notify, tracer->n_raw_batches);
+
+	mutex_lock(&tracer->lock);
+	if (tracer->raw != NULL)
+		seq_printf(file, "Raw dropped: %llu\n", tracer->raw_dropped);
+	mutex_unlock(&tracer->lock);
 
 	return 0;
 }
@@ -1390,6 +1645,7 @@ struct tegra_rtcpu_trace *tegra_rtcpu_trace_create(struct device *dev,
 	if (unlikely(tracer == NULL))
 		return NULL;
 
+	kref_init(&tracer->ref);
 	tracer->dev = dev;
 	mutex_init(&tracer->lock);
 
@@ -1452,6 +1708,8 @@ struct tegra_rtcpu_trace *tegra_rtcpu_trace_create(struct device *dev,
 	INIT_DELAYED_WORK(&tracer->work, rtcpu_trace_worker);
 	tracer->work_interval_jiffies = msecs_to_jiffies(param);
 
+	rtcpu_trace_raw_init(tracer);
+
 	/* Done with initialization */
 	schedule_delayed_work(&tracer->work, 0);
 
@@ -1487,12 +1745,14 @@ void tegra_rtcpu_trace_destroy(struct tegra_rtcpu_trace *tracer)
 	platform_device_put(tracer->vi_platform_device);
 	platform_device_put(tracer->vi1_platform_device);
 	of_node_put(tracer->of_node);
+	rtcpu_trace_raw_deinit(tracer);
 	cancel_delayed_work_sync(&tracer->work);
 	flush_delayed_work(&tracer->work);
 	rtcpu_trace_debugfs_deinit(tracer);
 	dma_free_coherent(tracer->dev, tracer->trace_memory_size,
 			tracer->trace_memory, tracer->dma_handle);
-	kfree(tracer);
+	/* an open raw consumer keeps the tracer until it is closed */
+	kref_put(&tracer->ref, rtcpu_trace_free);
 }
 EXPORT_SYMBOL(tegra_rtcpu_trace_destroy);
 
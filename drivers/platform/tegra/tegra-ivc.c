@@ -693,6 +693,181 @@ int tegra_ivc_write_advance(struct ivc *ivc)
 }
 EXPORT_SYMBOL(tegra_ivc_write_advance);
 
+/*
+ * Batched frame access.
+ *
+ * The functions below let a caller work on several frames in place and then
+ * publish or release them with a single counter update, so that the peer is
+ * notified at most once per batch instead of once per frame. Notifications
+ * are still only sent on the empty to non-empty (tx) and full to non-full
+ * (rx) transitions.
+ */
+static inline uint32_t ivc_pos_add(struct ivc *ivc, uint32_t pos, uint32_t n)
+{
+	pos += n;
+	if (pos >= ivc->nframes)
+		pos -= ivc->nframes;
+
+	return pos;
+}
+
+/* number of filled rx frames, treating an over-full channel as empty */
+static inline uint32_t ivc_rx_frames_filled(struct ivc *ivc)
+{
+	if (ivc_channel_empty(ivc, ivc->rx_channel))
+		return 0;
+
+	return ivc_channel_avail_count(ivc, ivc->rx_channel);
+}
+
+/* get the idx-th frame after the next frame to be tx'ed, if it is free */
+void *tegra_ivc_write_get_frame(struct ivc *ivc, uint32_t idx)
+{
+	int result = ivc_check_write(ivc);
+	if (result)
+		return ERR_PTR(result);
+
+	if (idx >= ivc->nframes - ivc_channel_avail_count(ivc, ivc->tx_channel)) {
+		ivc_invalidate_counter(ivc, ivc->tx_handle +
+				offsetof(struct ivc_channel_header, r_count));
+		if (idx >= ivc->nframes -
+				ivc_channel_avail_count(ivc, ivc->tx_channel))
+			return ERR_PTR(-ENOMEM);
+	}
+
+	return ivc_frame_pointer(ivc, ivc->tx_channel,
+			ivc_pos_add(ivc, ivc->w_pos, idx));
+}
+EXPORT_SYMBOL(tegra_ivc_write_get_frame);
+
+/* advance the tx buffer by count frames, with a single notification */
+int tegra_ivc_write_advance_n(struct ivc *ivc, uint32_t count)
+{
+	uint32_t i, avail;
+	int result;
+
+	if (count == 0)
+		return 0;
+
+	result = ivc_check_write(ivc);
+	if (result)
+		return result;
+
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+	avail = ivc_channel_avail_count(ivc, ivc->tx_channel);
+	if (avail > ivc->nframes || count > ivc->nframes - avail)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++)
+		ivc_flush_frame(ivc, ivc->tx_handle,
+				ivc_pos_add(ivc, ivc->w_pos, i), 0,
+				ivc->frame_size);
+
+	/*
+	 * Order any possible stores to the frames before update of w_pos.
+	 */
+	ivc_wmb();
+
+	WRITE_ONCE(ivc->tx_channel->w_count,
+			READ_ONCE(ivc->tx_channel->w_count) + count);
+	ivc->w_pos = ivc_pos_add(ivc, ivc->w_pos, count);
+	ivc_flush_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+
+	/*
+	 * Ensure our write to w_pos occurs before our read from r_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only if the channel was empty before this batch. The
+	 * available count can only asynchronously decrease, so the worst
+	 * possible side-effect will be a spurious notification.
+	 */
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+		offsetof(struct ivc_channel_header, r_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->tx_channel) == count)
+		ivc->notify(ivc);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_write_advance_n);
+
+/* get the idx-th frame after the next frame to be rx'ed, if it is filled */
+void *tegra_ivc_read_get_frame(struct ivc *ivc, uint32_t idx)
+{
+	uint32_t pos;
+	int result = ivc_check_read(ivc);
+	if (result)
+		return ERR_PTR(result);
+
+	if (idx >= ivc_rx_frames_filled(ivc)) {
+		ivc_invalidate_counter(ivc, ivc->rx_handle +
+				offsetof(struct ivc_channel_header, w_count));
+		if (idx >= ivc_rx_frames_filled(ivc))
+			return ERR_PTR(-ENOMEM);
+	}
+
+	/*
+	 * Order observation of w_pos potentially indicating new data before
+	 * data read.
+	 */
+	ivc_rmb();
+
+	pos = ivc_pos_add(ivc, ivc->r_pos, idx);
+	ivc_invalidate_frame(ivc, ivc->rx_handle, pos, 0, ivc->frame_size);
+	return ivc_frame_pointer(ivc, ivc->rx_channel, pos);
+}
+EXPORT_SYMBOL(tegra_ivc_read_get_frame);
+
+/* release count rx'ed frames, with a single notification */
+int tegra_ivc_read_advance_n(struct ivc *ivc, uint32_t count)
+{
+	int result;
+
+	if (count == 0)
+		return 0;
+
+	/*
+	 * As for tegra_ivc_read_advance(), the caller is expected to have
+	 * observed the frames being released already.
+	 */
+	result = ivc_check_read(ivc);
+	if (result)
+		return result;
+
+	if (count > ivc_rx_frames_filled(ivc))
+		return -ENOMEM;
+
+	WRITE_ONCE(ivc->rx_channel->r_count,
+			READ_ONCE(ivc->rx_channel->r_count) + count);
+	ivc->r_pos = ivc_pos_add(ivc, ivc->r_pos, count);
+
+	ivc_flush_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+
+	/*
+	 * Ensure our write to r_pos occurs before our read from w_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only if the channel was full before this batch. The
+	 * available count can only asynchronously increase, so the worst
+	 * possible side-effect will be a spurious notification.
+	 */
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+		offsetof(struct ivc_channel_header, w_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->rx_channel) == ivc->nframes - count)
+		ivc->notify(ivc);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_read_advance_n);
+
 void tegra_ivc_channel_reset(struct ivc *ivc)
 {
 	ivc->tx_channel->state = ivc_state_sync;
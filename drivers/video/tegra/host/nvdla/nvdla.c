@@ -40,6 +40,7 @@
 #include "dla_queue.h"
 #include "nvdla_buffer.h"
 #include "nvdla_debug.h"
+#include "nvdla_emu.h"
 #include "dla_os_interface.h"
 
 #if (IS_ENABLED(CONFIG_TEGRA_HSIERRRPTINJ))
@@ -1121,6 +1122,7 @@ static int nvdla_probe(struct platform_device *pdev)
 	pdata->private_data = nvdla_dev;
 	platform_set_drvdata(pdev, pdata);
 	nvdla_dev->dbg_mask = debug_err;
+	nvdla_dev->emu_latency_us = NVDLA_EMU_LATENCY_US_DEFAULT;
 
 	err = nvhost_client_device_get_resources(pdev);
 	if (err)
@@ -1153,6 +1155,12 @@ static int nvdla_probe(struct platform_device *pdev)
 		goto err_queue_init;
 	}
 
+	nvdla_dev->emu = nvdla_emu_init(pdev);
+	if (IS_ERR(nvdla_dev->emu)) {
+		err = PTR_ERR(nvdla_dev->emu);
+		goto err_emu_init;
+	}
+
 	/* init reset handler workqueue */
 	nvdla_reset_handler_init(nvdla_dev);
 
@@ -1247,6 +1255,8 @@ err_alloc_utilization_rate_mem:
 err_alloc_cmd_mem:
 	nvhost_syncpt_unit_interface_deinit(pdev);
 err_mss_init:
+	nvdla_emu_deinit(nvdla_dev->emu);
+err_emu_init:
 	nvdla_queue_deinit(nvdla_dev->pool);
 err_queue_init:
 	nvhost_client_device_release(pdev);
@@ -1296,6 +1306,7 @@ static int __exit nvdla_remove(struct platform_device *pdev)
 #endif /* CONFIG_TEGRA_HSIERRRPTINJ */
 
 	nvhost_syncpt_unit_interface_deinit(pdev);
+	nvdla_emu_deinit(nvdla_dev->emu);
 	nvdla_queue_deinit(nvdla_dev->pool);
 	nvhost_client_device_release(pdev);
 	nvhost_module_deinit(pdev);
@@ -249,9 +249,12 @@ struct nvdla_cmd_data {
 
 enum nvdla_submit_mode {
 	NVDLA_SUBMIT_MODE_MMIO		= 0,
-	NVDLA_SUBMIT_MODE_CHANNEL	= 1
+	NVDLA_SUBMIT_MODE_CHANNEL	= 1,
+	NVDLA_SUBMIT_MODE_EMULATE	= 2
 };
 
+#define NVDLA_EMU_LATENCY_US_DEFAULT	1000
+
 /**
  * data structure to keep per DLA engine device data
  *
@@ -279,6 +282,8 @@ enum nvdla_submit_mode {
  * @window_mem_va       virtual address of window size buffer
  * @is_suspended	flag to check if module is in suspend state.
  * @ping_lock	lock to synchronize the ping operation requests.
+ * @emu			software engine used in NVDLA_SUBMIT_MODE_EMULATE
+ * @emu_latency_us	execution time of each emulated task
  */
 struct nvdla_device {
 	struct device *dev;
@@ -312,8 +317,15 @@ struct nvdla_device {
 	bool is_suspended;
 #endif
 	struct mutex ping_lock;
+	struct nvdla_emu_engine *emu;
+	u32 emu_latency_us;
 };
 
+static inline bool nvdla_is_emulated(struct nvdla_device *nvdla_dev)
+{
+	return nvdla_dev->submit_mode == NVDLA_SUBMIT_MODE_EMULATE;
+}
+
 /**
  * struct nvdla_emu_task:	structure for emulator task info
  *
@@ -351,6 +363,10 @@ struct nvdla_emu_task {
  * @buf_size		Total size of task dma alloc
  * @timeout		max timeout to wait for task completion
  * @op_handle		pointer to handle list of operation descriptor
+ * @addr_keys		sorted address list handles pinned for the task
+ * @num_addr_keys	number of valid entries in addr_keys
+ * @emulated		task runs on the software engine, fixed once its
+ *			signal fences are computed
  *
  */
 struct nvdla_task {
@@ -364,6 +380,8 @@ struct nvdla_task {
 	struct nvdla_mem_handle sof_timestamps[MAX_NVDLA_OUT_TIMESTAMPS_PER_TASK];
 	struct nvdla_mem_handle eof_timestamps[MAX_NVDLA_OUT_TIMESTAMPS_PER_TASK];
 	struct nvdla_mem_handle memory_handles[MAX_NVDLA_BUFFERS_PER_TASK];
+	u64 addr_keys[MAX_NVDLA_BUFFERS_PER_TASK];
+	u32 num_addr_keys;
 	u8 num_prefences;
 	u8 num_postfences;
 	u8 num_in_task_status;
@@ -381,6 +399,7 @@ struct nvdla_task {
 	size_t buf_size;
 	int timeout;
 	int pool_index;
+	bool emulated;
 
 	struct dma_buf *memory_dmabuf[MAX_NVDLA_BUFFERS_PER_TASK];
 	struct dma_buf *prefences_sem_dmabuf[MAX_NVDLA_PREFENCES_PER_TASK];
@@ -502,6 +521,7 @@ int nvdla_get_cmd_memory(struct platform_device *pdev,
 				struct nvdla_cmd_mem_info *cmd_mem_info);
 int nvdla_put_cmd_memory(struct platform_device *pdev, int index);
 int nvdla_set_queue_state(struct nvdla_queue *queue, int cmd);
+bool nvdla_queue_is_emulated(struct nvdla_queue *queue);
 int nvdla_get_task_mem(struct nvdla_queue *queue,
 				struct nvdla_task **task);
 void nvdla_put_task_mem(struct nvdla_task *task);
@@ -511,6 +531,7 @@ int nvdla_free_gcov_region(struct platform_device *pdev, bool update_region);
 
 int nvdla_emulator_submit(struct nvdla_queue *queue,
 				struct nvdla_emu_task *task);
+void nvdla_task_emu_complete(struct nvdla_task *task, u64 exec_ns);
 void task_free(struct kref *ref);
 int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task);
 
@@ -11,6 +11,8 @@
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/dma-buf.h>
+#include <linux/hash.h>
+#include <linux/sort.h>
 
 #include "nvdla_buffer.h"
 
@@ -73,6 +75,22 @@ static struct nvdla_vm_buffer *nvdla_find_map_buffer(
 	return NULL;
 }
 
+static struct nvdla_vm_buffer *nvdla_find_map_buffer_cached(
+		struct nvdla_buffers *nvdla_buffers, u32 handle)
+{
+	u32 slot = hash_32(handle, NVDLA_BUFFERS_HOT_BITS);
+	struct nvdla_vm_buffer *vm = nvdla_buffers->hot[slot];
+
+	if (vm && vm->handle == handle)
+		return vm;
+
+	vm = nvdla_find_map_buffer(nvdla_buffers, handle);
+	if (vm)
+		nvdla_buffers->hot[slot] = vm;
+
+	return vm;
+}
+
 static void nvdla_buffer_insert_map_buffer(
 				struct nvdla_buffers *nvdla_buffers,
 				struct nvdla_vm_buffer *new_vm)
@@ -197,6 +215,9 @@ static void nvdla_buffer_unmap(struct nvdla_buffers *nvdla_buffers,
 	dma_buf_detach(vm->dmabuf, vm->attach);
 	dma_buf_put(vm->dmabuf);
 
+	if (nvdla_buffers->hot[hash_32(vm->handle, NVDLA_BUFFERS_HOT_BITS)] == vm)
+		nvdla_buffers->hot[hash_32(vm->handle, NVDLA_BUFFERS_HOT_BITS)] = NULL;
+
 	rb_erase(&vm->rb_node, &nvdla_buffers->rb_root);
 	list_del(&vm->list_head);
 
@@ -251,7 +272,7 @@ int nvdla_buffer_submit_pin(struct nvdla_buffers *nvdla_buffers,
 	mutex_lock(&nvdla_buffers->mutex);
 
 	for (i = 0; i < count; i++) {
-		vm = nvdla_find_map_buffer(nvdla_buffers, handles[i]);
+		vm = nvdla_find_map_buffer_cached(nvdla_buffers, handles[i]);
 		if (vm == NULL)
 			goto submit_err;
 
@@ -278,6 +299,93 @@ submit_err:
 	return -EINVAL;
 }
 
+static int nvdla_buffer_key_cmp(const void *a, const void *b)
+{
+	u64 ka = *(const u64 *)a;
+	u64 kb = *(const u64 *)b;
+
+	return ka < kb ? -1 : ka > kb;
+}
+
+/* Drop the submit references of the first count sorted keys */
+static void nvdla_buffer_submit_unpin_keys_locked(
+		struct nvdla_buffers *nvdla_buffers, const u64 *keys, u32 count)
+{
+	struct nvdla_vm_buffer *vm;
+	u32 i = 0, run;
+
+	while (i < count) {
+		u32 handle = NVDLA_BUFFER_KEY_HANDLE(keys[i]);
+
+		for (run = 1; i + run < count; run++)
+			if (NVDLA_BUFFER_KEY_HANDLE(keys[i + run]) != handle)
+				break;
+		i += run;
+
+		vm = nvdla_find_map_buffer_cached(nvdla_buffers, handle);
+		if (vm == NULL)
+			continue;
+
+		vm->submit_map_count -= run;
+		if (vm->submit_map_count < 0)
+			vm->submit_map_count = 0;
+		nvdla_buffer_unmap(nvdla_buffers, vm);
+	}
+}
+
+int nvdla_buffer_submit_pin_batch(struct nvdla_buffers *nvdla_buffers,
+				  u64 *keys, u32 count, u64 *paddr)
+{
+	struct nvdla_vm_buffer *vm;
+	u32 i = 0, j, run;
+
+	sort(keys, count, sizeof(*keys), nvdla_buffer_key_cmp, NULL);
+
+	kref_get(&nvdla_buffers->kref);
+
+	mutex_lock(&nvdla_buffers->mutex);
+
+	while (i < count) {
+		u32 handle = NVDLA_BUFFER_KEY_HANDLE(keys[i]);
+
+		for (run = 1; i + run < count; run++)
+			if (NVDLA_BUFFER_KEY_HANDLE(keys[i + run]) != handle)
+				break;
+
+		vm = nvdla_find_map_buffer_cached(nvdla_buffers, handle);
+		if (vm == NULL)
+			goto submit_err;
+
+		vm->submit_map_count += run;
+		for (j = i; j < i + run; j++)
+			paddr[NVDLA_BUFFER_KEY_INDEX(keys[j])] = vm->addr;
+
+		i += run;
+	}
+	spec_bar(); /* break_spec_p#5_1 */
+
+	mutex_unlock(&nvdla_buffers->mutex);
+	return 0;
+
+submit_err:
+	nvdla_buffer_submit_unpin_keys_locked(nvdla_buffers, keys, i);
+	mutex_unlock(&nvdla_buffers->mutex);
+
+	kref_put(&nvdla_buffers->kref, nvdla_free_buffers);
+
+	return -EINVAL;
+}
+
+void nvdla_buffer_submit_unpin_batch(struct nvdla_buffers *nvdla_buffers,
+				     const u64 *keys, u32 count)
+{
+	mutex_lock(&nvdla_buffers->mutex);
+	nvdla_buffer_submit_unpin_keys_locked(nvdla_buffers, keys, count);
+	mutex_unlock(&nvdla_buffers->mutex);
+
+	kref_put(&nvdla_buffers->kref, nvdla_free_buffers);
+}
+
 int nvdla_buffer_pin(struct nvdla_buffers *nvdla_buffers,
 			struct nvdla_mem_share_handle *descs,
 			u32 count)
@@ -334,7 +442,7 @@ void nvdla_buffer_submit_unpin(struct nvdla_buffers *nvdla_buffers,
 
 	for (i = 0; i < count; i++) {
 
-		vm = nvdla_find_map_buffer(nvdla_buffers, handles[i]);
+		vm = nvdla_find_map_buffer_cached(nvdla_buffers, handles[i]);
 		if (vm == NULL)
 			continue;
 
@@ -15,6 +15,17 @@ enum nvdla_buffers_heap {
 	NVDLA_BUFFERS_HEAP_DRAM = 0,
 };
 
+/* Recently pinned handles looked up without walking the tree */
+#define NVDLA_BUFFERS_HOT_BITS		6
+#define NVDLA_BUFFERS_HOT_SLOTS		(1U << NVDLA_BUFFERS_HOT_BITS)
+
+/* Batch pin key: memhandle in the upper word, caller index in the lower */
+#define NVDLA_BUFFER_KEY(handle, index)	(((u64)(handle) << 32) | (u32)(index))
+#define NVDLA_BUFFER_KEY_HANDLE(key)	((u32)((key) >> 32))
+#define NVDLA_BUFFER_KEY_INDEX(key)	((u32)(key))
+
+struct nvdla_vm_buffer;
+
 /**
  * @brief		Information needed for buffers
  *
@@ -23,6 +34,7 @@ enum nvdla_buffers_heap {
  * list			List for traversing through all the buffers
  * mutex		Mutex for the buffer tree and the buffer list
  * kref			Reference count for the bufferlist
+ * hot			Direct mapped cache of recently submitted buffers
  *
  */
 struct nvdla_buffers {
@@ -33,6 +45,8 @@ struct nvdla_buffers {
 	struct mutex mutex;
 
 	struct kref kref;
+
+	struct nvdla_vm_buffer *hot[NVDLA_BUFFERS_HOT_SLOTS];
 };
 
 /**
@@ -136,6 +150,38 @@ int nvdla_buffer_submit_pin(struct nvdla_buffers *nvdla_buffers,
 void nvdla_buffer_submit_unpin(struct nvdla_buffers *nvdla_buffers,
 					u32 *handles, u32 count);
 
+/**
+ * @brief			Pin a list of buffers for a task submit
+ *
+ * Same as nvdla_buffer_submit_pin() for a whole list under a single lock.
+ * The keys are sorted in place so that repeated handles are looked up once;
+ * keep them for nvdla_buffer_submit_unpin_batch(). Either all entries are
+ * pinned or none.
+ *
+ * @param nvdla_buffers		Pointer to nvdla_buffer struct
+ * @param keys			NVDLA_BUFFER_KEY() list, sorted on return
+ * @param count			Number of keys in the list
+ * @param paddr			IOVA list, paddr[index] is filled for the
+ *				index carried by each key
+ *
+ * @return			0 on success or negative on error
+ *
+ */
+int nvdla_buffer_submit_pin_batch(struct nvdla_buffers *nvdla_buffers,
+				  u64 *keys, u32 count, u64 *paddr);
+
+/**
+ * @brief			UnPin a list pinned by nvdla_buffer_submit_pin_batch
+ *
+ * @param nvdla_buffers		Pointer to nvdla_buffer struct
+ * @param keys			Sorted key list returned by the pin call
+ * @param count			Number of keys in the list
+ * @return			None
+ *
+ */
+void nvdla_buffer_submit_unpin_batch(struct nvdla_buffers *nvdla_buffers,
+				     const u64 *keys, u32 count);
+
 /**
  * @brief			Drop a user reference to buffer structure
  *
@@ -1191,6 +1191,9 @@ void nvdla_debug_init(struct platform_device *pdev)
 	nvdla_dev->submit_mode = nvdla_dev->submit_mode &&
 				pdata->isolate_contexts;
 
+	debugfs_create_u32("emu_latency_us", S_IRUGO | S_IWUSR, de,
+			&nvdla_dev->emu_latency_us);
+
 #if (IS_ENABLED(CONFIG_TEGRA_HSIERRRPTINJ))
 	nvdla_err_inj_debugfs_init(pdev);
 #endif /* CONFIG_TEGRA_HSIERRRPTINJ */
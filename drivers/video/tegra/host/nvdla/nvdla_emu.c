@@ -0,0 +1,617 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2023, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVDLA software engine for NVDLA_SUBMIT_MODE_EMULATE
+ */
+
+#include <linux/dma-fence.h>
+#include <linux/file.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/nvhost.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/sync_file.h>
+#include <linux/workqueue.h>
+
+#include "nvdla.h"
+#include "dla_queue.h"
+#include "nvdla_debug.h"
+#include "nvdla_emu.h"
+
+/* how often tasks blocked on prefences are re-evaluated */
+#define NVDLA_EMU_POLL_US	100
+
+/**
+ * struct nvdla_emu_syncpt:	software syncpoint of an emulated queue
+ *
+ * @id			host1x syncpoint of the queue, names this one in the
+ *			fences handed to userspace, 0 while unused
+ * @min			value reached by retired tasks
+ * @max			value reserved by submitted tasks
+ * @waiters		notifiers waiting for a threshold
+ * @fences		sync file fences waiting for a threshold
+ */
+struct nvdla_emu_syncpt {
+	u32 id;
+	u32 min;
+	u32 max;
+	struct list_head waiters;
+	struct list_head fences;
+};
+
+/**
+ * struct nvdla_emu_waiter:	counterpart of an nvhost interrupt notifier
+ *
+ * @list		entry in the syncpoint waiters, then in the engine
+ *			notified list
+ * @thresh		syncpoint value to wait for
+ * @notify		callback, run from the engine notify work
+ * @priv		callback argument
+ */
+struct nvdla_emu_waiter {
+	struct list_head list;
+	u32 thresh;
+	void (*notify)(void *priv);
+	void *priv;
+};
+
+/**
+ * struct nvdla_emu_fence:	dma_fence backing an emulated sync file
+ *
+ * @base		fence
+ * @lock		fence lock, a sync file may outlive the engine
+ * @list		entry in the syncpoint fences, holds a reference
+ * @sp			syncpoint the fence waits on
+ * @thresh		syncpoint value to wait for
+ */
+struct nvdla_emu_fence {
+	struct dma_fence base;
+	spinlock_t lock;
+	struct list_head list;
+	struct nvdla_emu_syncpt *sp;
+	u32 thresh;
+};
+
+/**
+ * struct nvdla_emu_job:	task waiting in or executing on the engine
+ *
+ * @list		entry in the engine job list
+ * @task		task, a reference is held until the job retires
+ * @queue_id		queue the task was submitted on
+ * @start_ns		time execution started, 0 while waiting
+ */
+struct nvdla_emu_job {
+	struct list_head list;
+	struct nvdla_task *task;
+	u32 queue_id;
+	u64 start_ns;
+};
+
+/**
+ * struct nvdla_emu_engine:	software DLA engine
+ *
+ * @pdev		DLA platform device
+ * @retire_lock		held by the scheduler from picking a job until it
+ *			retired, so a flush never runs alongside a retire
+ * @lock		protects jobs and cur
+ * @jobs		submitted jobs in submission order
+ * @cur			job executing, the engine runs one task at a time
+ * @suspended		queues suspended through DLA_CMD_QUEUE_SUSPEND
+ * @work		engine scheduler
+ * @syncpt_lock		protects the syncpoints and the notified list
+ * @syncpts		software syncpoint of each queue
+ * @fence_context	first dma_fence context, one per queue
+ * @notified		waiters whose threshold was reached
+ * @notify_work		runs the notified waiters
+ */
+struct nvdla_emu_engine {
+	struct platform_device *pdev;
+
+	struct mutex retire_lock;
+	struct mutex lock;
+	struct list_head jobs;
+	struct nvdla_emu_job *cur;
+	DECLARE_BITMAP(suspended, MAX_NVDLA_QUEUE_COUNT);
+	struct delayed_work work;
+
+	spinlock_t syncpt_lock;
+	struct nvdla_emu_syncpt syncpts[MAX_NVDLA_QUEUE_COUNT];
+	u64 fence_context;
+	struct list_head notified;
+	struct work_struct notify_work;
+};
+
+static inline bool nvdla_emu_expired(u32 min, u32 thresh)
+{
+	return (s32)(min - thresh) >= 0;
+}
+
+static struct nvdla_emu_fence *to_nvdla_emu_fence(struct dma_fence *f)
+{
+	return container_of(f, struct nvdla_emu_fence, base);
+}
+
+static const char *nvdla_emu_fence_get_driver_name(struct dma_fence *f)
+{
+	return "nvdla_emu";
+}
+
+static const char *nvdla_emu_fence_get_timeline_name(struct dma_fence *f)
+{
+	return "syncpoint";
+}
+
+static bool nvdla_emu_fence_signaled(struct dma_fence *f)
+{
+	struct nvdla_emu_fence *ef = to_nvdla_emu_fence(f);
+
+	return nvdla_emu_expired(READ_ONCE(ef->sp->min), ef->thresh);
+}
+
+/* Fences sit on their syncpoint from creation, signaling is always on */
+static const struct dma_fence_ops nvdla_emu_fence_ops = {
+	.get_driver_name = nvdla_emu_fence_get_driver_name,
+	.get_timeline_name = nvdla_emu_fence_get_timeline_name,
+	.signaled = nvdla_emu_fence_signaled,
+};
+
+/*
+ * Signal the fences and queue the notifiers a syncpoint reached. Notifiers
+ * run from a work, like nvhost ones run from the interrupt thread, since
+ * callers may hold the queue list_lock that nvdla_queue_update() takes.
+ */
+static void nvdla_emu_syncpt_update_locked(struct nvdla_emu_engine *emu,
+					   struct nvdla_emu_syncpt *sp)
+{
+	struct nvdla_emu_waiter *waiter, *wn;
+	struct nvdla_emu_fence *fence, *fn;
+
+	list_for_each_entry_safe(waiter, wn, &sp->waiters, list) {
+		if (nvdla_emu_expired(sp->min, waiter->thresh))
+			list_move_tail(&waiter->list, &emu->notified);
+	}
+
+	list_for_each_entry_safe(fence, fn, &sp->fences, list) {
+		if (!nvdla_emu_expired(sp->min, fence->thresh))
+			continue;
+
+		list_del(&fence->list);
+		dma_fence_signal(&fence->base);
+		dma_fence_put(&fence->base);
+	}
+
+	if (!list_empty(&emu->notified))
+		schedule_work(&emu->notify_work);
+}
+
+static void nvdla_emu_notify_worker(struct work_struct *work)
+{
+	struct nvdla_emu_engine *emu = container_of(work,
+				struct nvdla_emu_engine, notify_work);
+	struct nvdla_emu_waiter *waiter, *n;
+	unsigned long flags;
+	LIST_HEAD(notified);
+
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	list_splice_init(&emu->notified, &notified);
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+
+	list_for_each_entry_safe(waiter, n, &notified, list) {
+		list_del(&waiter->list);
+		waiter->notify(waiter->priv);
+		kfree(waiter);
+	}
+}
+
+u32 nvdla_emu_syncpt_incr_max(struct nvdla_emu_engine *emu,
+			      struct nvdla_queue *queue, u32 incrs)
+{
+	struct nvdla_emu_syncpt *sp = &emu->syncpts[queue->id];
+	unsigned long flags;
+	u32 max;
+
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	sp->id = queue->syncpt_id;
+	sp->max += incrs;
+	max = sp->max;
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+
+	return max;
+}
+
+u32 nvdla_emu_syncpt_read_max(struct nvdla_emu_engine *emu,
+			      struct nvdla_queue *queue)
+{
+	return READ_ONCE(emu->syncpts[queue->id].max);
+}
+
+bool nvdla_emu_syncpt_is_expired(struct nvdla_emu_engine *emu,
+				 struct nvdla_queue *queue, u32 thresh)
+{
+	return nvdla_emu_expired(READ_ONCE(emu->syncpts[queue->id].min),
+				 thresh);
+}
+
+static void nvdla_emu_syncpt_set_min(struct nvdla_emu_engine *emu,
+				     u32 queue_id, u32 val)
+{
+	struct nvdla_emu_syncpt *sp = &emu->syncpts[queue_id];
+	unsigned long flags;
+
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	/* never move back, an abort may have already released the queue */
+	if (!nvdla_emu_expired(sp->min, val))
+		WRITE_ONCE(sp->min, val);
+	nvdla_emu_syncpt_update_locked(emu, sp);
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+}
+
+void nvdla_emu_syncpt_reset(struct nvdla_emu_engine *emu,
+			    struct nvdla_queue *queue)
+{
+	nvdla_emu_syncpt_set_min(emu, queue->id,
+				 nvdla_emu_syncpt_read_max(emu, queue));
+}
+
+int nvdla_emu_register_notifier(struct nvdla_emu_engine *emu,
+				struct nvdla_queue *queue, u32 thresh,
+				void (*notify)(void *priv), void *priv)
+{
+	struct nvdla_emu_syncpt *sp = &emu->syncpts[queue->id];
+	struct nvdla_emu_waiter *waiter;
+	unsigned long flags;
+
+	waiter = kzalloc(sizeof(*waiter), GFP_KERNEL);
+	if (waiter == NULL)
+		return -ENOMEM;
+
+	waiter->thresh = thresh;
+	waiter->notify = notify;
+	waiter->priv = priv;
+
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	list_add_tail(&waiter->list, &sp->waiters);
+	nvdla_emu_syncpt_update_locked(emu, sp);
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+
+	return 0;
+}
+
+int nvdla_emu_fence_create_fd(struct nvdla_emu_engine *emu,
+			      struct nvdla_queue *queue, u32 thresh,
+			      s32 *fence_fd)
+{
+	struct nvdla_emu_syncpt *sp = &emu->syncpts[queue->id];
+	struct nvdla_emu_fence *fence;
+	struct sync_file *file;
+	unsigned long flags;
+	int fd;
+
+	fence = kzalloc(sizeof(*fence), GFP_KERNEL);
+	if (fence == NULL)
+		return -ENOMEM;
+
+	spin_lock_init(&fence->lock);
+	fence->sp = sp;
+	fence->thresh = thresh;
+	dma_fence_init(&fence->base, &nvdla_emu_fence_ops, &fence->lock,
+		       emu->fence_context + queue->id, thresh);
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		dma_fence_put(&fence->base);
+		return fd;
+	}
+
+	file = sync_file_create(&fence->base);
+	if (file == NULL) {
+		put_unused_fd(fd);
+		dma_fence_put(&fence->base);
+		return -ENOMEM;
+	}
+
+	/* the syncpoint list takes over the creation reference */
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	list_add_tail(&fence->list, &sp->fences);
+	nvdla_emu_syncpt_update_locked(emu, sp);
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+
+	fd_install(fd, file->file);
+	*fence_fd = fd;
+
+	return 0;
+}
+
+/* Prefences on an emulated queue are resolved on its software syncpoint */
+static bool nvdla_emu_prefence_expired(struct nvdla_emu_engine *emu,
+				       u32 id, u32 thresh)
+{
+	unsigned long flags;
+	bool found = false;
+	bool expired = false;
+	int i;
+
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	for (i = 0; i < MAX_NVDLA_QUEUE_COUNT; i++) {
+		if (id != 0 && emu->syncpts[i].id == id) {
+			expired = nvdla_emu_expired(emu->syncpts[i].min, thresh);
+			found = true;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+
+	if (found)
+		return expired;
+
+	return nvhost_syncpt_is_expired_ext(emu->pdev, id, thresh);
+}
+
+static bool nvdla_emu_prefences_done(struct nvdla_emu_engine *emu,
+				     struct nvdla_task *task)
+{
+	int i;
+
+	for (i = 0; i < task->num_prefences; i++) {
+		struct nvdev_fence *fence = &task->prefences[i];
+
+		/* Semaphore waits and resolved sync fds are not modelled */
+		if (fence->action != NVDEV_FENCE_WAIT ||
+		    fence->type != NVDEV_FENCE_TYPE_SYNCPT)
+			continue;
+
+		if (!nvdla_emu_prefence_expired(emu, fence->syncpoint_index,
+						fence->syncpoint_value))
+			return false;
+	}
+
+	return true;
+}
+
+/* First runnable job, keeping tasks of a queue in submission order */
+static struct nvdla_emu_job *nvdla_emu_pick(struct nvdla_emu_engine *emu)
+{
+	DECLARE_BITMAP(blocked, MAX_NVDLA_QUEUE_COUNT);
+	struct nvdla_emu_job *job;
+
+	bitmap_copy(blocked, emu->suspended, MAX_NVDLA_QUEUE_COUNT);
+
+	list_for_each_entry(job, &emu->jobs, list) {
+		if (test_bit(job->queue_id, blocked))
+			continue;
+
+		if (nvdla_emu_prefences_done(emu, job->task))
+			return job;
+
+		set_bit(job->queue_id, blocked);
+	}
+
+	return NULL;
+}
+
+static void nvdla_emu_retire(struct nvdla_emu_engine *emu,
+			     struct nvdla_emu_job *job, u64 exec_ns)
+{
+	struct nvdla_task *task = job->task;
+
+	nvdla_task_emu_complete(task, exec_ns);
+
+	/* Signal every fence of the task, the notifier frees it */
+	nvdla_emu_syncpt_set_min(emu, job->queue_id, task->fence);
+
+	nvdla_task_put(task);
+	kfree(job);
+}
+
+static void nvdla_emu_worker(struct work_struct *work)
+{
+	struct nvdla_emu_engine *emu = container_of(to_delayed_work(work),
+				struct nvdla_emu_engine, work);
+	struct nvhost_device_data *pdata = platform_get_drvdata(emu->pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+	u64 latency_ns = (u64)READ_ONCE(nvdla_dev->emu_latency_us) *
+				NSEC_PER_USEC;
+	struct nvdla_emu_job *done = NULL;
+	unsigned long delay = 0;
+	u64 now = ktime_get_ns();
+	u64 exec_ns = 0;
+
+	mutex_lock(&emu->retire_lock);
+	mutex_lock(&emu->lock);
+
+	if (emu->cur == NULL) {
+		emu->cur = nvdla_emu_pick(emu);
+		if (emu->cur)
+			emu->cur->start_ns = now;
+	}
+
+	if (emu->cur == NULL) {
+		/* idle, or everything waits on prefences */
+		if (!list_empty(&emu->jobs))
+			delay = usecs_to_jiffies(NVDLA_EMU_POLL_US);
+		else
+			delay = MAX_JIFFY_OFFSET;
+	} else if (now - emu->cur->start_ns >= latency_ns) {
+		done = emu->cur;
+		exec_ns = now - done->start_ns;
+		list_del(&done->list);
+		emu->cur = NULL;
+	} else {
+		delay = nsecs_to_jiffies(latency_ns -
+				(now - emu->cur->start_ns));
+	}
+
+	mutex_unlock(&emu->lock);
+
+	if (done)
+		nvdla_emu_retire(emu, done, exec_ns);
+
+	mutex_unlock(&emu->retire_lock);
+
+	if (delay != MAX_JIFFY_OFFSET)
+		mod_delayed_work(system_wq, &emu->work, delay);
+}
+
+int nvdla_emu_submit_task(struct nvdla_emu_engine *emu,
+			  struct nvdla_task *task)
+{
+	struct nvdla_emu_job *job;
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (job == NULL)
+		return -ENOMEM;
+
+	nvdla_task_get(task);
+	job->task = task;
+	job->queue_id = task->queue->id;
+
+	mutex_lock(&emu->lock);
+	list_add_tail(&job->list, &emu->jobs);
+	mutex_unlock(&emu->lock);
+
+	mod_delayed_work(system_wq, &emu->work, 0);
+
+	nvdla_dbg_info(emu->pdev, "emulated task[%p] queue[%u] fence[%u]",
+			task, job->queue_id, task->fence);
+
+	return 0;
+}
+
+/*
+ * Drop jobs of a queue without signalling, the caller resets the syncpoint
+ * with nvdla_emu_syncpt_reset().
+ * Waits for a retire in progress, so the syncpoint is final on return.
+ */
+static void nvdla_emu_flush_queue(struct nvdla_emu_engine *emu, u32 queue_id)
+{
+	struct nvdla_emu_job *job, *n;
+	LIST_HEAD(flushed);
+
+	mutex_lock(&emu->retire_lock);
+	mutex_lock(&emu->lock);
+	list_for_each_entry_safe(job, n, &emu->jobs, list) {
+		if (job->queue_id != queue_id)
+			continue;
+
+		if (emu->cur == job)
+			emu->cur = NULL;
+		list_move_tail(&job->list, &flushed);
+	}
+	mutex_unlock(&emu->lock);
+	mutex_unlock(&emu->retire_lock);
+
+	list_for_each_entry_safe(job, n, &flushed, list) {
+		nvdla_task_put(job->task);
+		kfree(job);
+	}
+}
+
+int nvdla_emu_send_cmd(struct nvdla_emu_engine *emu,
+		       struct nvdla_cmd_data *cmd_data)
+{
+	u32 cmd = cmd_data->method_id & DLA_METHOD_ID_CMD_MASK;
+	u32 queue_id = cmd_data->method_data;
+
+	switch (cmd) {
+	case DLA_CMD_QUEUE_SUSPEND:
+	case DLA_CMD_QUEUE_RESUME:
+	case DLA_CMD_QUEUE_FLUSH:
+		if (queue_id >= MAX_NVDLA_QUEUE_COUNT)
+			return -EINVAL;
+		break;
+	default:
+		/* no engine state to program */
+		return 0;
+	}
+
+	switch (cmd) {
+	case DLA_CMD_QUEUE_SUSPEND:
+		/* like the firmware, the task in flight still completes */
+		set_bit(queue_id, emu->suspended);
+		break;
+	case DLA_CMD_QUEUE_RESUME:
+		clear_bit(queue_id, emu->suspended);
+		mod_delayed_work(system_wq, &emu->work, 0);
+		break;
+	case DLA_CMD_QUEUE_FLUSH:
+		nvdla_emu_flush_queue(emu, queue_id);
+		mod_delayed_work(system_wq, &emu->work, 0);
+		break;
+	}
+
+	return 0;
+}
+
+struct nvdla_emu_engine *nvdla_emu_init(struct platform_device *pdev)
+{
+	struct nvdla_emu_engine *emu;
+	int i;
+
+	emu = kzalloc(sizeof(*emu), GFP_KERNEL);
+	if (emu == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	emu->pdev = pdev;
+	mutex_init(&emu->retire_lock);
+	mutex_init(&emu->lock);
+	INIT_LIST_HEAD(&emu->jobs);
+	INIT_DELAYED_WORK(&emu->work, nvdla_emu_worker);
+
+	spin_lock_init(&emu->syncpt_lock);
+	for (i = 0; i < MAX_NVDLA_QUEUE_COUNT; i++) {
+		INIT_LIST_HEAD(&emu->syncpts[i].waiters);
+		INIT_LIST_HEAD(&emu->syncpts[i].fences);
+	}
+	emu->fence_context = dma_fence_context_alloc(MAX_NVDLA_QUEUE_COUNT);
+	INIT_LIST_HEAD(&emu->notified);
+	INIT_WORK(&emu->notify_work, nvdla_emu_notify_worker);
+
+	return emu;
+}
+
+void nvdla_emu_deinit(struct nvdla_emu_engine *emu)
+{
+	struct nvdla_emu_job *job, *n;
+	struct nvdla_emu_waiter *waiter, *wn;
+	struct nvdla_emu_fence *fence, *fn;
+	struct nvdla_emu_syncpt *sp;
+	unsigned long flags;
+	int i;
+
+	if (IS_ERR_OR_NULL(emu))
+		return;
+
+	cancel_delayed_work_sync(&emu->work);
+	cancel_work_sync(&emu->notify_work);
+
+	list_for_each_entry_safe(job, n, &emu->jobs, list) {
+		nvdla_task_put(job->task);
+		kfree(job);
+	}
+
+	/* queues are gone, fail the sync files userspace may still hold */
+	spin_lock_irqsave(&emu->syncpt_lock, flags);
+	for (i = 0; i < MAX_NVDLA_QUEUE_COUNT; i++) {
+		sp = &emu->syncpts[i];
+
+		list_splice_init(&sp->waiters, &emu->notified);
+		list_for_each_entry_safe(fence, fn, &sp->fences, list) {
+			list_del(&fence->list);
+			dma_fence_set_error(&fence->base, -ENODEV);
+			dma_fence_signal(&fence->base);
+			dma_fence_put(&fence->base);
+		}
+	}
+	spin_unlock_irqrestore(&emu->syncpt_lock, flags);
+
+	list_for_each_entry_safe(waiter, wn, &emu->notified, list)
+		kfree(waiter);
+
+	mutex_destroy(&emu->lock);
+	mutex_destroy(&emu->retire_lock);
+	kfree(emu);
+}
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2023, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVDLA software engine for NVDLA_SUBMIT_MODE_EMULATE
+ *
+ * The engine stands in for the DLA falcon, and each queue gets a software
+ * syncpoint in place of its host1x one: task fences, completion notifiers
+ * and sync file postfences of emulated tasks never reach host1x. Probing
+ * the DLA device and allocating queues still go through nvhost.
+ *
+ * The PVA submit path is not covered, it has its own queue and syncpoint
+ * code and would need a backend of its own.
+ */
+
+#ifndef __NVHOST_NVDLA_EMU_H__
+#define __NVHOST_NVDLA_EMU_H__
+
+#include <linux/types.h>
+
+struct platform_device;
+struct nvdla_cmd_data;
+struct nvdla_emu_engine;
+struct nvdla_queue;
+struct nvdla_task;
+
+/**
+ * nvdla_emu_init() create the software engine of a DLA device
+ *
+ * @pdev	Pointer to DLA platform device
+ *
+ * Return	engine pointer or ERR_PTR on failure
+ */
+struct nvdla_emu_engine *nvdla_emu_init(struct platform_device *pdev);
+
+/**
+ * nvdla_emu_deinit() release the software engine and pending tasks
+ *
+ * @emu		Pointer to engine
+ */
+void nvdla_emu_deinit(struct nvdla_emu_engine *emu);
+
+/**
+ * nvdla_emu_submit_task() queue a filled task on the software engine
+ *
+ * @emu		Pointer to engine
+ * @task	Task with fence assigned and notifier registered
+ *
+ * Return	0 on success otherwise negative
+ *
+ * Tasks run one at a time for emu_latency_us once their syncpoint
+ * prefences expired, then the queue syncpoint is moved to the task fence.
+ */
+int nvdla_emu_submit_task(struct nvdla_emu_engine *emu,
+			  struct nvdla_task *task);
+
+/**
+ * nvdla_emu_send_cmd() software counterpart of nvdla_send_cmd()
+ *
+ * @emu		Pointer to engine
+ * @cmd_data	Command, queue suspend/resume/flush are handled
+ *
+ * Return	0 on success otherwise negative
+ */
+int nvdla_emu_send_cmd(struct nvdla_emu_engine *emu,
+		       struct nvdla_cmd_data *cmd_data);
+
+/**
+ * nvdla_emu_syncpt_incr_max() reserve values on a queue software syncpoint
+ *
+ * @emu		Pointer to engine
+ * @queue	Queue owning the syncpoint
+ * @incrs	Number of increments
+ *
+ * Return	new maximum, the fence of a task
+ */
+u32 nvdla_emu_syncpt_incr_max(struct nvdla_emu_engine *emu,
+			      struct nvdla_queue *queue, u32 incrs);
+
+/**
+ * nvdla_emu_syncpt_read_max() read the maximum of a queue software syncpoint
+ *
+ * @emu		Pointer to engine
+ * @queue	Queue owning the syncpoint
+ *
+ * Return	value the last submitted task signals
+ */
+u32 nvdla_emu_syncpt_read_max(struct nvdla_emu_engine *emu,
+			      struct nvdla_queue *queue);
+
+/**
+ * nvdla_emu_syncpt_is_expired() check a threshold of a queue software syncpoint
+ *
+ * @emu		Pointer to engine
+ * @queue	Queue owning the syncpoint
+ * @thresh	Value to check
+ *
+ * Return	true once retired tasks reached thresh
+ */
+bool nvdla_emu_syncpt_is_expired(struct nvdla_emu_engine *emu,
+				 struct nvdla_queue *queue, u32 thresh);
+
+/**
+ * nvdla_emu_syncpt_reset() move a queue software syncpoint to its maximum
+ *
+ * @emu		Pointer to engine
+ * @queue	Queue owning the syncpoint
+ *
+ * Releases the tasks of an aborted queue, like a host1x syncpoint reset.
+ */
+void nvdla_emu_syncpt_reset(struct nvdla_emu_engine *emu,
+			    struct nvdla_queue *queue);
+
+/**
+ * nvdla_emu_register_notifier() software counterpart of
+ *				 nvhost_intr_register_notifier()
+ *
+ * @emu		Pointer to engine
+ * @queue	Queue owning the syncpoint
+ * @thresh	Value to wait for
+ * @notify	Callback, run from a work once thresh is reached
+ * @priv	Callback argument
+ *
+ * Return	0 on success otherwise negative
+ */
+int nvdla_emu_register_notifier(struct nvdla_emu_engine *emu,
+				struct nvdla_queue *queue, u32 thresh,
+				void (*notify)(void *priv), void *priv);
+
+/**
+ * nvdla_emu_fence_create_fd() software counterpart of nvhost_fence_create_fd()
+ *
+ * @emu		Pointer to engine
+ * @queue	Queue owning the syncpoint
+ * @thresh	Value the fence signals at
+ * @fence_fd	Returned sync file descriptor
+ *
+ * Return	0 on success otherwise negative
+ */
+int nvdla_emu_fence_create_fd(struct nvdla_emu_engine *emu,
+			      struct nvdla_queue *queue, u32 thresh,
+			      s32 *fence_fd);
+
+#endif /* __NVHOST_NVDLA_EMU_H__ */
@@ -16,6 +16,7 @@
 #include "dla_queue.h"
 #include "nvdla_buffer.h"
 #include "nvdla_debug.h"
+#include "nvdla_emu.h"
 
 #include <uapi/linux/nvdev_fence.h>
 #include <uapi/linux/nvhost_ioctl.h>
@@ -114,6 +115,8 @@ static int nvdla_get_q_status(struct nvdla_private *priv, void *args)
 	struct nvdev_fence __user *usr_fence =
 		(struct nvdev_fence __user *)(uintptr_t)queue_arg->fence;
 	struct platform_device *pdev = priv->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	struct nvdla_queue *queue = priv->queue;
 	struct nvdev_fence fence = {0};
 	int err = 0;
@@ -127,8 +130,14 @@ static int nvdla_get_q_status(struct nvdla_private *priv, void *args)
 	}
 
 	fence.syncpoint_index = queue->syncpt_id;
-	fence.syncpoint_value = nvhost_syncpt_read_maxval(pdev,
+	mutex_lock(&queue->list_lock);
+	if (nvdla_queue_is_emulated(queue))
+		fence.syncpoint_value = nvdla_emu_syncpt_read_max(
+						nvdla_dev->emu, queue);
+	else
+		fence.syncpoint_value = nvhost_syncpt_read_maxval(pdev,
 						queue->syncpt_id);
+	mutex_unlock(&queue->list_lock);
 	nvdla_dbg_info(pdev, "syncpt_id[%u] val[%u]\n", fence.syncpoint_index, fence.syncpoint_value);
 
 	if (copy_to_user(usr_fence, &fence, sizeof(struct nvdev_fence))) {
@@ -521,6 +530,8 @@ static int nvdla_update_signal_fences(struct nvdla_task *task,
 	struct platform_device *dla_pdev = task->queue->pool->pdev;
 	struct platform_device *host_pdev =
 				to_platform_device(dla_pdev->dev.parent);
+	struct nvhost_device_data *pdata = platform_get_drvdata(dla_pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	struct nvdev_fence __user *prefences =
 		(struct nvdev_fence __user *)(uintptr_t)user_task->prefences;
 	struct nvdev_fence __user *postfences =
@@ -554,9 +565,14 @@ static int nvdla_update_signal_fences(struct nvdla_task *task,
 				goto fail;
 			}
 
-			err = nvhost_fence_create_fd(host_pdev,
-				&info, 1, fence_name,
-				&task->prefences[i].sync_fd);
+			if (task->emulated)
+				err = nvdla_emu_fence_create_fd(nvdla_dev->emu,
+					task->queue, info.thresh,
+					&task->prefences[i].sync_fd);
+			else
+				err = nvhost_fence_create_fd(host_pdev,
+					&info, 1, fence_name,
+					&task->prefences[i].sync_fd);
 
 			if (err) {
 				nvdla_dbg_err(dla_pdev,
@@ -601,9 +617,14 @@ static int nvdla_update_signal_fences(struct nvdla_task *task,
 				goto fail;
 			}
 
-			err = nvhost_fence_create_fd(host_pdev,
-				&info, 1, fence_name,
-				&task->postfences[i].sync_fd);
+			if (task->emulated)
+				err = nvdla_emu_fence_create_fd(nvdla_dev->emu,
+					task->queue, info.thresh,
+					&task->postfences[i].sync_fd);
+			else
+				err = nvhost_fence_create_fd(host_pdev,
+					&info, 1, fence_name,
+					&task->postfences[i].sync_fd);
 
 			if (err) {
 				nvdla_dbg_err(dla_pdev,
@@ -20,6 +20,7 @@
 #include "dla_channel.h"
 #include "dla_queue.h"
 #include "nvdla_debug.h"
+#include "nvdla_emu.h"
 #include "dla_os_interface.h"
 
 #define CREATE_TRACE_POINTS
@@ -171,16 +172,10 @@ static int nvdla_unmap_task_memory(struct nvdla_task *task)
 	nvdla_dbg_fn(pdev, "task:[%p]", task);
 
 	/* unpin address list */
-	for (ii = 0; ii < task->num_addresses; ii++) {
-		if (task->memory_handles[ii].type ==
-				NVDLA_BUFFER_TYPE_INTERNAL) {
-			/* No unpinning required for internal buffers */
-			continue;
-		}
-		if (task->memory_handles[ii].handle) {
-			nvdla_buffer_submit_unpin(task->buffers,
-				&task->memory_handles[ii].handle, 1);
-		}
+	if (task->num_addr_keys) {
+		nvdla_buffer_submit_unpin_batch(task->buffers,
+				task->addr_keys, task->num_addr_keys);
+		task->num_addr_keys = 0;
 	}
 	nvdla_dbg_fn(pdev, "all mem handles unmaped");
 
@@ -320,6 +315,21 @@ static inline size_t nvdla_profile_status_offset(struct nvdla_task *task)
 	return offset;
 }
 
+void nvdla_task_emu_complete(struct nvdla_task *task, u64 exec_ns)
+{
+	struct nvhost_notification *tsp_notifier;
+	u64 *timestamp_ptr;
+
+	/* fill the status notifier the way the firmware does for TSP */
+	tsp_notifier = (struct nvhost_notification *)
+			((uint8_t *)task->task_desc +
+			nvdla_profile_status_offset(task));
+	timestamp_ptr = (u64 *) &tsp_notifier->time_stamp;
+	*timestamp_ptr = arch_timer_read_counter() << 5;
+	tsp_notifier->info32 = div_u64(exec_ns, 1000);
+	tsp_notifier->status = 0;
+}
+
 
 #if IS_ENABLED(CONFIG_TEGRA_GRHOST)
 /*
@@ -335,10 +345,13 @@ static void nvdla_queue_update(void *priv)
 	struct nvdla_task *task, *safe;
 	struct nvdla_queue *queue = priv;
 	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	struct nvhost_notification *tsp_notifier;
 	u64 timestamp_start, timestamp_end;
 	u64 *timestamp_ptr;
 	int n_tasks_completed = 0;
+	int n_tasks_emulated = 0;
 	uint32_t task_id;
 	int i;
 	mutex_lock(&queue->list_lock);
@@ -349,7 +362,11 @@ static void nvdla_queue_update(void *priv)
 	list_for_each_entry_safe(task, safe, &queue->tasklist, list) {
 		task_id = nvdla_compute_task_id(task->task_desc->sequence,
 				task->task_desc->queue_id);
-		task_complete = nvhost_syncpt_is_expired_ext(pdev,
+		if (task->emulated)
+			task_complete = nvdla_emu_syncpt_is_expired(
+					nvdla_dev->emu, queue, task->fence);
+		else
+			task_complete = nvhost_syncpt_is_expired_ext(pdev,
 					queue->syncpt_id, task->fence);
 
 		/* clean task and remove from list */
@@ -375,17 +392,29 @@ static void nvdla_queue_update(void *priv)
 						task->postfences[i].syncpoint_value);
 			}
 		}
+			if (task->emulated)
+				n_tasks_emulated++;
 			nvdla_task_free_locked(task);
 			n_tasks_completed++;
 		}
 	}
 
-	/* put pm refcount */
-	nvhost_module_idle_mult(pdev, n_tasks_completed);
+	/* put pm refcount, emulated tasks did not take one */
+	nvhost_module_idle_mult(pdev, n_tasks_completed - n_tasks_emulated);
 
 	mutex_unlock(&queue->list_lock);
 }
 
+/* notifier of the software syncpoints, see nvdla_emu_register_notifier() */
+static void nvdla_queue_emu_update(void *priv)
+{
+#if IS_ENABLED(CONFIG_TEGRA_GRHOST)
+	nvdla_queue_update(priv, 0);
+#else
+	nvdla_queue_update(priv);
+#endif
+}
+
 static size_t nvdla_get_task_desc_size(void)
 {
 	size_t size = 0;
@@ -419,15 +448,6 @@ static void nvdla_get_task_desc_memsize_op(size_t *dma_size, size_t *kmem_size)
 	*kmem_size = nvdla_get_max_task_size();
 }
 
-static inline u8 *add_address(u8 *mem, uint64_t addr)
-{
-	struct dla_mem_addr *address = (struct dla_mem_addr *)mem;
-
-	address->val = addr;
-
-	return mem + sizeof(struct dla_mem_addr);
-}
-
 static inline u8 *add_opcode(u8 *mem, uint8_t op)
 {
 	struct dla_action_opcode *opcode = (struct dla_action_opcode *)mem;
@@ -512,6 +532,8 @@ static int nvdla_map_task_memory(struct nvdla_task *task)
 	struct nvdla_buffers *buffers = task->buffers;
 	struct platform_device *pdev = task->queue->pool->pdev;
 	struct dla_task_descriptor *task_desc = task->task_desc;
+	struct dla_mem_addr *address_list;
+	u32 num_keys = 0;
 	u8 *next;
 
 	nvdla_dbg_fn(pdev, "");
@@ -530,11 +552,10 @@ static int nvdla_map_task_memory(struct nvdla_task *task)
 	task_desc->address_list = (uint64_t)((u8 *)task->task_desc_pa + offset);
 	task_desc->num_addresses = task->num_addresses;
 
-	/* update address list with all dma */
-	for (jj = 0; jj < task->num_addresses; jj++) {
-		dma_addr_t dma_addr;
-		size_t dma_size;
+	address_list = (struct dla_mem_addr *)next;
 
+	/* collect handles so the whole list is pinned in one call */
+	for (jj = 0; jj < task->num_addresses; jj++) {
 		nvdla_dbg_info(pdev, "count[%d] handle[%u] offset[%u]",
 				jj,
 				task->memory_handles[jj].handle,
@@ -543,8 +564,7 @@ static int nvdla_map_task_memory(struct nvdla_task *task)
 		if (task->memory_handles[jj].type ==
 				NVDLA_BUFFER_TYPE_INTERNAL) {
 			/* For internal buffers, offset is the final address */
-			next = add_address(next,
-					task->memory_handles[jj].offset);
+			address_list[jj].val = task->memory_handles[jj].offset;
 			continue;
 		}
 
@@ -553,15 +573,25 @@ static int nvdla_map_task_memory(struct nvdla_task *task)
 			goto fail_to_pin_mem;
 		}
 
-		err = nvdla_buffer_submit_pin(buffers,
-				&task->memory_handles[jj].handle,
-				1, &dma_addr, &dma_size, NULL);
+		task->addr_keys[num_keys++] = NVDLA_BUFFER_KEY(
+				task->memory_handles[jj].handle, jj);
+	}
+
+	if (num_keys) {
+		err = nvdla_buffer_submit_pin_batch(buffers, task->addr_keys,
+				num_keys, &address_list[0].val);
 		if (err) {
 			nvdla_dbg_err(pdev, "fail to pin address list");
 			goto fail_to_pin_mem;
 		}
-		next = add_address(next,
-			dma_addr + task->memory_handles[jj].offset);
+		task->num_addr_keys = num_keys;
+	}
+
+	/* update address list with all dma */
+	for (jj = 0; jj < num_keys; jj++) {
+		u32 index = NVDLA_BUFFER_KEY_INDEX(task->addr_keys[jj]);
+
+		address_list[index].val += task->memory_handles[index].offset;
 	}
 	spec_bar(); /* break_spec_p#5_1 */
 
@@ -1226,6 +1256,8 @@ int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task)
 {
 	struct nvdla_task *task = (struct nvdla_task *)in_task;
 	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	uint32_t counter, task_fence;
 	int i;
 
@@ -1234,8 +1266,14 @@ int nvdla_get_signal_fences(struct nvdla_queue *queue, void *in_task)
 	if (task->fence_counter == 0)
 		task->fence_counter = 1;
 
-	task_fence = nvhost_syncpt_read_maxval(pdev, queue->syncpt_id) +
-			task->fence_counter;
+	/* fences name one syncpoint, so the submit mode is fixed from here */
+	task->emulated = nvdla_is_emulated(nvdla_dev);
+	if (task->emulated)
+		task_fence = nvdla_emu_syncpt_read_max(nvdla_dev->emu, queue) +
+				task->fence_counter;
+	else
+		task_fence = nvhost_syncpt_read_maxval(pdev, queue->syncpt_id) +
+				task->fence_counter;
 
 	/* Update fences signal updates for both prefence and postfence */
 	counter = task->fence_counter - 1;
@@ -1300,13 +1338,27 @@ static int nvdla_queue_submit_op(struct nvdla_queue *queue, void *in_task)
 
 	mutex_lock(&queue->list_lock);
 
+	/*
+	 * Tasks of a queue are chained for one engine and signal one
+	 * syncpoint, refuse a submit mode switch while the queue is busy.
+	 */
+	if (!list_empty(&queue->tasklist) &&
+	    nvdla_queue_is_emulated(queue) != task->emulated) {
+		nvdla_dbg_err(pdev, "submit mode changed with tasks queued");
+		mutex_unlock(&queue->list_lock);
+		return -EBUSY;
+	}
+
 	/* Get a reference before registration or submission */
 	nvdla_task_get(task);
 
 	task_id = nvdla_compute_task_id(task->task_desc->sequence, task->task_desc->queue_id);
 
-	/* get fence from nvhost for MMIO mode*/
-	if (nvdla_dev->submit_mode == NVDLA_SUBMIT_MODE_MMIO) {
+	/* get fence from nvhost for MMIO mode, the software engine has its own */
+	if (task->emulated) {
+		task->fence = nvdla_emu_syncpt_incr_max(nvdla_dev->emu, queue,
+						task->fence_counter);
+	} else if (nvdla_dev->submit_mode == NVDLA_SUBMIT_MODE_MMIO) {
 		task->fence = nvhost_syncpt_incr_max_ext(pdev,
 						queue->syncpt_id,
 						task->fence_counter);
@@ -1338,6 +1390,26 @@ static int nvdla_queue_submit_op(struct nvdla_queue *queue, void *in_task)
 	/* Report timestamp in TSC ticks. */
 	timestamp = arch_timer_read_counter();
 
+	/* software engine, the DLA is neither powered nor programmed */
+	if (task->emulated) {
+		err = nvdla_emu_register_notifier(nvdla_dev->emu, queue,
+			task->fence, nvdla_queue_emu_update, queue);
+		if (err)
+			goto fail_to_emulate;
+
+		err = nvdla_emu_submit_task(nvdla_dev->emu, task);
+		if (err) {
+			/* deletes invalid task from queue, puts refs */
+			nvdla_emu_syncpt_reset(nvdla_dev->emu, queue);
+		} else if (IS_ENABLED(CONFIG_TRACING)) {
+			trace_job_submit(&pdev->dev, pdata->class, task_id,
+					 task->num_prefences, timestamp);
+		}
+
+		mutex_unlock(&queue->list_lock);
+		return err;
+	}
+
 	/* get pm refcount */
 	if (nvhost_module_busy(pdev))
 		goto fail_to_poweron;
@@ -1399,16 +1471,38 @@ fail_to_register:
 fail_to_channel_submit:
 	nvhost_module_idle(pdev);
 fail_to_poweron:
+fail_to_emulate:
 	nvdla_task_free_locked(task);
 	mutex_unlock(&queue->list_lock);
 
 	return err;
 }
 
+/*
+ * Whether the tasks of a queue run on the software engine. An idle queue
+ * follows the current submit mode. Caller holds queue->list_lock.
+ */
+bool nvdla_queue_is_emulated(struct nvdla_queue *queue)
+{
+	struct nvhost_device_data *pdata =
+			platform_get_drvdata(queue->pool->pdev);
+	struct nvdla_task *last_task;
+
+	if (list_empty(&queue->tasklist))
+		return nvdla_is_emulated(pdata->private_data);
+
+	last_task = list_last_entry(&queue->tasklist, struct nvdla_task, list);
+
+	return last_task->emulated;
+}
+
 int nvdla_set_queue_state(struct nvdla_queue *queue, int cmd)
 {
 	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	struct nvdla_cmd_data cmd_data;
+	bool emulated;
 	int err;
 
 	nvdla_dbg_fn(pdev, "");
@@ -1419,6 +1513,18 @@ int nvdla_set_queue_state(struct nvdla_queue *queue, int cmd)
 		return -EINVAL;
 	}
 
+	mutex_lock(&queue->list_lock);
+	emulated = nvdla_queue_is_emulated(queue);
+	mutex_unlock(&queue->list_lock);
+
+	if (emulated) {
+		cmd_data.method_id = cmd;
+		cmd_data.method_data = queue->id;
+		cmd_data.wait = true;
+
+		return nvdla_emu_send_cmd(nvdla_dev->emu, &cmd_data);
+	}
+
 	/* get pm refcount */
 	err = nvhost_module_busy(pdev);
 	if (err) {
@@ -1449,6 +1555,8 @@ static int nvdla_queue_abort_op(struct nvdla_queue *queue)
 	struct nvdla_task *t;
 	struct nvdla_cmd_data cmd_data;
 	struct platform_device *pdev = queue->pool->pdev;
+	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	int retry = NVDLA_QUEUE_ABORT_TIMEOUT / NVDLA_QUEUE_ABORT_RETRY_PERIOD;
 
 	nvdla_dbg_fn(pdev, "");
@@ -1457,6 +1565,18 @@ static int nvdla_queue_abort_op(struct nvdla_queue *queue)
 	if (list_empty(&queue->tasklist))
 		goto list_empty;
 
+	/* route by the queued tasks, submit_mode may have changed since */
+	if (nvdla_queue_is_emulated(queue)) {
+		cmd_data.method_id = DLA_CMD_QUEUE_FLUSH;
+		cmd_data.method_data = queue->id;
+		cmd_data.wait = true;
+
+		err = nvdla_emu_send_cmd(nvdla_dev->emu, &cmd_data);
+		if (!err)
+			nvdla_emu_syncpt_reset(nvdla_dev->emu, queue);
+		goto list_empty;
+	}
+
 	/* get pm refcount */
 	err = nvhost_module_busy(pdev);
 	if (err) {
@@ -1372,6 +1372,7 @@ static int pva_probe(struct platform_device *pdev)
 
 	mutex_init(&pva->pva_auth.allow_list_lock);
 	mutex_init(&pva->pva_auth_sys.allow_list_lock);
+	pva_vpu_auth_init(pva);
 	if (pdata->version <= PVA_HW_GEN2) {
 		pva->pva_auth.pva_auth_enable = true;
 		pva->pva_auth_sys.pva_auth_enable = true;
@@ -1404,7 +1405,7 @@ static int pva_probe(struct platform_device *pdev)
 
 	if ((UINT_MAX - offset) < pdev->resource[0].start) {
 		err = -ENODEV;
-		goto err_mss_init;
+		goto err_iommu_ctxt_init;
 	}
 
 	nvpva_dbg_info(pva, "hwpm ip %s register", pdev->name);
@@ -1461,6 +1462,7 @@ err_cleanup_sysfs:
 	kobject_put(&pdata->clk_cap_kobj);
 #endif
 err_iommu_ctxt_init:
+	pva_vpu_auth_deinit(pva);
 	nvpva_syncpt_unit_interface_deinit(pdev, pva->aux_pdev);
 err_syncpt_xface_init:
 err_mss_init:
@@ -1516,6 +1518,7 @@ static int __exit pva_remove(struct platform_device *pdev)
 
 	pva_auth_allow_list_destroy(&pva->pva_auth_sys);
 	pva_auth_allow_list_destroy(&pva->pva_auth);
+	pva_vpu_auth_deinit(pva);
 	pva_free_task_status_buffer(pva);
 	nvpva_syncpt_unit_interface_deinit(pdev, pva->aux_pdev);
 	nvpva_client_context_deinit(pva);
@@ -31,6 +31,7 @@ enum {
 };
 
 struct nvpva_client_context;
+struct crypto_shash;
 
 enum pva_submit_mode {
 	PVA_SUBMIT_MODE_MAILBOX = 0,
@@ -365,6 +366,9 @@ struct nvpva_syncpts_desc {
  * profiling_level
  * driver_log_mask	controls the level of detail printed by kernel
  *			debug statements
+ * vpu_auth_tfm		sha256 transform for VPU app authentication, NULL
+ *			when the driver private sha256 is used
+ * vpu_auth_stats	cumulative VPU app authentication cost
  */
 
 struct pva {
@@ -378,6 +382,8 @@ struct pva {
 	struct nvpva_carveout_info fw_carveout;
 	struct pva_vpu_auth_s pva_auth;
 	struct pva_vpu_auth_s pva_auth_sys;
+	struct crypto_shash *vpu_auth_tfm;
+	struct pva_vpu_auth_stats_s vpu_auth_stats;
 	struct nvpva_syncpts_desc syncpts;
 
 	int irq[MAX_PVA_IRQS];
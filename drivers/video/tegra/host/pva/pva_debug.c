@@ -9,6 +9,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/nvhost.h>
 #include <linux/platform_device.h>
@@ -18,6 +19,7 @@
 #include <linux/uaccess.h>
 
 #include <uapi/linux/nvpva_ioctl.h>
+#include <crypto/hash.h>
 
 #include "pva.h"
 #include "pva_vpu_ocd.h"
@@ -346,6 +348,35 @@ static int set_authentication(void *data, u64 val)
 	return 0;
 }
 
+static int print_vpu_auth_stats(struct seq_file *s, void *data)
+{
+	struct pva *pva = s->private;
+	struct pva_vpu_auth_stats_s *stats = &pva->vpu_auth_stats;
+
+	seq_printf(s, "sha256: %s\n", pva->vpu_auth_tfm ?
+		   crypto_shash_driver_name(pva->vpu_auth_tfm) : "pva");
+	seq_printf(s, "checks: %lld\n", atomic64_read(&stats->num_checks));
+	seq_printf(s, "crc32: %lld\n", atomic64_read(&stats->num_crc32));
+	seq_printf(s, "sha256_count: %lld\n",
+		   atomic64_read(&stats->num_sha256));
+	seq_printf(s, "bytes: %lld\n", atomic64_read(&stats->num_bytes));
+	seq_printf(s, "total_us: %lld\n",
+		   div_s64(atomic64_read(&stats->total_ns), NSEC_PER_USEC));
+
+	return 0;
+}
+
+static int pva_auth_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, print_vpu_auth_stats, inode->i_private);
+}
+
+static const struct file_operations pva_auth_stats_fops = {
+	.open = pva_auth_stats_open,
+	.read = seq_read,
+	.release = single_release,
+};
+
 DEFINE_DEBUGFS_ATTRIBUTE(pva_auth_fops, get_authentication, set_authentication, "%llu");
 
 static long vpu_ocd_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
@@ -446,6 +477,8 @@ void pva_debugfs_init(struct platform_device *pdev)
 	debugfs_create_u32("driver_log_mask", 0644, de, &pva->driver_log_mask);
 	debugfs_create_file("vpu_app_authentication", 0644, de, pva,
 			    &pva_auth_fops);
+	debugfs_create_file("vpu_app_auth_stats", 0444, de, pva,
+			    &pva_auth_stats_fops);
 	debugfs_create_u32("profiling_level", 0644, de, &pva->profiling_level);
 	debugfs_create_bool("stats_enabled", 0644, de, &pva->stats_enabled);
 	debugfs_create_file("vpu_stats", 0644, de, pva, &pva_stats_fops);
@@ -567,8 +567,7 @@ static int pva_unpin(struct pva_private *priv, void *arg)
 static int
 pva_authenticate_vpu_app(struct pva *pva,
 			 struct pva_vpu_auth_s *auth,
-			 uint8_t *data,
-			 u32 size,
+			 struct pva_vpu_app_digest_s *digest,
 			 bool is_sys)
 {
 	int err = 0;
@@ -596,8 +595,7 @@ pva_authenticate_vpu_app(struct pva *pva,
 	mutex_unlock(&auth->allow_list_lock);
 	err = pva_vpu_check_sha256_key(pva,
 				       auth->vpu_hash_keys,
-				       data,
-				       size);
+				       digest);
 	if (err != 0)
 		nvpva_dbg_fn(pva, "app authentication failed");
 out:
@@ -611,6 +609,7 @@ static int pva_register_vpu_exec(struct pva_private *priv, void *arg)
 	struct	nvpva_vpu_exe_register_out_arg *reg_out =
 			(struct nvpva_vpu_exe_register_out_arg *)arg;
 	struct pva_elf_image	*image;
+	struct pva_vpu_app_digest_s digest;
 	void			*exec_data = NULL;
 	uint16_t		exe_id;
 	bool			is_system = false;
@@ -634,16 +633,16 @@ static int pva_register_vpu_exec(struct pva_private *priv, void *arg)
 		goto free_mem;
 	}
 
+	/* hashed at most once for both allow lists */
+	pva_vpu_app_digest_init(&digest, (uint8_t *)exec_data, data_size);
 	err = pva_authenticate_vpu_app(priv->pva,
 				       &priv->pva->pva_auth,
-				       (uint8_t *)exec_data,
-				       data_size,
+				       &digest,
 				       false);
 	if (err != 0) {
 		err = pva_authenticate_vpu_app(priv->pva,
 					       &priv->pva->pva_auth_sys,
-					       (uint8_t *)exec_data,
-					       data_size,
+					       &digest,
 					       true);
 		if (err != 0)
 			goto free_mem;
@@ -7,6 +7,10 @@
 #include <linux/firmware.h>
 #include <linux/nvhost.h>
 #include <linux/slab.h>
+#include <linux/sizes.h>
+#include <linux/crc32.h>
+#include <linux/ktime.h>
+#include <crypto/hash.h>
 
 #include "pva.h"
 #include "pva_bit_helpers.h"
@@ -187,54 +191,112 @@ pva_auth_allow_list_destroy(struct pva_vpu_auth_s *pva_auth)
 	pva_auth->vpu_hash_keys = NULL;
 }
 
+/*
+ * The driver private sha256 keeps a 32-bit bit count, results match the
+ * standard digest only below this size.
+ */
+#define PVA_SHA256_MAX_SIZE	(SZ_512M - 1U)
+
+void
+pva_vpu_app_digest_init(struct pva_vpu_app_digest_s *digest,
+			const uint8_t *dataptr,
+			size_t size)
+{
+	memset(digest, 0, sizeof(*digest));
+	digest->dataptr = dataptr;
+	digest->size = size;
+}
+
+void
+pva_vpu_auth_init(struct pva *pva)
+{
+	struct crypto_shash *tfm;
+
+	tfm = crypto_alloc_shash("sha256", 0, 0);
+	if (IS_ERR(tfm)) {
+		nvpva_dbg_info(pva, "sha256 unavailable, using driver sha256");
+		tfm = NULL;
+	}
+
+	pva->vpu_auth_tfm = tfm;
+}
+
+void
+pva_vpu_auth_deinit(struct pva *pva)
+{
+	if (pva->vpu_auth_tfm != NULL)
+		crypto_free_shash(pva->vpu_auth_tfm);
+
+	pva->vpu_auth_tfm = NULL;
+}
+
 /**
  * \brief
- * is_key_match calculates the sha256 key of ELF and checks if it matches with key.
+ * Calculates the sha256 key of the ELF with the driver private sha256.
  * \param[in] dataptr Pointer to the data to which sha256 to ba calculated
  * \param[in] size length in bytes of the data to which sha256 to be calculated.
- * \param[in] key the key with which calculated key would be compared for match.
- * \return The completion status of the operation. Possible values are:
- * \ref 0 Success. Passed in key matched wth calculated key.
- * \ref -EACCES. Passed in Key doesn't match with calcualted key.
+ * \param[out] key calculated key
  */
-static int32_t
-is_key_match(uint8_t *dataptr,
-	     size_t size,
-	     struct shakey_s key)
+static void
+pva_sha256_digest(const uint8_t *dataptr,
+		  size_t size,
+		  struct shakey_s *key)
 {
-	int32_t err = 0;
 	uint32_t calc_key[8];
 	size_t off;
-	struct sha256_ctx_s ctx1;
-	struct sha256_ctx_s ctx2;
+	struct sha256_ctx_s ctx;
 
-	sha256_init(&ctx1);
+	sha256_init(&ctx);
 	off = (size / 64U) * 64U;
 	if (off > 0U)
-		pva_sha256_update(&ctx1, dataptr, off);
-
-	/* clone */
-	sha256_copy(&ctx1, &ctx2);
+		pva_sha256_update(&ctx, dataptr, off);
 
 	/* finalize with leftover, if any */
-	sha256_finalize(&ctx2, dataptr + off, size % 64U, calc_key);
+	sha256_finalize(&ctx, dataptr + off, size % 64U, calc_key);
+	memcpy(key->sha_key, calc_key, NVPVA_SHA256_DIGEST_SIZE);
+}
+
+/**
+ * \brief
+ * Calculates the sha256 key of the ELF once and keeps it in the digest.
+ * \param[in] pva  Pointer to PVA driver context
+ * \param[in,out] digest digest of the ELF
+ */
+static void
+pva_vpu_app_digest_sha256(struct pva *pva,
+			  struct pva_vpu_app_digest_s *digest)
+{
+	struct crypto_shash *tfm = pva->vpu_auth_tfm;
+	int err = -EINVAL;
+
+	if (digest->sha_valid)
+		return;
+
+	if (tfm != NULL && digest->size <= PVA_SHA256_MAX_SIZE) {
+		SHASH_DESC_ON_STACK(desc, tfm);
+
+		desc->tfm = tfm;
+		err = crypto_shash_digest(desc, digest->dataptr,
+					  (unsigned int)digest->size,
+					  digest->sha_key.sha_key);
+		shash_desc_zero(desc);
+	}
 
-	err = memcmp((void *)&(key.sha_key),
-		     (void *)calc_key,
-		     NVPVA_SHA256_DIGEST_SIZE);
 	if (err != 0)
-		err = -EACCES;
+		pva_sha256_digest(digest->dataptr, digest->size,
+				  &digest->sha_key);
 
-	return err;
+	digest->sha_valid = true;
+	atomic64_inc(&pva->vpu_auth_stats.num_sha256);
+	atomic64_add(digest->size, &pva->vpu_auth_stats.num_bytes);
 }
 
 /**
  * \brief
- * Keeps checking all the keys accociated with match_hash
- * against the calculated sha256 key for dataptr, until it finds a match.
- * \param[in] pva  Pointer to PVA driver context structure struct \ref nvpva_drv_ctx
- * \param[in] dataptr pointer to ELF data
- * \param[in] size length (in bytes) of ELF data
+ * Checks all the keys accociated with match_hash
+ * against the sha256 key of the ELF, until it finds a match.
+ * \param[in] pallkeys Array of all keys of the allow list
+ * \param[in] digest digest of the ELF with sha256 key calculated
  * \param[in] match_hash pointer to matching hash structure, \ref struct vpu_hash_vector_s.
  * \return Matching status of the calculated key
  * against the keys asscociated with match_hash. possible values:
@@ -244,14 +306,12 @@ is_key_match(uint8_t *dataptr,
  */
 static int
 check_all_keys_for_match(struct shakey_s *pallkeys,
-			 uint8_t *dataptr,
-			 size_t size,
+			 const struct pva_vpu_app_digest_s *digest,
 			 const struct vpu_hash_vector_s *match_hash)
 {
-	int32_t err = 0;
+	int32_t err = -EACCES;
 	uint32_t idx;
 	uint32_t count;
-	struct shakey_s key;
 	uint32_t i;
 
 	idx = match_hash->index;
@@ -262,10 +322,12 @@ check_all_keys_for_match(struct shakey_s *pallkeys,
 	}
 
 	for (i = 0; i < count; i++) {
-		key = pallkeys[idx+i];
-		err = is_key_match(dataptr, size, key);
-		if (err == 0)
+		if (memcmp(pallkeys[idx + i].sha_key,
+			   digest->sha_key.sha_key,
+			   NVPVA_SHA256_DIGEST_SIZE) == 0) {
+			err = 0;
 			break;
+		}
 	}
 fail:
 	return err;
@@ -300,34 +362,6 @@ compare_hash_value(const void *pkey,
 	return ret;
 }
 
-/**
- * @brief
- * calculates crc32.
- * @param[in] crc initial crc value. usually 0.
- * @param[in] buf pointer to the buffer whose crc32 to be calculated.
- * @param[in] len length (in bytes) of data at @ref buf.
- * @retval value of calculated crc32.
- */
-static uint32_t
-pva_crc32(uint32_t crc,
-	  unsigned char *buf,
-	  size_t len)
-{
-	int k;
-
-	crc = ~crc;
-	while (len != 0U) {
-		crc ^= *buf++;
-		for (k = 0; k < 8; k++)
-			crc = ((crc & 1U) == 1U) ?
-			(crc >> 1U) ^ 0xedb88320U : crc >> 1U;
-
-		len--;
-	}
-
-	return ~crc;
-}
-
 const void
 *binary_search(const void *key,
 	       const void *base,
@@ -374,14 +408,23 @@ const void
 int
 pva_vpu_check_sha256_key(struct pva *pva,
 			 struct vpu_hash_key_pair_s *vpu_hash_keys,
-			 uint8_t *dataptr,
-			 size_t size)
+			 struct pva_vpu_app_digest_s *digest)
 {
 	int err = 0;
 	struct vpu_hash_vector_s cal_Hash;
 	const struct vpu_hash_vector_s *match_Hash;
+	u64 start_ns = ktime_get_ns();
+
+	if (!digest->crc_valid) {
+		/* table driven or instruction based, same as bitwise reflected crc32 */
+		digest->crc32_hash = ~crc32_le(~0U, digest->dataptr,
+					       digest->size);
+		digest->crc_valid = true;
+		atomic64_inc(&pva->vpu_auth_stats.num_crc32);
+		atomic64_add(digest->size, &pva->vpu_auth_stats.num_bytes);
+	}
 
-	cal_Hash.crc32_hash = pva_crc32(0L, dataptr, size);
+	cal_Hash.crc32_hash = digest->crc32_hash;
 
 	match_Hash = (const struct vpu_hash_vector_s *)
 		binary_search(&cal_Hash,
@@ -395,12 +438,15 @@ pva_vpu_check_sha256_key(struct pva *pva,
 		goto fail;
 	}
 
+	pva_vpu_app_digest_sha256(pva, digest);
+
 	err = check_all_keys_for_match(vpu_hash_keys->psha_key,
-				       dataptr,
-				       size,
+				       digest,
 				       match_Hash);
 	if (err != 0)
 		nvpva_dbg_info(pva, "Error: Match key not found");
 fail:
+	atomic64_inc(&pva->vpu_auth_stats.num_checks);
+	atomic64_add(ktime_get_ns() - start_ns, &pva->vpu_auth_stats.total_ns);
 	return err;
 }
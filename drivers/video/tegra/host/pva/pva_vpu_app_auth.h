@@ -6,6 +6,8 @@
 #ifndef NVPVA_VPU_HASH_H
 #define NVPVA_VPU_HASH_H
 
+#include <linux/atomic.h>
+
 #include "pva_vpu_exe.h"
 
 /**
@@ -67,8 +69,73 @@ struct pva_vpu_auth_s {
 	bool pva_auth_allow_list_parsed;
 };
 
+/**
+ * Digests of one VPU ELF, computed on first use and shared by the
+ * lookups in the user and system allow lists.
+ */
+struct pva_vpu_app_digest_s {
+	/** ELF data */
+	const uint8_t *dataptr;
+	/** ELF size in bytes */
+	size_t size;
+	/** CRC32 of the ELF, valid when crc_valid is set */
+	uint32_t crc32_hash;
+	/** SHA-256 of the ELF, valid when sha_valid is set */
+	struct shakey_s sha_key;
+	bool crc_valid;
+	bool sha_valid;
+};
+
+/**
+ * Cumulative cost of VPU ELF authentication since probe
+ */
+struct pva_vpu_auth_stats_s {
+	/** Number of allow list lookups */
+	atomic64_t num_checks;
+	/** Number of CRC32 computed */
+	atomic64_t num_crc32;
+	/** Number of SHA-256 computed */
+	atomic64_t num_sha256;
+	/** Bytes hashed by CRC32 and SHA-256 */
+	atomic64_t num_bytes;
+	/** Time spent in allow list lookups, in ns */
+	atomic64_t total_ns;
+};
+
 struct nvpva_drv_ctx;
 
+/**
+ * \brief Prepares the digest of an ELF for \ref pva_vpu_check_sha256_key.
+ *
+ * No hashing is done here, CRC32 and SHA-256 are computed when a lookup
+ * first needs them.
+ *
+ * \param[out] digest digest to initialize
+ * \param[in] dataptr data pointer of ELF, must stay valid while digest is used
+ * \param[in] size ELF size in number of bytes
+ */
+void pva_vpu_app_digest_init(struct pva_vpu_app_digest_s *digest,
+			     const uint8_t *dataptr,
+			     size_t size);
+
+/**
+ * \brief Sets up the SHA-256 transform used for VPU ELF authentication.
+ *
+ * Uses the kernel crypto API so the architecture accelerated sha256 is
+ * picked up when available, the driver private implementation is used
+ * otherwise.
+ *
+ * \param[in] pva Pointer to PVA driver context
+ */
+void pva_vpu_auth_init(struct pva *pva);
+
+/**
+ * \brief Releases what \ref pva_vpu_auth_init set up.
+ *
+ * \param[in] pva Pointer to PVA driver context
+ */
+void pva_vpu_auth_deinit(struct pva *pva);
+
 /**
  * \brief checks if the sha256 key of ELF has a match in allowlist.
  *
@@ -83,8 +150,8 @@ struct nvpva_drv_ctx;
  *
  * \param[in] vpu_hash_keys  Pointer to PVA vpu elf sha256 authentication
  *            keys structure \ref struct vpu_hash_key_pair_s
- * \param[in] dataptr data pointer of ELF to be validate SHA
- * \param[in] size  32-bit unsigned int ELF size in  number of bytes
+ * \param[in,out] digest digest of the ELF, see \ref pva_vpu_app_digest_init.
+ *            Digests computed by the lookup are kept for later lookups.
  *
  * \return  The completion status of the operation. Possible values are:
  * - 0 when there exists a match key for the elf data pointed by dataptr.
@@ -94,8 +161,7 @@ struct nvpva_drv_ctx;
  */
 int pva_vpu_check_sha256_key(struct pva *pva,
 			     struct vpu_hash_key_pair_s *vpu_hash_keys,
-			     uint8_t *dataptr,
-			     size_t size);
+			     struct pva_vpu_app_digest_s *digest);
 
 
 /**
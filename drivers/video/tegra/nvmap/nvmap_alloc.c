@@ -11,6 +11,8 @@
 #include <linux/random.h>
 #include <linux/version.h>
 #include <linux/io.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
 #if KERNEL_VERSION(4, 15, 0) > LINUX_VERSION_CODE
 #include <soc/tegra/chip-id.h>
 #else
@@ -83,6 +85,98 @@ static struct page *nvmap_alloc_pages_exact(gfp_t gfp, size_t size, bool use_num
 	return page;
 }
 
+/*
+ * Chunk sizes used to fill non-contiguous handles, largest first. Big
+ * naturally aligned chunks cut TLB misses and IOMMU map time, and since
+ * sg_alloc_table_from_pages() merges physically contiguous pages, each
+ * chunk ends up as a single sg entry in the dma-buf sg_table. The last
+ * entry must stay PAGE_SIZE and accounts for everything else.
+ */
+static const u32 nvmap_alloc_chunk_sizes[NVMAP_ALLOC_NR_CHUNK_SIZES] = {
+	SZ_2M, SZ_64K, PAGE_SIZE,
+};
+static atomic64_t nvmap_alloc_chunk_hist[NVMAP_ALLOC_NR_CHUNK_SIZES];
+
+/* Largest chunk handle_page_alloc() tries to get from the page allocator */
+static uint s_max_chunk_size = SZ_2M;
+module_param_named(max_chunk_size, s_max_chunk_size, uint, 0644);
+
+static void nvmap_alloc_chunk_account(u32 chunk_size, u32 nr_chunks)
+{
+	int i;
+
+	/*
+	 * Search from the smallest entry so that PAGE_SIZE chunks land in
+	 * the last bucket even when a larger entry equals PAGE_SIZE too,
+	 * as SZ_64K does on 64K page kernels.
+	 */
+	for (i = NVMAP_ALLOC_NR_CHUNK_SIZES - 1; i >= 0; i--) {
+		if (nvmap_alloc_chunk_sizes[i] == chunk_size) {
+			atomic64_add(nr_chunks, &nvmap_alloc_chunk_hist[i]);
+			return;
+		}
+	}
+}
+
+void nvmap_alloc_chunk_hist_show(struct seq_file *s)
+{
+	u32 size;
+	s64 count;
+	int i;
+
+	seq_printf(s, "%-6s %-12s %s\n", "order", "count", "bytes");
+	for (i = 0; i < NVMAP_ALLOC_NR_CHUNK_SIZES; i++) {
+		size = nvmap_alloc_chunk_sizes[i];
+		/* Entries no bigger than a page are never used as chunks */
+		if (size <= PAGE_SIZE && i != NVMAP_ALLOC_NR_CHUNK_SIZES - 1)
+			continue;
+
+		count = atomic64_read(&nvmap_alloc_chunk_hist[i]);
+		seq_printf(s, "%-6d %-12lld %lld\n", get_order(size), count,
+			   count * size);
+	}
+}
+
+/*
+ * Fill pages[page_index..nr_page) with high order chunks from the page
+ * allocator, largest first. Each chunk is split so that its pages can
+ * still be freed one by one. Returns the new page index.
+ */
+static int nvmap_alloc_chunks(gfp_t gfp, struct page **pages, int page_index,
+			      int nr_page, int numa_id)
+{
+	/*
+	 * set the gfp not to trigger direct/kswapd reclaims and
+	 * not to use emergency reserves.
+	 */
+	gfp_t gfp_no_reclaim = (gfp | __GFP_NOMEMALLOC | __GFP_NOWARN) &
+				~__GFP_RECLAIM;
+	int i, idx, pages_per_chunk;
+	struct page *page;
+
+	for (i = 0; i < NVMAP_ALLOC_NR_CHUNK_SIZES - 1; i++) {
+		pages_per_chunk = nvmap_alloc_chunk_sizes[i] >> PAGE_SHIFT;
+		if (pages_per_chunk <= 1 ||
+		    nvmap_alloc_chunk_sizes[i] > s_max_chunk_size)
+			continue;
+
+		while (nr_page - page_index >= pages_per_chunk) {
+			page = nvmap_alloc_pages_exact(gfp_no_reclaim,
+					nvmap_alloc_chunk_sizes[i], true, numa_id);
+			if (!page)
+				break;
+
+			for (idx = 0; idx < pages_per_chunk; idx++)
+				pages[page_index + idx] = nth_page(page, idx);
+			nvmap_clean_cache(&pages[page_index], pages_per_chunk);
+			atomic64_inc(&nvmap_alloc_chunk_hist[i]);
+			page_index += pages_per_chunk;
+		}
+	}
+
+	return page_index;
+}
+
 static uint s_nr_colors = 1;
 module_param_named(nr_colors, s_nr_colors, uint, 0644);
 
@@ -482,13 +576,9 @@ static int handle_page_alloc(struct nvmap_client *client,
 	int i = 0, page_index = 0, allocated = 0;
 	struct page **pages;
 	gfp_t gfp = GFP_NVMAP | __GFP_ZERO;
-#ifdef CONFIG_ARM64_4K_PAGES
-#ifdef NVMAP_CONFIG_PAGE_POOLS
-	int pages_per_big_pg = NVMAP_PP_BIG_PAGE_SIZE >> PAGE_SHIFT;
-#else
-	int pages_per_big_pg = 0;
+#if defined(CONFIG_ARM64_4K_PAGES) && defined(NVMAP_CONFIG_PAGE_POOLS)
+	int pages_per_big_pg;
 #endif
-#endif /* CONFIG_ARM64_4K_PAGES */
 #if KERNEL_VERSION(4, 15, 0) > LINUX_VERSION_CODE
 	static u32 chipid;
 #else
@@ -527,30 +617,18 @@ static int handle_page_alloc(struct nvmap_client *client,
 		page_index = nvmap_page_pool_alloc_lots_bp(&nvmap_dev->pool, pages,
 							nr_page, true, h->numa_id);
 		pages_per_big_pg = nvmap_dev->pool.pages_per_big_pg;
+		if (pages_per_big_pg > 1)
+			nvmap_alloc_chunk_account(pages_per_big_pg << PAGE_SHIFT,
+						  page_index / pages_per_big_pg);
 #endif
-		/* Try to allocate big pages from page allocator */
-		for (i = page_index;
-		     i < nr_page && pages_per_big_pg > 1 && (nr_page - i) >= pages_per_big_pg;
-		     i += pages_per_big_pg, page_index += pages_per_big_pg) {
-			struct page *page;
-			int idx;
-			/*
-			 * set the gfp not to trigger direct/kswapd reclaims and
-			 * not to use emergency reserves.
-			 */
-			gfp_t gfp_no_reclaim = (gfp | __GFP_NOMEMALLOC) & ~__GFP_RECLAIM;
-
-			page = nvmap_alloc_pages_exact(gfp_no_reclaim,
-					pages_per_big_pg << PAGE_SHIFT, true, h->numa_id);
-			if (!page)
-				break;
-
-			for (idx = 0; idx < pages_per_big_pg; idx++)
-				pages[i + idx] = nth_page(page, idx);
-			nvmap_clean_cache(&pages[i], pages_per_big_pg);
-		}
+#endif /* CONFIG_ARM64_4K_PAGES */
+		/* Try to allocate large chunks from page allocator */
+		i = page_index = nvmap_alloc_chunks(gfp, pages, page_index,
+						    nr_page, h->numa_id);
+#ifdef CONFIG_ARM64_4K_PAGES
 		nvmap_big_page_allocs += page_index;
 #endif /* CONFIG_ARM64_4K_PAGES */
+		nvmap_alloc_chunk_account(PAGE_SIZE, nr_page - page_index);
 		if (s_nr_colors <= 1) {
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 			/* Get as many pages from the pool as possible. */
@@ -1092,7 +1170,8 @@ void _nvmap_handle_free(struct nvmap_handle *h)
 out:
 	NVMAP_TAG_TRACE(trace_nvmap_destroy_handle,
 		NULL, get_current()->pid, 0, NVMAP_TP_ARGS_H(h));
-	kfree(h);
+	/* nvmap_validate_get() may still be looking at it under RCU */
+	kfree_rcu(h, rcu);
 }
 
 void nvmap_free_handle(struct nvmap_client *client,
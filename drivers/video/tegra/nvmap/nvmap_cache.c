@@ -7,6 +7,13 @@
 
 #include <linux/io.h>
 #include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/moduleparam.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/sort.h>
+#include <linux/workqueue.h>
 #include <linux/of.h>
 #include <linux/version.h>
 #if KERNEL_VERSION(4, 15, 0) > LINUX_VERSION_CODE
@@ -327,6 +334,236 @@ out:
 	return err;
 }
 
+/*
+ * Ranges of a cache maintenance list are coalesced per handle, and when
+ * the list is large enough the work is split in chunks of this size and
+ * spread over all CPUs with an unbound workqueue. By-VA cache maintenance
+ * is broadcast to the inner shareable domain, so any CPU can do it.
+ */
+static uint cache_maint_chunk_size = SZ_2M;
+module_param(cache_maint_chunk_size, uint, 0644);
+
+static uint cache_maint_parallel_thresh = SZ_8M;
+module_param(cache_maint_parallel_thresh, uint, 0644);
+
+struct cache_maint_range {
+	struct nvmap_handle *h;
+	u64 start;
+	u64 end;
+};
+
+struct cache_maint_work {
+	struct work_struct work;
+	struct cache_maint_range range;
+	int op;
+	int err;
+};
+
+/* Latency histogram of list operations, bucketed by log2 of their size */
+#define CACHE_MAINT_HIST_MIN_SHIFT	PAGE_SHIFT
+#define CACHE_MAINT_HIST_BUCKETS	15
+
+static struct {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+} cache_maint_hist[CACHE_MAINT_HIST_BUCKETS];
+static DEFINE_SPINLOCK(cache_maint_hist_lock);
+
+static void cache_maint_hist_add(u64 size, u64 ns)
+{
+	int b = 0;
+
+	if (size > (1ULL << CACHE_MAINT_HIST_MIN_SHIFT))
+		b = min_t(int, CACHE_MAINT_HIST_BUCKETS - 1,
+			  fls64(size - 1) - CACHE_MAINT_HIST_MIN_SHIFT);
+
+	spin_lock(&cache_maint_hist_lock);
+	cache_maint_hist[b].count++;
+	cache_maint_hist[b].total_ns += ns;
+	cache_maint_hist[b].max_ns = max(cache_maint_hist[b].max_ns, ns);
+	spin_unlock(&cache_maint_hist_lock);
+}
+
+static int cache_maint_hist_show(struct seq_file *s, void *unused)
+{
+	int b;
+
+	seq_printf(s, "%-12s %-10s %-12s %s\n",
+		   "size<=", "count", "avg_ns", "max_ns");
+	spin_lock(&cache_maint_hist_lock);
+	for (b = 0; b < CACHE_MAINT_HIST_BUCKETS; b++) {
+		if (!cache_maint_hist[b].count)
+			continue;
+		seq_printf(s, "%-12llu %-10llu %-12llu %llu\n",
+			   1ULL << (b + CACHE_MAINT_HIST_MIN_SHIFT),
+			   cache_maint_hist[b].count,
+			   div64_u64(cache_maint_hist[b].total_ns,
+				     cache_maint_hist[b].count),
+			   cache_maint_hist[b].max_ns);
+	}
+	spin_unlock(&cache_maint_hist_lock);
+	return 0;
+}
+
+static int cache_maint_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cache_maint_hist_show, inode->i_private);
+}
+
+static const struct file_operations cache_maint_hist_fops = {
+	.open = cache_maint_hist_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void nvmap_cache_debugfs_init(struct dentry *nvmap_root)
+{
+	if (IS_ERR_OR_NULL(nvmap_root))
+		return;
+
+	debugfs_create_file("cache_maint_latency", S_IRUGO, nvmap_root,
+			    NULL, &cache_maint_hist_fops);
+}
+
+static int cache_maint_range_cmp(const void *a, const void *b)
+{
+	const struct cache_maint_range *ra = a, *rb = b;
+
+	if (ra->h != rb->h)
+		return (uintptr_t)ra->h < (uintptr_t)rb->h ? -1 : 1;
+	if (ra->start != rb->start)
+		return ra->start < rb->start ? -1 : 1;
+	return 0;
+}
+
+static void cache_maint_work_fn(struct work_struct *work)
+{
+	struct cache_maint_work *cw =
+		container_of(work, struct cache_maint_work, work);
+
+	cw->err = __nvmap_do_cache_maint(cw->range.h->owner, cw->range.h,
+					 cw->range.start, cw->range.end,
+					 cw->op, false);
+}
+
+/*
+ * Split the ranges in chunks and run them on the unbound workqueue.
+ * Returns -ENOMEM if the work items can't be allocated, in which case
+ * nothing has been done yet.
+ */
+static int cache_maint_ranges_parallel(struct cache_maint_range *ranges,
+				       u32 nr, int op)
+{
+	u64 chunk = max_t(u64, PAGE_ALIGN(cache_maint_chunk_size), PAGE_SIZE);
+	struct cache_maint_work *works;
+	u32 i, nr_works = 0, w = 0;
+	u64 start;
+	int err = 0;
+
+	for (i = 0; i < nr; i++)
+		nr_works += DIV_ROUND_UP_ULL(ranges[i].end - ranges[i].start,
+					     chunk);
+
+	works = nvmap_altalloc(nr_works * sizeof(*works));
+	if (!works)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i++) {
+		for (start = ranges[i].start; start < ranges[i].end;
+		     start += chunk) {
+			struct cache_maint_work *cw = &works[w++];
+
+			INIT_WORK(&cw->work, cache_maint_work_fn);
+			cw->range.h = ranges[i].h;
+			cw->range.start = start;
+			cw->range.end = min(start + chunk, ranges[i].end);
+			cw->op = op;
+			queue_work(system_unbound_wq, &cw->work);
+		}
+	}
+
+	for (w = 0; w < nr_works; w++) {
+		flush_work(&works[w].work);
+		if (works[w].err && !err)
+			err = works[w].err;
+	}
+
+	nvmap_altfree(works, nr_works * sizeof(*works));
+	return err;
+}
+
+/*
+ * Do the per handle cache maintenance of a list. Overlapping and
+ * adjacent ranges of the same handle are merged first, so that each
+ * handle is walked only once.
+ */
+static int nvmap_cache_maint_ranges(struct nvmap_handle **handles,
+				    u64 *offsets, u64 *sizes, int op,
+				    u32 nr_ops, bool is_32)
+{
+	struct cache_maint_range *ranges;
+	u32 *offs_32 = (u32 *)offsets, *sizes_32 = (u32 *)sizes;
+	u64 total = 0, t1;
+	u32 i, nr = 0;
+	int err = 0;
+
+	ranges = nvmap_altalloc(nr_ops * sizeof(*ranges));
+	if (!ranges)
+		return -ENOMEM;
+
+	for (i = 0; i < nr_ops; i++) {
+		u64 size = is_32 ? sizes_32[i] : sizes[i];
+		u64 offset = is_32 ? offs_32[i] : offsets[i];
+
+		size = size ?: handles[i]->size;
+		offset = offset ?: 0;
+		ranges[i].h = handles[i];
+		ranges[i].start = offset;
+		ranges[i].end = offset + size;
+	}
+
+	sort(ranges, nr_ops, sizeof(*ranges), cache_maint_range_cmp, NULL);
+	for (i = 0; i < nr_ops; i++) {
+		if (nr && ranges[nr - 1].h == ranges[i].h &&
+		    ranges[i].start <= ranges[nr - 1].end) {
+			ranges[nr - 1].end = max(ranges[nr - 1].end,
+						 ranges[i].end);
+			continue;
+		}
+		ranges[nr++] = ranges[i];
+	}
+
+	for (i = 0; i < nr; i++)
+		total += ranges[i].end - ranges[i].start;
+
+	t1 = ktime_get_ns();
+	if (total >= cache_maint_parallel_thresh && num_online_cpus() > 1) {
+		err = cache_maint_ranges_parallel(ranges, nr, op);
+		if (err != -ENOMEM)
+			goto out;
+		err = 0;
+	}
+
+	for (i = 0; i < nr; i++) {
+		err = __nvmap_do_cache_maint(ranges[i].h->owner, ranges[i].h,
+					     ranges[i].start, ranges[i].end,
+					     op, false);
+		if (err)
+			break;
+	}
+
+out:
+	if (err)
+		pr_err("cache maint per handle failed [%d]\n", err);
+	else
+		cache_maint_hist_add(total, ktime_get_ns() - t1);
+
+	nvmap_altfree(ranges, nr_ops * sizeof(*ranges));
+	return err;
+}
+
 /*
  * Perform cache op on the list of memory regions within passed handles.
  * A memory region within handle[i] is identified by offsets[i], sizes[i]
@@ -391,24 +628,8 @@ static int __nvmap_do_cache_maint_list(struct nvmap_handle **handles,
 					nvmap_stats_read(NS_CFLUSH_RQ),
 					nvmap_stats_read(NS_CFLUSH_DONE));
 	} else {
-		for (i = 0; i < nr_ops; i++) {
-			u32 *offs_32 = (u32 *)offsets, *sizes_32 = (u32 *)sizes;
-			u64 size = is_32 ? sizes_32[i] : sizes[i];
-			u64 offset = is_32 ? offs_32[i] : offsets[i];
-			int err;
-
-			size = size ?: handles[i]->size;
-			offset = offset ?: 0;
-			err = __nvmap_do_cache_maint(handles[i]->owner,
-						     handles[i], offset,
-						     offset + size,
-						     op, false);
-			if (err) {
-				pr_err("cache maint per handle failed [%d]\n",
-						err);
-				return err;
-			}
-		}
+		return nvmap_cache_maint_ranges(handles, offsets, sizes, op,
+						nr_ops, is_32);
 	}
 
 	return 0;
@@ -83,6 +83,7 @@ int nvmap_create_carveout(const struct nvmap_platform_carveout *co)
 	node->index = nvmap_dev->nr_carveouts;
 	nvmap_dev->nr_carveouts++;
 	node->heap_bit = co->usage_mask;
+	node->sgt_stash_max = NVMAP_SGT_STASH_DEFAULT_MAX;
 
 	if (!IS_ERR_OR_NULL(nvmap_dev->debug_root)) {
 		struct dentry *heap_root =
@@ -110,6 +111,8 @@ int nvmap_create_carveout(const struct nvmap_platform_carveout *co)
 				&debug_maps_fops);
 			debugfs_create_bool("no_cpu_access", S_IRUGO,
 				heap_root, (bool *)&co->no_cpu_access);
+			debugfs_create_u32("sgt_stash_max", S_IRUGO | S_IWUSR,
+				heap_root, &node->sgt_stash_max);
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 			debugfs_create_file("device_list", S_IRUGO,
 				heap_root,
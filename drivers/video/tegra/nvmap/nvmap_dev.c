@@ -457,6 +457,10 @@ static long nvmap_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		err = nvmap_ioctl_gup_test(filp, uarg);
 		break;
 
+	case NVMAP_IOC_FIRST_TOUCH_TEST:
+		err = nvmap_ioctl_first_touch_test(filp, uarg);
+		break;
+
 	case NVMAP_IOC_FROM_ID:
 	case NVMAP_IOC_GET_ID:
 		pr_warn("NVMAP_IOC_GET_ID/FROM_ID pair is deprecated. "
@@ -863,6 +867,13 @@ static int nvmap_debug_free_size_show(struct seq_file *s, void *unused)
 }
 DEBUGFS_OPEN_FOPS(free_size);
 
+static int nvmap_debug_chunk_hist_show(struct seq_file *s, void *unused)
+{
+	nvmap_alloc_chunk_hist_show(s);
+	return 0;
+}
+DEBUGFS_OPEN_FOPS(chunk_hist);
+
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 static int nvmap_debug_device_list_show(struct seq_file *s, void *unused)
 {
@@ -1354,6 +1365,10 @@ static void nvmap_iovmm_debugfs_init(void)
 			debugfs_create_file("free_size", S_IRUGO, iovmm_root,
 				(void *)(uintptr_t)NVMAP_HEAP_IOVMM,
 				&debug_free_size_fops);
+			debugfs_create_file("chunk_hist", S_IRUGO, iovmm_root,
+				NULL, &debug_chunk_hist_fops);
+			debugfs_create_u32("sgt_stash_max", S_IRUGO | S_IWUSR,
+				iovmm_root, &nvmap_dev->iovmm_sgt_stash_max);
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 			debugfs_create_file("device_list", S_IRUGO, iovmm_root,
 				(void *)(uintptr_t)NVMAP_HEAP_IOVMM,
@@ -1436,6 +1451,10 @@ int __init nvmap_probe(struct platform_device *pdev)
 	dev->handles = RB_ROOT;
 	dev->serial_id_counter = 0;
 
+	e = nvmap_handle_ht_init(dev);
+	if (e)
+		goto fail_ht;
+
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 	e = nvmap_page_pool_init(dev);
 	if (e)
@@ -1466,6 +1485,7 @@ int __init nvmap_probe(struct platform_device *pdev)
 				     nvmap_dev->debug_root, &nvmap_init_time);
 #endif
 	}
+	nvmap_dev->iovmm_sgt_stash_max = NVMAP_SGT_STASH_DEFAULT_MAX;
 	nvmap_dev->dynamic_dma_map_mask = ~0U;
 	nvmap_dev->cpu_access_mask = ~0U;
 #ifdef NVMAP_CONFIG_CACHE_FLUSH_AT_ALLOC
@@ -1481,6 +1501,7 @@ int __init nvmap_probe(struct platform_device *pdev)
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 	nvmap_page_pool_debugfs_init(nvmap_dev->debug_root);
 #endif
+	nvmap_cache_debugfs_init(nvmap_debug_root);
 	nvmap_stats_init(nvmap_debug_root);
 	platform_set_drvdata(pdev, dev);
 
@@ -1531,6 +1552,8 @@ fail:
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 	nvmap_page_pool_fini(nvmap_dev);
 #endif
+	nvmap_handle_ht_destroy(dev);
+fail_ht:
 	kfree(dev->heaps);
 	if (dev->dev_user.minor != MISC_DYNAMIC_MINOR)
 		misc_deregister(&dev->dev_user);
@@ -1562,6 +1585,7 @@ int nvmap_remove(struct platform_device *pdev)
 		rb_erase(&h->node, &dev->handles);
 		kfree(h);
 	}
+	nvmap_handle_ht_destroy(dev);
 
 	for (i = 0; i < dev->nr_carveouts; i++) {
 		struct nvmap_carveout_node *node = &dev->heaps[i];
@@ -10,6 +10,7 @@
 #include <nvidia/conftest.h>
 
 #include <linux/list.h>
+#include <linux/hashtable.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/export.h>
@@ -44,6 +45,8 @@ struct nvmap_handle_sgt {
 	struct sg_table *sgt;
 	struct device *dev;
 	struct list_head maps_entry;
+	struct hlist_node hash_entry;
+	u32 users;		/* attachments currently mapping this sgt */
 	struct nvmap_handle_info *owner;
 } ____cacheline_aligned_in_smp;
 
@@ -112,6 +115,80 @@ static inline bool access_vpr_phys(struct device *dev)
 	return !!of_find_property(dev->of_node, "access-vpr-phys", NULL);
 }
 
+static void __nvmap_dmabuf_unmap_dma_buf(struct nvmap_handle_sgt *nvmap_sgt);
+
+static inline unsigned long nvmap_sgt_stash_key(struct device *dev,
+						enum dma_data_direction dir)
+{
+	return (unsigned long)dev ^ (unsigned long)dir;
+}
+
+/* Max number of stashed sgt's for a dma-buf of handle h, 0 for no limit */
+static u32 nvmap_sgt_stash_max(struct nvmap_handle *h)
+{
+	int i;
+
+	if (h->heap_type == NVMAP_HEAP_IOVMM)
+		return nvmap_dev->iovmm_sgt_stash_max;
+
+	for (i = 0; i < nvmap_dev->nr_carveouts; i++)
+		if (nvmap_dev->heaps[i].heap_bit & h->heap_type)
+			return nvmap_dev->heaps[i].sgt_stash_max;
+
+	return NVMAP_SGT_STASH_DEFAULT_MAX;
+}
+
+static struct nvmap_handle_sgt *nvmap_dmabuf_stash_lookup_locked(
+		struct nvmap_handle_info *info, struct device *dev,
+		enum dma_data_direction dir)
+{
+	struct nvmap_handle_sgt *nvmap_sgt;
+
+	hash_for_each_possible(info->maps_hash, nvmap_sgt, hash_entry,
+			       nvmap_sgt_stash_key(dev, dir)) {
+		if (nvmap_sgt->dir == dir && nvmap_sgt->dev == dev)
+			return nvmap_sgt;
+	}
+
+	return NULL;
+}
+
+static void nvmap_dmabuf_stash_free_locked(struct nvmap_handle_sgt *nvmap_sgt)
+{
+	struct nvmap_handle_info *info = nvmap_sgt->owner;
+
+	__nvmap_dmabuf_unmap_dma_buf(nvmap_sgt);
+	list_del(&nvmap_sgt->maps_entry);
+	hash_del(&nvmap_sgt->hash_entry);
+	info->nr_maps--;
+	kmem_cache_free(handle_sgt_cache, nvmap_sgt);
+}
+
+/*
+ * Drop least recently used sgt's which are not mapped by any attachment
+ * until the stash is back under the cap of the handle's heap.
+ */
+static void nvmap_dmabuf_stash_evict_locked(struct dma_buf *dmabuf)
+{
+	struct nvmap_handle_info *info = dmabuf->priv;
+	struct nvmap_handle_sgt *nvmap_sgt, *tmp;
+	u32 max = nvmap_sgt_stash_max(info->handle);
+
+	if (!max)
+		return;
+
+	list_for_each_entry_safe_reverse(nvmap_sgt, tmp, &info->maps,
+					 maps_entry) {
+		if (info->nr_maps <= max)
+			break;
+		if (nvmap_sgt->users)
+			continue;
+
+		trace_nvmap_dmabuf_stash_evict(dmabuf, nvmap_sgt->dev);
+		nvmap_dmabuf_stash_free_locked(nvmap_sgt);
+	}
+}
+
 static int nvmap_dmabuf_stash_sgt_locked(struct dma_buf_attachment *attach,
 					 enum dma_data_direction dir,
 					 struct sg_table *sgt)
@@ -128,8 +205,14 @@ static int nvmap_dmabuf_stash_sgt_locked(struct dma_buf_attachment *attach,
 	nvmap_sgt->dir = dir;
 	nvmap_sgt->sgt = sgt;
 	nvmap_sgt->dev = attach->dev;
+	nvmap_sgt->users = 1;
 	nvmap_sgt->owner = info;
 	list_add(&nvmap_sgt->maps_entry, &info->maps);
+	hash_add(info->maps_hash, &nvmap_sgt->hash_entry,
+		 nvmap_sgt_stash_key(attach->dev, dir));
+	info->nr_maps++;
+
+	nvmap_dmabuf_stash_evict_locked(attach->dmabuf);
 
 	return 0;
 }
@@ -139,18 +222,19 @@ static struct sg_table *nvmap_dmabuf_get_sgt_from_stash(struct dma_buf_attachmen
 {
 	struct nvmap_handle_info *info = attach->dmabuf->priv;
 	struct nvmap_handle_sgt *nvmap_sgt;
-	struct sg_table *sgt = NULL;
 
-	list_for_each_entry(nvmap_sgt, &info->maps, maps_entry) {
-		if (nvmap_sgt->dir != dir || nvmap_sgt->dev != attach->dev)
-			continue;
-
-		/* found sgt in stash */
-		sgt = nvmap_sgt->sgt;
-		break;
+	nvmap_sgt = nvmap_dmabuf_stash_lookup_locked(info, attach->dev, dir);
+	if (!nvmap_sgt) {
+		trace_nvmap_dmabuf_stash_miss(attach->dmabuf, attach->dev);
+		return NULL;
 	}
 
-	return sgt;
+	/* found sgt in stash, keep the list in LRU order */
+	trace_nvmap_dmabuf_stash_hit(attach->dmabuf, attach->dev);
+	list_move(&nvmap_sgt->maps_entry, &info->maps);
+	nvmap_sgt->users++;
+
+	return nvmap_sgt->sgt;
 }
 
 static struct sg_table *nvmap_dmabuf_map_dma_buf(struct dma_buf_attachment *attach,
@@ -260,6 +344,7 @@ static void nvmap_dmabuf_unmap_dma_buf(struct dma_buf_attachment *attach,
 				       enum dma_data_direction dir)
 {
 	struct nvmap_handle_info *info = attach->dmabuf->priv;
+	struct nvmap_handle_sgt *nvmap_sgt;
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	char *device_name = NULL;
 	u32 heap_type = 0;
@@ -274,6 +359,12 @@ static void nvmap_dmabuf_unmap_dma_buf(struct dma_buf_attachment *attach,
 		return;
 	}
 
+	nvmap_sgt = nvmap_dmabuf_stash_lookup_locked(info, attach->dev, dir);
+	if (nvmap_sgt && nvmap_sgt->sgt == sgt && nvmap_sgt->users) {
+		nvmap_sgt->users--;
+		nvmap_dmabuf_stash_evict_locked(attach->dmabuf);
+	}
+
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	/* Remove the device name from the list of carveout accessing devices */
 	heap_type = info->handle->heap_type;
@@ -299,9 +390,7 @@ static void nvmap_dmabuf_release(struct dma_buf *dmabuf)
 		nvmap_sgt = list_first_entry(&info->maps,
 					     struct nvmap_handle_sgt,
 					     maps_entry);
-		__nvmap_dmabuf_unmap_dma_buf(nvmap_sgt);
-		list_del(&nvmap_sgt->maps_entry);
-		kmem_cache_free(handle_sgt_cache, nvmap_sgt);
+		nvmap_dmabuf_stash_free_locked(nvmap_sgt);
 	}
 	mutex_unlock(&info->maps_lock);
 
@@ -616,6 +705,7 @@ struct dma_buf *__nvmap_make_dmabuf(struct nvmap_client *client,
 	info->handle = handle;
 	info->is_ro = ro_buf;
 	INIT_LIST_HEAD(&info->maps);
+	hash_init(info->maps_hash);
 	mutex_init(&info->maps_lock);
 
 	dmabuf = __dma_buf_export(info, handle->size, ro_buf);
@@ -5,11 +5,23 @@
 
 #define pr_fmt(fmt)	"%s: " fmt, __func__
 
+#include <nvidia/conftest.h>
+
 #include <trace/events/nvmap.h>
 #include <linux/highmem.h>
+#include <linux/huge_mm.h>
+#include <linux/moduleparam.h>
+#include <linux/pfn_t.h>
 
 #include "nvmap_priv.h"
 
+/*
+ * Number of carveout pages mapped by a single fault, starting at the
+ * faulting one.
+ */
+static uint fault_around_pages = 16;
+module_param(fault_around_pages, uint, 0644);
+
 static void nvmap_vma_close(struct vm_area_struct *vma);
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
@@ -21,10 +33,24 @@ static int nvmap_vma_fault(struct vm_fault *vmf);
 static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf);
 #endif
 
+#if defined(CONFIG_TRANSPARENT_HUGEPAGE) && \
+	LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
+#define NVMAP_HUGE_FAULT
+#if defined(NV_VM_OPERATIONS_STRUCT_HUGE_FAULT_HAS_ORDER_ARG) /* Linux v6.6 */
+static vm_fault_t nvmap_vma_huge_fault(struct vm_fault *vmf, unsigned int order);
+#else
+static vm_fault_t nvmap_vma_huge_fault(struct vm_fault *vmf,
+				       enum page_entry_size pe_size);
+#endif
+#endif
+
 struct vm_operations_struct nvmap_vma_ops = {
 	.open		= nvmap_vma_open,
 	.close		= nvmap_vma_close,
 	.fault		= nvmap_vma_fault,
+#ifdef NVMAP_HUGE_FAULT
+	.huge_fault	= nvmap_vma_huge_fault,
+#endif
 };
 
 int is_nvmap_vma(struct vm_area_struct *vma)
@@ -165,6 +191,78 @@ static void nvmap_vma_close(struct vm_area_struct *vma)
 	}
 }
 
+/* Number of pages to resolve for a fault at addr, handle offset offs */
+static size_t nvmap_fault_around_nr(struct vm_area_struct *vma,
+				    unsigned long addr, size_t offs,
+				    size_t size)
+{
+	size_t nr = max_t(size_t, fault_around_pages, 1);
+
+	nr = min_t(size_t, nr, (vma->vm_end - addr) >> PAGE_SHIFT);
+	nr = min_t(size_t, nr, (size - offs) >> PAGE_SHIFT);
+	return max_t(size_t, nr, 1);
+}
+
+#ifdef NVMAP_HUGE_FAULT
+/*
+ * Map carveout memory with a PMD when the faulting 2M block is fully
+ * inside both the VMA and the handle and physically 2M aligned. Anything
+ * else falls back to the PTE fault path.
+ */
+#if defined(NV_VM_OPERATIONS_STRUCT_HUGE_FAULT_HAS_ORDER_ARG) /* Linux v6.6 */
+static vm_fault_t nvmap_vma_huge_fault(struct vm_fault *vmf, unsigned int order)
+#else
+static vm_fault_t nvmap_vma_huge_fault(struct vm_fault *vmf,
+				       enum page_entry_size pe_size)
+#endif
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct nvmap_vma_priv *priv = vma->vm_private_data;
+	unsigned long addr = vmf->address & PMD_MASK;
+	struct nvmap_handle *h;
+	phys_addr_t phys;
+	unsigned long offs, pfn;
+
+#if defined(NV_VM_OPERATIONS_STRUCT_HUGE_FAULT_HAS_ORDER_ARG) /* Linux v6.6 */
+	if (order != PMD_SHIFT - PAGE_SHIFT)
+		return VM_FAULT_FALLBACK;
+#else
+	if (pe_size != PE_SIZE_PMD)
+		return VM_FAULT_FALLBACK;
+#endif
+
+	if (!priv || !priv->handle || !priv->handle->alloc)
+		return VM_FAULT_FALLBACK;
+
+	h = priv->handle;
+	if (h->pgalloc.pages || !(vma->vm_flags & VM_PFNMAP))
+		return VM_FAULT_FALLBACK;
+
+	if (addr < vma->vm_start || addr + PMD_SIZE > vma->vm_end)
+		return VM_FAULT_FALLBACK;
+
+	offs = addr - vma->vm_start + priv->offs + (vma->vm_pgoff << PAGE_SHIFT);
+	if (offs + PMD_SIZE > h->size)
+		return VM_FAULT_FALLBACK;
+
+	phys = h->carveout->base + offs;
+	if (phys & ~PMD_MASK)
+		return VM_FAULT_FALLBACK;
+
+	/*
+	 * Only carveouts without struct pages are mapped as PFN_DEV; CMA
+	 * backed carveouts take the page based PTE path.
+	 */
+	pfn = PHYS_PFN(phys);
+	if (!IS_ALIGNED(pfn, PTRS_PER_PMD) ||
+	    pfn_valid(pfn) || pfn_valid(pfn + PTRS_PER_PMD - 1))
+		return VM_FAULT_FALLBACK;
+
+	return vmf_insert_pfn_pmd(vmf, phys_to_pfn_t(phys, PFN_DEV),
+				  vmf->flags & FAULT_FLAG_WRITE);
+}
+#endif /* NVMAP_HUGE_FAULT */
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
 static vm_fault_t nvmap_vma_fault(struct vm_fault *vmf)
 #define vm_insert_pfn vmf_insert_pfn
@@ -199,12 +297,23 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 
 	if (!priv->handle->pgalloc.pages) {
 		unsigned long pfn;
+		size_t i, nr;
 
 		BUG_ON(priv->handle->carveout->base & ~PAGE_MASK);
 		pfn = ((priv->handle->carveout->base + offs) >> PAGE_SHIFT);
 		if (!pfn_valid(pfn)) {
-			vm_insert_pfn(vma,
-				(unsigned long)vmf_address, pfn);
+			/* Carveouts are contiguous, map the neighbours too */
+			nr = nvmap_fault_around_nr(vma, (unsigned long)vmf_address,
+						   offs, priv->handle->size);
+			vm_insert_pfn(vma, (unsigned long)vmf_address, pfn);
+			for (i = 1; i < nr; i++) {
+				if (pfn_valid(pfn + i))
+					break;
+				if (vm_insert_pfn(vma, (unsigned long)vmf_address +
+						  (i << PAGE_SHIFT), pfn + i) &
+				    VM_FAULT_ERROR)
+					break;
+			}
 			return VM_FAULT_NOPAGE;
 		}
 		/* CMA memory would get here */
@@ -235,6 +344,7 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 
 			if (!nvmap_handle_track_dirty(priv->handle))
 				goto finish;
+
 			mutex_lock(&priv->handle->lock);
 			if (nvmap_page_dirty(priv->handle->pgalloc.pages[offs])) {
 				mutex_unlock(&priv->handle->lock);
@@ -247,10 +357,6 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 			inner_cache_maint(NVMAP_CACHE_OP_WB_INV, kaddr, PAGE_SIZE);
 			kunmap(page);
 
-			if (priv->handle->flags & NVMAP_HANDLE_INNER_CACHEABLE)
-				goto make_dirty;
-
-make_dirty:
 			nvmap_page_mkdirty(&priv->handle->pgalloc.pages[offs]);
 			atomic_inc(&priv->handle->pgalloc.ndirty);
 			mutex_unlock(&priv->handle->lock);
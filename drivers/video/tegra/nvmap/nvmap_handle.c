@@ -11,10 +11,15 @@
 
 #include <linux/err.h>
 #include <linux/io.h>
+#include <linux/completion.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/rbtree.h>
+#include <linux/rcupdate.h>
+#include <linux/rhashtable.h>
 #include <linux/dma-buf.h>
 #include <linux/moduleparam.h>
 #include <linux/nvmap.h>
@@ -58,12 +63,39 @@ struct nvmap_handle_ref *__nvmap_validate_locked(struct nvmap_client *c,
 
 	return NULL;
 }
-/* adds a newly-created handle to the device master tree */
+/*
+ * The device master tree is kept for ordered walks, lookups by handle go
+ * through this hash under RCU so that they don't take handle_lock.
+ */
+static const struct rhashtable_params nvmap_handle_ht_params = {
+	.key_len = sizeof(struct nvmap_handle *),
+	.key_offset = offsetof(struct nvmap_handle, ht_key),
+	.head_offset = offsetof(struct nvmap_handle, ht_node),
+	.automatic_shrinking = true,
+};
+
+int nvmap_handle_ht_init(struct nvmap_device *dev)
+{
+	return rhashtable_init(&dev->handle_ht, &nvmap_handle_ht_params);
+}
+
+void nvmap_handle_ht_destroy(struct nvmap_device *dev)
+{
+	rhashtable_destroy(&dev->handle_ht);
+}
+
+/*
+ * Adds a fully set up handle to the device master tree and publishes it
+ * to nvmap_validate_get(). If the hash insert fails the handle is still
+ * found through the tree, only more slowly.
+ */
 void nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h)
 {
 	struct rb_node **p;
 	struct rb_node *parent = NULL;
 
+	h->ht_key = h;
+
 	spin_lock(&dev->handle_lock);
 	p = &dev->handles.rb_node;
 	while (*p) {
@@ -85,6 +117,9 @@ void nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h)
 	 * lock on handle_lock.
 	 */
 	h->serial_id = dev->serial_id_counter++;
+	if (rhashtable_insert_fast(&dev->handle_ht, &h->ht_node,
+				   nvmap_handle_ht_params))
+		pr_debug("handle %p not hashed\n", h);
 	spin_unlock(&dev->handle_lock);
 }
 
@@ -106,14 +141,15 @@ int nvmap_handle_remove(struct nvmap_device *dev, struct nvmap_handle *h)
 
 	nvmap_lru_del(h);
 	rb_erase(&h->node, &dev->handles);
+	rhashtable_remove_fast(&dev->handle_ht, &h->ht_node,
+			       nvmap_handle_ht_params);
 
 	spin_unlock(&dev->handle_lock);
 	return 0;
 }
 
-/* Validates that a handle is in the device master tree and that the
- * client has permission to access it. */
-struct nvmap_handle *nvmap_validate_get(struct nvmap_handle *id)
+/* Slow path of nvmap_validate_get() for handles missing from the hash */
+static struct nvmap_handle *nvmap_validate_get_tree(struct nvmap_handle *id)
 {
 	struct nvmap_handle *h = NULL;
 	struct rb_node *n;
@@ -138,6 +174,31 @@ struct nvmap_handle *nvmap_validate_get(struct nvmap_handle *id)
 	return NULL;
 }
 
+/* Validates that a handle is in the device master tree and that the
+ * client has permission to access it. Handles are freed after an RCU
+ * grace period, so this doesn't need to take handle_lock. */
+struct nvmap_handle *nvmap_validate_get(struct nvmap_handle *id)
+{
+	struct nvmap_handle *h;
+
+	rcu_read_lock();
+	h = rhashtable_lookup(&nvmap_dev->handle_ht, &id,
+			      nvmap_handle_ht_params);
+	if (!h) {
+		rcu_read_unlock();
+		return nvmap_validate_get_tree(id);
+	}
+	/* a handle without references is being freed */
+	if (!atomic_inc_not_zero(&h->ref))
+		h = NULL;
+	rcu_read_unlock();
+
+	if (h)
+		NVMAP_TAG_TRACE(trace_nvmap_handle_get, h,
+				atomic_read(&h->ref));
+	return h;
+}
+
 static void add_handle_ref(struct nvmap_client *client,
 			   struct nvmap_handle_ref *ref)
 {
@@ -247,6 +308,7 @@ struct nvmap_handle_ref *nvmap_create_handle(struct nvmap_client *client,
 
 	INIT_LIST_HEAD(&h->pg_ref_h);
 	init_waitqueue_head(&h->waitq);
+
 	/*
 	 * This takes out 1 ref on the dambuf. This corresponds to the
 	 * handle_ref that gets automatically made by nvmap_create_handle().
@@ -552,3 +614,109 @@ struct nvmap_handle_ref *nvmap_dup_handle_ro(struct nvmap_client *client,
 
 	return ref;
 }
+
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+/*
+ * Handle lookup benchmark. Writing N to the handle_bench_threads module
+ * parameter runs N threads which repeatedly validate and put one live
+ * handle, and reports the aggregate lookup throughput so that
+ * scaling with the number of looking up threads can be compared.
+ */
+#define HANDLE_BENCH_LOOPS	(1 << 20)
+
+struct handle_bench_thread {
+	struct completion done;
+	struct nvmap_handle *h;
+	u64 lookups;
+};
+
+static int handle_bench_threads;
+
+static int handle_bench_fn(void *arg)
+{
+	struct handle_bench_thread *t = arg;
+	struct nvmap_handle *h;
+	int i;
+
+	for (i = 0; i < HANDLE_BENCH_LOOPS; i++) {
+		h = nvmap_validate_get(t->h);
+		if (WARN_ON(!h))
+			break;
+		nvmap_handle_put(h);
+		t->lookups++;
+
+		if (!(i & 1023))
+			cond_resched();
+	}
+
+	complete(&t->done);
+	return 0;
+}
+
+static int handle_bench_set(const char *arg, const struct kernel_param *kp)
+{
+	struct handle_bench_thread *threads;
+	struct nvmap_handle *h = NULL;
+	struct task_struct *task;
+	struct rb_node *n;
+	u64 t1, t2, lookups = 0;
+	int i, ret, started = 0;
+
+	ret = param_set_int(arg, kp);
+	if (ret || handle_bench_threads <= 0 || !nvmap_dev)
+		return ret;
+
+	/* Any live handle will do, hold it for the duration of the run */
+	spin_lock(&nvmap_dev->handle_lock);
+	n = rb_first(&nvmap_dev->handles);
+	if (n)
+		h = nvmap_handle_get(rb_entry(n, struct nvmap_handle, node));
+	spin_unlock(&nvmap_dev->handle_lock);
+	if (!h)
+		return -ENODEV;
+
+	threads = kcalloc(handle_bench_threads, sizeof(*threads), GFP_KERNEL);
+	if (!threads) {
+		nvmap_handle_put(h);
+		return -ENOMEM;
+	}
+
+	t1 = ktime_get_ns();
+	for (i = 0; i < handle_bench_threads; i++) {
+		init_completion(&threads[i].done);
+		threads[i].h = h;
+		task = kthread_run(handle_bench_fn, &threads[i],
+				   "nvmap-hb/%d", i);
+		if (IS_ERR(task))
+			break;
+		started++;
+	}
+
+	for (i = 0; i < started; i++) {
+		wait_for_completion(&threads[i].done);
+		lookups += threads[i].lookups;
+	}
+	t2 = ktime_get_ns();
+
+	pr_info("threads=%d lookups=%llu time=%lluns lookups/sec=%llu\n",
+		started, lookups, t2 - t1,
+		div64_u64(lookups * NSEC_PER_SEC, max_t(u64, t2 - t1, 1)));
+
+	kfree(threads);
+	nvmap_handle_put(h);
+	return 0;
+}
+
+static int handle_bench_get(char *buff, const struct kernel_param *kp)
+{
+	return param_get_int(buff, kp);
+}
+
+static struct kernel_param_ops handle_bench_ops = {
+	.get = handle_bench_get,
+	.set = handle_bench_set,
+};
+
+module_param_cb(handle_bench_threads, &handle_bench_ops,
+		&handle_bench_threads, 0644);
+#endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
@@ -12,7 +12,9 @@
 #include <linux/fs.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/nvmap.h>
@@ -1090,6 +1092,43 @@ exit:
 	return err;
 }
 
+/*
+ * Read one byte from every page of a freshly mapped handle and report how
+ * long it took, so that fault path changes can be compared. Whether the
+ * range is backed by nvmap is not checked, it is only a timing aid.
+ */
+int nvmap_ioctl_first_touch_test(struct file *filp, void __user *arg)
+{
+	struct nvmap_first_touch_test op;
+	const char __user *va;
+	u64 off, t1, t2;
+	char val;
+
+	if (copy_from_user(&op, arg, sizeof(op)))
+		return -EFAULT;
+
+	if (!op.size || (op.va & ~PAGE_MASK))
+		return -EINVAL;
+
+	va = u64_to_user_ptr(op.va);
+	t1 = ktime_get_ns();
+	for (off = 0; off < op.size; off += PAGE_SIZE) {
+		if (get_user(val, va + off))
+			return -EFAULT;
+	}
+	t2 = ktime_get_ns();
+
+	op.time_ns = t2 - t1;
+	op.bandwidth = div64_u64(op.size * NSEC_PER_SEC,
+				 max_t(u64, op.time_ns, 1));
+	pr_debug("first touch of %llu bytes took %lluns\n", op.size, op.time_ns);
+
+	if (copy_to_user(arg, &op, sizeof(op)))
+		return -EFAULT;
+
+	return 0;
+}
+
 int nvmap_ioctl_set_tag_label(struct file *filp, void __user *arg)
 {
 	struct nvmap_set_tag_label op;
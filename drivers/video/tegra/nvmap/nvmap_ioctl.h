@@ -48,6 +48,8 @@ int nvmap_ioctl_cache_maint_list(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_gup_test(struct file *filp, void __user *arg);
 
+int nvmap_ioctl_first_touch_test(struct file *filp, void __user *arg);
+
 int nvmap_ioctl_set_tag_label(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_get_available_heaps(struct file *filp, void __user *arg);
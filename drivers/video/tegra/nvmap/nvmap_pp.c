@@ -18,6 +18,11 @@
 #include <linux/debugfs.h>
 #include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/completion.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
 #include <linux/version.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
@@ -55,57 +60,75 @@ static inline void __pp_dbg_var_add(u64 *dbg_var, u32 nr)
 static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 				       struct page **pages, u32 nr);
 
-static inline struct page *get_zero_list_page(struct nvmap_page_pool *pool, bool use_numa,
-					int numa_id)
+/*
+ * Return the list of the node the caller wants pages from. Without
+ * use_numa the local node is preferred and the remaining nodes are used
+ * as fallback, so that the lookup stays O(nr_node_ids) instead of being
+ * a walk over every page in the pool.
+ */
+static struct list_head *pp_node_list(struct nvmap_page_pool *pool,
+				      size_t list_off, bool use_numa,
+				      int numa_id)
 {
-	struct page *page, *tmp;
 	int nid = numa_id == NUMA_NO_NODE ? numa_mem_id() : numa_id;
+	struct list_head *head;
 
-	trace_get_zero_list_page(pool->to_zero);
-
-	if (list_empty(&pool->zero_list))
+	if (nid >= 0 && nid < nr_node_ids) {
+		head = (void *)&pool->nodes[nid] + list_off;
+		if (use_numa || !list_empty(head))
+			return head;
+	} else if (use_numa) {
 		return NULL;
+	}
 
-	if (!use_numa) {
-		page = list_first_entry(&pool->zero_list, struct page, lru);
-		goto exit;
-	} else {
-		list_for_each_entry_safe(page, tmp, &pool->zero_list, lru)
-			if (page_to_nid(page) == nid)
-				goto exit;
+	for_each_node(nid) {
+		head = (void *)&pool->nodes[nid] + list_off;
+		if (!list_empty(head))
+			return head;
 	}
+
 	return NULL;
+}
+
+#define pp_list(pool, member, use_numa, numa_id)			\
+	pp_node_list(pool, offsetof(struct nvmap_pp_node, member),	\
+		     use_numa, numa_id)
 
-exit:
+static inline struct page *pp_list_take(struct list_head *head)
+{
+	struct page *page;
+
+	if (!head || list_empty(head))
+		return NULL;
+
+	page = list_first_entry(head, struct page, lru);
 	list_del(&page->lru);
-	pool->to_zero--;
 	return page;
 }
 
-static inline struct page *get_page_list_page(struct nvmap_page_pool *pool, bool use_numa,
+static inline struct page *get_zero_list_page(struct nvmap_page_pool *pool, bool use_numa,
 					int numa_id)
 {
-	struct page *page, *tmp;
-	int nid = numa_id == NUMA_NO_NODE ? numa_mem_id() : numa_id;
+	struct page *page;
 
-	trace_get_page_list_page(pool->count);
+	trace_get_zero_list_page(pool->to_zero);
 
-	if (list_empty(&pool->page_list))
-		return NULL;
+	page = pp_list_take(pp_list(pool, zero_list, use_numa, numa_id));
+	if (page)
+		pool->to_zero--;
+	return page;
+}
 
-	if (!use_numa) {
-		page = list_first_entry(&pool->page_list, struct page, lru);
-		goto exit;
-	} else {
-		list_for_each_entry_safe(page, tmp, &pool->page_list, lru)
-			if (page_to_nid(page) == nid)
-				goto exit;
-	}
-	return NULL;
+static inline struct page *get_page_list_page(struct nvmap_page_pool *pool, bool use_numa,
+					int numa_id)
+{
+	struct page *page;
 
-exit:
-	list_del(&page->lru);
-	pool->count--;
+	trace_get_page_list_page(pool->count);
+
+	page = pp_list_take(pp_list(pool, page_list, use_numa, numa_id));
+	if (page)
+		pool->count--;
 	return page;
 }
 
@@ -113,35 +136,131 @@ exit:
 static inline struct page *get_page_list_page_bp(struct nvmap_page_pool *pool, bool use_numa,
 					int numa_id)
 {
-	struct page *page, *tmp;
-	int nid = numa_id == NUMA_NO_NODE ? numa_mem_id() : numa_id;
+	struct page *page;
 
 	trace_get_page_list_page_bp(pool->big_page_count);
 
-	if (list_empty(&pool->page_list_bp))
-		return NULL;
-
-	if (!use_numa) {
-		page = list_first_entry(&pool->page_list_bp, struct page, lru);
-		goto exit;
-	} else {
-		list_for_each_entry_safe(page, tmp, &pool->page_list_bp, lru)
-			if (page_to_nid(page) == nid)
-				goto exit;
+	page = pp_list_take(pp_list(pool, page_list_bp, use_numa, numa_id));
+	if (page) {
+		pool->count -= pool->pages_per_big_pg;
+		pool->big_page_count -= pool->pages_per_big_pg;
 	}
-	return NULL;
-
-exit:
-	list_del(&page->lru);
-	pool->count -= pool->pages_per_big_pg;
-	pool->big_page_count -= pool->pages_per_big_pg;
 	return page;
 }
 #endif /* CONFIG_ARM64_4K_PAGES */
 
+static inline bool pp_lists_empty(struct nvmap_page_pool *pool)
+{
+	int nid;
+
+	for_each_node(nid) {
+		if (!list_empty(&pool->nodes[nid].page_list) ||
+		    !list_empty(&pool->nodes[nid].zero_list))
+			return false;
+#ifdef CONFIG_ARM64_4K_PAGES
+		if (!list_empty(&pool->nodes[nid].page_list_bp))
+			return false;
+#endif /* CONFIG_ARM64_4K_PAGES */
+	}
+
+	return true;
+}
+
+/*
+ * Take up to nr zeroed pages from the current CPU's magazine. This does
+ * not touch the pool lock; the magazine lock is only contended when the
+ * task migrates or the pool is being drained.
+ */
+static u32 pp_pcp_alloc(struct nvmap_page_pool *pool, struct page **pages,
+			u32 nr, bool use_numa, int nid)
+{
+	struct nvmap_pp_pcp *pcp = raw_cpu_ptr(pool->pcp);
+	u32 ind = 0;
+
+	spin_lock(&pcp->lock);
+	if (!use_numa || pcp->nid == nid) {
+		while (ind < nr && pcp->nr)
+			pages[ind++] = pcp->pages[--pcp->nr];
+	}
+	spin_unlock(&pcp->lock);
+
+	if (ind)
+		atomic_sub(ind, &pool->pcp_count);
+	return ind;
+}
+
+/*
+ * Top up the current CPU's magazine from the page list of node nid.
+ *
+ * You must lock the page pool before using this.
+ */
+static void pp_pcp_refill_locked(struct nvmap_page_pool *pool, int nid)
+{
+	struct nvmap_pp_pcp *pcp = raw_cpu_ptr(pool->pcp);
+	struct list_head *head;
+	u32 moved = 0;
+
+	if (nid < 0 || nid >= nr_node_ids)
+		return;
+	head = &pool->nodes[nid].page_list;
+
+	spin_lock(&pcp->lock);
+	/* Never mix pages of different nodes in one magazine */
+	if (pcp->nr && pcp->nid != nid)
+		goto out;
+
+	pcp->nid = nid;
+	while (pcp->nr < NVMAP_PP_PCP_BATCH && !list_empty(head)) {
+		pcp->pages[pcp->nr++] = pp_list_take(head);
+		moved++;
+	}
+out:
+	spin_unlock(&pcp->lock);
+
+	pool->count -= moved;
+	atomic_add(moved, &pool->pcp_count);
+}
+
+/*
+ * Return the pages of every per-CPU magazine to their node lists.
+ *
+ * You must lock the page pool before using this.
+ */
+static void pp_pcp_drain_locked(struct nvmap_page_pool *pool)
+{
+	struct nvmap_pp_pcp *pcp;
+	struct page *page;
+	u32 moved = 0;
+	int cpu;
+
+	if (!pool->pcp)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock(&pcp->lock);
+		while (pcp->nr) {
+			page = pcp->pages[--pcp->nr];
+			list_add(&page->lru,
+				 &pool->nodes[page_to_nid(page)].page_list);
+			moved++;
+		}
+		spin_unlock(&pcp->lock);
+	}
+
+	atomic_sub(moved, &pool->pcp_count);
+	pool->count += moved;
+}
+
+/* Pages held by the pool which count against pool->max. */
+static inline u32 pp_total_pages(struct nvmap_page_pool *pool)
+{
+	return pool->count + atomic_read(&pool->pcp_count);
+}
+
 static inline bool nvmap_bg_should_run(struct nvmap_page_pool *pool)
 {
-	return !list_empty(&pool->zero_list);
+	return READ_ONCE(pool->to_zero) != 0;
 }
 
 static void nvmap_pp_zero_pages(struct page **pages, int nr)
@@ -252,6 +371,8 @@ static ulong nvmap_page_pool_free_pages_locked(struct nvmap_page_pool *pool,
 
 	pr_debug("req to release pages=%ld\n", nr_pages);
 
+	pp_pcp_drain_locked(pool);
+
 	while (nr_pages) {
 
 #ifdef CONFIG_ARM64_4K_PAGES
@@ -314,10 +435,19 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 	u32 ind = 0;
 	u32 non_zero_idx;
 	u32 non_zero_cnt = 0;
+	int nid = numa_id == NUMA_NO_NODE ? numa_mem_id() : numa_id;
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+	u32 i;
+#endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
 
 	if (!enable_pp || !nr)
 		return 0;
 
+	/* Small requests are usually served from the per-CPU magazine */
+	ind = pp_pcp_alloc(pool, pages, nr, use_numa, nid);
+	if (ind == nr)
+		goto out;
+
 	rt_mutex_lock(&pool->lock);
 
 	while (ind < nr) {
@@ -336,18 +466,26 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 		}
 
 		pages[ind++] = page;
-#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
-		nvmap_pgcount(page, false);
-		BUG_ON(page_count(page) != 1);
-#endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
 	}
 
+	/* The magazine ran dry on this CPU, refill it in the same section */
+	if (!use_numa || nid == numa_mem_id())
+		pp_pcp_refill_locked(pool, nid);
+
 	rt_mutex_unlock(&pool->lock);
 
 	/* Zero non-zeroed pages, if any */
 	if (non_zero_cnt)
 		nvmap_pp_zero_pages(&pages[non_zero_idx], non_zero_cnt);
 
+out:
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+	for (i = 0; i < ind; i++) {
+		nvmap_pgcount(pages[i], false);
+		BUG_ON(page_count(pages[i]) != 1);
+	}
+#endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
+
 	pp_alloc_add(pool, ind);
 	pp_hit_add(pool, ind);
 	pp_miss_add(pool, nr - ind);
@@ -431,7 +569,9 @@ static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 		return 0;
 
 	BUG_ON(pool->count > pool->max);
-	real_nr = min_t(u32, pool->max - pool->count, nr);
+	if (pp_total_pages(pool) >= pool->max)
+		return 0;
+	real_nr = min_t(u32, pool->max - pp_total_pages(pool), nr);
 	pages_to_fill = real_nr;
 	if (real_nr == 0)
 		return 0;
@@ -444,13 +584,16 @@ static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 
 #ifdef CONFIG_ARM64_4K_PAGES
 		if (nvmap_is_big_page(pool, pages, ind, pages_to_fill)) {
-			list_add_tail(&pages[ind]->lru, &pool->page_list_bp);
+			list_add_tail(&pages[ind]->lru,
+				      &pool->nodes[page_to_nid(pages[ind])].page_list_bp);
 			ind += pool->pages_per_big_pg;
 			real_nr -= pool->pages_per_big_pg;
 			pool->big_page_count += pool->pages_per_big_pg;
 		} else {
 #endif /* CONFIG_ARM64_4K_PAGES */
-			list_add_tail(&pages[ind++]->lru, &pool->page_list);
+			list_add_tail(&pages[ind]->lru,
+				      &pool->nodes[page_to_nid(pages[ind])].page_list);
+			ind++;
 			real_nr--;
 #ifdef CONFIG_ARM64_4K_PAGES
 		}
@@ -475,7 +618,11 @@ u32 nvmap_page_pool_fill_lots(struct nvmap_page_pool *pool,
 
 	save_to_zero = pool->to_zero;
 
-	ret = min(nr, pool->max - pool->count - pool->to_zero - pool->under_zero);
+	if (pp_total_pages(pool) + pool->to_zero + pool->under_zero >= pool->max)
+		ret = 0;
+	else
+		ret = min(nr, pool->max - pp_total_pages(pool) -
+			  pool->to_zero - pool->under_zero);
 
 	for (i = 0; i < ret; i++) {
 		/* If page has additonal referecnces, Don't add it into
@@ -486,7 +633,8 @@ u32 nvmap_page_pool_fill_lots(struct nvmap_page_pool *pool,
 		if (page_count(pages[i]) > 1) {
 			__free_page(pages[i]);
 		} else {
-			list_add_tail(&pages[i]->lru, &pool->zero_list);
+			list_add_tail(&pages[i]->lru,
+				      &pool->nodes[page_to_nid(pages[i])].zero_list);
 			pool->to_zero++;
 		}
 	}
@@ -510,7 +658,7 @@ ulong nvmap_page_pool_get_unused_pages(void)
 	if (!nvmap_dev)
 		return 0;
 
-	total = nvmap_dev->pool.count + nvmap_dev->pool.to_zero;
+	total = pp_total_pages(&nvmap_dev->pool) + nvmap_dev->pool.to_zero;
 
 	return total;
 }
@@ -525,10 +673,11 @@ int nvmap_page_pool_clear(void)
 
 	rt_mutex_lock(&pool->lock);
 
-	(void)nvmap_page_pool_free_pages_locked(pool, pool->count + pool->to_zero);
+	(void)nvmap_page_pool_free_pages_locked(pool,
+			pp_total_pages(pool) + pool->to_zero);
 
 	/* For some reason, if an error occured... */
-	if (!list_empty(&pool->page_list) || !list_empty(&pool->zero_list)) {
+	if (!pp_lists_empty(pool)) {
 		rt_mutex_unlock(&pool->lock);
 		return -ENOMEM;
 	}
@@ -640,6 +789,100 @@ static struct kernel_param_ops shrink_ops = {
 module_param_cb(shrink_page_pools, &shrink_ops, &shrink_pp, 0644);
 #endif
 
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+/*
+ * Page pool allocation benchmark. Writing N to the pp_bench_threads
+ * module parameter runs N threads which repeatedly allocate and return
+ * PP_BENCH_BATCH pages, and reports the aggregate throughput so that
+ * scaling with the number of allocating threads can be compared.
+ */
+#define PP_BENCH_BATCH	16
+#define PP_BENCH_LOOPS	4096
+
+struct pp_bench_thread {
+	struct completion done;
+	u64 pages;
+};
+
+static int pp_bench_threads;
+
+static int pp_bench_fn(void *arg)
+{
+	struct pp_bench_thread *t = arg;
+	struct nvmap_page_pool *pool = &nvmap_dev->pool;
+	struct page *pages[PP_BENCH_BATCH];
+	int i, got, ret;
+
+	for (i = 0; i < PP_BENCH_LOOPS; i++) {
+		got = nvmap_page_pool_alloc_lots(pool, pages, PP_BENCH_BATCH,
+						 true, NUMA_NO_NODE);
+		t->pages += got;
+
+		/* Pages are untouched, so they can go back as zeroed pages */
+		rt_mutex_lock(&pool->lock);
+		ret = __nvmap_page_pool_fill_lots_locked(pool, pages, got);
+		rt_mutex_unlock(&pool->lock);
+		for (; ret < got; ret++)
+			__free_page(pages[ret]);
+
+		cond_resched();
+	}
+
+	complete(&t->done);
+	return 0;
+}
+
+static int pp_bench_set(const char *arg, const struct kernel_param *kp)
+{
+	struct pp_bench_thread *threads;
+	struct task_struct *task;
+	u64 t1, t2, pages = 0;
+	int i, ret, started = 0;
+
+	ret = param_set_int(arg, kp);
+	if (ret || pp_bench_threads <= 0)
+		return ret;
+
+	threads = kcalloc(pp_bench_threads, sizeof(*threads), GFP_KERNEL);
+	if (!threads)
+		return -ENOMEM;
+
+	t1 = ktime_get_ns();
+	for (i = 0; i < pp_bench_threads; i++) {
+		init_completion(&threads[i].done);
+		task = kthread_run(pp_bench_fn, &threads[i], "nvmap-ppb/%d", i);
+		if (IS_ERR(task))
+			break;
+		started++;
+	}
+
+	for (i = 0; i < started; i++) {
+		wait_for_completion(&threads[i].done);
+		pages += threads[i].pages;
+	}
+	t2 = ktime_get_ns();
+
+	pr_info("threads=%d pages=%llu time=%lluns pages/sec=%llu\n",
+		started, pages, t2 - t1,
+		div64_u64(pages * NSEC_PER_SEC, max_t(u64, t2 - t1, 1)));
+
+	kfree(threads);
+	return 0;
+}
+
+static int pp_bench_get(char *buff, const struct kernel_param *kp)
+{
+	return param_get_int(buff, kp);
+}
+
+static struct kernel_param_ops pp_bench_ops = {
+	.get = pp_bench_get,
+	.set = pp_bench_set,
+};
+
+module_param_cb(pp_bench_threads, &pp_bench_ops, &pp_bench_threads, 0644);
+#endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
+
 static int enable_pp_set(const char *arg, const struct kernel_param *kp)
 {
 	int ret;
@@ -705,6 +948,9 @@ int nvmap_page_pool_debugfs_init(struct dentry *nvmap_root)
 	debugfs_create_u32("page_pool_pages_to_zero",
 			   S_IRUGO, pp_root,
 			   &nvmap_dev->pool.to_zero);
+	debugfs_create_atomic_t("page_pool_pcp_pages",
+			   S_IRUGO, pp_root,
+			   &nvmap_dev->pool.pcp_count);
 #ifdef CONFIG_ARM64_4K_PAGES
 	debugfs_create_u32("page_pool_available_big_pages",
 			   S_IRUGO, pp_root,
@@ -742,14 +988,35 @@ int nvmap_page_pool_init(struct nvmap_device *dev)
 {
 	struct sysinfo info;
 	struct nvmap_page_pool *pool = &dev->pool;
+	int nid, cpu;
 
 	memset(pool, 0x0, sizeof(*pool));
 	rt_mutex_init(&pool->lock);
-	INIT_LIST_HEAD(&pool->page_list);
-	INIT_LIST_HEAD(&pool->zero_list);
+	atomic_set(&pool->pcp_count, 0);
+
+	pool->nodes = kcalloc(nr_node_ids, sizeof(*pool->nodes), GFP_KERNEL);
+	if (!pool->nodes)
+		goto fail;
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		INIT_LIST_HEAD(&pool->nodes[nid].page_list);
+		INIT_LIST_HEAD(&pool->nodes[nid].zero_list);
 #ifdef CONFIG_ARM64_4K_PAGES
-	INIT_LIST_HEAD(&pool->page_list_bp);
+		INIT_LIST_HEAD(&pool->nodes[nid].page_list_bp);
+#endif /* CONFIG_ARM64_4K_PAGES */
+	}
+
+	pool->pcp = alloc_percpu(struct nvmap_pp_pcp);
+	if (!pool->pcp)
+		goto fail;
+	for_each_possible_cpu(cpu) {
+		struct nvmap_pp_pcp *pcp = per_cpu_ptr(pool->pcp, cpu);
 
+		spin_lock_init(&pcp->lock);
+		pcp->nid = NUMA_NO_NODE;
+		pcp->nr = 0;
+	}
+
+#ifdef CONFIG_ARM64_4K_PAGES
 	pool->big_pg_sz = NVMAP_PP_BIG_PAGE_SIZE;
 	pool->pages_per_big_pg = NVMAP_PP_BIG_PAGE_SIZE >> PAGE_SHIFT;
 #endif /* CONFIG_ARM64_4K_PAGES */
@@ -820,7 +1087,25 @@ int nvmap_page_pool_fini(struct nvmap_device *dev)
 		background_allocator = NULL;
 	}
 
-	WARN_ON(!list_empty(&pool->page_list));
+	if (pool->nodes) {
+		/*
+		 * Return whatever is still pooled, including the per-CPU
+		 * magazines, before the list heads go away.
+		 */
+		rt_mutex_lock(&pool->lock);
+		(void)nvmap_page_pool_free_pages_locked(pool, ULONG_MAX);
+		rt_mutex_unlock(&pool->lock);
+
+		WARN_ON(!pp_lists_empty(pool));
+		kfree(pool->nodes);
+		pool->nodes = NULL;
+	}
+
+	if (pool->pcp) {
+		WARN_ON(atomic_read(&pool->pcp_count));
+		free_percpu(pool->pcp);
+		pool->pcp = NULL;
+	}
 
 	return 0;
 }
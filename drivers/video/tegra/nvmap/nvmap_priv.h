@@ -11,10 +11,12 @@
 #include <nvidia/conftest.h>
 
 #include <linux/list.h>
+#include <linux/hashtable.h>
 #include <linux/mm.h>
 #include <linux/mutex.h>
 #include <linux/rtmutex.h>
 #include <linux/rbtree.h>
+#include <linux/rhashtable.h>
 #include <linux/sched.h>
 #include <linux/wait.h>
 #include <linux/atomic.h>
@@ -139,6 +141,7 @@ do {                                                    \
 #endif
 
 struct page;
+struct seq_file;
 struct nvmap_device;
 
 void _nvmap_handle_free(struct nvmap_handle *h);
@@ -147,6 +150,10 @@ extern u32 nvmap_max_handle_count;
 extern u64 nvmap_big_page_allocs;
 extern u64 nvmap_total_page_allocs;
 
+/* Number of chunk sizes tracked by the allocation contiguity histogram */
+#define NVMAP_ALLOC_NR_CHUNK_SIZES	3
+void nvmap_alloc_chunk_hist_show(struct seq_file *s);
+
 extern bool nvmap_convert_iovmm_to_carveout;
 extern bool nvmap_convert_carveout_to_iovmm;
 
@@ -182,6 +189,7 @@ struct nvmap_carveout_node {
 	int			index;
 	phys_addr_t		base;
 	size_t			size;
+	u32			sgt_stash_max;	/* max stashed sgt's per dma-buf */
 };
 
 /* handles allocated as collection of pages */
@@ -224,6 +232,9 @@ struct nvmap_handle_dmabuf_priv {
 
 struct nvmap_handle {
 	struct rb_node node;	/* entry on global handle tree */
+	struct rhash_head ht_node;	/* entry on global handle hash */
+	struct nvmap_handle *ht_key;	/* hash key, the handle itself */
+	struct rcu_head rcu;
 	atomic_t ref;		/* reference count (i.e., # of duplications) */
 	atomic_t pin;		/* pin count */
 	u32 flags;		/* caching flags */
@@ -273,9 +284,16 @@ struct nvmap_handle {
 	u64 serial_id;
 };
 
+/* Number of buckets in the per dma-buf (device, direction) sgt index */
+#define NVMAP_SGT_STASH_HASH_BITS	3
+/* Default cap on stashed sgt's per dma-buf, 0 means no limit */
+#define NVMAP_SGT_STASH_DEFAULT_MAX	16
+
 struct nvmap_handle_info {
 	struct nvmap_handle *handle;
-	struct list_head maps;
+	struct list_head maps;		/* stashed sgt's, most recent first */
+	DECLARE_HASHTABLE(maps_hash, NVMAP_SGT_STASH_HASH_BITS);
+	u32 nr_maps;
 	struct mutex maps_lock;
 	bool is_ro;
 };
@@ -309,22 +327,49 @@ struct nvmap_handle_ref {
 #ifdef CONFIG_ARM64_4K_PAGES
 #define NVMAP_PP_BIG_PAGE_SIZE           (0x10000)
 #endif /* CONFIG_ARM64_4K_PAGES */
+
+/*
+ * Size of the per-CPU magazine of zeroed pages kept in front of the
+ * per-node lists, and the number of pages moved into it on a refill.
+ */
+#define NVMAP_PP_PCP_SIZE                (64)
+#define NVMAP_PP_PCP_BATCH               (NVMAP_PP_PCP_SIZE / 2)
+
+/* Free lists of a single NUMA node, indexed by page_to_nid(). */
+struct nvmap_pp_node {
+	struct list_head page_list;
+	struct list_head zero_list;
+#ifdef CONFIG_ARM64_4K_PAGES
+	struct list_head page_list_bp;
+#endif /* CONFIG_ARM64_4K_PAGES */
+};
+
+/*
+ * Per-CPU magazine of zeroed pages. All pages in a magazine belong to
+ * node @nid so that NUMA aware allocations can be served without taking
+ * the pool lock.
+ */
+struct nvmap_pp_pcp {
+	spinlock_t lock;
+	int nid;
+	u32 nr;
+	struct page *pages[NVMAP_PP_PCP_SIZE];
+};
+
 struct nvmap_page_pool {
 	struct rt_mutex lock;
 	u32 count;      /* Number of pages in the page & dirty list. */
 	u32 max;        /* Max no. of pages in all lists. */
 	u32 to_zero;    /* Number of pages on the zero list */
 	u32 under_zero; /* Number of pages getting zeroed */
+	atomic_t pcp_count; /* Number of pages in the per-CPU magazines */
 #ifdef CONFIG_ARM64_4K_PAGES
 	u32 big_pg_sz;  /* big page size supported(64k, etc.) */
 	u32 big_page_count;   /* Number of zeroed big pages avaialble */
 	u32 pages_per_big_pg; /* Number of pages in big page */
 #endif /* CONFIG_ARM64_4K_PAGES */
-	struct list_head page_list;
-	struct list_head zero_list;
-#ifdef CONFIG_ARM64_4K_PAGES
-	struct list_head page_list_bp;
-#endif /* CONFIG_ARM64_4K_PAGES */
+	struct nvmap_pp_node *nodes;      /* nr_node_ids entries */
+	struct nvmap_pp_pcp __percpu *pcp;
 
 #ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
 	u64 allocs;
@@ -382,6 +427,7 @@ struct nvmap_vma_priv {
 struct nvmap_device {
 	struct rb_root	handles;
 	spinlock_t	handle_lock;
+	struct rhashtable handle_ht;	/* RCU lookup index of handles */
 	struct miscdevice dev_user;
 	struct nvmap_carveout_node *heaps;
 	int nr_heaps;
@@ -400,6 +446,7 @@ struct nvmap_device {
 	struct rb_root	tags;
 	struct mutex	tags_lock;
 	struct mutex carveout_lock; /* needed to serialize carveout creation */
+	u32 iovmm_sgt_stash_max;	/* max stashed sgt's per IOVMM dma-buf */
 	u32 dynamic_dma_map_mask;
 	u32 cpu_access_mask;
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
@@ -569,6 +616,10 @@ void nvmap_free_handle_from_fd(struct nvmap_client *c, int fd);
 
 int nvmap_handle_remove(struct nvmap_device *dev, struct nvmap_handle *h);
 
+int nvmap_handle_ht_init(struct nvmap_device *dev);
+
+void nvmap_handle_ht_destroy(struct nvmap_device *dev);
+
 void nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h);
 
 int is_nvmap_vma(struct vm_area_struct *vma);
@@ -595,6 +646,8 @@ void nvmap_flush_cache(struct page **pages, int numpages);
 int nvmap_cache_maint_phys_range(unsigned int op, phys_addr_t pstart,
 		phys_addr_t pend, int inner, int outer);
 
+void nvmap_cache_debugfs_init(struct dentry *nvmap_root);
+
 int nvmap_do_cache_maint_list(struct nvmap_handle **handles, u64 *offsets,
 			      u64 *sizes, int op, u32 nr_ops, bool is_32);
 int __nvmap_cache_maint(struct nvmap_client *client,
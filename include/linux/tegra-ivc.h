@@ -53,6 +53,10 @@ struct tegra_hv_ivm_cookie {
 #define tegra_ivc_write_poke nv_tegra_ivc_write_poke
 #define tegra_ivc_write_get_next_frame nv_tegra_ivc_write_get_next_frame
 #define tegra_ivc_write_advance nv_tegra_ivc_write_advance
+#define tegra_ivc_write_get_frame nv_tegra_ivc_write_get_frame
+#define tegra_ivc_write_advance_n nv_tegra_ivc_write_advance_n
+#define tegra_ivc_read_get_frame nv_tegra_ivc_read_get_frame
+#define tegra_ivc_read_advance_n nv_tegra_ivc_read_advance_n
 #define tegra_ivc_channel_reset nv_tegra_ivc_channel_reset
 #define tegra_ivc_channel_notified nv_tegra_ivc_channel_notified
 
@@ -69,6 +73,10 @@ int tegra_ivc_write_poke(struct ivc *ivc, const void *buf, size_t off,
 		size_t count);
 void *tegra_ivc_write_get_next_frame(struct ivc *ivc);
 int tegra_ivc_write_advance(struct ivc *ivc);
+void *tegra_ivc_write_get_frame(struct ivc *ivc, uint32_t idx);
+int tegra_ivc_write_advance_n(struct ivc *ivc, uint32_t count);
+void *tegra_ivc_read_get_frame(struct ivc *ivc, uint32_t idx);
+int tegra_ivc_read_advance_n(struct ivc *ivc, uint32_t count);
 int tegra_ivc_channel_notified(struct ivc *ivc);
 void tegra_ivc_channel_reset(struct ivc *ivc);
 
@@ -151,6 +151,21 @@ void *tegra_pcie_edma_initialize(struct tegra_pcie_edma_init_info *info);
 edma_xfer_status_t tegra_pcie_edma_submit_xfer(void *cookie,
 						struct tegra_pcie_edma_xfer_info *tx_info);
 
+/**
+ * @brief: API to chain multiple transfers into one submission. Descriptors of all
+ *         transfers are queued back to back on the channel of tx_info[0] and the
+ *         doorbell is rung once. Only the last descriptor raises an interrupt, the
+ *         complete callback of every transfer is still called in submission order.
+ * @param[in] cookie : cookie data returned in tegra_pcie_edma_initialize() call.
+ * @param[in] tx_info: array of num_xfer EDMA Tx data structures, all with same type and
+ *                     channel_num. Refer struct tegra_pcie_edma_xfer_info for details.
+ * @param[in] num_xfer: Number of entries in tx_info.
+ * @retVal: Refer edma_xfer_status_t. On failure, none of the transfers is queued.
+ */
+edma_xfer_status_t tegra_pcie_edma_submit_xfer_batch(void *cookie,
+						      struct tegra_pcie_edma_xfer_info *tx_info,
+						      u32 num_xfer);
+
 /**
  * @brief: API to stop EDMA engine,.
  * @param[in] cookie : cookie data returned in tegra_pcie_edma_initialize() call.
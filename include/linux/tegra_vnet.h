@@ -6,6 +6,8 @@
 #ifndef PCIE_EPF_TEGRA_DMA_H
 #define PCIE_EPF_TEGRA_DMA_H
 
+#include <linux/version.h>
+
 #ifndef PCI_DEVICE_ID_NVIDIA_JETSON_AGX_NETWORK
 #define PCI_DEVICE_ID_NVIDIA_JETSON_AGX_NETWORK     0x2296
 #endif
@@ -27,6 +29,15 @@
 
 #define TVNET_NAPI_WEIGHT	64
 
+/*
+ * Data queue pairs, each with its own rings, NAPI and interrupt. Bounded by
+ * EP DMA write channels as EP Tx uses one write channel per queue.
+ */
+#define TVNET_MAX_QUEUES	DMA_WR_CHNL_NUM
+
+/* Max packets queued on DMA descriptors before ringing DMA doorbell */
+#define TVNET_TX_BATCH		16
+
 #define RING_COUNT 256
 
 /* Allocate 100% extra desc to handle the drift between empty & full buffer */
@@ -218,6 +229,15 @@ struct bar_md {
 	u64 bar0_base_phy;
 	u32 ep_rx_pkt_offset;
 	u32 ep_rx_pkt_size;
+	/*
+	 * Data queue pairs supported by endpoint. Data rings of queue N follow
+	 * the ones of queue N - 1, offsets above point to queue 0 rings.
+	 */
+	u32 num_queues;
+	/* Data queue pairs used by host, written by host before link up */
+	u32 host_num_queues;
+	/* IRQ generation for data packets per queue, [0] same as irq_data */
+	struct irq_md irq_data_mq[TVNET_MAX_QUEUES];
 };
 
 enum ctrl_msg_type {
@@ -240,6 +260,15 @@ enum data_msg_type {
 	DATA_MSG_FULL_BUF,
 };
 
+enum data_msg_gso_type {
+	DATA_MSG_GSO_NONE,
+	DATA_MSG_GSO_TCPV4,
+	DATA_MSG_GSO_TCPV6,
+};
+
+/* Packet checksum is not computed, csum_start/csum_offset are valid */
+#define DATA_MSG_F_CSUM_PARTIAL	BIT(0)
+
 struct data_msg {
 	u32 msg_id; /* enum data_msg_type */
 	union {
@@ -250,6 +279,12 @@ struct data_msg {
 		struct {
 			u32 packet_size;
 			u64 pcie_address;
+			/* GSO segment size of TSO frame, 0 otherwise */
+			u16 gso_size;
+			u8 gso_type; /* enum data_msg_gso_type */
+			u8 flags; /* DATA_MSG_F_* */
+			u16 csum_start;
+			u16 csum_offset;
 		} full_buffer;
 		u32 reserved[7];
 	} u;
@@ -260,15 +295,20 @@ struct tvnet_counter {
 	u32 *wr;
 };
 
-struct ep_own_cnt {
-	u32 h2ep_ctrl_rd_cnt;
-	u32 ep2h_ctrl_wr_cnt;
+struct ep_own_data_cnt {
 	u32 ep2h_empty_rd_cnt;
 	u32 ep2h_full_wr_cnt;
 	u32 h2ep_full_rd_cnt;
 	u32 h2ep_empty_wr_cnt;
 };
 
+/* Queue 0 data counters keep the single queue layout */
+struct ep_own_cnt {
+	u32 h2ep_ctrl_rd_cnt;
+	u32 ep2h_ctrl_wr_cnt;
+	struct ep_own_data_cnt data[TVNET_MAX_QUEUES];
+};
+
 struct ep_ring_buf {
 	struct ep_own_cnt *ep_cnt;
 	/* Endpoint written message buffers */
@@ -277,15 +317,20 @@ struct ep_ring_buf {
 	struct data_msg *h2ep_empty_msgs;
 };
 
-struct host_own_cnt {
-	u32 h2ep_ctrl_wr_cnt;
-	u32 ep2h_ctrl_rd_cnt;
+struct host_own_data_cnt {
 	u32 ep2h_empty_wr_cnt;
 	u32 ep2h_full_rd_cnt;
 	u32 h2ep_full_wr_cnt;
 	u32 h2ep_empty_rd_cnt;
 };
 
+/* Queue 0 data counters keep the single queue layout */
+struct host_own_cnt {
+	u32 h2ep_ctrl_wr_cnt;
+	u32 ep2h_ctrl_rd_cnt;
+	struct host_own_data_cnt data[TVNET_MAX_QUEUES];
+};
+
 struct host_ring_buf {
 	struct host_own_cnt *host_cnt;
 	/* Host written message buffers */
@@ -294,6 +339,22 @@ struct host_ring_buf {
 	struct data_msg *h2ep_full_msgs;
 };
 
+/* DMA mapped piece of a packet queued for batched transmission */
+struct tvnet_tx_map {
+	dma_addr_t iova;
+	u32 len;
+	bool page;
+};
+
+/* Packet queued on DMA descriptors, pending doorbell and full message */
+struct tvnet_tx_pkt {
+	struct sk_buff *skb;
+	struct netdev_queue *txq;
+	u64 dst_iova;
+	u32 nr_maps;
+	struct tvnet_tx_map map[MAX_SKB_FRAGS + 1];
+};
+
 struct ep2h_empty_list {
 	int len;
 	dma_addr_t iova;
@@ -416,5 +477,73 @@ static inline u32 tvnet_ivc_get_rd_cnt(struct tvnet_counter *counter)
 	return READ_ONCE(*counter->rd);
 }
 
+static inline bool tvnet_xmit_more(struct sk_buff *skb)
+{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0))
+	return netdev_xmit_more();
+#else
+	return skb->xmit_more;
+#endif
+}
+
+/* Describe GSO and checksum offload state of skb in full buffer msg */
+static inline void tvnet_skb_to_full_msg(struct sk_buff *skb,
+					 struct data_msg *msg)
+{
+	struct skb_shared_info *info = skb_shinfo(skb);
+
+	msg->u.full_buffer.gso_size = 0;
+	msg->u.full_buffer.gso_type = DATA_MSG_GSO_NONE;
+	msg->u.full_buffer.flags = 0;
+	msg->u.full_buffer.csum_start = 0;
+	msg->u.full_buffer.csum_offset = 0;
+
+	if (skb->ip_summed == CHECKSUM_PARTIAL) {
+		msg->u.full_buffer.flags = DATA_MSG_F_CSUM_PARTIAL;
+		msg->u.full_buffer.csum_start = skb_checksum_start_offset(skb);
+		msg->u.full_buffer.csum_offset = skb->csum_offset;
+	}
+
+	if (skb_is_gso(skb)) {
+		msg->u.full_buffer.gso_size = info->gso_size;
+		msg->u.full_buffer.gso_type =
+			(info->gso_type & SKB_GSO_TCPV6) ?
+			DATA_MSG_GSO_TCPV6 : DATA_MSG_GSO_TCPV4;
+	}
+}
+
+/*
+ * Restore GSO and checksum offload state of a received frame. TSO frames are
+ * passed up unsegmented, same as packets looped back in the same system.
+ */
+static inline int tvnet_full_msg_to_skb(struct sk_buff *skb,
+					struct data_msg *msg)
+{
+	struct skb_shared_info *info = skb_shinfo(skb);
+	u16 gso_size = msg->u.full_buffer.gso_size;
+
+	if (msg->u.full_buffer.flags & DATA_MSG_F_CSUM_PARTIAL) {
+		if (!skb_partial_csum_set(skb, msg->u.full_buffer.csum_start,
+					  msg->u.full_buffer.csum_offset))
+			return -EINVAL;
+	}
+
+	if (gso_size) {
+		if (msg->u.full_buffer.gso_type == DATA_MSG_GSO_TCPV6)
+			info->gso_type = SKB_GSO_TCPV6;
+		else if (msg->u.full_buffer.gso_type == DATA_MSG_GSO_TCPV4)
+			info->gso_type = SKB_GSO_TCPV4;
+		else
+			return -EINVAL;
+
+		/* Header comes from remote system, let stack validate it */
+		info->gso_type |= SKB_GSO_DODGY;
+		info->gso_size = gso_size;
+		info->gso_segs = 0;
+	}
+
+	return 0;
+}
+
 
 #endif
@@ -105,6 +105,24 @@ regmap_util_write_table_16_as_8(struct regmap *regmap,
 				int num_override_regs,
 				u16 wait_ms_addr, u16 end_addr);
 
+struct regmap_util_table;
+
+int
+regmap_util_compile_table_8(struct regmap *regmap,
+			    const struct reg_8 table[],
+			    const struct reg_8 override_list[],
+			    int num_override_regs,
+			    u16 wait_ms_addr, u16 end_addr,
+			    unsigned int max_burst,
+			    struct regmap_util_table **out);
+
+int
+regmap_util_write_compiled(struct regmap_util_table *tbl);
+
+int
+regmap_util_write_delta(struct regmap_util_table *from,
+			struct regmap_util_table *to);
+
 enum switch_state {
 	SWITCH_OFF,
 	SWITCH_ON,
@@ -549,6 +549,27 @@ DEFINE_EVENT(nvmap_dmabuf_2, nvmap_dmabuf_unmap_dma_buf,
 	TP_ARGS(dbuf, dev)
 );
 
+DEFINE_EVENT(nvmap_dmabuf_2, nvmap_dmabuf_stash_hit,
+	TP_PROTO(struct dma_buf *dbuf,
+		 struct device *dev
+	),
+	TP_ARGS(dbuf, dev)
+);
+
+DEFINE_EVENT(nvmap_dmabuf_2, nvmap_dmabuf_stash_miss,
+	TP_PROTO(struct dma_buf *dbuf,
+		 struct device *dev
+	),
+	TP_ARGS(dbuf, dev)
+);
+
+DEFINE_EVENT(nvmap_dmabuf_2, nvmap_dmabuf_stash_evict,
+	TP_PROTO(struct dma_buf *dbuf,
+		 struct device *dev
+	),
+	TP_ARGS(dbuf, dev)
+);
+
 DEFINE_EVENT(nvmap_dmabuf_1, nvmap_dmabuf_mmap,
 	TP_PROTO(struct dma_buf *dbuf),
 	TP_ARGS(dbuf)
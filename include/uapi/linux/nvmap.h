@@ -88,6 +88,13 @@ struct nvmap_gup_test {
 	__u32 result;		/* result=1 for pass, result=-err for failure */
 };
 
+struct nvmap_first_touch_test {
+	__u64 va;		/* VA of a freshly mmap'ed handle */
+	__u64 size;		/* bytes to touch, one read per page */
+	__u64 time_ns;		/* returns time spent touching the range */
+	__u64 bandwidth;	/* returns first touch bandwidth in bytes/s */
+};
+
 struct nvmap_alloc_handle {
 	__u32 handle;		/* nvmap handle */
 	__u32 heap_mask;	/* heaps to allocate from */
@@ -342,6 +349,10 @@ struct nvmap_fd_for_range_from_list {
 #define NVMAP_IOC_PARAMETERS \
 	_IOR(NVMAP_IOC_MAGIC, 27, struct nvmap_handle_parameters)
 
+/* Measure the cost of first CPU access to a mapped handle */
+#define NVMAP_IOC_FIRST_TOUCH_TEST \
+	_IOWR(NVMAP_IOC_MAGIC, 28, struct nvmap_first_touch_test)
+
 /* START of T124 IOCTLS */
 /* Actually allocates memory from IVM heaps */
 #define NVMAP_IOC_ALLOC_IVM _IOW(NVMAP_IOC_MAGIC, 101, struct nvmap_alloc_ivm_handle)
@@ -75,6 +75,93 @@ struct nvsciipc_map_vuid {
 	uint64_t peer_vuid;
 };
 
+struct nvsciipc_resolve_entry {
+	/* in: endpoint name, used unless NVSCIIPC_RESOLVE_BY_VUID */
+	char ep_name[NVSCIIPC_MAX_EP_NAME];
+	/* in: vuid, used with NVSCIIPC_RESOLVE_BY_VUID */
+	uint64_t vuid;
+	/* out: matching entry, valid when status is 0 */
+	struct nvsciipc_config_entry entry;
+	uint32_t idx;
+	/* out: 0 or -ENOENT */
+	int32_t status;
+};
+
+#define NVSCIIPC_RESOLVE_BY_VUID	(1U << 0)
+
+struct nvsciipc_resolve {
+	/* user pointer to array of struct nvsciipc_resolve_entry */
+	uint64_t entries;
+	uint32_t count;
+	uint32_t flags;
+	/* out: number of entries found */
+	uint32_t num_found;
+	uint32_t reserved;
+};
+
+/*
+ * Read-only endpoint database snapshot
+ *
+ * After NVSCIIPC_IOCTL_SET_DB the endpoint table can be mapped read-only
+ * with mmap() at offset 0 and searched without syscalls. The mapping
+ * starts with struct nvsciipc_db_snapshot_header, @total_size bytes are
+ * mappable.
+ *
+ * @num_eps entries of @entry_size bytes (struct nvsciipc_config_entry) are
+ * at @entries_offset, in the same order as NVSCIIPC_IOCTL_GET_DB_BY_*
+ * report them through idx.
+ *
+ * @name_hash_offset and @vuid_hash_offset point to two open addressed
+ * tables of @hash_size uint32_t slots each (a power of two). A slot holds
+ * an entry index or NVSCIIPC_DB_HASH_EMPTY. A key is searched from slot
+ * (hash & (hash_size - 1)) onwards, wrapping around, until the key matches
+ * or an empty slot is met. Names are hashed with nvsciipc_db_name_hash()
+ * and compared like strncmp() over NVSCIIPC_MAX_EP_NAME bytes, vuids with
+ * nvsciipc_db_vuid_hash(). When keys repeat, the first matching slot holds
+ * the lowest index.
+ *
+ * A snapshot never changes once mapped. A later NVSCIIPC_IOCTL_SET_DB
+ * publishes a new snapshot with a higher @generation and sets @stale in
+ * the old one, clients then map the device again.
+ */
+#define NVSCIIPC_DB_SNAPSHOT_MAGIC	0x4244534EU	/* "NSDB" */
+#define NVSCIIPC_DB_SNAPSHOT_VERSION	1U
+#define NVSCIIPC_DB_HASH_EMPTY		0xFFFFFFFFU
+
+struct nvsciipc_db_snapshot_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t generation;
+	uint32_t stale;
+	uint32_t total_size;
+	uint32_t num_eps;
+	uint32_t entry_size;
+	uint32_t entries_offset;
+	uint32_t hash_size;
+	uint32_t name_hash_offset;
+	uint32_t vuid_hash_offset;
+	uint32_t reserved;
+};
+
+/* FNV-1a over the name, up to its NUL or NVSCIIPC_MAX_EP_NAME bytes */
+static inline uint32_t nvsciipc_db_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261U;
+	uint32_t i;
+
+	for (i = 0U; (i < NVSCIIPC_MAX_EP_NAME) && (name[i] != '\0'); i++) {
+		hash ^= (uint8_t)name[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static inline uint32_t nvsciipc_db_vuid_hash(uint64_t vuid)
+{
+	return (uint32_t)((vuid * 0x61C8864680B583EBULL) >> 32);
+}
+
 /* IOCTL magic number - seen available in ioctl-number.txt*/
 #define NVSCIIPC_IOCTL_MAGIC    0xC3
 
@@ -104,6 +191,10 @@ struct nvsciipc_map_vuid {
 #define NVSCIIPC_IOCTL_GET_VMID \
 	_IOWR(NVSCIIPC_IOCTL_MAGIC, 8, uint32_t)
 
-#define NVSCIIPC_IOCTL_NUMBER_MAX 8
+/* resolve many endpoints by name or vuid in one call */
+#define NVSCIIPC_IOCTL_RESOLVE \
+	_IOWR(NVSCIIPC_IOCTL_MAGIC, 9, struct nvsciipc_resolve)
+
+#define NVSCIIPC_IOCTL_NUMBER_MAX 9
 
 #endif /* __NVSCIIPC_IOCTL_H__ */
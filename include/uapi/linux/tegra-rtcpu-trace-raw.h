@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0-only WITH Linux-syscall-note */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.  All rights reserved.
+ */
+
+#ifndef _UAPI_TEGRA_RTCPU_TRACE_RAW_H
+#define _UAPI_TEGRA_RTCPU_TRACE_RAW_H
+
+#include <linux/types.h>
+
+/*
+ * Raw camera-RTCPU trace ring
+ *
+ * Opening /dev/camrtc-trace switches the trace driver to raw mode: new
+ * firmware events are copied as-is into a ring that the consumer maps
+ * with mmap() instead of being decoded into kernel tracepoints. Only one
+ * consumer may have the device open at a time; closing it returns the
+ * driver to decoding mode.
+ *
+ * The mapping starts with struct camrtc_trace_raw_header followed by
+ * @entries event slots of @entry_size bytes at @data_offset. Each slot
+ * holds one struct camrtc_event_struct as written by the firmware.
+ *
+ * @write_idx and @read_idx are free running counters, the slot of an index
+ * is (idx & (entries - 1)). The kernel only advances @write_idx and the
+ * consumer only advances @read_idx. Events arriving while the ring is full
+ * are dropped and counted in @dropped. poll() reports POLLIN while
+ * write_idx != read_idx.
+ *
+ * @write_idx and @dropped are published copies of state the kernel keeps
+ * to itself, consumer writes to them are overwritten and otherwise
+ * ignored. A @read_idx outside [write_idx - entries, write_idx] is reset
+ * to @write_idx.
+ */
+
+#define CAMRTC_TRACE_RAW_MAGIC		0x57415254U	/* "TRAW" */
+#define CAMRTC_TRACE_RAW_VERSION	1U
+
+struct camrtc_trace_raw_header {
+	__u32 magic;
+	__u32 version;
+	__u32 entry_size;
+	__u32 entries;
+	__u32 data_offset;
+	__u32 reserved;
+	__u64 dropped;
+	__u8 pad0[32];
+	/* producer cache line */
+	__u32 write_idx;
+	__u8 pad1[60];
+	/* consumer cache line */
+	__u32 read_idx;
+	__u8 pad2[60];
+};
+
+#endif
@@ -27,6 +27,8 @@
 #define TEGRA_NVVSE_CMDID_GET_IVC_DB			12
 #define TEGRA_NVVSE_CMDID_TSEC_SIGN_VERIFY		13
 #define TEGRA_NVVSE_CMDID_TSEC_GET_KEYLOAD_STATUS	14
+#define TEGRA_NVVSE_CMDID_RING_SETUP			15
+#define TEGRA_NVVSE_CMDID_RING_ENTER			16
 
 /** Defines the length of the AES-CBC Initial Vector */
 #define TEGRA_NVVSE_AES_IV_LEN				16U
@@ -412,5 +414,113 @@ struct tegra_nvvse_aes_drng_ctl {
 #define NVVSE_IOCTL_CMDID_AES_DRNG _IOWR(TEGRA_NVVSE_IOC_MAGIC, TEGRA_NVVSE_CMDID_AES_DRNG, \
 						struct tegra_nvvse_aes_drng_ctl)
 
+/** Defines the maximum number of entries of the submission ring */
+#define TEGRA_NVVSE_RING_MAX_ENTRIES			4096U
+/** Defines the maximum size of the data area of the submission ring */
+#define TEGRA_NVVSE_RING_MAX_DATA_SIZE			(16U * 1024U * 1024U)
+
+/**
+  * \brief Defines operations accepted on the submission ring.
+  */
+enum tegra_nvvse_ring_op {
+	/** Defines one-shot SHA digest */
+	TEGRA_NVVSE_RING_OP_SHA = 0u,
+	/** Defines one-shot AES CMAC Sign */
+	TEGRA_NVVSE_RING_OP_CMAC_SIGN,
+	/** Defines one-shot AES CMAC Verify */
+	TEGRA_NVVSE_RING_OP_CMAC_VERIFY,
+	/** Defines maximum ring operation, must be last entry */
+	TEGRA_NVVSE_RING_OP_MAX,
+};
+
+/**
+  * \brief Holds the ring indices, placed at offset 0 of the mapping.
+  * Indices are free running and are masked with (entries - 1) by the user.
+  */
+struct tegra_nvvse_ring_hdr {
+	/** [out] Next submission entry to be consumed by the driver */
+	uint32_t	sq_head;
+	/** [in] Next submission entry to be filled by the application */
+	uint32_t	sq_tail;
+	/** [in] Next completion entry to be reaped by the application */
+	uint32_t	cq_head;
+	/** [out] Next completion entry to be filled by the driver */
+	uint32_t	cq_tail;
+};
+
+/**
+  * \brief Holds one submission ring entry.
+  * All offsets are relative to the start of the data area.
+  */
+struct tegra_nvvse_ring_sqe {
+	/** [in] Opaque value copied to the matching completion entry */
+	uint64_t	user_data;
+	/** [in] Holds an operation from enum tegra_nvvse_ring_op */
+	uint32_t	op;
+	/** [in] Holds the SHA type for TEGRA_NVVSE_RING_OP_SHA */
+	uint32_t	sha_type;
+	/** [in] Holds the offset of the input message */
+	uint32_t	src_offset;
+	/** [in] Holds the length of the input message */
+	uint32_t	src_length;
+	/** [in] Holds the offset of the digest or CMAC.
+	 * The driver writes it for SHA and CMAC Sign and reads it for CMAC Verify.
+	 */
+	uint32_t	dst_offset;
+	/** [in] Holds the length of the digest or CMAC */
+	uint32_t	dst_length;
+	/** [in] Holds a keyslot handle for CMAC operations */
+	uint8_t		key_slot[KEYSLOT_SIZE_BYTES];
+	/** [in] Holds the Key length for CMAC operations */
+	uint8_t		key_length;
+	uint8_t		reserved[7];
+};
+
+/**
+  * \brief Holds one completion ring entry.
+  */
+struct tegra_nvvse_ring_cqe {
+	/** [out] user_data of the submission entry */
+	uint64_t	user_data;
+	/** [out] '0' on success, negative errno on failure */
+	int32_t		status;
+	/** [out] CMAC verification result, '0' indicates success */
+	uint32_t	result;
+};
+
+/**
+  * \brief Holds submission ring setup parameters.
+  * On success the ring is mapped by calling mmap() at offset 0 with mmap_size.
+  */
+struct tegra_nvvse_ring_setup_ctl {
+	/** [in] Holds the number of ring entries, must be a power of 2 */
+	uint32_t	entries;
+	/** [in] Holds the size of the data area */
+	uint32_t	data_size;
+	/** [out] Holds the size of the mapping */
+	uint32_t	mmap_size;
+	/** [out] Holds the offset of the submission entries */
+	uint32_t	sq_offset;
+	/** [out] Holds the offset of the completion entries */
+	uint32_t	cq_offset;
+	/** [out] Holds the offset of the data area */
+	uint32_t	data_offset;
+};
+#define NVVSE_IOCTL_CMDID_RING_SETUP _IOWR(TEGRA_NVVSE_IOC_MAGIC, TEGRA_NVVSE_CMDID_RING_SETUP, \
+						struct tegra_nvvse_ring_setup_ctl)
+
+/**
+  * \brief Holds submission ring processing parameters.
+  * Processing stops early when the completion ring is full.
+  */
+struct tegra_nvvse_ring_enter_ctl {
+	/** [in] Holds the maximum number of submission entries to process */
+	uint32_t	to_submit;
+	/** [out] Holds the number of submission entries processed */
+	uint32_t	submitted;
+};
+#define NVVSE_IOCTL_CMDID_RING_ENTER _IOWR(TEGRA_NVVSE_IOC_MAGIC, TEGRA_NVVSE_CMDID_RING_ENTER, \
+						struct tegra_nvvse_ring_enter_ctl)
+
 #endif
 
@@ -6205,6 +6205,28 @@ compile_test() {
             compile_check_conftest "$CODE" "NV_IOMMU_SVA_BIND_DEVICE_HAS_DRVDATA_ARG" "" "types"
         ;;
 
+        vm_operations_struct_huge_fault_has_order_arg)
+            #
+            # Determine if the 'huge_fault' callback of the
+            # 'vm_operations_struct' structure takes an 'order' argument.
+            #
+            # The 'enum page_entry_size' argument was replaced by an
+            # order by commit 1d024e7a8dab ("mm: remove enum
+            # page_entry_size") in v6.6-rc1 (2023-08-18).
+            #
+            CODE="
+            #include <linux/mm.h>
+            vm_fault_t conftest_huge_fault(struct vm_fault *vmf, unsigned int order);
+            void conftest_vm_operations_struct_huge_fault_has_order_arg(void) {
+                struct vm_operations_struct ops = {
+                    .huge_fault = conftest_huge_fault,
+                };
+                (void) ops;
+            }"
+
+            compile_check_conftest "$CODE" "NV_VM_OPERATIONS_STRUCT_HUGE_FAULT_HAS_ORDER_ARG" "" "types"
+        ;;
+
         vm_area_struct_has_const_vm_flags)
             #
             # Determine if the 'vm_area_struct' structure has
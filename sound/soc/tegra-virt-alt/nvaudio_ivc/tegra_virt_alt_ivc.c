@@ -12,7 +12,7 @@
 #include <linux/spinlock.h>
 #include <linux/hardirq.h>
 #include <linux/interrupt.h>
-#include <linux/iopoll.h>
+#include <linux/wait.h>
 #include <soc/tegra/virt/hv-ivc.h>
 
 #include "tegra_virt_alt_ivc.h"
@@ -23,44 +23,28 @@ static struct nvaudio_ivc_ctxt *saved_ivc_ctxt;
 static void nvaudio_ivc_deinit(struct nvaudio_ivc_ctxt *ictxt);
 static int nvaudio_ivc_init(struct nvaudio_ivc_ctxt *ictxt);
 
-int nvaudio_ivc_send_retry(struct nvaudio_ivc_ctxt *ictxt,
-		struct nvaudio_ivc_msg *msg, int size)
+static bool nvaudio_ivc_channel_ready(struct nvaudio_ivc_ctxt *ictxt)
 {
-	int err = 0;
-	int dcnt = 50;
-
-	if (!ictxt || !ictxt->ivck || !msg || !size)
-		return -EINVAL;
-
-	err = nvaudio_ivc_send(ictxt, msg, size);
-
-	while (err < 0 && dcnt--) {
-		udelay(100);
-		err = nvaudio_ivc_send(ictxt, msg, size);
-	}
-	return (dcnt < 0) ? -ETIMEDOUT : err;
-
+	return tegra_hv_ivc_channel_notified(ictxt->ivck) == 0;
 }
-EXPORT_SYMBOL_GPL(nvaudio_ivc_send_retry);
 
-int nvaudio_ivc_send(struct nvaudio_ivc_ctxt *ictxt,
-		struct nvaudio_ivc_msg *msg, int size)
+/*
+ * Write one request frame. With ack_required the request is tagged with
+ * the next sequence number and its reply is matched in nvaudio_ivc_irq.
+ * Never sleeps, returns -EBUSY when the queue or the completion table
+ * is full.
+ */
+static int nvaudio_ivc_write_req(struct nvaudio_ivc_ctxt *ictxt,
+		struct nvaudio_ivc_msg *msg, int size,
+		struct nvaudio_ivc_waiter *waiter)
 {
-	int len = 0;
+	struct nvaudio_ivc_req *req;
 	unsigned long flags = 0;
+	int len = 0;
 	int err = 0;
-	int dcnt = 50;
 
-	if (!ictxt || !ictxt->ivck || !msg || !size)
-		return -EINVAL;
-
-	while (tegra_hv_ivc_channel_notified(ictxt->ivck) != 0) {
-		dev_err(ictxt->dev, "channel notified returns non zero\n");
-		dcnt--;
-		udelay(100);
-		if (!dcnt)
-			return -EIO;
-	}
+	if (!nvaudio_ivc_channel_ready(ictxt))
+		return -EBUSY;
 
 	spin_lock_irqsave(&ictxt->ivck_tx_lock, flags);
 
@@ -69,9 +53,30 @@ int nvaudio_ivc_send(struct nvaudio_ivc_ctxt *ictxt,
 		goto fail;
 	}
 
+	if (msg->ack_required) {
+		spin_lock(&ictxt->lock);
+		if (ictxt->seq_head - ictxt->seq_tail >=
+				NVAUDIO_IVC_MAX_PENDING) {
+			spin_unlock(&ictxt->lock);
+			err = -EBUSY;
+			goto fail;
+		}
+		req = &ictxt->reqs[ictxt->seq_head % NVAUDIO_IVC_MAX_PENDING];
+		req->seq = ictxt->seq_head;
+		req->cmd = msg->cmd;
+		req->waiter = waiter;
+		ictxt->seq_head++;
+		spin_unlock(&ictxt->lock);
+	}
+
 	len = tegra_hv_ivc_write(ictxt->ivck, msg, size);
 	if (len != size) {
 		pr_err("%s: write Error\n", __func__);
+		if (msg->ack_required) {
+			spin_lock(&ictxt->lock);
+			ictxt->seq_head--;
+			spin_unlock(&ictxt->lock);
+		}
 		err = -EIO;
 		goto fail;
 	}
@@ -82,80 +87,170 @@ fail:
 	spin_unlock_irqrestore(&ictxt->ivck_tx_lock, flags);
 	return err;
 }
-EXPORT_SYMBOL_GPL(nvaudio_ivc_send);
 
-int nvaudio_ivc_send_receive(struct nvaudio_ivc_ctxt *ictxt,
-			struct nvaudio_ivc_msg *rx_msg, int size)
+/* Match the replies read from the queue to the oldest pending requests */
+static void nvaudio_ivc_process_rx(struct nvaudio_ivc_ctxt *ictxt)
 {
+	struct nvaudio_ivc_msg reply;
+	struct nvaudio_ivc_waiter *waiter;
+	struct nvaudio_ivc_req *req;
+	int len, err;
+
+	while (tegra_hv_ivc_can_read(ictxt->ivck)) {
+		memset(&reply, 0, sizeof(reply));
+		len = tegra_hv_ivc_read(ictxt->ivck, &reply, sizeof(reply));
+
+		spin_lock(&ictxt->lock);
+		if (ictxt->seq_tail == ictxt->seq_head) {
+			spin_unlock(&ictxt->lock);
+			dev_err(ictxt->dev, "unexpected reply for cmd %d\n",
+				reply.cmd);
+			continue;
+		}
+
+		req = &ictxt->reqs[ictxt->seq_tail % NVAUDIO_IVC_MAX_PENDING];
+		ictxt->seq_tail++;
+		waiter = req->waiter;
+		req->waiter = NULL;
+
+		err = 0;
+		if (len != sizeof(reply)) {
+			dev_err(ictxt->dev, "IVC read failure (msg size error)\n");
+			err = -EIO;
+		} else if (reply.cmd != req->cmd) {
+			dev_err(ictxt->dev, "reply cmd %d for request %u cmd %d\n",
+				reply.cmd, req->seq, req->cmd);
+			err = -EPROTO;
+		}
+
+		if (waiter) {
+			if (!err)
+				memcpy(waiter->msg, &reply, sizeof(reply));
+			waiter->err = err;
+			/* publish msg and err before the caller sees done */
+			smp_store_release(&waiter->done, true);
+		} else if (!err && reply.err) {
+			dev_err(ictxt->dev, "request %u cmd %d failed: %d\n",
+				req->seq, req->cmd, reply.err);
+		}
+		spin_unlock(&ictxt->lock);
+	}
+}
 
-	int len = 0;
-	unsigned long flags = 0, flags1 = 0;
+static irqreturn_t nvaudio_ivc_irq(int irq, void *data)
+{
+	struct nvaudio_ivc_ctxt *ictxt = data;
+
+	if (nvaudio_ivc_channel_ready(ictxt)) {
+		spin_lock(&ictxt->ivck_rx_lock);
+		nvaudio_ivc_process_rx(ictxt);
+		spin_unlock(&ictxt->ivck_rx_lock);
+	}
+
+	/* replies, freed queue space or channel reset done */
+	wake_up_all(&ictxt->wait);
+
+	return IRQ_HANDLED;
+}
+
+int nvaudio_ivc_send_retry(struct nvaudio_ivc_ctxt *ictxt,
+		struct nvaudio_ivc_msg *msg, int size)
+{
 	int err = 0;
-	int dcnt = 50;
-	int status = -1;
-	struct nvaudio_ivc_msg *msg = rx_msg;
+	long ret;
 
 	if (!ictxt || !ictxt->ivck || !msg || !size)
 		return -EINVAL;
 
-	while (tegra_hv_ivc_channel_notified(ictxt->ivck) != 0) {
-		dev_err(ictxt->dev, "channel notified returns non zero\n");
-		dcnt--;
-		udelay(100);
-		if (!dcnt)
-			return -EIO;
-	}
+	might_sleep();
 
-	spin_lock_irqsave(&ictxt->ivck_rx_lock, flags);
-	spin_lock_irqsave(&ictxt->ivck_tx_lock, flags1);
+	ret = wait_event_timeout(ictxt->wait,
+			(err = nvaudio_ivc_send(ictxt, msg, size)) != -EBUSY,
+			usecs_to_jiffies(NVAUDIO_IVC_SEND_TIMEOUT));
 
-	if (!tegra_hv_ivc_can_write(ictxt->ivck)) {
-		err = -EBUSY;
-		spin_unlock_irqrestore(&ictxt->ivck_tx_lock, flags1);
-		goto fail;
-	}
+	return (!ret && err == -EBUSY) ? -ETIMEDOUT : err;
 
-	len = tegra_hv_ivc_write(ictxt->ivck, msg, size);
-	if (len != size) {
-		pr_err("%s: write Error\n", __func__);
-		err = -EIO;
-		spin_unlock_irqrestore(&ictxt->ivck_tx_lock, flags1);
-		goto fail;
-	}
-	spin_unlock_irqrestore(&ictxt->ivck_tx_lock, flags1);
+}
+EXPORT_SYMBOL_GPL(nvaudio_ivc_send_retry);
 
-	err = readx_poll_timeout_atomic(tegra_hv_ivc_can_read, ictxt->ivck,
-			status, status, 10, NVAUDIO_IVC_WAIT_TIMEOUT);
+/*
+ * Send without waiting, safe from atomic context. A reply requested with
+ * ack_required is consumed by the IVC interrupt and only logged on error.
+ */
+int nvaudio_ivc_send(struct nvaudio_ivc_ctxt *ictxt,
+		struct nvaudio_ivc_msg *msg, int size)
+{
+	if (!ictxt || !ictxt->ivck || !msg || !size)
+		return -EINVAL;
 
-	if (err == -ETIMEDOUT) {
-		pr_err("%s: Waited too long for msg reply\n", __func__);
-		goto fail;
-	}
+	return nvaudio_ivc_write_req(ictxt, msg, size, NULL);
+}
+EXPORT_SYMBOL_GPL(nvaudio_ivc_send);
 
-	/* Message available */
-	memset(rx_msg, 0, sizeof(struct nvaudio_ivc_msg));
-	len = tegra_hv_ivc_read(ictxt->ivck,
-				rx_msg,
-				sizeof(struct nvaudio_ivc_msg));
-	if (len != sizeof(struct nvaudio_ivc_msg)) {
-		dev_err(ictxt->dev, "IVC read failure (msg size error)\n");
-		err = -1;
-		goto fail;
+/*
+ * Send a request and sleep until its reply is copied back into rx_msg.
+ * Other requests may be in flight on the channel at the same time.
+ */
+int nvaudio_ivc_send_receive(struct nvaudio_ivc_ctxt *ictxt,
+			struct nvaudio_ivc_msg *rx_msg, int size)
+{
+	struct nvaudio_ivc_waiter waiter = { .msg = rx_msg };
+	unsigned long timeout = usecs_to_jiffies(NVAUDIO_IVC_WAIT_TIMEOUT);
+	unsigned long flags = 0;
+	int err = 0;
+	long ret;
+	u32 seq;
+
+	if (!ictxt || !ictxt->ivck || !rx_msg || !size)
+		return -EINVAL;
+
+	might_sleep();
+
+	/* the reply is what the caller waits for */
+	rx_msg->ack_required = true;
+
+	ret = wait_event_timeout(ictxt->wait,
+			(err = nvaudio_ivc_write_req(ictxt, rx_msg, size,
+						     &waiter)) != -EBUSY,
+			timeout);
+	if (!ret && err == -EBUSY) {
+		pr_err("%s: Waited too long to send msg\n", __func__);
+		return -ETIMEDOUT;
+	}
+	if (err < 0)
+		return err;
+
+	ret = wait_event_timeout(ictxt->wait, smp_load_acquire(&waiter.done),
+				 timeout);
+	if (!ret) {
+		/* detach, a late reply must not touch the caller's msg */
+		spin_lock_irqsave(&ictxt->lock, flags);
+		for (seq = ictxt->seq_tail; seq != ictxt->seq_head; seq++) {
+			if (ictxt->reqs[seq % NVAUDIO_IVC_MAX_PENDING].waiter ==
+					&waiter)
+				ictxt->reqs[seq % NVAUDIO_IVC_MAX_PENDING].waiter =
+					NULL;
+		}
+		spin_unlock_irqrestore(&ictxt->lock, flags);
+
+		if (!waiter.done) {
+			pr_err("%s: Waited too long for msg reply\n", __func__);
+			return -ETIMEDOUT;
+		}
 	}
-	err = len;
 
-fail:
-	spin_unlock_irqrestore(&ictxt->ivck_rx_lock, flags);
+	if (waiter.err)
+		return waiter.err;
 
-	return err;
+	return sizeof(struct nvaudio_ivc_msg);
 
 }
 EXPORT_SYMBOL_GPL(nvaudio_ivc_send_receive);
 
 /* Every communication with the server is identified
  * with this ivc context.
- * There can be one outstanding request to the server per
- * ivc context.
+ * There can be up to NVAUDIO_IVC_MAX_PENDING outstanding
+ * requests to the server per ivc context.
  */
 struct nvaudio_ivc_ctxt *nvaudio_ivc_alloc_ctxt(struct device *dev)
 {
@@ -181,6 +276,15 @@ struct nvaudio_ivc_ctxt *nvaudio_ivc_alloc_ctxt(struct device *dev)
 
 	spin_lock_init(&ictxt->ivck_rx_lock);
 	spin_lock_init(&ictxt->ivck_tx_lock);
+	spin_lock_init(&ictxt->lock);
+	init_waitqueue_head(&ictxt->wait);
+
+	if (devm_request_irq(dev, ictxt->ivck->irq, nvaudio_ivc_irq, 0,
+			dev_name(dev), ictxt) != 0) {
+		dev_err(dev, "Failed to request irq %d\n", ictxt->ivck->irq);
+		goto fail;
+	}
+	ictxt->irq_requested = true;
 
 	tegra_hv_ivc_channel_reset(ictxt->ivck);
 
@@ -214,8 +318,11 @@ EXPORT_SYMBOL_GPL(nvaudio_ivc_free_ctxt);
 
 static void nvaudio_ivc_deinit(struct nvaudio_ivc_ctxt *ictxt)
 {
-	if (ictxt)
+	if (ictxt) {
+		if (ictxt->irq_requested)
+			devm_free_irq(ictxt->dev, ictxt->ivck->irq, ictxt);
 		tegra_hv_ivc_unreserve(ictxt->ivck);
+	}
 }
 
 static int nvaudio_ivc_init(struct nvaudio_ivc_ctxt *ictxt)
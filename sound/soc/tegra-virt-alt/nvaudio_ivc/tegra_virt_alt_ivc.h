@@ -9,8 +9,30 @@
 #include "tegra_virt_alt_ivc_common.h"
 
 #define NVAUDIO_IVC_WAIT_TIMEOUT	1000000
+/* Requests sent with ack_required and not yet replied to */
+#define NVAUDIO_IVC_MAX_PENDING		16
+/* Budget nvaudio_ivc_send_retry waits for queue space, in usec */
+#define NVAUDIO_IVC_SEND_TIMEOUT	5000
 struct nvaudio_ivc_dev;
 
+/* A caller sleeping for the reply of its request */
+struct nvaudio_ivc_waiter {
+	struct nvaudio_ivc_msg		*msg;
+	bool				done;
+	int				err;
+};
+
+/*
+ * Completion table entry. The server replies in request order, so the
+ * reply read at seq_tail belongs to the request tagged seq_tail.
+ */
+struct nvaudio_ivc_req {
+	u32				seq;
+	enum nvaudio_ivc_cmd_t		cmd;
+	/* NULL when nobody waits, the reply is only checked for errors */
+	struct nvaudio_ivc_waiter	*waiter;
+};
+
 struct nvaudio_ivc_ctxt {
 	struct tegra_hv_ivc_cookie	*ivck;
 	struct device			*dev;
@@ -21,7 +43,12 @@ struct nvaudio_ivc_ctxt {
 	struct nvaudio_ivc_dev		*ivcdev;
 	spinlock_t			ivck_rx_lock;
 	spinlock_t			ivck_tx_lock;
+	/* guards reqs, seq_head and seq_tail */
 	spinlock_t			lock;
+	struct nvaudio_ivc_req		reqs[NVAUDIO_IVC_MAX_PENDING];
+	u32				seq_head;
+	u32				seq_tail;
+	bool				irq_requested;
 };
 
 void nvaudio_ivc_rx(struct tegra_hv_ivc_cookie *ivck);
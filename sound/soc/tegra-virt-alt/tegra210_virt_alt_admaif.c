@@ -113,6 +113,10 @@ static int tegra210_admaif_hw_params(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/*
+ * PCM trigger runs in atomic context, the start/stop requests are queued
+ * without waiting and their replies are checked by the IVC interrupt.
+ */
 static void tegra210_admaif_start_playback(struct snd_soc_dai *dai)
 {
 	struct tegra210_virt_admaif_client_data *data =
@@ -124,7 +128,7 @@ static void tegra210_admaif_start_playback(struct snd_soc_dai *dai)
 	msg.cmd = NVAUDIO_START_PLAYBACK;
 	msg.params.dmaif_info.id = dai->id;
 	msg.ack_required = true;
-	err = nvaudio_ivc_send_receive(data->hivc_client,
+	err = nvaudio_ivc_send(data->hivc_client,
 			&msg, sizeof(struct nvaudio_ivc_msg));
 
 	if (err < 0)
@@ -143,7 +147,7 @@ static void tegra210_admaif_stop_playback(struct snd_soc_dai *dai)
 	msg.params.dmaif_info.id = dai->id;
 
 	msg.ack_required = true;
-	err = nvaudio_ivc_send_receive(data->hivc_client,
+	err = nvaudio_ivc_send(data->hivc_client,
 			&msg, sizeof(struct nvaudio_ivc_msg));
 
 	if (err < 0)
@@ -162,7 +166,7 @@ static void tegra210_admaif_start_capture(struct snd_soc_dai *dai)
 	msg.params.dmaif_info.id = dai->id;
 
 	msg.ack_required = true;
-	err = nvaudio_ivc_send_receive(data->hivc_client,
+	err = nvaudio_ivc_send(data->hivc_client,
 			&msg, sizeof(struct nvaudio_ivc_msg));
 
 	if (err < 0)
@@ -181,7 +185,7 @@ static void tegra210_admaif_stop_capture(struct snd_soc_dai *dai)
 	msg.params.dmaif_info.id = dai->id;
 
 	msg.ack_required = true;
-	err = nvaudio_ivc_send_receive(data->hivc_client,
+	err = nvaudio_ivc_send(data->hivc_client,
 			&msg, sizeof(struct nvaudio_ivc_msg));
 	if (err < 0)
 		pr_err("%s: error on ivc_send\n", __func__);
@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * The part of the DRM uapi header that tegra_drm_next.h builds on, for
+ * user space builds without libdrm headers installed.
+ */
+
+#ifndef __DRM_TEGRA_SHIM_UAPI_DRM_H
+#define __DRM_TEGRA_SHIM_UAPI_DRM_H
+
+#include <linux/types.h>
+#include <sys/ioctl.h>
+
+#define DRM_IOCTL_BASE			'd'
+#define DRM_IOWR(nr, type)		_IOWR(DRM_IOCTL_BASE, nr, type)
+#define DRM_COMMAND_BASE		0x40
+
+#endif /* __DRM_TEGRA_SHIM_UAPI_DRM_H */
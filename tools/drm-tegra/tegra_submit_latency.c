@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+/*
+ * tegra_submit_latency - latency of DRM_IOCTL_TEGRA_CHANNEL_SUBMIT.
+ *
+ * Opens a channel to one engine and submits small jobs built from a
+ * single GATHER_UPTR command: the gather only increments the job
+ * syncpoint once the engine is idle, padded with SETCLASS words up to -g
+ * words, so the time measured is the kernel submit path (argument copy,
+ * gather BO allocation, firewall, job pin and push) rather than engine
+ * work. Up to -q jobs are kept in flight before waiting for the oldest,
+ * which lets gather BOs of completed jobs go back to the channel context
+ * pool between submits.
+ *
+ * The latency of each submit ioctl is reported as min, median, p99, max
+ * and mean, along with the time from submit to syncpoint completion. The
+ * latter includes queueing behind the other jobs in flight when -q > 1.
+ *
+ * Build, from the top of the tree:
+ *	gcc -O2 -Itools/drm-tegra/include \
+ *		-Idrivers/gpu/drm/tegra/include/uapi \
+ *		-o tegra_submit_latency tools/drm-tegra/tegra_submit_latency.c
+ *
+ * Example Usage:
+ *	tegra_submit_latency [-d <drm device>] [-c <host1x class>]
+ *		[-n <submits>] [-g <gather words>] [-q <jobs in flight>]
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <drm/tegra_drm_next.h>
+
+#define DEFAULT_DEVICE		"/dev/dri/card0"
+#define HOST1X_CLASS_VIC	0x5d
+#define WAIT_TIMEOUT_NS		1000000000LL
+/* same limit as the submit arrays in the kernel */
+#define MAX_GATHER_WORDS	(16384 / 4)
+
+#define HOST1X_OPCODE_SETCLASS(class)	((0u << 28) | ((class) << 6))
+#define HOST1X_OPCODE_NONINCR(off, cnt)	((2u << 28) | ((off) << 16) | (cnt))
+/* engine register 0 is INCR_SYNCPT, condition OP_DONE */
+#define HOST1X_INCR_SYNCPT(id)		((1u << 8) | (id))
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int syncpt_wait(int fd, uint32_t id, uint32_t threshold)
+{
+	struct drm_tegra_syncpoint_wait wait;
+
+	memset(&wait, 0, sizeof(wait));
+	wait.timeout_ns = now_ns() + WAIT_TIMEOUT_NS;
+	wait.id = id;
+	wait.threshold = threshold;
+
+	return ioctl(fd, DRM_IOCTL_TEGRA_SYNCPOINT_WAIT, &wait);
+}
+
+static void report(const char *name, uint64_t *ns, unsigned int n)
+{
+	uint64_t sum = 0;
+	unsigned int i;
+
+	qsort(ns, n, sizeof(*ns), cmp_u64);
+	for (i = 0; i < n; i++)
+		sum += ns[i];
+
+	printf("%-8s min %" PRIu64 " p50 %" PRIu64 " p99 %" PRIu64
+	       " max %" PRIu64 " mean %" PRIu64 " ns\n", name, ns[0],
+	       ns[n / 2], ns[(uint64_t)n * 99 / 100], ns[n - 1], sum / n);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-d device] [-c class] [-n submits] [-g gather words] [-q jobs in flight]\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	const char *device = DEFAULT_DEVICE;
+	unsigned int class = HOST1X_CLASS_VIC, num = 10000, words = 2;
+	unsigned int depth = 1, i, done = 0;
+	struct drm_tegra_channel_open open_args;
+	struct drm_tegra_channel_close close_args;
+	struct drm_tegra_syncpoint_allocate alloc;
+	struct drm_tegra_syncpoint_free free_args;
+	struct drm_tegra_channel_submit submit;
+	struct drm_tegra_submit_cmd cmd;
+	uint64_t *start_ns = NULL, *submit_ns = NULL, *complete_ns = NULL;
+	uint32_t *gather = NULL, *values = NULL;
+	int fd, opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "d:c:n:g:q:")) != -1) {
+		switch (opt) {
+		case 'd':
+			device = optarg;
+			break;
+		case 'c':
+			class = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			num = strtoul(optarg, NULL, 0);
+			break;
+		case 'g':
+			words = strtoul(optarg, NULL, 0);
+			break;
+		case 'q':
+			depth = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (num == 0 || words < 2 || words > MAX_GATHER_WORDS || depth == 0 ||
+	    class > 0x3ff) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	fd = open(device, O_RDWR | O_CLOEXEC);
+	if (fd < 0) {
+		perror(device);
+		return 1;
+	}
+
+	memset(&open_args, 0, sizeof(open_args));
+	open_args.host1x_class = class;
+	if (ioctl(fd, DRM_IOCTL_TEGRA_CHANNEL_OPEN, &open_args) < 0) {
+		perror("DRM_IOCTL_TEGRA_CHANNEL_OPEN");
+		goto close_fd;
+	}
+
+	memset(&alloc, 0, sizeof(alloc));
+	if (ioctl(fd, DRM_IOCTL_TEGRA_SYNCPOINT_ALLOCATE, &alloc) < 0) {
+		perror("DRM_IOCTL_TEGRA_SYNCPOINT_ALLOCATE");
+		goto close_channel;
+	}
+
+	gather = calloc(words, sizeof(*gather));
+	values = calloc(num, sizeof(*values));
+	start_ns = calloc(num, sizeof(*start_ns));
+	submit_ns = calloc(num, sizeof(*submit_ns));
+	complete_ns = calloc(num, sizeof(*complete_ns));
+	if (!gather || !values || !start_ns || !submit_ns || !complete_ns)
+		goto free_syncpt;
+
+	for (i = 0; i < words - 2; i++)
+		gather[i] = HOST1X_OPCODE_SETCLASS(class);
+	gather[i++] = HOST1X_OPCODE_NONINCR(0, 1);
+	gather[i] = HOST1X_INCR_SYNCPT(alloc.id);
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.type = DRM_TEGRA_SUBMIT_CMD_GATHER_UPTR;
+	cmd.gather_uptr.words = words;
+
+	for (i = 0; i < num; i++) {
+		memset(&submit, 0, sizeof(submit));
+		submit.context = open_args.context;
+		submit.num_cmds = 1;
+		submit.cmds_ptr = (uintptr_t)&cmd;
+		submit.gather_data_words = words;
+		submit.gather_data_ptr = (uintptr_t)gather;
+		submit.syncpt.id = alloc.id;
+		submit.syncpt.increments = 1;
+
+		start_ns[i] = now_ns();
+		if (ioctl(fd, DRM_IOCTL_TEGRA_CHANNEL_SUBMIT, &submit) < 0) {
+			perror("DRM_IOCTL_TEGRA_CHANNEL_SUBMIT");
+			goto free_syncpt;
+		}
+		submit_ns[i] = now_ns() - start_ns[i];
+		values[i] = submit.syncpt.value;
+
+		/* keep at most depth jobs in flight */
+		if (i + 1 - done < depth && i + 1 < num)
+			continue;
+		while (done <= i) {
+			if (syncpt_wait(fd, alloc.id, values[done]) < 0) {
+				perror("DRM_IOCTL_TEGRA_SYNCPOINT_WAIT");
+				goto free_syncpt;
+			}
+			complete_ns[done] = now_ns() - start_ns[done];
+			done++;
+			if (i + 1 < num)
+				break;
+		}
+	}
+
+	printf("%u submits of %u gather words, %u in flight, class 0x%x\n",
+	       num, words, depth, class);
+	report("submit", submit_ns, num);
+	report("complete", complete_ns, num);
+	ret = 0;
+
+free_syncpt:
+	/* jobs still queued hold their own syncpoint reference */
+	memset(&free_args, 0, sizeof(free_args));
+	free_args.id = alloc.id;
+	ioctl(fd, DRM_IOCTL_TEGRA_SYNCPOINT_FREE, &free_args);
+close_channel:
+	memset(&close_args, 0, sizeof(close_args));
+	close_args.context = open_args.context;
+	ioctl(fd, DRM_IOCTL_TEGRA_CHANNEL_CLOSE, &close_args);
+close_fd:
+	close(fd);
+	free(complete_ns);
+	free(submit_ns);
+	free(start_ns);
+	free(values);
+	free(gather);
+
+	return ret;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+/*
+ * nvdla_submit_bench - measure the NVDLA task submit path.
+ *
+ * The DLA device is switched to the software engine (submit_mode 2 in its
+ * debugfs directory), so no firmware or DLA hardware is involved. With
+ * emu_latency_us set to 0 the engine retires a task as soon as it is
+ * scheduled, and the rate measured is that of the kernel submit path:
+ * task pool allocation, address list pinning, descriptor and fence fill,
+ * queueing and completion. -a sets the address list size of each task,
+ * -b how many dma-bufs it cycles through.
+ *
+ * Buffers come from the dma-buf system heap. The device keeps its original
+ * submit mode and latency once the run is done.
+ *
+ * Build, from the top of the tree:
+ *	gcc -O2 -Iinclude/uapi -o nvdla_submit_bench \
+ *		tools/nvdla/nvdla_submit_bench.c
+ *
+ * Example Usage:
+ *	nvdla_submit_bench [-d <dla>] [-n <tasks>] [-t <tasks/submit>]
+ *		[-a <addresses/task>] [-b <buffers>] [-l <latency us>]
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/dma-heap.h>
+#include <linux/nvhost_nvdla_ioctl.h>
+
+#define DEFAULT_DLA		"nvdla0"
+#define DMA_HEAP		"/dev/dma_heap/system"
+#define DEBUGFS_ROOT		"/sys/kernel/debug"
+#define SUBMIT_MODE_EMULATE	2
+#define BUFFER_SIZE		4096
+/* first share id, 0 is rejected in the address list */
+#define SHARE_ID_BASE		1
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int debugfs_read(const char *dla, const char *name, unsigned int *val)
+{
+	char path[256];
+	FILE *f;
+	int ret;
+
+	snprintf(path, sizeof(path), "%s/%s/%s", DEBUGFS_ROOT, dla, name);
+	f = fopen(path, "r");
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+	ret = fscanf(f, "%u", val) == 1 ? 0 : -1;
+	fclose(f);
+
+	return ret;
+}
+
+static int debugfs_write(const char *dla, const char *name, unsigned int val)
+{
+	char path[256];
+	FILE *f;
+	int ret;
+
+	snprintf(path, sizeof(path), "%s/%s/%s", DEBUGFS_ROOT, dla, name);
+	f = fopen(path, "w");
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+	ret = fprintf(f, "%u\n", val) > 0 ? 0 : -1;
+	if (fclose(f) != 0)
+		ret = -1;
+
+	return ret;
+}
+
+static int alloc_buffers(struct nvdla_mem_share_handle *handles,
+			 unsigned int num)
+{
+	struct dma_heap_allocation_data data;
+	unsigned int i;
+	int heap;
+
+	heap = open(DMA_HEAP, O_RDWR | O_CLOEXEC);
+	if (heap < 0) {
+		perror(DMA_HEAP);
+		return -1;
+	}
+
+	for (i = 0; i < num; i++) {
+		memset(&data, 0, sizeof(data));
+		data.len = BUFFER_SIZE;
+		data.fd_flags = O_RDWR | O_CLOEXEC;
+		if (ioctl(heap, DMA_HEAP_IOCTL_ALLOC, &data) < 0) {
+			perror("DMA_HEAP_IOCTL_ALLOC");
+			close(heap);
+			return -1;
+		}
+
+		handles[i].share_id = SHARE_ID_BASE + i;
+		handles[i].offset = 0;
+		handles[i].access_flags = NVDLA_MEM_ACCESS_READ_WRITE;
+		handles[i].import_id = data.fd;
+	}
+	close(heap);
+
+	return 0;
+}
+
+/* PIN takes at most 32 buffers per call */
+static int pin_buffers(int fd, unsigned long cmd,
+		       struct nvdla_mem_share_handle *handles, unsigned int num)
+{
+	struct nvdla_pin_unpin_args args;
+	unsigned int i, n;
+
+	for (i = 0; i < num; i += n) {
+		n = num - i < 32 ? num - i : 32;
+		memset(&args, 0, sizeof(args));
+		args.buffers = (uintptr_t)&handles[i];
+		args.num_buffers = n;
+		if (ioctl(fd, cmd, &args) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-d dla] [-n tasks] [-t tasks/submit] [-a addresses/task] [-b buffers] [-l latency us]\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dla = DEFAULT_DLA;
+	uint64_t num_tasks = 100000;
+	unsigned int per_submit = 1, num_addrs = 64, num_bufs = 32;
+	unsigned int latency_us = 0, old_mode = 0, old_latency = 0;
+	struct nvdla_mem_share_handle *handles = NULL;
+	struct nvdla_ioctl_submit_task *tasks = NULL;
+	struct nvdla_mem_handle *addrs = NULL;
+	struct nvdla_submit_args submit;
+	uint64_t done = 0, busy = 0;
+	uint64_t start, elapsed, t, ioctl_ns = 0;
+	char path[64];
+	unsigned int i;
+	int fd = -1, opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "d:n:t:a:b:l:")) != -1) {
+		switch (opt) {
+		case 'd':
+			dla = optarg;
+			break;
+		case 'n':
+			num_tasks = strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			per_submit = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			num_addrs = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			num_bufs = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			latency_us = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (num_tasks == 0 || per_submit == 0 ||
+	    per_submit > MAX_NVDLA_TASKS_PER_SUBMIT || num_addrs == 0 ||
+	    num_addrs > MAX_NVDLA_BUFFERS_PER_TASK || num_bufs == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (debugfs_read(dla, "submit_mode", &old_mode) ||
+	    debugfs_read(dla, "emu_latency_us", &old_latency))
+		return 1;
+	if (debugfs_write(dla, "emu_latency_us", latency_us) ||
+	    debugfs_write(dla, "submit_mode", SUBMIT_MODE_EMULATE))
+		goto restore;
+
+	snprintf(path, sizeof(path), "/dev/nvhost-ctrl-%s", dla);
+	fd = open(path, O_RDWR | O_CLOEXEC);
+	if (fd < 0) {
+		perror(path);
+		goto restore;
+	}
+
+	if (ioctl(fd, NVDLA_IOCTL_ALLOC_QUEUE) < 0) {
+		perror("NVDLA_IOCTL_ALLOC_QUEUE");
+		goto close_dev;
+	}
+
+	handles = calloc(num_bufs, sizeof(*handles));
+	addrs = calloc(num_addrs, sizeof(*addrs));
+	tasks = calloc(per_submit, sizeof(*tasks));
+	if (handles == NULL || addrs == NULL || tasks == NULL)
+		goto release_queue;
+
+	if (alloc_buffers(handles, num_bufs))
+		goto release_queue;
+	if (pin_buffers(fd, NVDLA_IOCTL_PIN, handles, num_bufs)) {
+		perror("NVDLA_IOCTL_PIN");
+		goto free_buffers;
+	}
+
+	/* address lists repeat buffers, like tensors shared across layers */
+	for (i = 0; i < num_addrs; i++) {
+		addrs[i].handle = SHARE_ID_BASE + i % num_bufs;
+		addrs[i].offset = 0;
+		addrs[i].type = NVDLA_BUFFER_TYPE_MC;
+	}
+	for (i = 0; i < per_submit; i++) {
+		tasks[i].num_addresses = num_addrs;
+		tasks[i].address_list = (uintptr_t)addrs;
+	}
+
+	memset(&submit, 0, sizeof(submit));
+	submit.tasks = (uintptr_t)tasks;
+	submit.num_tasks = per_submit;
+
+	start = now_ns();
+	while (done < num_tasks) {
+		t = now_ns();
+		if (ioctl(fd, NVDLA_IOCTL_SUBMIT, &submit) < 0) {
+			/* task pool full, the engine catches up */
+			if (errno == EAGAIN) {
+				busy++;
+				continue;
+			}
+			perror("NVDLA_IOCTL_SUBMIT");
+			goto unpin;
+		}
+		ioctl_ns += now_ns() - t;
+		done += per_submit;
+	}
+	elapsed = now_ns() - start;
+
+	printf("%" PRIu64 " tasks, %u per submit, %u addresses over %u buffers\n",
+	       done, per_submit, num_addrs, num_bufs);
+	printf("%.0f tasks/s, %.2f us per successful submit, %" PRIu64 " busy retries\n",
+	       done * 1e9 / elapsed, ioctl_ns / 1e3 / (done / per_submit),
+	       busy);
+	ret = 0;
+
+unpin:
+	/* release waits for the tasks still queued */
+	if (ioctl(fd, NVDLA_IOCTL_RELEASE_QUEUE) < 0)
+		perror("NVDLA_IOCTL_RELEASE_QUEUE");
+	if (pin_buffers(fd, NVDLA_IOCTL_UNPIN, handles, num_bufs))
+		perror("NVDLA_IOCTL_UNPIN");
+	close(fd);
+	fd = -1;
+free_buffers:
+	for (i = 0; i < num_bufs; i++)
+		if (handles[i].import_id)
+			close(handles[i].import_id);
+release_queue:
+	if (fd >= 0)
+		ioctl(fd, NVDLA_IOCTL_RELEASE_QUEUE);
+close_dev:
+	if (fd >= 0)
+		close(fd);
+	free(tasks);
+	free(addrs);
+	free(handles);
+restore:
+	debugfs_write(dla, "submit_mode", old_mode);
+	debugfs_write(dla, "emu_latency_us", old_latency);
+
+	return ret;
+}
@@ -0,0 +1,558 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+/*
+ * xsk_loopback - AF_XDP zero-copy loopback test for nvethernet.
+ *
+ * An AF_XDP socket is bound in zero-copy mode to one queue of the
+ * interface, which makes the driver take the UMEM buffer pool on that DMA
+ * channel. The MAC is put in loopback, so every frame sent from the
+ * socket Tx ring is received back on the interface. A minimal XDP program
+ * redirects it to the socket, which checks that each frame comes back
+ * once, in order and unmodified, and that every Tx frame is reported on
+ * the completion ring.
+ *
+ * Loopback frames are steered like any other received frame, so the
+ * queue tested must be the one they land on: queue 0 unless Rx steering
+ * is configured otherwise. The MAC loopback setting is restored on exit.
+ *
+ * Build:
+ *	gcc -O2 -o xsk_loopback tools/nvethernet/xsk_loopback.c
+ *
+ * Example Usage:
+ *	xsk_loopback -i <interface> [-q <queue>] [-n <frames>] [-s <frame size>]
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <time.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+
+#ifndef AF_XDP
+#define AF_XDP			44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP			283
+#endif
+
+#define NUM_FRAMES		4096
+#define FRAME_SIZE		4096
+#define RING_SIZE		2048
+#define TEST_ETH_TYPE		0x88B5
+#define TEST_MAGIC		0x78736b6cU
+#define TEST_HDR_LEN		(ETH_HLEN + 8)
+#define IDLE_TIMEOUT_MS		2000
+
+/* single producer/consumer view of one AF_XDP ring */
+struct xsk_ring {
+	uint32_t *producer;
+	uint32_t *consumer;
+	uint32_t *flags;
+	void *descs;
+	uint32_t size;
+	uint32_t local;
+	void *map;
+	size_t map_len;
+};
+
+struct xsk_test {
+	int fd;
+	void *umem;
+	struct xsk_ring fill, comp, rx, tx;
+	/* UMEM frames owned by user space for Tx */
+	uint64_t free_frames[NUM_FRAMES];
+	unsigned int num_free;
+	unsigned char mac[ETH_ALEN];
+	unsigned int size;
+	uint32_t tx_seq, rx_seq;
+	unsigned long completed, out_of_order, corrupted;
+};
+
+static int sys_bpf(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static uint64_t now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline uint32_t ring_load(uint32_t *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void ring_store(uint32_t *p, uint32_t v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int ring_map(int fd, struct xsk_ring *r, const struct xdp_ring_offset *off,
+		    off_t pgoff, size_t desc_size)
+{
+	r->size = RING_SIZE;
+	r->map_len = off->desc + RING_SIZE * desc_size;
+	r->map = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_POPULATE, fd, pgoff);
+	if (r->map == MAP_FAILED)
+		return -1;
+
+	r->producer = (uint32_t *)((char *)r->map + off->producer);
+	r->consumer = (uint32_t *)((char *)r->map + off->consumer);
+	r->flags = (uint32_t *)((char *)r->map + off->flags);
+	r->descs = (char *)r->map + off->desc;
+
+	return 0;
+}
+
+static int xsk_setup(struct xsk_test *t, unsigned int ifindex,
+		     unsigned int queue)
+{
+	struct xdp_umem_reg reg = { 0 };
+	struct xdp_mmap_offsets off;
+	struct sockaddr_xdp sxdp = { 0 };
+	socklen_t optlen = sizeof(off);
+	int size = RING_SIZE;
+	unsigned int i;
+
+	t->fd = socket(AF_XDP, SOCK_RAW, 0);
+	if (t->fd < 0) {
+		perror("socket(AF_XDP)");
+		return -1;
+	}
+
+	t->umem = mmap(NULL, (size_t)NUM_FRAMES * FRAME_SIZE,
+		       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+		       -1, 0);
+	if (t->umem == MAP_FAILED) {
+		perror("mmap(UMEM)");
+		return -1;
+	}
+
+	reg.addr = (uintptr_t)t->umem;
+	reg.len = (uint64_t)NUM_FRAMES * FRAME_SIZE;
+	reg.chunk_size = FRAME_SIZE;
+	if (setsockopt(t->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) ||
+	    setsockopt(t->fd, SOL_XDP, XDP_UMEM_FILL_RING, &size, sizeof(size)) ||
+	    setsockopt(t->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &size,
+		       sizeof(size)) ||
+	    setsockopt(t->fd, SOL_XDP, XDP_RX_RING, &size, sizeof(size)) ||
+	    setsockopt(t->fd, SOL_XDP, XDP_TX_RING, &size, sizeof(size))) {
+		perror("setsockopt(SOL_XDP)");
+		return -1;
+	}
+
+	if (getsockopt(t->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen)) {
+		perror("getsockopt(XDP_MMAP_OFFSETS)");
+		return -1;
+	}
+
+	if (ring_map(t->fd, &t->fill, &off.fr, XDP_UMEM_PGOFF_FILL_RING,
+		     sizeof(uint64_t)) ||
+	    ring_map(t->fd, &t->comp, &off.cr, XDP_UMEM_PGOFF_COMPLETION_RING,
+		     sizeof(uint64_t)) ||
+	    ring_map(t->fd, &t->rx, &off.rx, XDP_PGOFF_RX_RING,
+		     sizeof(struct xdp_desc)) ||
+	    ring_map(t->fd, &t->tx, &off.tx, XDP_PGOFF_TX_RING,
+		     sizeof(struct xdp_desc))) {
+		perror("mmap(ring)");
+		return -1;
+	}
+
+	/* first half of UMEM feeds Rx, second half is sent from */
+	for (i = 0; i < RING_SIZE; i++)
+		((uint64_t *)t->fill.descs)[i] = (uint64_t)i * FRAME_SIZE;
+	t->fill.local = RING_SIZE;
+	ring_store(t->fill.producer, t->fill.local);
+	for (i = RING_SIZE; i < NUM_FRAMES; i++)
+		t->free_frames[t->num_free++] = (uint64_t)i * FRAME_SIZE;
+
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = ifindex;
+	sxdp.sxdp_queue_id = queue;
+	sxdp.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+	if (bind(t->fd, (struct sockaddr *)&sxdp, sizeof(sxdp))) {
+		perror("bind(XDP_ZEROCOPY)");
+		return -1;
+	}
+
+	return 0;
+}
+
+/* redirect to the socket of the Rx queue, pass to the stack otherwise */
+static int xdp_attach(int xsk_fd, unsigned int ifindex, unsigned int queue)
+{
+	struct bpf_insn prog[] = {
+		{ .code = BPF_LDX | BPF_MEM | BPF_W, .dst_reg = BPF_REG_2,
+		  .src_reg = BPF_REG_1,
+		  .off = offsetof(struct xdp_md, rx_queue_index) },
+		{ .code = BPF_LD | BPF_DW | BPF_IMM, .dst_reg = BPF_REG_1,
+		  .src_reg = BPF_PSEUDO_MAP_FD },
+		{ 0 },
+		{ .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = BPF_REG_3,
+		  .imm = XDP_PASS },
+		{ .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_redirect_map },
+		{ .code = BPF_JMP | BPF_EXIT },
+	};
+	char log[4096] = "";
+	union bpf_attr attr;
+	int map_fd, prog_fd, link_fd;
+	uint32_t key = queue, val = xsk_fd;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(key);
+	attr.value_size = sizeof(val);
+	attr.max_entries = queue + 1;
+	map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+	if (map_fd < 0) {
+		perror("BPF_MAP_CREATE");
+		return -1;
+	}
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = map_fd;
+	attr.key = (uintptr_t)&key;
+	attr.value = (uintptr_t)&val;
+	if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr)) {
+		perror("BPF_MAP_UPDATE_ELEM");
+		return -1;
+	}
+
+	prog[1].imm = map_fd;
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insns = (uintptr_t)prog;
+	attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+	attr.license = (uintptr_t)"GPL";
+	attr.log_buf = (uintptr_t)log;
+	attr.log_size = sizeof(log);
+	attr.log_level = 1;
+	prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+	if (prog_fd < 0) {
+		perror("BPF_PROG_LOAD");
+		fprintf(stderr, "%s", log);
+		return -1;
+	}
+
+	/* detached when the link fd is closed at exit */
+	memset(&attr, 0, sizeof(attr));
+	attr.link_create.prog_fd = prog_fd;
+	attr.link_create.target_ifindex = ifindex;
+	attr.link_create.attach_type = BPF_XDP;
+	attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+	link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+	if (link_fd < 0) {
+		perror("BPF_LINK_CREATE");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int mac_loopback(const char *ifname, const char *set, bool *was_enabled)
+{
+	char path[128], buf[16] = "";
+	FILE *f;
+	int ret;
+
+	snprintf(path, sizeof(path), "/sys/class/net/%s/device/mac_loopback",
+		 ifname);
+	if (was_enabled) {
+		f = fopen(path, "r");
+		if (f == NULL) {
+			perror(path);
+			return -1;
+		}
+		ret = fgets(buf, sizeof(buf), f) ? 0 : -1;
+		fclose(f);
+		if (ret)
+			return -1;
+		*was_enabled = strncmp(buf, "enabled", 7) == 0;
+	}
+
+	f = fopen(path, "w");
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+	ret = fputs(set, f) >= 0 ? 0 : -1;
+	if (fclose(f) != 0)
+		ret = -1;
+
+	return ret;
+}
+
+static int get_mac(const char *ifname, unsigned char *mac)
+{
+	struct ifreq ifr;
+	int fd, ret;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		return -1;
+	memset(&ifr, 0, sizeof(ifr));
+	snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+	ret = ioctl(fd, SIOCGIFHWADDR, &ifr);
+	if (!ret)
+		memcpy(mac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+	close(fd);
+
+	return ret;
+}
+
+static void frame_fill(struct xsk_test *t, unsigned char *p, uint32_t seq)
+{
+	uint32_t magic = TEST_MAGIC;
+	unsigned int i;
+
+	memcpy(p, t->mac, ETH_ALEN);
+	memcpy(p + ETH_ALEN, t->mac, ETH_ALEN);
+	p[12] = TEST_ETH_TYPE >> 8;
+	p[13] = TEST_ETH_TYPE & 0xff;
+	memcpy(p + ETH_HLEN, &magic, sizeof(magic));
+	memcpy(p + ETH_HLEN + 4, &seq, sizeof(seq));
+	for (i = TEST_HDR_LEN; i < t->size; i++)
+		p[i] = (unsigned char)(seq + i);
+}
+
+/*
+ * Returns the sequence number, -1 if a test frame is not intact, -2 for
+ * traffic of the stack that loops back as well.
+ */
+static int64_t frame_check(struct xsk_test *t, const unsigned char *p,
+			   uint32_t len)
+{
+	uint32_t magic, seq;
+	unsigned int i;
+
+	if (len < ETH_HLEN || p[12] != (TEST_ETH_TYPE >> 8) ||
+	    p[13] != (TEST_ETH_TYPE & 0xff))
+		return -2;
+	/* frames may come back with the FCS */
+	if (len < t->size || memcmp(p, t->mac, ETH_ALEN))
+		return -1;
+	memcpy(&magic, p + ETH_HLEN, sizeof(magic));
+	memcpy(&seq, p + ETH_HLEN + 4, sizeof(seq));
+	if (magic != TEST_MAGIC)
+		return -1;
+	for (i = TEST_HDR_LEN; i < t->size; i++) {
+		if (p[i] != (unsigned char)(seq + i))
+			return -1;
+	}
+
+	return seq;
+}
+
+static unsigned int xsk_send(struct xsk_test *t, uint32_t count)
+{
+	struct xdp_desc *descs = t->tx.descs;
+	uint32_t room = t->tx.size - (t->tx.local - ring_load(t->tx.consumer));
+	unsigned int sent = 0;
+	uint64_t addr;
+
+	while (sent < count && sent < room && t->num_free > 0) {
+		addr = t->free_frames[--t->num_free];
+		frame_fill(t, (unsigned char *)t->umem + addr, t->tx_seq++);
+		descs[t->tx.local++ & (t->tx.size - 1)] = (struct xdp_desc) {
+			.addr = addr, .len = t->size,
+		};
+		sent++;
+	}
+
+	if (sent > 0) {
+		ring_store(t->tx.producer, t->tx.local);
+		if (ring_load(t->tx.flags) & XDP_RING_NEED_WAKEUP)
+			sendto(t->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+	}
+
+	return sent;
+}
+
+static unsigned int xsk_complete(struct xsk_test *t)
+{
+	uint64_t *addrs = t->comp.descs;
+	uint32_t prod = ring_load(t->comp.producer);
+	unsigned int n = 0;
+
+	while (t->comp.local != prod) {
+		t->free_frames[t->num_free++] =
+			addrs[t->comp.local++ & (t->comp.size - 1)];
+		n++;
+	}
+	ring_store(t->comp.consumer, t->comp.local);
+	t->completed += n;
+
+	return n;
+}
+
+static unsigned int xsk_receive(struct xsk_test *t)
+{
+	struct xdp_desc *descs = t->rx.descs;
+	uint64_t *fill = t->fill.descs;
+	uint32_t prod = ring_load(t->rx.producer);
+	unsigned int n = 0;
+	struct xdp_desc d;
+	int64_t seq;
+
+	while (t->rx.local != prod) {
+		d = descs[t->rx.local++ & (t->rx.size - 1)];
+		seq = frame_check(t, (unsigned char *)t->umem + d.addr, d.len);
+		if (seq == -1) {
+			t->corrupted++;
+		} else if (seq >= 0) {
+			if ((uint32_t)seq != t->rx_seq)
+				t->out_of_order++;
+			t->rx_seq = (uint32_t)seq + 1;
+		}
+		/* give the buffer back to the driver, frame aligned */
+		fill[t->fill.local++ & (t->fill.size - 1)] =
+			d.addr & ~(uint64_t)(FRAME_SIZE - 1);
+		n++;
+	}
+	ring_store(t->rx.consumer, t->rx.local);
+	if (n > 0)
+		ring_store(t->fill.producer, t->fill.local);
+
+	return n;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s -i interface [-q queue] [-n frames] [-s frame size]\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	struct xsk_test *t;
+	const char *ifname = NULL;
+	unsigned long num_frames = 100000, received = 0;
+	unsigned int queue = 0, size = 128, ifindex;
+	struct pollfd pfd;
+	bool was_enabled = false, lb_set = false;
+	uint64_t last, start, elapsed;
+	int opt, ret = 1;
+
+	while ((opt = getopt(argc, argv, "i:q:n:s:")) != -1) {
+		switch (opt) {
+		case 'i':
+			ifname = optarg;
+			break;
+		case 'q':
+			queue = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			num_frames = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			size = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (ifname == NULL || num_frames == 0 || size < ETH_ZLEN ||
+	    size > ETH_FRAME_LEN) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ifindex = if_nametoindex(ifname);
+	if (ifindex == 0) {
+		perror(ifname);
+		return 1;
+	}
+
+	t = calloc(1, sizeof(*t));
+	if (t == NULL)
+		return 1;
+	t->size = size;
+	if (get_mac(ifname, t->mac)) {
+		perror("SIOCGIFHWADDR");
+		goto out;
+	}
+
+	/* binding restarts the interface, so loopback is set afterwards */
+	if (xsk_setup(t, ifindex, queue) || xdp_attach(t->fd, ifindex, queue))
+		goto out;
+	if (mac_loopback(ifname, "enable", &was_enabled))
+		goto out;
+	lb_set = true;
+	sleep(1);
+
+	pfd.fd = t->fd;
+	pfd.events = POLLIN;
+	start = last = now_ms();
+	while (received < num_frames || t->completed < t->tx_seq) {
+		unsigned int n = 0;
+
+		if (t->tx_seq < num_frames)
+			n += xsk_send(t, num_frames - t->tx_seq);
+		n += xsk_complete(t);
+		n += xsk_receive(t);
+		received = t->rx_seq;
+
+		if (n > 0) {
+			last = now_ms();
+			continue;
+		}
+		if (now_ms() - last > IDLE_TIMEOUT_MS)
+			break;
+		/* kick Tx and let Rx refill pick up the fill ring */
+		if (ring_load(t->fill.flags) & XDP_RING_NEED_WAKEUP)
+			poll(&pfd, 1, 10);
+		else if (ring_load(t->tx.flags) & XDP_RING_NEED_WAKEUP)
+			sendto(t->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+	}
+	elapsed = now_ms() - start;
+
+	printf("%u sent, %lu completed, %u received, %lu out of order, %lu corrupted\n",
+	       t->tx_seq, t->completed, t->rx_seq, t->out_of_order,
+	       t->corrupted);
+	if (elapsed > 0)
+		printf("%" PRIu64 " frames/s\n",
+		       (uint64_t)t->rx_seq * 1000 / elapsed);
+
+	if (t->completed == num_frames && t->rx_seq == num_frames &&
+	    t->out_of_order == 0 && t->corrupted == 0) {
+		printf("PASS\n");
+		ret = 0;
+	} else {
+		printf("FAIL\n");
+	}
+
+out:
+	if (lb_set && !was_enabled)
+		mac_loopback(ifname, "disable", NULL);
+	free(t);
+
+	return ret;
+}
@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __IOVA_SHIM_LINUX_BITOPS_H
+#define __IOVA_SHIM_LINUX_BITOPS_H
+
+#define BIT(nr)		(1UL << (nr))
+
+#endif /* __IOVA_SHIM_LINUX_BITOPS_H */
@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __IOVA_SHIM_LINUX_ERRNO_H
+#define __IOVA_SHIM_LINUX_ERRNO_H
+
+#include <asm/errno.h>
+
+#endif /* __IOVA_SHIM_LINUX_ERRNO_H */
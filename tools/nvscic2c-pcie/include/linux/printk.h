@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __IOVA_SHIM_LINUX_PRINTK_H
+#define __IOVA_SHIM_LINUX_PRINTK_H
+
+#include <linux/types.h>
+
+#ifndef pr_fmt
+#define pr_fmt(fmt)	fmt
+#endif
+
+#define pr_err(fmt, ...)	fprintf(stderr, pr_fmt(fmt), ##__VA_ARGS__)
+/* kernel-only formats such as %pa, never printed here */
+#define pr_debug(fmt, ...)	do { } while (0)
+
+#endif /* __IOVA_SHIM_LINUX_PRINTK_H */
@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * Red-black tree with the kernel rbtree interface used by iova-mngr.c.
+ * Colour is kept in its own field rather than in the parent pointer.
+ */
+
+#ifndef __IOVA_SHIM_LINUX_RBTREE_H
+#define __IOVA_SHIM_LINUX_RBTREE_H
+
+#include <linux/types.h>
+
+struct rb_node {
+	struct rb_node *rb_parent;
+	struct rb_node *rb_right;
+	struct rb_node *rb_left;
+	bool rb_red;
+};
+
+struct rb_root {
+	struct rb_node *rb_node;
+};
+
+#define RB_ROOT		((struct rb_root) { NULL })
+
+#define rb_entry(ptr, type, member)	container_of(ptr, type, member)
+
+#define rb_entry_safe(ptr, type, member)				\
+	({								\
+		__typeof__(ptr) ____ptr = (ptr);			\
+		____ptr ? rb_entry(____ptr, type, member) : NULL;	\
+	})
+
+static inline void rb_link_node(struct rb_node *node, struct rb_node *parent,
+				struct rb_node **link)
+{
+	node->rb_parent = parent;
+	node->rb_left = NULL;
+	node->rb_right = NULL;
+	node->rb_red = true;
+	*link = node;
+}
+
+static inline void rb_replace_child(struct rb_root *root, struct rb_node *old,
+				    struct rb_node *new)
+{
+	struct rb_node *parent = old->rb_parent;
+
+	if (!parent)
+		root->rb_node = new;
+	else if (parent->rb_left == old)
+		parent->rb_left = new;
+	else
+		parent->rb_right = new;
+	if (new)
+		new->rb_parent = parent;
+}
+
+static inline void rb_rotate_left(struct rb_root *root, struct rb_node *x)
+{
+	struct rb_node *y = x->rb_right;
+
+	x->rb_right = y->rb_left;
+	if (y->rb_left)
+		y->rb_left->rb_parent = x;
+	rb_replace_child(root, x, y);
+	y->rb_left = x;
+	x->rb_parent = y;
+}
+
+static inline void rb_rotate_right(struct rb_root *root, struct rb_node *x)
+{
+	struct rb_node *y = x->rb_left;
+
+	x->rb_left = y->rb_right;
+	if (y->rb_right)
+		y->rb_right->rb_parent = x;
+	rb_replace_child(root, x, y);
+	y->rb_right = x;
+	x->rb_parent = y;
+}
+
+static inline bool rb_is_red(const struct rb_node *node)
+{
+	return node && node->rb_red;
+}
+
+static inline void rb_insert_color(struct rb_node *node, struct rb_root *root)
+{
+	struct rb_node *parent, *gparent, *uncle;
+
+	while ((parent = node->rb_parent) && parent->rb_red) {
+		gparent = parent->rb_parent;
+		if (parent == gparent->rb_left) {
+			uncle = gparent->rb_right;
+			if (rb_is_red(uncle)) {
+				parent->rb_red = false;
+				uncle->rb_red = false;
+				gparent->rb_red = true;
+				node = gparent;
+				continue;
+			}
+			if (node == parent->rb_right) {
+				rb_rotate_left(root, parent);
+				parent = node;
+			}
+			rb_rotate_right(root, gparent);
+		} else {
+			uncle = gparent->rb_left;
+			if (rb_is_red(uncle)) {
+				parent->rb_red = false;
+				uncle->rb_red = false;
+				gparent->rb_red = true;
+				node = gparent;
+				continue;
+			}
+			if (node == parent->rb_left) {
+				rb_rotate_right(root, parent);
+				parent = node;
+			}
+			rb_rotate_left(root, gparent);
+		}
+		parent->rb_red = false;
+		gparent->rb_red = true;
+		break;
+	}
+	root->rb_node->rb_red = false;
+}
+
+static inline void rb_erase_color(struct rb_node *node, struct rb_node *parent,
+				  struct rb_root *root)
+{
+	struct rb_node *sibling;
+
+	while (node != root->rb_node && !rb_is_red(node)) {
+		if (node == parent->rb_left) {
+			sibling = parent->rb_right;
+			if (sibling->rb_red) {
+				sibling->rb_red = false;
+				parent->rb_red = true;
+				rb_rotate_left(root, parent);
+				sibling = parent->rb_right;
+			}
+			if (!rb_is_red(sibling->rb_left) &&
+			    !rb_is_red(sibling->rb_right)) {
+				sibling->rb_red = true;
+				node = parent;
+				parent = node->rb_parent;
+				continue;
+			}
+			if (!rb_is_red(sibling->rb_right)) {
+				sibling->rb_left->rb_red = false;
+				sibling->rb_red = true;
+				rb_rotate_right(root, sibling);
+				sibling = parent->rb_right;
+			}
+			sibling->rb_red = parent->rb_red;
+			parent->rb_red = false;
+			sibling->rb_right->rb_red = false;
+			rb_rotate_left(root, parent);
+		} else {
+			sibling = parent->rb_left;
+			if (sibling->rb_red) {
+				sibling->rb_red = false;
+				parent->rb_red = true;
+				rb_rotate_right(root, parent);
+				sibling = parent->rb_left;
+			}
+			if (!rb_is_red(sibling->rb_left) &&
+			    !rb_is_red(sibling->rb_right)) {
+				sibling->rb_red = true;
+				node = parent;
+				parent = node->rb_parent;
+				continue;
+			}
+			if (!rb_is_red(sibling->rb_left)) {
+				sibling->rb_right->rb_red = false;
+				sibling->rb_red = true;
+				rb_rotate_left(root, sibling);
+				sibling = parent->rb_left;
+			}
+			sibling->rb_red = parent->rb_red;
+			parent->rb_red = false;
+			sibling->rb_left->rb_red = false;
+			rb_rotate_right(root, parent);
+		}
+		node = root->rb_node;
+		break;
+	}
+	if (node)
+		node->rb_red = false;
+}
+
+static inline void rb_erase(struct rb_node *node, struct rb_root *root)
+{
+	struct rb_node *child, *parent, *succ;
+	bool red = node->rb_red;
+
+	if (!node->rb_left) {
+		child = node->rb_right;
+		parent = node->rb_parent;
+		rb_replace_child(root, node, child);
+	} else if (!node->rb_right) {
+		child = node->rb_left;
+		parent = node->rb_parent;
+		rb_replace_child(root, node, child);
+	} else {
+		succ = node->rb_right;
+		while (succ->rb_left)
+			succ = succ->rb_left;
+		red = succ->rb_red;
+		child = succ->rb_right;
+		if (succ->rb_parent == node) {
+			parent = succ;
+		} else {
+			parent = succ->rb_parent;
+			rb_replace_child(root, succ, child);
+			succ->rb_right = node->rb_right;
+			succ->rb_right->rb_parent = succ;
+		}
+		rb_replace_child(root, node, succ);
+		succ->rb_left = node->rb_left;
+		succ->rb_left->rb_parent = succ;
+		succ->rb_red = node->rb_red;
+	}
+
+	if (!red)
+		rb_erase_color(child, parent, root);
+}
+
+static inline struct rb_node *rb_first(const struct rb_root *root)
+{
+	struct rb_node *node = root->rb_node;
+
+	if (!node)
+		return NULL;
+	while (node->rb_left)
+		node = node->rb_left;
+	return node;
+}
+
+static inline struct rb_node *rb_next(const struct rb_node *node)
+{
+	struct rb_node *parent;
+
+	if (node->rb_right) {
+		node = node->rb_right;
+		while (node->rb_left)
+			node = node->rb_left;
+		return (struct rb_node *)node;
+	}
+	while ((parent = node->rb_parent) && node == parent->rb_right)
+		node = parent;
+	return parent;
+}
+
+static inline struct rb_node *rb_left_deepest_node(const struct rb_node *node)
+{
+	for (;;) {
+		if (node->rb_left)
+			node = node->rb_left;
+		else if (node->rb_right)
+			node = node->rb_right;
+		else
+			return (struct rb_node *)node;
+	}
+}
+
+static inline struct rb_node *rb_first_postorder(const struct rb_root *root)
+{
+	if (!root->rb_node)
+		return NULL;
+	return rb_left_deepest_node(root->rb_node);
+}
+
+static inline struct rb_node *rb_next_postorder(const struct rb_node *node)
+{
+	struct rb_node *parent = node->rb_parent;
+
+	if (parent && node == parent->rb_left && parent->rb_right)
+		return rb_left_deepest_node(parent->rb_right);
+	return parent;
+}
+
+#define rbtree_postorder_for_each_entry_safe(pos, n, root, field)	\
+	for (pos = rb_entry_safe(rb_first_postorder(root),		\
+				 __typeof__(*pos), field);		\
+	     pos && ({ n = rb_entry_safe(rb_next_postorder(&pos->field),	\
+					 __typeof__(*pos), field); 1; });	\
+	     pos = n)
+
+#endif /* __IOVA_SHIM_LINUX_RBTREE_H */
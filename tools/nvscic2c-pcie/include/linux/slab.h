@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __IOVA_SHIM_LINUX_SLAB_H
+#define __IOVA_SHIM_LINUX_SLAB_H
+
+#include <linux/types.h>
+
+#define GFP_KERNEL	0
+
+#define kzalloc(size, gfp)	calloc(1, size)
+#define kfree(ptr)		free(ptr)
+
+#endif /* __IOVA_SHIM_LINUX_SLAB_H */
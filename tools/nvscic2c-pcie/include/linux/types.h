@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * Userspace stand-ins for the kernel helpers used by iova-mngr.c, so that
+ * the allocator can be built into iova_mngr_test.
+ */
+
+#ifndef __IOVA_SHIM_LINUX_TYPES_H
+#define __IOVA_SHIM_LINUX_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define __iomem
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef uint64_t dma_addr_t;
+typedef uint64_t phys_addr_t;
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define ALIGN(x, a)	(((x) + (a) - 1) & ~((__typeof__(x))(a) - 1))
+
+#define WARN_ON(cond)							\
+	({								\
+		int __ret = !!(cond);					\
+		if (__ret)						\
+			fprintf(stderr, "WARN_ON(%s) at %s:%d\n",	\
+				#cond, __func__, __LINE__);		\
+		__ret;							\
+	})
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#endif /* __IOVA_SHIM_LINUX_TYPES_H */
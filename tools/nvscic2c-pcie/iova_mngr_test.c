@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+/*
+ * iova_mngr_test - unit test and trace-replay benchmark for the nvscic2c-pcie
+ * IOVA manager.
+ *
+ * drivers/misc/nvscic2c-pcie/iova-mngr.c is built in directly, against the
+ * stand-in kernel headers in include/. The unit tests check best-fit and
+ * aligned reservation and merging on release. The replay then runs a
+ * reserve/release trace, either generated from a seed or read from a file,
+ * checking the free trees after every operation with -c, and reports ns/op,
+ * failed reservations and the free space fragmentation at the end.
+ *
+ * Trace file lines:
+ *	r <id> <size> <align>	reserve a block as <id>, align 0 for none
+ *	f <id>			release block <id>
+ *
+ * Build, from the top of the tree:
+ *	gcc -O2 -Itools/nvscic2c-pcie/include \
+ *		-o iova_mngr_test tools/nvscic2c-pcie/iova_mngr_test.c
+ *
+ * Example Usage:
+ *	iova_mngr_test [-n <ops>] [-l <live blocks>] [-s <seed>] [-c]
+ *	iova_mngr_test -f <trace file> [-c]
+ */
+
+#include "../../drivers/misc/nvscic2c-pcie/iova-mngr.c"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+
+#define IOVA_BASE		(0x40000000ULL)
+#define IOVA_SPACE		(1ULL << 32)
+#define PAGE_SZ			(0x1000ULL)
+
+static int failures;
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__func__, __LINE__, #cond);		\
+			failures++;					\
+		}							\
+	} while (0)
+
+struct trace_op {
+	char op;
+	unsigned int id;
+	size_t size;
+	size_t align;
+};
+
+/* one reservation of the trace */
+struct live_block {
+	void *handle;
+	u64 address;
+	size_t size;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* black height of the subtree, -1 if the red-black rules are broken */
+static int rb_check(const struct rb_node *node)
+{
+	int left, right;
+
+	if (!node)
+		return 1;
+	if (node->rb_left && node->rb_left->rb_parent != node)
+		return -1;
+	if (node->rb_right && node->rb_right->rb_parent != node)
+		return -1;
+	if (node->rb_red && (rb_is_red(node->rb_left) ||
+			     rb_is_red(node->rb_right)))
+		return -1;
+
+	left = rb_check(node->rb_left);
+	right = rb_check(node->rb_right);
+	if (left < 0 || left != right)
+		return -1;
+
+	return left + !node->rb_red;
+}
+
+/*
+ * Free trees are balanced, hold the same blocks, are ordered, and the free
+ * blocks are fully merged. Returns the free space.
+ */
+static u64 check_free_trees(struct mngr_ctx_t *ctx)
+{
+	struct block_t *block, *prev = NULL;
+	struct rb_node *node;
+	size_t addr_cnt = 0, size_cnt = 0;
+	u64 free = 0;
+
+	CHECK(rb_check(ctx->free_addr_tree.rb_node) > 0);
+	CHECK(rb_check(ctx->free_size_tree.rb_node) > 0);
+
+	for (node = rb_first(&ctx->free_addr_tree); node;
+	     node = rb_next(node)) {
+		block = rb_entry(node, struct block_t, addr_node);
+		if (prev)
+			CHECK(prev->address + prev->size < block->address);
+		free += block->size;
+		prev = block;
+		addr_cnt++;
+	}
+
+	prev = NULL;
+	for (node = rb_first(&ctx->free_size_tree); node;
+	     node = rb_next(node)) {
+		block = rb_entry(node, struct block_t, size_node);
+		if (prev)
+			CHECK(prev->size < block->size ||
+			      (prev->size == block->size &&
+			       prev->address < block->address));
+		prev = block;
+		size_cnt++;
+	}
+	CHECK(addr_cnt == size_cnt);
+
+	return free;
+}
+
+static void *mngr_create(u64 size)
+{
+	void *mngr = NULL;
+
+	if (iova_mngr_init("test", IOVA_BASE, size, &mngr)) {
+		fprintf(stderr, "iova_mngr_init failed\n");
+		exit(1);
+	}
+	return mngr;
+}
+
+static void test_merge(void)
+{
+	void *mngr = mngr_create(16 * PAGE_SZ);
+	struct mngr_ctx_t *ctx = mngr;
+	void *blk[4] = { NULL };
+	u64 addr = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		CHECK(!iova_mngr_block_reserve(mngr, 4 * PAGE_SZ, &addr, NULL,
+					       &blk[i]));
+		CHECK(addr == IOVA_BASE + i * 4 * PAGE_SZ);
+	}
+	CHECK(iova_mngr_block_reserve(mngr, PAGE_SZ, NULL, NULL,
+				      &(void *){ NULL }) == -ENOMEM);
+
+	/* release out of order, every release merges with its neighbours */
+	CHECK(!iova_mngr_block_release(mngr, &blk[1]));
+	CHECK(!iova_mngr_block_release(mngr, &blk[3]));
+	CHECK(!iova_mngr_block_release(mngr, &blk[2]));
+	CHECK(check_free_trees(ctx) == 12 * PAGE_SZ);
+	CHECK(!iova_mngr_block_release(mngr, &blk[0]));
+	CHECK(check_free_trees(ctx) == 16 * PAGE_SZ);
+	CHECK(rb_first(&ctx->free_addr_tree) == ctx->free_addr_tree.rb_node &&
+	      !ctx->free_addr_tree.rb_node->rb_left &&
+	      !ctx->free_addr_tree.rb_node->rb_right);
+
+	iova_mngr_deinit(&mngr);
+}
+
+static void test_best_fit(void)
+{
+	void *mngr = mngr_create(32 * PAGE_SZ);
+	size_t holes[] = { 3, 1, 2, 4 };
+	void *blk[8] = { NULL }, *fit = NULL;
+	u64 addr[8] = { 0 }, got = 0;
+	int i;
+
+	/* free holes of 3, 1, 2 and 4 pages, separated by reserved pages */
+	for (i = 0; i < 8; i++)
+		CHECK(!iova_mngr_block_reserve(mngr,
+					       (i & 1) ? PAGE_SZ :
+					       holes[i / 2] * PAGE_SZ,
+					       &addr[i], NULL, &blk[i]));
+	for (i = 0; i < 8; i += 2)
+		CHECK(!iova_mngr_block_release(mngr, &blk[i]));
+
+	CHECK(!iova_mngr_block_reserve(mngr, 2 * PAGE_SZ, &got, NULL, &fit));
+	CHECK(got == addr[4]);
+	CHECK(!iova_mngr_block_release(mngr, &fit));
+
+	/* the 3 page hole is the smallest one with an 8 page aligned fit */
+	CHECK(!iova_mngr_block_reserve_aligned(mngr, PAGE_SZ, 8 * PAGE_SZ,
+					       &got, NULL, &fit));
+	CHECK(got == addr[0]);
+	CHECK(!iova_mngr_block_release(mngr, &fit));
+
+	for (i = 1; i < 8; i += 2)
+		CHECK(!iova_mngr_block_release(mngr, &blk[i]));
+	CHECK(check_free_trees(mngr) == 32 * PAGE_SZ);
+
+	iova_mngr_deinit(&mngr);
+}
+
+/*
+ * More near-fit holes than are probed, none of them aligned. The aligned
+ * reservation has to land in the one block that always fits.
+ */
+static void test_aligned_probe_bound(void)
+{
+	size_t align = 16 * PAGE_SZ;
+	unsigned int nr = 4 * BEST_FIT_MAX_PROBES;
+	void *mngr = mngr_create((2 * nr + 64) * align);
+	void **blk = calloc(2 * nr + 1, sizeof(*blk));
+	void *fit = NULL;
+	u64 addr = 0, got = 0;
+	unsigned int i;
+
+	for (i = 0; i < 2 * nr; i++) {
+		/* hole of align - 2 pages starting 1 page past the boundary */
+		if (!(i & 1)) {
+			CHECK(!iova_mngr_block_reserve(mngr, PAGE_SZ, NULL,
+						       NULL, &fit));
+			fit = NULL;
+		}
+		CHECK(!iova_mngr_block_reserve(mngr, (i & 1) ? PAGE_SZ :
+					       align - 2 * PAGE_SZ, &addr,
+					       NULL, &blk[i]));
+	}
+	for (i = 0; i < 2 * nr; i += 2)
+		CHECK(!iova_mngr_block_release(mngr, &blk[i]));
+
+	CHECK(!iova_mngr_block_reserve_aligned(mngr, align - 4 * PAGE_SZ,
+					       align, &got, NULL, &fit));
+	CHECK(!(got & (align - 1)));
+	CHECK(got > addr);
+	CHECK(!iova_mngr_block_release(mngr, &fit));
+	check_free_trees(mngr);
+
+	free(blk);
+	iova_mngr_deinit(&mngr);
+}
+
+static uint64_t rand_next(uint64_t *state)
+{
+	/* xorshift64 */
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+/*
+ * Mostly small buffers with a tail of large ones, two in five of them
+ * aligned. Keeps between @live / 2 and @live blocks reserved.
+ */
+static struct trace_op *trace_generate(unsigned long nr_ops,
+				       unsigned int live, uint64_t seed)
+{
+	static const size_t aligns[] = { 0, 0, 0, 0x10000, 0x200000 };
+	struct trace_op *ops = calloc(nr_ops, sizeof(*ops));
+	unsigned int *ids = calloc(live, sizeof(*ids));
+	unsigned int nr_live = 0, next_id = 0, idx;
+	uint64_t state = seed ? seed : 1;
+	unsigned long i;
+	uint64_t r;
+
+	for (i = 0; i < nr_ops; i++) {
+		r = rand_next(&state);
+		if (nr_live == live || (nr_live > live / 2 && (r & 1))) {
+			idx = (r >> 1) % nr_live;
+			ops[i].op = 'f';
+			ops[i].id = ids[idx];
+			ids[idx] = ids[--nr_live];
+			continue;
+		}
+
+		r = rand_next(&state);
+		ops[i].op = 'r';
+		ops[i].id = next_id;
+		ops[i].size = (r % 16 ? 1 + (r >> 8) % 16 :
+			       1 + (r >> 8) % 512) * PAGE_SZ;
+		ops[i].align = aligns[(r >> 32) % 5];
+		ids[nr_live++] = next_id++;
+	}
+
+	free(ids);
+	return ops;
+}
+
+static struct trace_op *trace_read(const char *path, unsigned long *nr_ops)
+{
+	struct trace_op *ops = NULL, op;
+	unsigned long nr = 0, cap = 0;
+	char line[128];
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		memset(&op, 0, sizeof(op));
+		if (sscanf(line, "r %u %zu %zu", &op.id, &op.size,
+			   &op.align) == 3)
+			op.op = 'r';
+		else if (sscanf(line, "f %u", &op.id) == 1)
+			op.op = 'f';
+		else
+			continue;
+
+		if (nr == cap) {
+			cap = cap ? 2 * cap : 1024;
+			ops = realloc(ops, cap * sizeof(*ops));
+		}
+		ops[nr++] = op;
+	}
+	fclose(f);
+
+	*nr_ops = nr;
+	return ops;
+}
+
+static void trace_replay(struct trace_op *ops, unsigned long nr_ops,
+			 bool check)
+{
+	void *mngr = mngr_create(IOVA_SPACE);
+	struct mngr_ctx_t *ctx = mngr;
+	struct live_block *blocks;
+	unsigned int max_id = 0;
+	unsigned long i, failed = 0, nr_free = 0;
+	u64 reserved = 0, largest = 0;
+	struct block_t *block;
+	struct rb_node *node;
+	uint64_t start, elapsed;
+	int ret;
+
+	for (i = 0; i < nr_ops; i++)
+		if (ops[i].id > max_id)
+			max_id = ops[i].id;
+	blocks = calloc(max_id + 1, sizeof(*blocks));
+
+	start = now_ns();
+	for (i = 0; i < nr_ops; i++) {
+		struct live_block *b = &blocks[ops[i].id];
+
+		if (ops[i].op == 'r') {
+			if (b->handle)
+				continue;
+			ret = iova_mngr_block_reserve_aligned(mngr,
+							      ops[i].size,
+							      ops[i].align,
+							      &b->address,
+							      NULL,
+							      &b->handle);
+			if (ret) {
+				failed++;
+				continue;
+			}
+			b->size = ops[i].size;
+			reserved += b->size;
+			if (check) {
+				CHECK(!ops[i].align ||
+				      !(b->address & (ops[i].align - 1)));
+				CHECK(b->address >= IOVA_BASE &&
+				      b->address + b->size <=
+				      IOVA_BASE + IOVA_SPACE);
+			}
+		} else {
+			if (!b->handle)
+				continue;
+			CHECK(!iova_mngr_block_release(mngr, &b->handle));
+			reserved -= b->size;
+		}
+
+		if (check)
+			CHECK(check_free_trees(ctx) + reserved == IOVA_SPACE);
+	}
+	elapsed = now_ns() - start;
+
+	for (node = rb_first(&ctx->free_addr_tree); node;
+	     node = rb_next(node)) {
+		block = rb_entry(node, struct block_t, addr_node);
+		if (block->size > largest)
+			largest = block->size;
+		nr_free++;
+	}
+
+	printf("replay: %lu ops, %.1f ns/op, %lu failed reservations\n",
+	       nr_ops, (double)elapsed / nr_ops, failed);
+	printf("replay: %" PRIu64 " MiB reserved, %lu free blocks, largest %" PRIu64 " MiB\n",
+	       reserved >> 20, nr_free, largest >> 20);
+
+	for (i = 0; i <= max_id; i++)
+		if (blocks[i].handle)
+			iova_mngr_block_release(mngr, &blocks[i].handle);
+	CHECK(check_free_trees(ctx) == IOVA_SPACE);
+
+	free(blocks);
+	iova_mngr_deinit(&mngr);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long nr_ops = 1000000;
+	unsigned int live = 4096;
+	const char *path = NULL;
+	struct trace_op *ops;
+	uint64_t seed = 1;
+	bool check = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:l:s:f:c")) != -1) {
+		switch (opt) {
+		case 'n':
+			nr_ops = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			live = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'f':
+			path = optarg;
+			break;
+		case 'c':
+			check = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n ops] [-l live] [-s seed] [-f trace] [-c]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	test_merge();
+	test_best_fit();
+	test_aligned_probe_bound();
+
+	if (path) {
+		ops = trace_read(path, &nr_ops);
+	} else {
+		if (!nr_ops || !live) {
+			fprintf(stderr, "ops and live blocks must be non-zero\n");
+			return 1;
+		}
+		ops = trace_generate(nr_ops, live, seed);
+	}
+	if (nr_ops)
+		trace_replay(ops, nr_ops, check);
+	free(ops);
+
+	if (failures) {
+		printf("FAIL: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("PASS\n");
+	return 0;
+}
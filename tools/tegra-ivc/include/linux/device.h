@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __IVC_SHIM_LINUX_DEVICE_H
+#define __IVC_SHIM_LINUX_DEVICE_H
+
+struct device {
+	int unused;
+};
+
+#endif /* __IVC_SHIM_LINUX_DEVICE_H */
@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __IVC_SHIM_LINUX_MODULE_H
+#define __IVC_SHIM_LINUX_MODULE_H
+
+#define EXPORT_SYMBOL(sym)
+
+#endif /* __IVC_SHIM_LINUX_MODULE_H */
@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ * Userspace stand-ins for the kernel helpers used by tegra-ivc.c, so that
+ * the ring logic can be built into ivc_ring_test.
+ */
+
+#ifndef __IVC_SHIM_LINUX_TYPES_H
+#define __IVC_SHIM_LINUX_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+
+#define CONFIG_SMP
+
+#define __user
+
+#define READ_ONCE(x)		(*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, val)	(*(volatile __typeof__(x) *)&(x) = (val))
+
+#define BUG()			abort()
+#define BUG_ON(cond)		do { if (cond) abort(); } while (0)
+#define BUILD_BUG_ON(cond)	((void)sizeof(char[1 - 2 * !!(cond)]))
+
+#define pr_err(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+
+typedef uint64_t dma_addr_t;
+
+#endif /* __IVC_SHIM_LINUX_TYPES_H */
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+/*
+ * ivc_ring_test - unit test and benchmark for the tegra-ivc ring.
+ *
+ * drivers/platform/tegra/tegra-ivc.c is built in directly, against the
+ * stand-in kernel headers in include/. The unit tests check the bounds
+ * and notification rules of the batched frame API on a single thread.
+ * The benchmark then runs a producer and a consumer thread over shared
+ * memory, each sleeping until the peer notifies it, and reports frames/s
+ * and notifications/frame for per-frame and batched access.
+ *
+ * Build, from the top of the tree:
+ *	gcc -O2 -pthread -Itools/tegra-ivc/include -Iinclude \
+ *		-o ivc_ring_test tools/tegra-ivc/ivc_ring_test.c
+ *
+ * Example Usage:
+ *	ivc_ring_test [-n <frames>] [-s <frame size>] [-c <count>] [-b <batch>]
+ */
+
+#include <linux/tegra-ivc.h>
+#include <linux/tegra-ivc-instance.h>
+
+#include "../../drivers/platform/tegra/tegra-ivc.c"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+
+#define WAIT_TIMEOUT_S		2
+
+/* one end of the channel, woken by the peer's notifications */
+struct ivc_end {
+	struct ivc ivc;
+	struct ivc_end *peer;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint64_t seq;		/* notifications received */
+};
+
+static int failures;
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__func__, __LINE__, #cond);		\
+			failures++;					\
+		}							\
+	} while (0)
+
+static uint64_t ivc_end_seq(struct ivc_end *end)
+{
+	uint64_t seq;
+
+	pthread_mutex_lock(&end->lock);
+	seq = end->seq;
+	pthread_mutex_unlock(&end->lock);
+
+	return seq;
+}
+
+static void ivc_end_notify(struct ivc *ivc)
+{
+	struct ivc_end *peer = ((struct ivc_end *)ivc)->peer;
+
+	pthread_mutex_lock(&peer->lock);
+	peer->seq++;
+	pthread_cond_signal(&peer->cond);
+	pthread_mutex_unlock(&peer->lock);
+}
+
+/* sleep until a notification newer than seq arrives, -ETIMEDOUT if none */
+static int ivc_end_wait(struct ivc_end *end, uint64_t seq)
+{
+	struct timespec ts;
+	int ret = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += WAIT_TIMEOUT_S;
+
+	pthread_mutex_lock(&end->lock);
+	while (end->seq == seq && !ret)
+		ret = pthread_cond_timedwait(&end->cond, &end->lock, &ts);
+	pthread_mutex_unlock(&end->lock);
+
+	return ret ? -ETIMEDOUT : 0;
+}
+
+static void *queue_alloc(size_t size)
+{
+	void *p = aligned_alloc(IVC_ALIGN, size);
+
+	if (!p) {
+		perror("aligned_alloc");
+		exit(1);
+	}
+	memset(p, 0, size);
+
+	return p;
+}
+
+static void channel_init(struct ivc_end *a, struct ivc_end *b,
+			 unsigned int nframes, unsigned int frame_size)
+{
+	size_t size = tegra_ivc_total_queue_size(nframes * frame_size);
+	uintptr_t q0 = (uintptr_t)queue_alloc(size);
+	uintptr_t q1 = (uintptr_t)queue_alloc(size);
+
+	memset(a, 0, sizeof(*a));
+	memset(b, 0, sizeof(*b));
+	a->peer = b;
+	b->peer = a;
+	pthread_mutex_init(&a->lock, NULL);
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_cond_init(&a->cond, NULL);
+	pthread_cond_init(&b->cond, NULL);
+
+	if (tegra_ivc_init(&a->ivc, q0, q1, nframes, frame_size, NULL,
+			   ivc_end_notify) ||
+	    tegra_ivc_init(&b->ivc, q1, q0, nframes, frame_size, NULL,
+			   ivc_end_notify)) {
+		fprintf(stderr, "tegra_ivc_init failed\n");
+		exit(1);
+	}
+
+	/* run the reset handshake to the established state on both ends */
+	tegra_ivc_channel_reset(&a->ivc);
+	tegra_ivc_channel_reset(&b->ivc);
+	while (tegra_ivc_channel_notified(&a->ivc) |
+	       tegra_ivc_channel_notified(&b->ivc))
+		;
+
+	a->seq = 0;
+	b->seq = 0;
+}
+
+static void channel_free(struct ivc_end *a)
+{
+	/* a's channels are the two queues, b only points at them */
+	free(a->ivc.rx_channel);
+	free(a->ivc.tx_channel);
+}
+
+static void test_batch_bounds(void)
+{
+	struct ivc_end a, b;
+	unsigned int nframes = 8, i;
+	uint64_t *frame;
+
+	channel_init(&a, &b, nframes, IVC_ALIGN);
+
+	/* every frame of an empty ring can be reserved, one more can't */
+	for (i = 0; i < nframes; i++) {
+		frame = tegra_ivc_write_get_frame(&a.ivc, i);
+		CHECK(!IS_ERR(frame));
+		if (!IS_ERR(frame))
+			*frame = i;
+	}
+	CHECK(PTR_ERR(tegra_ivc_write_get_frame(&a.ivc, nframes)) == -ENOMEM);
+	CHECK(tegra_ivc_write_advance_n(&a.ivc, nframes + 1) == -ENOMEM);
+	CHECK(tegra_ivc_write_advance_n(&a.ivc, 0) == 0);
+	CHECK(b.seq == 0);
+
+	/* publishing three frames notifies the reader once */
+	CHECK(tegra_ivc_write_advance_n(&a.ivc, 3) == 0);
+	CHECK(b.seq == 1);
+	CHECK(PTR_ERR(tegra_ivc_write_get_frame(&a.ivc, nframes - 3)) ==
+	      -ENOMEM);
+
+	/* a non-empty ring is not notified again */
+	CHECK(tegra_ivc_write_advance_n(&a.ivc, 1) == 0);
+	CHECK(b.seq == 1);
+
+	for (i = 0; i < 4; i++) {
+		frame = tegra_ivc_read_get_frame(&b.ivc, i);
+		CHECK(!IS_ERR(frame) && *frame == i);
+	}
+	CHECK(PTR_ERR(tegra_ivc_read_get_frame(&b.ivc, 4)) == -ENOMEM);
+	CHECK(tegra_ivc_read_advance_n(&b.ivc, 5) == -ENOMEM);
+
+	/* the ring was not full, so releasing does not notify the writer */
+	CHECK(tegra_ivc_read_advance_n(&b.ivc, 4) == 0);
+	CHECK(a.seq == 0);
+	CHECK(!tegra_ivc_can_read(&b.ivc));
+
+	channel_free(&a);
+}
+
+static void test_full_ring_notify(void)
+{
+	struct ivc_end a, b;
+	unsigned int nframes = 4;
+
+	channel_init(&a, &b, nframes, IVC_ALIGN);
+
+	CHECK(tegra_ivc_write_advance_n(&a.ivc, nframes) == 0);
+	CHECK(!tegra_ivc_can_write(&a.ivc));
+
+	/* full to non-full notifies the writer, later releases don't */
+	CHECK(tegra_ivc_read_advance_n(&b.ivc, 1) == 0);
+	CHECK(a.seq == 1);
+	CHECK(tegra_ivc_read_advance_n(&b.ivc, nframes - 1) == 0);
+	CHECK(a.seq == 1);
+
+	channel_free(&a);
+}
+
+static void test_wrap(void)
+{
+	struct ivc_end a, b;
+	unsigned int nframes = 7, n, i;
+	uint64_t wr = 0, rd = 0, *frame;
+	int round;
+
+	channel_init(&a, &b, nframes, IVC_ALIGN);
+
+	/* mix batch sizes so that batches straddle the end of the ring */
+	for (round = 0; round < 1000; round++) {
+		n = 1 + round % nframes;
+		for (i = 0; i < n; i++) {
+			frame = tegra_ivc_write_get_frame(&a.ivc, i);
+			CHECK(!IS_ERR(frame));
+			if (!IS_ERR(frame))
+				*frame = wr + i;
+		}
+		CHECK(tegra_ivc_write_advance_n(&a.ivc, n) == 0);
+		wr += n;
+
+		for (i = 0; i < n; i++) {
+			frame = tegra_ivc_read_get_frame(&b.ivc, i);
+			CHECK(!IS_ERR(frame) && *frame == rd + i);
+		}
+		CHECK(tegra_ivc_read_advance_n(&b.ivc, n) == 0);
+		rd += n;
+	}
+	CHECK(rd == wr);
+
+	channel_free(&a);
+}
+
+struct bench {
+	struct ivc_end a, b;
+	uint64_t count;
+	unsigned int batch;
+	int err;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *producer(void *arg)
+{
+	struct bench *bench = arg;
+	struct ivc_end *end = &bench->a;
+	uint64_t sent = 0, seq, *frame;
+	unsigned int n;
+
+	while (sent < bench->count && !bench->err) {
+		seq = ivc_end_seq(end);
+
+		if (bench->batch == 1) {
+			frame = tegra_ivc_write_get_next_frame(&end->ivc);
+			if (!IS_ERR(frame)) {
+				*frame = sent++;
+				tegra_ivc_write_advance(&end->ivc);
+				continue;
+			}
+		} else {
+			for (n = 0; n < bench->batch && sent + n < bench->count;
+			     n++) {
+				frame = tegra_ivc_write_get_frame(&end->ivc, n);
+				if (IS_ERR(frame))
+					break;
+				*frame = sent + n;
+			}
+			if (n) {
+				tegra_ivc_write_advance_n(&end->ivc, n);
+				sent += n;
+				continue;
+			}
+		}
+
+		if (ivc_end_wait(end, seq)) {
+			fprintf(stderr, "producer: lost wakeup at %" PRIu64 "\n",
+				sent);
+			bench->err = -ETIMEDOUT;
+		}
+	}
+
+	return NULL;
+}
+
+static void *consumer(void *arg)
+{
+	struct bench *bench = arg;
+	struct ivc_end *end = &bench->b;
+	uint64_t rcvd = 0, seq, *frame;
+	unsigned int n;
+
+	while (rcvd < bench->count && !bench->err) {
+		seq = ivc_end_seq(end);
+
+		if (bench->batch == 1) {
+			frame = tegra_ivc_read_get_next_frame(&end->ivc);
+			if (!IS_ERR(frame)) {
+				if (*frame != rcvd)
+					bench->err = -EIO;
+				rcvd++;
+				tegra_ivc_read_advance(&end->ivc);
+				continue;
+			}
+		} else {
+			for (n = 0; n < bench->batch; n++) {
+				frame = tegra_ivc_read_get_frame(&end->ivc, n);
+				if (IS_ERR(frame))
+					break;
+				if (*frame != rcvd + n)
+					bench->err = -EIO;
+			}
+			if (n) {
+				tegra_ivc_read_advance_n(&end->ivc, n);
+				rcvd += n;
+				continue;
+			}
+		}
+
+		if (ivc_end_wait(end, seq)) {
+			fprintf(stderr, "consumer: lost wakeup at %" PRIu64 "\n",
+				rcvd);
+			bench->err = -ETIMEDOUT;
+		}
+	}
+
+	if (bench->err == -EIO)
+		fprintf(stderr, "consumer: frame out of sequence\n");
+
+	return NULL;
+}
+
+static int run_bench(unsigned int nframes, unsigned int frame_size,
+		     uint64_t count, unsigned int batch)
+{
+	struct bench bench = { .count = count, .batch = batch };
+	pthread_t prod, cons;
+	uint64_t t1, t2, notifies;
+
+	channel_init(&bench.a, &bench.b, nframes, frame_size);
+
+	t1 = now_ns();
+	pthread_create(&cons, NULL, consumer, &bench);
+	pthread_create(&prod, NULL, producer, &bench);
+	pthread_join(prod, NULL);
+	pthread_join(cons, NULL);
+	t2 = now_ns();
+
+	notifies = bench.a.seq + bench.b.seq;
+	printf("batch=%-3u frames=%" PRIu64 " frames/s=%.0f notifications/frame=%.4f%s\n",
+	       batch, count, (double)count * 1e9 / (double)(t2 - t1),
+	       (double)notifies / (double)count, bench.err ? " FAILED" : "");
+
+	channel_free(&bench.a);
+
+	return bench.err;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int nframes = 64, frame_size = IVC_ALIGN, batch = 0;
+	uint64_t count = 1000000;
+	int opt, err = 0;
+
+	while ((opt = getopt(argc, argv, "n:s:c:b:")) != -1) {
+		switch (opt) {
+		case 'n':
+			nframes = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			frame_size = tegra_ivc_align(strtoul(optarg, NULL, 0));
+			break;
+		case 'c':
+			count = strtoull(optarg, NULL, 0);
+			break;
+		case 'b':
+			batch = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n frames] [-s frame size] "
+				"[-c count] [-b batch]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (nframes < 2 || frame_size < sizeof(uint64_t)) {
+		fprintf(stderr, "need at least 2 frames of 8 bytes\n");
+		return 1;
+	}
+
+	test_batch_bounds();
+	test_full_ring_notify();
+	test_wrap();
+	printf("unit tests: %s\n", failures ? "FAILED" : "passed");
+
+	if (batch) {
+		err |= run_bench(nframes, frame_size, count, batch);
+	} else {
+		err |= run_bench(nframes, frame_size, count, 1);
+		err |= run_bench(nframes, frame_size, count, 8);
+		err |= run_bench(nframes, frame_size, count, nframes);
+	}
+
+	return failures || err ? 1 : 0;
+}
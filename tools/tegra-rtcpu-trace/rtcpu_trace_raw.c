@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES.All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ */
+
+/*
+ * rtcpu_trace_raw - consume the raw camera-RTCPU trace ring from userspace.
+ *
+ * Events are either decoded to stdout, written as raw 64-byte records to a
+ * file for offline decoding, or only counted to measure ingestion
+ * throughput.
+ *
+ * Example Usage:
+ *	rtcpu_trace_raw [-d <device>] [-o <file>] [-b <seconds>]
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <linux/tegra-rtcpu-trace-raw.h>
+
+#define DEFAULT_DEVICE		"/dev/camrtc-trace"
+#define EVENT_HEADER_SIZE	16
+
+/* mirrors struct camrtc_event_struct from the firmware interface */
+struct rtcpu_event {
+	uint32_t len;
+	uint32_t id;
+	uint64_t tstamp;
+	uint8_t data[48];
+};
+
+static const char * const type_names[] = {
+	"array", "exception", "pad", "start", "string", "bulk",
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void decode_event(const struct rtcpu_event *ev)
+{
+	unsigned int type = (ev->id >> 24) & 0xff;
+	unsigned int module = (ev->id >> 16) & 0xff;
+	unsigned int subid = ev->id & 0xffff;
+	unsigned int len = ev->len > EVENT_HEADER_SIZE ?
+		ev->len - EVENT_HEADER_SIZE : 0;
+	unsigned int i;
+
+	if (len > sizeof(ev->data))
+		len = sizeof(ev->data);
+
+	printf("%20" PRIu64 " %-9s mod=%u sub=%u",
+		ev->tstamp,
+		type < sizeof(type_names) / sizeof(type_names[0]) ?
+			type_names[type] : "unknown",
+		module, subid);
+
+	if (type == 4) {
+		printf(" \"%.*s\"\n", (int)strnlen((const char *)ev->data, len),
+			(const char *)ev->data);
+		return;
+	}
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		uint32_t v;
+
+		memcpy(&v, &ev->data[i], sizeof(v));
+		printf(" %08x", v);
+	}
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *device = DEFAULT_DEVICE;
+	const char *out_name = NULL;
+	unsigned int bench_secs = 0;
+	struct camrtc_trace_raw_header *hdr;
+	volatile struct camrtc_trace_raw_header *vhdr;
+	const uint8_t *data;
+	FILE *out = NULL;
+	uint64_t start, events = 0, wakeups = 0;
+	size_t size;
+	int fd, c;
+
+	while ((c = getopt(argc, argv, "d:o:b:h")) != -1) {
+		switch (c) {
+		case 'd':
+			device = optarg;
+			break;
+		case 'o':
+			out_name = optarg;
+			break;
+		case 'b':
+			bench_secs = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-d device] [-o file] [-b seconds]\n",
+				argv[0]);
+			return c == 'h' ? 0 : 1;
+		}
+	}
+
+	fd = open(device, O_RDWR);
+	if (fd < 0) {
+		fprintf(stderr, "open %s: %s\n", device, strerror(errno));
+		return 1;
+	}
+
+	hdr = mmap(NULL, sizeof(*hdr), PROT_READ, MAP_SHARED, fd, 0);
+	if (hdr == MAP_FAILED) {
+		fprintf(stderr, "mmap header: %s\n", strerror(errno));
+		return 1;
+	}
+
+	if (hdr->magic != CAMRTC_TRACE_RAW_MAGIC ||
+	    hdr->version != CAMRTC_TRACE_RAW_VERSION ||
+	    hdr->entry_size != sizeof(struct rtcpu_event)) {
+		fprintf(stderr, "unsupported ring format\n");
+		return 1;
+	}
+
+	size = hdr->data_offset + (size_t)hdr->entries * hdr->entry_size;
+	munmap(hdr, sizeof(*hdr));
+
+	hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (hdr == MAP_FAILED) {
+		fprintf(stderr, "mmap ring: %s\n", strerror(errno));
+		return 1;
+	}
+	vhdr = hdr;
+	data = (const uint8_t *)hdr + hdr->data_offset;
+
+	if (out_name != NULL) {
+		out = fopen(out_name, "wb");
+		if (out == NULL) {
+			fprintf(stderr, "open %s: %s\n", out_name,
+				strerror(errno));
+			return 1;
+		}
+	}
+
+	start = now_ns();
+
+	for (;;) {
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		uint32_t rd = vhdr->read_idx;
+		uint32_t wr;
+
+		if (bench_secs && now_ns() - start >= bench_secs * 1000000000ULL)
+			break;
+
+		if (poll(&pfd, 1, 1000) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		wakeups++;
+
+		wr = __atomic_load_n(&vhdr->write_idx, __ATOMIC_ACQUIRE);
+
+		while (rd != wr) {
+			uint32_t slot = rd & (hdr->entries - 1);
+			uint32_t n = wr - rd;
+
+			if (n > hdr->entries - slot)
+				n = hdr->entries - slot;
+
+			if (out != NULL) {
+				fwrite(data + (size_t)slot * hdr->entry_size,
+					hdr->entry_size, n, out);
+			} else if (!bench_secs) {
+				uint32_t i;
+
+				for (i = 0; i < n; i++)
+					decode_event((const void *)(data +
+						(size_t)(slot + i) *
+						hdr->entry_size));
+			}
+
+			rd += n;
+			events += n;
+		}
+
+		__atomic_store_n(&vhdr->read_idx, rd, __ATOMIC_RELEASE);
+	}
+
+	if (bench_secs) {
+		double secs = (now_ns() - start) / 1e9;
+
+		printf("events %" PRIu64 " (%.0f/s, %.2f MB/s), wakeups %"
+			PRIu64 " (%.1f events/wakeup), dropped %" PRIu64 "\n",
+			events, events / secs,
+			events * hdr->entry_size / secs / 1e6,
+			wakeups, wakeups ? (double)events / wakeups : 0.0,
+			(uint64_t)vhdr->dropped);
+	}
+
+	if (out != NULL)
+		fclose(out);
+	munmap(hdr, size);
+	close(fd);
+
+	return 0;
+}